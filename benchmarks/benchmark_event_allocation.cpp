@@ -0,0 +1,190 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mir/events/event_builders.h"
+#include "mir/events/event_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace mev = mir::events;
+
+// Count every trip to the heap, whether through operator new or straight to malloc
+std::atomic<long> heap_allocations{0};
+
+extern "C"
+{
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+    ++heap_allocations;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    ++heap_allocations;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    ++heap_allocations;
+    return __libc_realloc(ptr, size);
+}
+}
+
+namespace
+{
+// Built as DefaultEventBuilder does for the devices LibInputDevice reads
+mir::EventUPtr pointer_motion(int i)
+{
+    return mev::make_event(MirInputDeviceId{1}, std::chrono::nanoseconds{i}, std::vector<uint8_t>{},
+                           mir_input_event_modifier_none, mir_pointer_action_motion, 0, 0, 0, 0, 0, 1, 1);
+}
+
+mir::EventUPtr touch_frame(int i)
+{
+    auto event = mev::make_event(MirInputDeviceId{2}, std::chrono::nanoseconds{i}, std::vector<uint8_t>{},
+                                 mir_input_event_modifier_none);
+    for (auto contact = 0; contact != 10; ++contact)
+        mev::add_touch(*event, contact, mir_touch_action_change, mir_touch_tooltype_finger, i, contact, 1, 4, 4, 0);
+    return event;
+}
+
+mir::EventUPtr key(int i)
+{
+    return mev::make_event(MirInputDeviceId{3}, std::chrono::nanoseconds{i}, std::vector<uint8_t>{},
+                           i % 2 ? mir_keyboard_action_up : mir_keyboard_action_down, 0, 30, mir_input_event_modifier_none);
+}
+
+struct Result
+{
+    double heap_allocations_per_event;
+    double microseconds_per_event;
+};
+
+// Each event is shared, as for InputSink::handle_input(), and released on the same thread
+Result same_thread(std::function<mir::EventUPtr(int)> const& make, int events)
+{
+    for (auto i = 0; i != 1000; ++i)
+        mev::share_event(make(i));
+
+    auto const allocations_before = heap_allocations.load();
+    auto const start = std::chrono::steady_clock::now();
+
+    for (auto i = 0; i != events; ++i)
+        mev::share_event(make(i));
+
+    std::chrono::duration<double, std::micro> const duration = std::chrono::steady_clock::now() - start;
+
+    return {double(heap_allocations - allocations_before) / events, duration.count() / events};
+}
+
+// Events are released on a second thread, as when a dispatcher holds on to them
+Result other_thread(std::function<mir::EventUPtr(int)> const& make, int events)
+{
+    int const depth = 64;
+    std::shared_ptr<MirEvent> queue[depth];
+    int produced = 0;
+    int consumed = 0;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    auto const total = events + 1000;
+    long allocations_before = 0;
+
+    std::thread consumer{[&]
+        {
+            for (auto i = 0; i != total; ++i)
+            {
+                std::shared_ptr<MirEvent> event;
+                {
+                    std::unique_lock<std::mutex> lock{mutex};
+                    changed.wait(lock, [&] { return consumed != produced; });
+                    event = std::move(queue[consumed++ % depth]);
+                }
+                changed.notify_one();
+            }
+        }};
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i != total; ++i)
+    {
+        if (i == 1000)
+        {
+            allocations_before = heap_allocations;
+            start = std::chrono::steady_clock::now();
+        }
+
+        auto event = mev::share_event(make(i));
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            changed.wait(lock, [&] { return produced - consumed != depth; });
+            queue[produced++ % depth] = std::move(event);
+        }
+        changed.notify_one();
+    }
+
+    consumer.join();
+    std::chrono::duration<double, std::micro> const duration = std::chrono::steady_clock::now() - start;
+
+    return {double(heap_allocations - allocations_before) / events, duration.count() / events};
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <events>"<<std::endl;
+        std::cout<<"Reports heap allocations and microseconds per input event built, shared and released"<<std::endl;
+        exit(1);
+    }
+
+    int const events = std::atoi(argv[1]);
+
+    struct { char const* name; std::function<mir::EventUPtr(int)> make; } const kinds[] =
+        {{"pointer", &pointer_motion}, {"touch", &touch_frame}, {"key", &key}};
+
+    std::cout<<std::setw(10)<<"event"
+             <<std::setw(16)<<"allocs/event"<<std::setw(12)<<"us/event"
+             <<std::setw(24)<<"cross-thread allocs/event"<<std::setw(12)<<"us/event"<<std::endl;
+
+    for (auto const& kind : kinds)
+    {
+        auto const local = same_thread(kind.make, events);
+        auto const remote = other_thread(kind.make, events);
+
+        std::cout<<std::setw(10)<<kind.name<<std::fixed<<std::setprecision(3)
+                 <<std::setw(16)<<local.heap_allocations_per_event<<std::setw(12)<<local.microseconds_per_event
+                 <<std::setw(24)<<remote.heap_allocations_per_event<<std::setw(12)<<remote.microseconds_per_event
+                 <<std::endl;
+    }
+
+    exit(0);
+}
@@ -18,21 +18,25 @@
 
 #include "mir/dispatch/multiplexing_dispatchable.h"
 
+#include <atomic>
 #include <iostream>
+#include <iomanip>
 #include <vector>
 #include <memory>
 #include <chrono>
 #include <thread>
+#include <system_error>
 #include <poll.h>
 #include <unistd.h>
 
 namespace md = mir::dispatch;
 
+/// A source that stays readable, and so is ready again as soon as it is re-armed
 class TestDispatchable : public md::Dispatchable
 {
 public:
-    TestDispatchable(uint64_t limit)
-        : dispatch_limit{limit}
+    TestDispatchable(std::atomic<uint64_t>& dispatch_count)
+        : dispatch_count(dispatch_count)
     {
         int pipefds[2];
         if (pipe(pipefds) < 0)
@@ -57,7 +61,7 @@ public:
     bool dispatch(md::FdEvents) override
     {
         ++dispatch_count;
-        return (dispatch_count < dispatch_limit);
+        return true;
     }
     md::FdEvents relevant_events() const override
     {
@@ -65,13 +69,10 @@ public:
     }
 
 private:
-    static thread_local uint64_t dispatch_count;
-    uint64_t const dispatch_limit;
+    std::atomic<uint64_t>& dispatch_count;
     mir::Fd read_fd, write_fd;
 };
 
-thread_local uint64_t TestDispatchable::dispatch_count = 0;
-
 bool fd_is_readable(int fd)
 {
     struct pollfd poller {
@@ -79,33 +80,31 @@ bool fd_is_readable(int fd)
         POLLIN,
         0
     };
-    return poll(&poller, 1, 0);
+    return poll(&poller, 1, 10);
 }
 
-int main(int argc, char** argv)
+// Dispatches per second with thread_count threads dispatching source_count ready sources
+double dispatch_rate(int thread_count, int source_count, int events_per_dispatch, uint64_t dispatch_count)
 {
-    if (argc != 3)
+    std::atomic<uint64_t> dispatched{0};
+
+    auto dispatcher = std::make_shared<md::MultiplexingDispatchable>(events_per_dispatch);
+    for (int i = 0; i < source_count; ++i)
     {
-        std::cout<<"Usage: "<<argv[0]<<" <number of threads> <dispatch count>"<<std::endl;
-        exit(1);
+        dispatcher->add_watch(std::make_shared<TestDispatchable>(dispatched));
     }
 
-    int const thread_count = std::atoi(argv[1]);
-    uint64_t const dispatch_count = std::atoll(argv[2]);
-
-    auto dispatcher = std::make_shared<md::MultiplexingDispatchable>();
-    dispatcher->add_watch(std::make_shared<TestDispatchable>(dispatch_count / thread_count), md::DispatchReentrancy::reentrant);
-
     auto start = std::chrono::steady_clock::now();
 
     std::vector<std::thread> thread_loops;
     for (int i = 0; i < thread_count; ++i)
     {
-        thread_loops.emplace_back([](md::Dispatchable& dispatch)
+        thread_loops.emplace_back([&dispatched, dispatch_count](md::Dispatchable& dispatch)
         {
-            while(fd_is_readable(dispatch.watch_fd()))
+            while (dispatched < dispatch_count)
             {
-                dispatch.dispatch(md::FdEvent::readable);
+                if (fd_is_readable(dispatch.watch_fd()))
+                    dispatch.dispatch(md::FdEvent::readable);
             }
         }, std::ref(*dispatcher));
     }
@@ -115,7 +114,37 @@ int main(int argc, char** argv)
         thread.join();
     }
 
-    auto duration = std::chrono::steady_clock::now() - start;
-    std::cout<<"Dispatching "<<dispatch_count<<" times took "<<std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()<<"ns"<<std::endl;
+    std::chrono::duration<double> const duration = std::chrono::steady_clock::now() - start;
+    return dispatched / duration.count();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <max number of threads> <max number of ready sources> <dispatch count>"<<std::endl;
+        std::cout<<"Reports dispatches per second, unbatched and batched, for powers of two up to each maximum"<<std::endl;
+        exit(1);
+    }
+
+    int const max_thread_count = std::atoi(argv[1]);
+    int const max_source_count = std::atoi(argv[2]);
+    uint64_t const dispatch_count = std::atoll(argv[3]);
+    int const batch = md::MultiplexingDispatchable::max_dispatch_batch;
+
+    std::cout<<std::setw(8)<<"threads"<<std::setw(8)<<"sources"
+             <<std::setw(16)<<"unbatched/s"<<std::setw(16)<<"batched/s"<<std::endl;
+
+    for (int threads = 1; threads <= max_thread_count; threads *= 2)
+    {
+        for (int sources = 1; sources <= max_source_count; sources *= 2)
+        {
+            std::cout<<std::setw(8)<<threads<<std::setw(8)<<sources
+                     <<std::setw(16)<<std::fixed<<std::setprecision(0)
+                     <<dispatch_rate(threads, sources, 1, dispatch_count)
+                     <<std::setw(16)<<dispatch_rate(threads, sources, batch, dispatch_count)<<std::endl;
+        }
+    }
+
     exit(0);
 }
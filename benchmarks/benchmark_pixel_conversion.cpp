@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/server/scene/pixel_conversion.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+namespace ms = mir::scene;
+
+typedef void (*Converter)(uint32_t const* src, uint32_t* dst, size_t count);
+
+// Milliseconds per frame to convert a width x height frame, row by row as GLPixelBuffer does
+double frame_time(Converter convert, int width, int height, int frames)
+{
+    std::vector<uint32_t> src(size_t(width) * height);
+    std::iota(src.begin(), src.end(), 0);
+    std::vector<uint32_t> dst(src.size());
+
+    auto const start = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        for (int row = 0; row < height; ++row)
+            convert(&src[size_t(height - row - 1) * width], &dst[size_t(row) * width], width);
+    }
+
+    std::chrono::duration<double, std::milli> const duration = std::chrono::steady_clock::now() - start;
+
+    return duration.count() / frames;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <frames>"<<std::endl;
+        std::cout<<"Reports milliseconds per frame to y-flip and convert RGBA readback to ARGB"<<std::endl;
+        exit(1);
+    }
+
+    int const frames = std::atoi(argv[1]);
+
+    struct { int width, height; } const sizes[] = {{640, 480}, {1920, 1080}, {3840, 2160}};
+
+    std::cout<<std::setw(12)<<"size"<<std::setw(12)<<"scalar ms"<<std::setw(12)<<"vector ms"<<std::endl;
+
+    for (auto const& size : sizes)
+    {
+        std::cout<<std::setw(6)<<size.width<<"x"<<std::setw(5)<<std::left<<size.height<<std::right
+                 <<std::setw(12)<<std::fixed<<std::setprecision(2)
+                 <<frame_time(&ms::detail::abgr_to_argb_scalar, size.width, size.height, frames)
+                 <<std::setw(12)<<frame_time(&ms::abgr_to_argb, size.width, size.height, frames)<<std::endl;
+    }
+
+    exit(0);
+}
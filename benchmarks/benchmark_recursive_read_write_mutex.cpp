@@ -0,0 +1,191 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mir/recursive_read_write_mutex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+/// The mutex and condition variable design RecursiveReadWriteMutex used to have, for comparison
+class SingleMutexReadWriteMutex
+{
+public:
+    void read_lock()
+    {
+        auto const my_id = std::this_thread::get_id();
+
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        cv.wait(lock, [&]{ return !write_count || write_locking_thread == my_id; });
+
+        auto const my_count = std::find_if(
+            read_locking_threads.begin(),
+            read_locking_threads.end(),
+            [my_id](ThreadLockCount const& candidate) { return my_id == candidate.id; });
+
+        if (my_count == read_locking_threads.end())
+            read_locking_threads.push_back(ThreadLockCount{my_id, 1U});
+        else
+            ++(my_count->count);
+    }
+
+    void read_unlock()
+    {
+        auto const my_id = std::this_thread::get_id();
+
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        auto const my_count = std::find_if(
+            read_locking_threads.begin(),
+            read_locking_threads.end(),
+            [my_id](ThreadLockCount const& candidate) { return my_id == candidate.id; });
+
+        --(my_count->count);
+        cv.notify_all();
+    }
+
+    void write_lock()
+    {
+        auto const my_id = std::this_thread::get_id();
+
+        std::unique_lock<decltype(mutex)> lock{mutex};
+        cv.wait(lock, [&]
+            {
+                if (write_count && write_locking_thread != my_id) return false;
+                for (auto const& candidate : read_locking_threads)
+                {
+                    if (candidate.id != my_id && candidate.count != 0) return false;
+                }
+                return true;
+            });
+
+        ++write_count;
+        write_locking_thread = my_id;
+    }
+
+    void write_unlock()
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        --write_count;
+        cv.notify_all();
+    }
+
+private:
+    struct ThreadLockCount
+    {
+        std::thread::id id;
+        unsigned int count;
+    };
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread::id write_locking_thread;
+    unsigned int write_count{0};
+    std::vector<ThreadLockCount> read_locking_threads;
+};
+
+// Read locks per second with reader_count threads each taking lock_count
+// (singly nested) read locks, and optionally a writer taking the lock once a millisecond
+template<typename Mutex>
+double read_lock_rate(int reader_count, long lock_count, bool with_writer)
+{
+    Mutex mutex;
+    std::atomic<int> readers_running{reader_count};
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < reader_count; ++i)
+    {
+        readers.emplace_back([&mutex, &readers_running, lock_count]
+        {
+            for (long j = 0; j < lock_count; ++j)
+            {
+                mutex.read_lock();
+                mutex.read_lock();
+                mutex.read_unlock();
+                mutex.read_unlock();
+            }
+            --readers_running;
+        });
+    }
+
+    std::thread writer;
+    if (with_writer)
+    {
+        writer = std::thread{[&mutex, &readers_running]
+        {
+            while (readers_running)
+            {
+                mutex.write_lock();
+                mutex.write_unlock();
+                std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            }
+        }};
+    }
+
+    for (auto& thread : readers)
+    {
+        thread.join();
+    }
+
+    std::chrono::duration<double> const duration = std::chrono::steady_clock::now() - start;
+
+    if (writer.joinable())
+        writer.join();
+
+    return 2 * reader_count * lock_count / duration.count();
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <max number of reader threads> <read locks per thread>"<<std::endl;
+        std::cout<<"Reports read locks per second, for powers of two up to the maximum number of readers,"<<std::endl;
+        std::cout<<"for the previous single mutex design and for RecursiveReadWriteMutex, without and with a writer"<<std::endl;
+        exit(1);
+    }
+
+    int const max_reader_count = std::atoi(argv[1]);
+    long const lock_count = std::atol(argv[2]);
+
+    std::cout<<std::setw(8)<<"readers"
+             <<std::setw(16)<<"single/s"<<std::setw(16)<<"slotted/s"
+             <<std::setw(16)<<"single+w/s"<<std::setw(16)<<"slotted+w/s"<<std::endl;
+
+    for (int readers = 1; readers <= max_reader_count; readers *= 2)
+    {
+        std::cout<<std::setw(8)<<readers
+                 <<std::setw(16)<<std::fixed<<std::setprecision(0)
+                 <<read_lock_rate<SingleMutexReadWriteMutex>(readers, lock_count, false)
+                 <<std::setw(16)<<read_lock_rate<mir::RecursiveReadWriteMutex>(readers, lock_count, false)
+                 <<std::setw(16)<<read_lock_rate<SingleMutexReadWriteMutex>(readers, lock_count, true)
+                 <<std::setw(16)<<read_lock_rate<mir::RecursiveReadWriteMutex>(readers, lock_count, true)<<std::endl;
+    }
+
+    exit(0);
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/surface_stack.h"
+#include "src/server/report/null_report_factory.h"
+
+#include "mir/compositor/scene_element.h"
+#include "mir/test/doubles/stub_surface.h"
+#include "mir/test/doubles/stub_renderable.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace ms = mir::scene;
+namespace mr = mir::report;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+class BenchmarkSurface : public mtd::StubSurface
+{
+public:
+    bool visible() const override
+    {
+        return true;
+    }
+
+    mg::RenderableList generate_renderables(mc::CompositorID) const override
+    {
+        return {renderable};
+    }
+
+    int buffers_ready_for_compositor(void const*) const override
+    {
+        return 1;
+    }
+
+private:
+    std::shared_ptr<mg::Renderable> const renderable = std::make_shared<mtd::StubRenderable>();
+};
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4)
+    {
+        std::cout<<"Usage: "<<argv[0]<<" <number of surfaces> <number of outputs> <frames per output>"<<std::endl;
+        exit(1);
+    }
+
+    int const surface_count = std::atoi(argv[1]);
+    int const output_count = std::atoi(argv[2]);
+    int const frame_count = std::atoi(argv[3]);
+
+    ms::SurfaceStack stack{mr::null_scene_report()};
+
+    std::vector<std::shared_ptr<ms::Surface>> surfaces;
+    for (int i = 0; i < surface_count; ++i)
+    {
+        surfaces.push_back(std::make_shared<BenchmarkSurface>());
+        stack.add_surface(surfaces.back(), mir::input::InputReceptionMode::normal);
+    }
+
+    // One compositor thread per output, as with the multi-threaded compositor
+    std::vector<int> const compositor_ids(output_count);
+    for (auto const& id : compositor_ids)
+        stack.register_compositor(&id);
+
+    // Meanwhile the shell keeps restacking surfaces
+    std::atomic<bool> compositing{true};
+    std::thread shell{[&]
+        {
+            for (size_t i = 0; compositing; ++i)
+                stack.raise(surfaces[i % surfaces.size()]);
+        }};
+
+    auto const start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> compositors;
+    for (auto const& id : compositor_ids)
+    {
+        compositors.emplace_back([&stack, &id, frame_count]
+            {
+                for (int frame = 0; frame < frame_count; ++frame)
+                {
+                    if (stack.frames_pending(&id) == 0)
+                        continue;
+
+                    for (auto const& element : stack.scene_elements_for(&id))
+                        element->rendered();
+                }
+            });
+    }
+
+    for (auto& compositor : compositors)
+        compositor.join();
+
+    auto const duration = std::chrono::steady_clock::now() - start;
+
+    compositing = false;
+    shell.join();
+
+    for (auto const& id : compositor_ids)
+        stack.unregister_compositor(&id);
+
+    std::cout<<"Compositing "<<frame_count<<" frames of "<<surface_count<<" surfaces on "<<output_count
+             <<" outputs took "<<std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / frame_count
+             <<"ns per frame"<<std::endl;
+    exit(0);
+}
@@ -65,6 +65,11 @@ struct StubDisplaySyncGroup : mg::DisplaySyncGroup
     {
         return std::chrono::milliseconds::zero();
     }
+
+    std::experimental::optional<mg::Frame> next_vblank() const override
+    {
+        return {};
+    }
     
     double const vsync_rate_in_hz;
 
@@ -22,6 +22,7 @@
 #include "mir/dispatch/dispatchable.h"
 #include "mir/posix_rw_mutex.h"
 
+#include <atomic>
 #include <functional>
 #include <initializer_list>
 #include <list>
@@ -53,8 +54,21 @@ enum class DispatchReentrancy
 class MultiplexingDispatchable final : public Dispatchable
 {
 public:
+    /// Upper bound on max_events_per_dispatch
+    static int const max_dispatch_batch = 32;
+
     MultiplexingDispatchable();
     MultiplexingDispatchable(std::initializer_list<std::shared_ptr<Dispatchable>> dispatchees);
+    /**
+     * \brief Create a multiplexer that dispatches several ready dispatchees per dispatch()
+     * \param [in] max_events_per_dispatch  How many ready dispatchees a single dispatch()
+     *                                      may harvest and dispatch (in the order the kernel
+     *                                      reports them). Between 1 and max_dispatch_batch.
+     * \note  Batching saves a wakeup and epoll_wait() per ready dispatchee, but a batch
+     *        is dispatched on a single thread, so it suits multiplexers with few
+     *        dispatching threads.
+     */
+    explicit MultiplexingDispatchable(int max_events_per_dispatch);
     virtual ~MultiplexingDispatchable() noexcept;
 
     MultiplexingDispatchable& operator=(MultiplexingDispatchable const&) = delete;
@@ -95,8 +109,14 @@ public:
      */
     void remove_watch(Fd const& fd);
 private:
+    bool is_watched(std::shared_ptr<Dispatchable> const& dispatchee);
+
+    int const max_events_per_dispatch;
+
     PosixRWMutex lifetime_mutex;
     std::list<std::pair<std::shared_ptr<Dispatchable>, bool>> dispatchee_holder;
+    // Bumped on every removal so a batch can notice a dispatchee it harvested was removed
+    std::atomic<unsigned> removals{0};
 
     Fd epoll_fd;
 };
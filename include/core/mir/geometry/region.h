@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GEOMETRY_REGION_H_
+#define MIR_GEOMETRY_REGION_H_
+
+#include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
+
+#include <vector>
+#include <initializer_list>
+#include <iosfwd>
+
+namespace mir
+{
+namespace geometry
+{
+
+/**
+ * An arbitrary set of points, supporting union, intersection and subtraction.
+ *
+ * The points are held as non-overlapping rectangles sorted into horizontal
+ * bands (top to bottom, then left to right). Adjacent rectangles are merged
+ * so that equal regions always have the same representation.
+ */
+class Region
+{
+public:
+    Region();
+    Region(Rectangle const& rect);
+    Region(std::initializer_list<Rectangle> const& rects);
+    /* We want to keep implicit copy and move methods */
+
+    bool empty() const;
+    bool contains(Point const& point) const;
+    /// Whether every point of rect is in the region (trivially true if rect is empty)
+    bool contains(Rectangle const& rect) const;
+    Rectangle bounding_rectangle() const;
+
+    void unite(Region const& other);
+    void intersect(Region const& other);
+    void subtract(Region const& other);
+    void translate(Displacement const& displacement);
+    void clear();
+
+    typedef std::vector<Rectangle>::const_iterator const_iterator;
+    typedef std::vector<Rectangle>::size_type size_type;
+    const_iterator begin() const;
+    const_iterator end() const;
+    size_type size() const;
+
+    bool operator==(Region const& other) const;
+    bool operator!=(Region const& other) const;
+
+private:
+    std::vector<Rectangle> rectangles;
+};
+
+std::ostream& operator<<(std::ostream& out, Region const& value);
+
+}
+}
+
+#endif /* MIR_GEOMETRY_REGION_H_ */
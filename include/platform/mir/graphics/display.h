@@ -23,6 +23,7 @@
 #include <memory>
 #include <functional>
 #include <chrono>
+#include <experimental/optional>
 
 namespace mir
 {
@@ -86,6 +87,14 @@ public:
      */
     virtual std::chrono::milliseconds recommended_sleep() const = 0;
 
+    /**
+     * Predicts the next vblank: the earliest frame on which content posted
+     * now could be displayed. When this is known the compositor can sample
+     * the scene just in time to render and post() before it, in preference
+     * to recommended_sleep(). If unsure just return nullopt.
+     */
+    virtual std::experimental::optional<Frame> next_vblank() const = 0;
+
     virtual ~DisplaySyncGroup() = default;
 protected:
     DisplaySyncGroup() = default;
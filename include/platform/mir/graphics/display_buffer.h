@@ -68,6 +68,26 @@ public:
     **/
     virtual bool overlay(RenderableList const& renderlist) = 0;
 
+    /** Like overlay(), but the hardware may take over only part of the list.
+     *  \param [in] renderlist
+     *      The renderables that should appear on the screen.
+     *  \param [out] to_render
+     *      The renderables (in the same order) that the caller must still
+     *      render using a graphics library. Only meaningful if this returns
+     *      false; the rest will be shown by the hardware on post().
+     *  \returns
+     *      True if the hardware can (and has) fully composite/overlay the list;
+     *      False if the caller should render to_render another way.
+    **/
+    virtual bool overlay_where_possible(RenderableList const& renderlist, RenderableList& to_render)
+    {
+        if (overlay(renderlist))
+            return true;
+
+        to_render = renderlist;
+        return false;
+    }
+
     /**
      * Returns a transformation that the renderer must apply to all rendering.
      * There is usually no transformation required (just the identity matrix)
@@ -37,6 +37,8 @@ public:
     virtual void report_successful_display_construction() = 0;
     virtual void report_egl_configuration(EGLDisplay disp, EGLConfig cfg) = 0;
     virtual void report_vsync(unsigned int output_id, Frame const& f) = 0;
+    /* cursor positions that were superseded before reaching the hardware */
+    virtual void report_cursor_moves_coalesced(unsigned int /*moves*/) {}
 
     /* gbm specific */
     virtual void report_successful_drm_mode_set_crtc_on_construction() = 0;
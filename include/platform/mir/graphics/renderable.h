@@ -20,7 +20,10 @@
 #define MIR_GRAPHICS_RENDERABLE_H_
 
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
+#include <mir/geometry/region.h>
 #include <glm/glm.hpp>
+#include <experimental/optional>
 #include <memory>
 #include <vector>
 
@@ -71,6 +74,25 @@ public:
     virtual bool shaped() const = 0;  // meaning the pixel format has alpha
 
     virtual unsigned int swap_interval() const = 0;
+
+    /**
+     * Return the regions of buffer() (in buffer coordinates) whose contents
+     * may differ from the buffer previously rendered for this renderable
+     * by the same compositor.
+     *
+     * An empty collection means the contents are unchanged. nullopt means
+     * the renderable doesn't track damage, in which case any change of
+     * buffer()->id() must be assumed to damage the whole renderable.
+     */
+    virtual std::experimental::optional<geometry::Rectangles> buffer_damage() const = 0;
+
+    /**
+     * Return the parts of screen_position() the client has declared to be
+     * fully opaque, even though shaped() means the rest may not be. This
+     * is only meaningful when alpha() is 1 and transformation() is the
+     * identity. An empty region means nothing is known to be opaque.
+     */
+    virtual geometry::Region opaque_region() const { return {}; }
 protected:
     Renderable() = default;
     Renderable(Renderable const&) = delete;
@@ -20,9 +20,11 @@
 #define MIR_RENDERER_RENDERER_H_
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/graphics/renderable.h"
 #include "mir_toolkit/common.h"
 #include <glm/glm.hpp>
+#include <cstddef>
 
 namespace mir
 {
@@ -39,6 +41,25 @@ public:
     virtual void render(graphics::RenderableList const&) const = 0;
     virtual void suspend() = 0; // called when render() is skipped
 
+    /**
+     * How many frames ago the buffer the next render() draws into was last
+     * rendered, or zero if its contents are undefined.
+     */
+    virtual unsigned int buffer_age() const = 0;
+
+    /**
+     * Limits the next render() to the given regions (in the coordinates of
+     * set_viewport()). Outside them the buffer is left as it was
+     * buffer_age() frames ago. Without this render() redraws everything.
+     */
+    virtual void set_damage(geometry::Rectangles const& damage) = 0;
+
+    /**
+     * The number of bytes of pixel data the last render() copied into
+     * textures, or 0 if the renderer doesn't count them.
+     */
+    virtual std::size_t bytes_uploaded() const { return 0; }
+
 protected:
     Renderer() = default;
     Renderer(const Renderer&) = delete;
@@ -19,6 +19,13 @@
 #ifndef MIR_RENDERER_GL_TEXTURE_SOURCE_H_
 #define MIR_RENDERER_GL_TEXTURE_SOURCE_H_
 
+#include <cstddef>
+
+namespace mir
+{
+namespace geometry { class Rectangles; }
+}
+
 namespace mir
 {
 namespace renderer
@@ -49,6 +56,25 @@ protected:
     TextureSource& operator=(TextureSource const&) = delete;
 };
 
+//Optionally implemented alongside TextureSource by buffers that can update
+//a texture's existing storage in place rather than reallocating it.
+class DamagedTextureSource
+{
+public:
+    virtual ~DamagedTextureSource() = default;
+
+    //Uploads only the damaged regions (in buffer coordinates). The bound
+    //texture must already hold an earlier buffer of the same size and format;
+    //everything outside the damage is assumed unchanged since then.
+    //Returns the number of bytes uploaded.
+    virtual std::size_t bind_damaged(geometry::Rectangles const& damage) = 0;
+
+protected:
+    DamagedTextureSource() = default;
+    DamagedTextureSource(DamagedTextureSource const&) = delete;
+    DamagedTextureSource& operator=(DamagedTextureSource const&) = delete;
+};
+
 }
 }
 }
@@ -20,6 +20,7 @@
 #define MIR_COMPOSITOR_COMPOSITOR_REPORT_H_
 
 #include "mir/graphics/renderable.h"
+#include <cstddef>
 
 namespace mir
 {
@@ -34,10 +35,13 @@ public:
     virtual void began_frame(SubCompositorId id) = 0;
     virtual void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) = 0;
     virtual void rendered_frame(SubCompositorId id) = 0;
+    virtual void uploaded_textures(SubCompositorId /*id*/, std::size_t /*bytes*/) {}
     virtual void finished_frame(SubCompositorId id) = 0;
     virtual void started() = 0;
     virtual void stopped() = 0;
     virtual void scheduled() = 0;
+    /// A scene change didn't touch the display, so it wasn't recomposited
+    virtual void skipped_wakeup(SubCompositorId /*id*/) {}
 protected:
     CompositorReport() = default;
     virtual ~CompositorReport() = default;
@@ -22,6 +22,8 @@
 #include <mir_toolkit/common.h>
 #include "mir/graphics/buffer_id.h"
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/geometry/region.h"
 #include <functional>
 #include <memory>
 
@@ -42,6 +44,14 @@ public:
     virtual ~BufferStream() = default;
     
     virtual void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) = 0;
+    /**
+     * As submit_buffer(), but with the client promising that only the
+     * damaged regions (in buffer coordinates) differ from the previously
+     * submitted buffer.
+     */
+    virtual void submit_damaged_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Rectangles const& damage) = 0;
     virtual void resize(geometry::Size const& size) = 0;
 
     virtual void set_frame_posted_callback(
@@ -56,6 +66,12 @@ public:
     //      side once we only support the NBS system.
     virtual void allow_framedropping(bool) = 0;
     virtual void set_scale(float scale) = 0;
+    /**
+     * The region (in buffer coordinates) the client promises will be fully
+     * opaque in the buffers it submits, for occlusion purposes. Streams
+     * that don't take part in occlusion may ignore it.
+     */
+    virtual void set_opaque_region(geometry::Region const& /*region*/) {}
 protected:
     BufferStream() = default;
     BufferStream(BufferStream const&) = delete;
@@ -48,6 +48,8 @@ class Surface
 public:
     virtual std::string name() const = 0;
     virtual geometry::Rectangle input_bounds() const = 0;
+    /// Contains every point for which input_area_contains() can be true
+    virtual geometry::Rectangle input_extents() const { return input_bounds(); }
     virtual bool input_area_contains(geometry::Point const& point) const = 0;
     virtual std::shared_ptr<graphics::CursorImage> cursor_image() const = 0;
     virtual InputReceptionMode reception_mode() const = 0;
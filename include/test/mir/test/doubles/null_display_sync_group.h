@@ -60,6 +60,11 @@ public:
         return std::chrono::milliseconds::zero();
     }
 
+    std::experimental::optional<graphics::Frame> next_vblank() const override
+    {
+        return {};
+    }
+
 private:
     std::vector<geometry::Rectangle> const output_rects;
     std::vector<StubDisplayBuffer> display_buffers;
@@ -82,6 +87,11 @@ struct NullDisplaySyncGroup : graphics::DisplaySyncGroup
         return std::chrono::milliseconds::zero();
     }
 
+    std::experimental::optional<graphics::Frame> next_vblank() const override
+    {
+        return {};
+    }
+
     NullDisplayBuffer db;
 };
 
@@ -343,15 +343,13 @@ mir::EventUPtr mev::make_event(mf::SurfaceId const& surface_id, MirInputDeviceId
     auto e = new_event<MirKeymapEvent>();
     auto ep = make_uptr_event(e);
 
-    auto ctx = mi::make_unique_context();
-    auto map = mi::make_unique_keymap(ctx.get(), mi::Keymap{model, layout, variant, options});
+    auto map = mi::make_shared_keymap(mi::Keymap{model, layout, variant, options});
 
     if (!map.get())
         BOOST_THROW_EXCEPTION(std::runtime_error("failed to assemble keymap from given parameters"));
 
     e->set_surface_id(surface_id.as_value());
     e->set_device_id(id);
-    // TODO consider caching compiled keymaps
     auto buffer = xkb_keymap_get_as_string(map.get(), XKB_KEYMAP_FORMAT_TEXT_V1);
     e->set_buffer(buffer);
     std::free(buffer);
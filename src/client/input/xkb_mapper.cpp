@@ -114,9 +114,55 @@ mi::XKBComposeTablePtr make_unique_compose_table_from_locale(mi::XKBContextPtr c
            &xkb_compose_table_unref};
 }
 
-mi::XKBStatePtr make_unique_state(xkb_keymap* keymap)
+/**
+ * The keymaps from make_shared_keymap(), keyed by their names or text.
+ *
+ * Each keymap is compiled in a context of its own, as xkbcommon contexts
+ * aren't thread safe; the mutex guards the unsynchronised reference counts of
+ * the keymaps (and their contexts) as states come and go.
+ */
+struct KeymapCache
+{
+    std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<xkb_keymap>> keymaps;
+
+    template<typename Compile>
+    std::shared_ptr<xkb_keymap> find_or_compile(std::string const& key, Compile const& compile)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        auto& cached = keymaps[key];
+        if (auto const keymap = cached.lock())
+            return keymap;
+
+        auto const keymap = compile(mi::make_unique_context().get());
+        if (!keymap)
+        {
+            keymaps.erase(key);
+            return nullptr;
+        }
+
+        std::shared_ptr<xkb_keymap> const shared{keymap, [this](xkb_keymap* keymap) { release(keymap); }};
+        cached = shared;
+        return shared;
+    }
+
+    void release(xkb_keymap* keymap)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        xkb_keymap_unref(keymap);
+
+        for (auto i = begin(keymaps); i != end(keymaps);)
+            i = i->second.expired() ? keymaps.erase(i) : std::next(i);
+    }
+};
+
+KeymapCache& keymap_cache()
 {
-    return {xkb_state_new(keymap), xkb_state_unref};
+    // Never destroyed, as keymaps may be released during static destruction
+    static auto const cache = new KeymapCache;
+    return *cache;
 }
 }
 
@@ -153,6 +199,58 @@ mi::XKBKeymapPtr mi::make_unique_keymap(xkb_context* context, char const* buffer
     return {keymap_ptr, &xkb_keymap_unref};
 }
 
+std::shared_ptr<xkb_keymap> mi::make_shared_keymap(mi::Keymap const& map)
+{
+    auto const key = "names:" + map.model + '\0' + map.layout + '\0' + map.variant + '\0' + map.options;
+
+    auto keymap = keymap_cache().find_or_compile(key, [&](xkb_context* context)
+        {
+            xkb_rule_names keymap_names
+            {
+                "evdev",
+                map.model.c_str(),
+                map.layout.c_str(),
+                map.variant.c_str(),
+                map.options.c_str()
+            };
+            return xkb_keymap_new_from_names(context, &keymap_names, xkb_keymap_compile_flags(0));
+        });
+
+    if (!keymap)
+    {
+        std::stringstream error;
+        error << "Illegal keymap configuration evdev-" << map;
+        BOOST_THROW_EXCEPTION(std::invalid_argument(error.str().c_str()));
+    }
+    return keymap;
+}
+
+std::shared_ptr<xkb_keymap> mi::make_shared_keymap(char const* buffer, size_t size)
+{
+    auto const key = "text:" + std::string{buffer, size};
+
+    auto keymap = keymap_cache().find_or_compile(key, [&](xkb_context* context)
+        {
+            return xkb_keymap_new_from_buffer(context, buffer, size, XKB_KEYMAP_FORMAT_TEXT_V1, xkb_keymap_compile_flags(0));
+        });
+
+    if (!keymap)
+        BOOST_THROW_EXCEPTION(std::runtime_error("failed to create keymap from buffer."));
+
+    return keymap;
+}
+
+mi::XKBStatePtr mi::make_unique_state(xkb_keymap* keymap)
+{
+    std::lock_guard<std::mutex> lock{keymap_cache().mutex};
+
+    return {xkb_state_new(keymap), [](xkb_state* state)
+        {
+            std::lock_guard<std::mutex> lock{keymap_cache().mutex};
+            xkb_state_unref(state);
+        }};
+}
+
 mircv::XKBMapper::XKBMapper() :
     context{make_unique_context()},
     compose_table{make_unique_compose_table_from_locale(context, get_locale_from_environment())}
@@ -235,39 +333,39 @@ mircv::XKBMapper::XkbMappingState* mircv::XKBMapper::get_keymapping_state(MirInp
 
 void mircv::XKBMapper::set_keymap_for_all_devices(Keymap const& new_keymap)
 {
-    set_keymap(make_unique_keymap(context.get(), new_keymap));
+    set_keymap(make_shared_keymap(new_keymap));
 }
 
 void mircv::XKBMapper::set_keymap_for_all_devices(char const* buffer, size_t len)
 {
-    set_keymap(make_unique_keymap(context.get(), buffer, len));
+    set_keymap(make_shared_keymap(buffer, len));
 }
 
-void mircv::XKBMapper::set_keymap(XKBKeymapPtr new_keymap)
+void mircv::XKBMapper::set_keymap(std::shared_ptr<xkb_keymap> const& new_keymap)
 {
     std::lock_guard<std::mutex> lg(guard);
-    default_keymap = std::move(new_keymap);
+    default_keymap = new_keymap;
     device_mapping.clear();
 }
 
 void mircv::XKBMapper::set_keymap_for_device(MirInputDeviceId id, Keymap const& new_keymap)
 {
-    set_keymap(id, make_unique_keymap(context.get(), new_keymap));
+    set_keymap(id, make_shared_keymap(new_keymap));
 }
 
 void mircv::XKBMapper::set_keymap_for_device(MirInputDeviceId id, char const* buffer, size_t len)
 {
-    set_keymap(id, make_unique_keymap(context.get(), buffer, len));
+    set_keymap(id, make_shared_keymap(buffer, len));
 }
 
-void mircv::XKBMapper::set_keymap(MirInputDeviceId id, XKBKeymapPtr new_keymap)
+void mircv::XKBMapper::set_keymap(MirInputDeviceId id, std::shared_ptr<xkb_keymap> const& new_keymap)
 {
     std::lock_guard<std::mutex> lg(guard);
 
     device_mapping.erase(id);
     device_mapping.emplace(std::piecewise_construct,
                            std::forward_as_tuple(id),
-                           std::forward_as_tuple(std::make_unique<XkbMappingState>(std::move(new_keymap))));
+                           std::forward_as_tuple(std::make_unique<XkbMappingState>(new_keymap)));
 }
 
 void mircv::XKBMapper::clear_all_keymaps()
@@ -32,6 +32,15 @@ namespace mcll = mir::client::logging;
 namespace
 {
 std::string const component{"rpc"};
+
+// Invocations are sent by opcode once the server has supplied its method table
+std::string method_of(mir::protobuf::wire::Invocation const& invocation)
+{
+    if (invocation.has_method_opcode())
+        return "#" + std::to_string(invocation.method_opcode());
+
+    return invocation.method_name();
+}
 }
 
 mcll::RpcReport::RpcReport(std::shared_ptr<ml::Logger> const& logger)
@@ -44,7 +53,7 @@ void mcll::RpcReport::invocation_requested(
 {
     std::stringstream ss;
     ss << "Invocation request: id: " << invocation.id()
-       << " method_name: " << invocation.method_name();
+       << " method_name: " << method_of(invocation);
 
     logger->log(ml::Severity::debug, ss.str(), component);
 }
@@ -54,7 +63,7 @@ void mcll::RpcReport::invocation_succeeded(
 {
     std::stringstream ss;
     ss << "Invocation succeeded: id: " << invocation.id()
-       << " method_name: " << invocation.method_name();
+       << " method_name: " << method_of(invocation);
 
     logger->log(ml::Severity::debug, ss.str(), component);
 }
@@ -65,7 +74,7 @@ void mcll::RpcReport::invocation_failed(
 {
     std::stringstream ss;
     ss << "Invocation failed: id: " << invocation.id()
-       << " method_name: " << invocation.method_name()
+       << " method_name: " << method_of(invocation)
        << " error: " << boost::diagnostic_information(ex);
 
     logger->log(ml::Severity::error, ss.str(), component);
@@ -27,18 +27,30 @@
 
 namespace mcl = mir::client;
 
+namespace
+{
+// Invocations are sent by opcode once the server has supplied its method table
+std::string method_of(mir::protobuf::wire::Invocation const& invocation)
+{
+    if (invocation.has_method_opcode())
+        return "#" + std::to_string(invocation.method_opcode());
+
+    return invocation.method_name();
+}
+}
+
 void mcl::lttng::RpcReport::invocation_requested(
     mir::protobuf::wire::Invocation const& invocation)
 {
     mir_tracepoint(mir_client_rpc, invocation_requested,
-                   invocation.id(), invocation.method_name().c_str());
+                   invocation.id(), method_of(invocation).c_str());
 }
 
 void mcl::lttng::RpcReport::invocation_succeeded(
     mir::protobuf::wire::Invocation const& invocation)
 {
     mir_tracepoint(mir_client_rpc, invocation_succeeded,
-                   invocation.id(), invocation.method_name().c_str());
+                   invocation.id(), method_of(invocation).c_str());
 }
 
 void mcl::lttng::RpcReport::invocation_failed(
@@ -157,7 +157,16 @@ mir::protobuf::wire::Invocation mclr::MirBasicRpcChannel::invocation_for(
     mir::protobuf::wire::Invocation invoke;
 
     invoke.set_id(next_id());
-    invoke.set_method_name(method_name);
+
+    {
+        std::lock_guard<decltype(method_opcodes_mutex)> lock{method_opcodes_mutex};
+        auto const opcode = method_opcodes.find(method_name);
+        if (opcode != method_opcodes.end())
+            invoke.set_method_opcode(opcode->second);
+        else
+            invoke.set_method_name(method_name);
+    }
+
     invoke.set_parameters(buffer.data(), buffer.size());
     invoke.set_protocol_version(protocol_version);
     invoke.set_side_channel_fds(num_side_channel_fds);
@@ -165,6 +174,15 @@ mir::protobuf::wire::Invocation mclr::MirBasicRpcChannel::invocation_for(
     return invoke;
 }
 
+void mclr::MirBasicRpcChannel::use_method_opcodes_from(mir::protobuf::Connection const& connection)
+{
+    std::lock_guard<decltype(method_opcodes_mutex)> lock{method_opcodes_mutex};
+
+    method_opcodes.clear();
+    for (int opcode = 0; opcode != connection.method_opcode_size(); ++opcode)
+        method_opcodes[connection.method_opcode(opcode)] = opcode;
+}
+
 int mclr::MirBasicRpcChannel::next_id()
 {
     return next_message_id.fetch_add(1);
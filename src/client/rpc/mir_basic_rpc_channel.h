@@ -26,6 +26,8 @@
 #include <vector>
 #include <condition_variable>
 #include <functional>
+#include <string>
+#include <unordered_map>
 
 namespace google
 {
@@ -40,6 +42,8 @@ namespace mir
 {
 namespace protobuf
 {
+class Connection;
+
 namespace wire
 {
 class Invocation;
@@ -127,9 +131,15 @@ protected:
         size_t num_side_channel_fds);
     int next_id();
 
+    /// Invoke the methods in the server's table by opcode rather than by name
+    void use_method_opcodes_from(mir::protobuf::Connection const& connection);
+
 private:
     std::atomic<int> next_message_id;
     int const protocol_version;
+
+    std::mutex method_opcodes_mutex;
+    std::unordered_map<std::string, uint32_t> method_opcodes;
 };
 
 }
@@ -176,6 +176,10 @@ void mclr::MirProtobufRpcChannel::receive_file_descriptors(google::protobuf::Mes
         auto connection = static_cast<mir::protobuf::Connection*>(response);
         if (connection && connection->has_platform())
             platform = connection->mutable_platform();
+
+        // Servers that can dispatch by opcode tell us so in their reply to connect
+        if (connection)
+            use_method_opcodes_from(*connection);
     }
     else if (message_type == "mir.protobuf.SocketFD")
     {
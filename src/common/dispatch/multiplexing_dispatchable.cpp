@@ -30,7 +30,9 @@
 #include <unistd.h>
 #include <string.h>
 #include <system_error>
+#include <stdexcept>
 #include <algorithm>
+#include <array>
 
 namespace md = mir::dispatch;
 
@@ -72,9 +74,20 @@ private:
 }
 
 md::MultiplexingDispatchable::MultiplexingDispatchable()
-    : lifetime_mutex{PosixRWMutex::Type::PreferWriterNonRecursive},
+    : MultiplexingDispatchable(1)
+{
+}
+
+md::MultiplexingDispatchable::MultiplexingDispatchable(int max_events_per_dispatch)
+    : max_events_per_dispatch{max_events_per_dispatch},
+      lifetime_mutex{PosixRWMutex::Type::PreferWriterNonRecursive},
       epoll_fd{mir::Fd{::epoll_create1(EPOLL_CLOEXEC)}}
 {
+    if (max_events_per_dispatch < 1 || max_events_per_dispatch > max_dispatch_batch)
+    {
+        BOOST_THROW_EXCEPTION((std::invalid_argument{"Invalid number of events per dispatch"}));
+    }
+
     if (epoll_fd == mir::Fd::invalid)
     {
         BOOST_THROW_EXCEPTION((std::system_error{errno,
@@ -108,48 +121,79 @@ bool md::MultiplexingDispatchable::dispatch(md::FdEvents events)
         return false;
     }
 
-    std::shared_ptr<md::Dispatchable> source;
-    bool rearm_source{false};
-    epoll_event event;
+    std::array<epoll_event, max_dispatch_batch> ready;
+    std::array<std::pair<std::shared_ptr<md::Dispatchable>, bool>, max_dispatch_batch> sources;
+    int ready_count;
+    unsigned removals_seen;
 
     {
         std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
 
-        auto result = epoll_wait(epoll_fd, &event, 1, 0);
+        ready_count = epoll_wait(epoll_fd, ready.data(), max_events_per_dispatch, 0);
 
-        if (result < 0)
+        if (ready_count < 0)
         {
             BOOST_THROW_EXCEPTION((std::system_error{errno,
                                                      std::system_category(),
                                                      "Failed to wait on fds"}));
         }
 
-        if (result == 0)
+        if (ready_count == 0)
         {
             // Some other thread must have stolen the event we were woken for;
             // that's ok, just return.
             return true;
         }
 
-        auto event_source = reinterpret_cast<decltype(dispatchee_holder)::pointer>(event.data.ptr);
+        for (int i = 0; i != ready_count; ++i)
+        {
+            sources[i] = *reinterpret_cast<decltype(dispatchee_holder)::pointer>(ready[i].data.ptr);
+        }
 
-        source = event_source->first;
-        rearm_source = event_source->second;
+        removals_seen = removals.load();
     }
 
-    if (!source->dispatch(epoll_to_fd_event(event)))
-    {
-        remove_watch(source);
-    }
-    else if (rearm_source)
+    for (int i = 0; i != ready_count; ++i)
     {
-        event.events = fd_event_to_epoll(source->relevant_events()) | EPOLLONESHOT;
-        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source->watch_fd(), &event);
+        auto const& source = sources[i].first;
+        auto const rearm_source = sources[i].second;
+
+        // An earlier dispatch in this batch may have removed a later dispatchee;
+        // it mustn't be dispatched after its remove_watch() has returned.
+        if (removals.load() != removals_seen)
+        {
+            removals_seen = removals.load();
+            if (!is_watched(source))
+                continue;
+        }
+
+        if (!source->dispatch(epoll_to_fd_event(ready[i])))
+        {
+            remove_watch(source);
+        }
+        else if (rearm_source)
+        {
+            // epoll has no bulk re-arm, so rather than hold back every dispatchee in the
+            // batch until the last has been dispatched hand each back as soon as it's done.
+            ready[i].events = fd_event_to_epoll(source->relevant_events()) | EPOLLONESHOT;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, source->watch_fd(), &ready[i]);
+        }
     }
 
     return true;
 }
 
+bool md::MultiplexingDispatchable::is_watched(std::shared_ptr<Dispatchable> const& dispatchee)
+{
+    std::shared_lock<decltype(lifetime_mutex)> lock{lifetime_mutex};
+
+    return std::any_of(dispatchee_holder.begin(), dispatchee_holder.end(),
+        [&](std::pair<std::shared_ptr<Dispatchable>, bool> const& candidate)
+        {
+            return candidate.first == dispatchee;
+        });
+}
+
 md::FdEvents md::MultiplexingDispatchable::relevant_events() const
 {
     return md::FdEvent::readable;
@@ -227,4 +271,5 @@ void md::MultiplexingDispatchable::remove_watch(Fd const& fd)
     {
         return candidate.first->watch_fd() == fd;
     });
+    ++removals;
 }
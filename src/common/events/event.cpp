@@ -33,11 +33,37 @@
 #include "mir/events/surface_output_event.h"
 #include "mir/events/input_device_state_event.h"
 #include "mir/events/surface_placement_event.h"
+#include "mir/events/event_pool.h"
 
 #include <capnp/serialize.h>
+#include <kj/io.h>
 
 
 namespace ml = mir::logging;
+namespace mev = mir::events;
+
+MirEvent::FirstSegment::FirstSegment()
+    : segment{static_cast<::capnp::word*>(mev::event_pool::allocate(words * sizeof(::capnp::word)))}
+{
+    static_assert(words * sizeof(::capnp::word) <= mev::event_pool::max_block_size,
+                  "an event's first segment should be recycled by the event pool");
+}
+
+MirEvent::FirstSegment::~FirstSegment()
+{
+    // The MallocMessageBuilder has zeroed what it used, as a first segment must be
+    mev::event_pool::release(segment, words * sizeof(::capnp::word));
+}
+
+void* MirEvent::operator new(std::size_t size)
+{
+    return mev::event_pool::allocate(size);
+}
+
+void MirEvent::operator delete(void* event, std::size_t size)
+{
+    mev::event_pool::release(event, size);
+}
 
 MirEvent::MirEvent(MirEvent const& e)
 {
@@ -75,6 +101,17 @@ std::string MirEvent::serialize(MirEvent const* event)
     return {reinterpret_cast<char*>(flat_event.asBytes().begin()), flat_event.asBytes().size()};
 }
 
+size_t MirEvent::serialized_size(MirEvent const* event)
+{
+    return ::capnp::computeSerializedSizeInWords(const_cast<MirEvent*>(event)->message) * sizeof(::capnp::word);
+}
+
+void MirEvent::serialize_into(MirEvent const* event, char* output)
+{
+    kj::ArrayOutputStream stream{kj::arrayPtr(reinterpret_cast<kj::byte*>(output), serialized_size(event))};
+    ::capnp::writeMessage(stream, const_cast<MirEvent*>(event)->message);
+}
+
 MirEventType MirEvent::type() const
 {
     switch (event.asReader().which())
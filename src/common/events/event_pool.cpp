@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/events/event_pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+namespace mev = mir::events;
+
+namespace
+{
+std::size_t const min_block_size = 64;
+std::size_t const size_classes = 5;     // 64, 128, 256, 512 and 1024 bytes
+static_assert(min_block_size << (size_classes - 1) == mev::event_pool::max_block_size,
+              "size classes must reach max_block_size");
+
+// Each thread keeps up to thread_cache_limit released blocks of each size,
+// moving them to and from the depot transfer_batch at a time.
+std::size_t const thread_cache_limit = 32;
+std::size_t const transfer_batch = 16;
+std::size_t const depot_limit = 1024;
+
+std::size_t size_class_of(std::size_t size)
+{
+    std::size_t size_class = 0;
+    while ((min_block_size << size_class) < size)
+        ++size_class;
+    return size_class;
+}
+
+void* allocate_from_heap(std::size_t size)
+{
+    if (auto const block = std::calloc(1, size))
+        return block;
+
+    throw std::bad_alloc{};
+}
+
+struct FreeList
+{
+    struct Link { Link* next; };
+
+    Link* head = nullptr;
+    std::size_t count = 0;
+
+    void push(void* block)
+    {
+        auto const link = static_cast<Link*>(block);
+        link->next = head;
+        head = link;
+        ++count;
+    }
+
+    void* pop()
+    {
+        auto const link = head;
+        head = link->next;
+        --count;
+        // A block released zero-filled comes back zero-filled
+        link->next = nullptr;
+        return link;
+    }
+
+    std::size_t transfer_to(FreeList& other, std::size_t blocks)
+    {
+        blocks = std::min(blocks, count);
+        for (auto i = blocks; i != 0; --i)
+            other.push(pop());
+        return blocks;
+    }
+};
+
+struct Depot
+{
+    std::mutex mutex;
+    FreeList blocks;
+
+    void take_from(FreeList& list, std::size_t count)
+    {
+        {
+            std::lock_guard<decltype(mutex)> lock{mutex};
+            auto const room = depot_limit - std::min(depot_limit, blocks.count);
+            count -= list.transfer_to(blocks, std::min(count, room));
+        }
+
+        // Anything the depot has no room for goes back to the heap
+        for (; count != 0 && list.count != 0; --count)
+            std::free(list.pop());
+    }
+
+    void give_to(FreeList& list, std::size_t count)
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        blocks.transfer_to(list, count);
+    }
+};
+
+Depot& depot_for(std::size_t size_class)
+{
+    // Never destroyed: threads can still release blocks after static destruction
+    static auto const depots = new Depot[size_classes];
+    return depots[size_class];
+}
+
+thread_local bool thread_cache_destroyed = false;
+
+struct ThreadCache
+{
+    FreeList lists[size_classes];
+
+    ~ThreadCache()
+    {
+        for (std::size_t i = 0; i != size_classes; ++i)
+            depot_for(i).take_from(lists[i], lists[i].count);
+
+        thread_cache_destroyed = true;
+    }
+};
+
+thread_local ThreadCache thread_cache;
+}
+
+void* mev::event_pool::allocate(std::size_t size)
+{
+    if (size > max_block_size)
+        return allocate_from_heap(size);
+
+    auto const size_class = size_class_of(size);
+    auto& depot = depot_for(size_class);
+
+    if (thread_cache_destroyed)
+    {
+        FreeList list;
+        depot.give_to(list, 1);
+        return list.count ? list.pop() : allocate_from_heap(min_block_size << size_class);
+    }
+
+    auto& list = thread_cache.lists[size_class];
+
+    if (!list.count)
+        depot.give_to(list, transfer_batch);
+
+    return list.count ? list.pop() : allocate_from_heap(min_block_size << size_class);
+}
+
+void mev::event_pool::release(void* block, std::size_t size)
+{
+    if (!block)
+        return;
+
+    if (size > max_block_size)
+    {
+        std::free(block);
+        return;
+    }
+
+    auto const size_class = size_class_of(size);
+    auto& depot = depot_for(size_class);
+
+    if (thread_cache_destroyed)
+    {
+        FreeList list;
+        list.push(block);
+        depot.take_from(list, 1);
+        return;
+    }
+
+    auto& list = thread_cache.lists[size_class];
+    list.push(block);
+
+    if (list.count > thread_cache_limit)
+        depot.take_from(list, transfer_batch);
+}
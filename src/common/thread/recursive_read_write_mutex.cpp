@@ -19,69 +19,138 @@
 #include "mir/recursive_read_write_mutex.h"
 
 #include <algorithm>
+#include <vector>
 
-void mir::RecursiveReadWriteMutex::read_lock()
+namespace
 {
-    auto const my_id = std::this_thread::get_id();
+// The read locks a thread holds, with how deeply each is nested
+struct HeldReadLock
+{
+    unsigned long long instance;
+    unsigned int count;
+};
 
-    std::unique_lock<decltype(mutex)> lock{mutex};
-    cv.wait(lock, [&]{
-        return !write_locking_thread.count ||
-            write_locking_thread.id == my_id; });
+thread_local std::vector<HeldReadLock> held_read_locks;
+
+HeldReadLock* find_held_read_lock(unsigned long long instance)
+{
+    auto const held = std::find_if(
+        held_read_locks.begin(),
+        held_read_locks.end(),
+        [instance](HeldReadLock const& candidate) { return candidate.instance == instance; });
 
-    auto const my_count = std::find_if(
-        read_locking_threads.begin(),
-        read_locking_threads.end(),
-        [my_id](ThreadLockCount const& candidate) { return my_id == candidate.id; });
+    return held != held_read_locks.end() ? &*held : nullptr;
+}
 
-    if (my_count == read_locking_threads.end())
+std::atomic<unsigned long long> next_instance{0};
+std::atomic<std::size_t> next_reader_slot{0};
+thread_local std::size_t const thread_reader_slot{next_reader_slot++};
+}
+
+mir::RecursiveReadWriteMutex::RecursiveReadWriteMutex() :
+    instance{next_instance++},
+    writer{false},
+    write_locking_thread{std::thread::id{}},
+    write_count{0},
+    waiting_writers{0}
+{
+    for (auto& slot : readers)
+        slot.count = 0;
+}
+
+void mir::RecursiveReadWriteMutex::read_lock()
+{
+    if (auto const held = find_held_read_lock(instance))
     {
-        read_locking_threads.push_back(ThreadLockCount(my_id, 1U));
+        ++held->count;
+        return;
     }
-    else
+
+    auto& slot = readers[thread_reader_slot % reader_slots].count;
+
+    slot.fetch_add(1);
+
+    // The write locking thread can always read; anyone else waits for writers
+    if (write_locking_thread.load() != std::this_thread::get_id())
     {
-        ++(my_count->count);
+        while (writer.load())
+        {
+            slot.fetch_sub(1);
+
+            std::unique_lock<decltype(mutex)> lock{mutex};
+            cv.notify_all();    // A writer may be waiting for our slot to drain
+            cv.wait(lock, [this]{ return !writer.load(); });
+            lock.unlock();
+
+            slot.fetch_add(1);
+        }
     }
+
+    held_read_locks.push_back(HeldReadLock{instance, 1U});
 }
 
 void mir::RecursiveReadWriteMutex::read_unlock()
 {
-    auto const my_id = std::this_thread::get_id();
+    auto const held = find_held_read_lock(instance);
 
-    std::lock_guard<decltype(mutex)> lock{mutex};
-    auto const my_count = std::find_if(
-        read_locking_threads.begin(),
-        read_locking_threads.end(),
-        [my_id](ThreadLockCount const& candidate) { return my_id == candidate.id; });
+    if (--(held->count))
+        return;
 
-    --(my_count->count);
+    *held = held_read_locks.back();
+    held_read_locks.pop_back();
 
-    cv.notify_all();
+    readers[thread_reader_slot % reader_slots].count.fetch_sub(1);
+
+    if (writer.load())
+    {
+        std::lock_guard<decltype(mutex)> lock{mutex};
+        cv.notify_all();
+    }
 }
 
 void mir::RecursiveReadWriteMutex::write_lock()
 {
     auto const my_id = std::this_thread::get_id();
 
+    if (write_locking_thread.load() == my_id)
+    {
+        ++write_count;
+        return;
+    }
+
+    unsigned int const own_reads = find_held_read_lock(instance) ? 1 : 0;
+
     std::unique_lock<decltype(mutex)> lock{mutex};
+    ++waiting_writers;
+    writer = true;
+
     cv.wait(lock, [&]
         {
-            if (write_locking_thread.count &&
-                write_locking_thread.id != my_id) return false;
-            for (auto const& candidate : read_locking_threads)
-            {
-                if (candidate.id != my_id && candidate.count != 0) return false;
-            }
-            return true;
+            return write_locking_thread.load() == std::thread::id{} &&
+                   !other_readers(own_reads);
         });
 
-    ++write_locking_thread.count;
-    write_locking_thread.id = my_id;
+    --waiting_writers;
+    write_locking_thread = my_id;
+    write_count = 1;
 }
 
 void mir::RecursiveReadWriteMutex::write_unlock()
 {
+    if (--write_count)
+        return;
+
     std::lock_guard<decltype(mutex)> lock{mutex};
-    --write_locking_thread.count;
+    write_locking_thread = std::thread::id{};
+    writer = waiting_writers > 0;
     cv.notify_all();
 }
+
+bool mir::RecursiveReadWriteMutex::other_readers(unsigned int own_reads) const
+{
+    unsigned int total{0};
+    for (auto const& slot : readers)
+        total += slot.count.load();
+
+    return total > own_reads;
+}
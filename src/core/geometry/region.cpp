@@ -0,0 +1,286 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace geom = mir::geometry;
+
+namespace
+{
+struct Span
+{
+    int left;
+    int right; // exclusive
+};
+
+struct Band
+{
+    int top;
+    int bottom; // exclusive
+    std::vector<Span> spans;
+};
+
+bool operator==(Span const& lhs, Span const& rhs)
+{
+    return lhs.left == rhs.left && lhs.right == rhs.right;
+}
+
+std::vector<Band> bands_of(std::vector<geom::Rectangle> const& rects)
+{
+    std::vector<Band> bands;
+
+    for (auto const& rect : rects)
+    {
+        int const top = rect.top_left.y.as_int();
+
+        if (bands.empty() || bands.back().top != top)
+            bands.push_back({top, top + rect.size.height.as_int(), {}});
+
+        int const left = rect.top_left.x.as_int();
+        bands.back().spans.push_back({left, left + rect.size.width.as_int()});
+    }
+
+    return bands;
+}
+
+std::vector<geom::Rectangle> rectangles_of(std::vector<Band> const& bands)
+{
+    std::vector<geom::Rectangle> rects;
+
+    for (auto const& band : bands)
+    {
+        for (auto const& span : band.spans)
+            rects.push_back({{span.left, band.top}, {span.right - span.left, band.bottom - band.top}});
+    }
+
+    return rects;
+}
+
+// The spans of the band (if any) covering the row y. Bands are visited in
+// order, so next tracks where to resume the search.
+std::vector<Span> const& spans_at(int y, std::vector<Band> const& bands, size_t& next)
+{
+    static std::vector<Span> const none;
+
+    while (next < bands.size() && bands[next].bottom <= y)
+        ++next;
+
+    if (next < bands.size() && bands[next].top <= y)
+        return bands[next].spans;
+
+    return none;
+}
+
+template<typename Keep>
+std::vector<Span> combine(std::vector<Span> const& a, std::vector<Span> const& b, Keep keep)
+{
+    std::vector<int> edges;
+    edges.reserve(2 * (a.size() + b.size()));
+    for (auto const& span : a)
+    {
+        edges.push_back(span.left);
+        edges.push_back(span.right);
+    }
+    for (auto const& span : b)
+    {
+        edges.push_back(span.left);
+        edges.push_back(span.right);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    std::vector<Span> result;
+    auto i = a.begin();
+    auto j = b.begin();
+
+    for (size_t e = 0; e + 1 < edges.size(); ++e)
+    {
+        int const left = edges[e];
+        int const right = edges[e + 1];
+
+        while (i != a.end() && i->right <= left) ++i;
+        while (j != b.end() && j->right <= left) ++j;
+
+        bool const in_a = i != a.end() && i->left <= left;
+        bool const in_b = j != b.end() && j->left <= left;
+
+        if (keep(in_a, in_b))
+        {
+            if (!result.empty() && result.back().right == left)
+                result.back().right = right;
+            else
+                result.push_back({left, right});
+        }
+    }
+
+    return result;
+}
+
+template<typename Keep>
+std::vector<geom::Rectangle> combine(
+    std::vector<geom::Rectangle> const& a,
+    std::vector<geom::Rectangle> const& b,
+    Keep keep)
+{
+    auto const a_bands = bands_of(a);
+    auto const b_bands = bands_of(b);
+
+    std::vector<int> edges;
+    edges.reserve(2 * (a_bands.size() + b_bands.size()));
+    for (auto const& band : a_bands)
+    {
+        edges.push_back(band.top);
+        edges.push_back(band.bottom);
+    }
+    for (auto const& band : b_bands)
+    {
+        edges.push_back(band.top);
+        edges.push_back(band.bottom);
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    std::vector<Band> result;
+    size_t next_a = 0;
+    size_t next_b = 0;
+
+    for (size_t e = 0; e + 1 < edges.size(); ++e)
+    {
+        int const top = edges[e];
+        int const bottom = edges[e + 1];
+
+        auto spans = combine(spans_at(top, a_bands, next_a), spans_at(top, b_bands, next_b), keep);
+        if (spans.empty())
+            continue;
+
+        // Grow the previous band rather than stacking an identical one beneath it
+        if (!result.empty() && result.back().bottom == top && result.back().spans == spans)
+            result.back().bottom = bottom;
+        else
+            result.push_back({top, bottom, std::move(spans)});
+    }
+
+    return rectangles_of(result);
+}
+}
+
+geom::Region::Region()
+{
+}
+
+geom::Region::Region(Rectangle const& rect)
+{
+    if (rect.size.width > Width{} && rect.size.height > Height{})
+        rectangles.push_back(rect);
+}
+
+geom::Region::Region(std::initializer_list<Rectangle> const& rects)
+{
+    for (auto const& rect : rects)
+        unite(rect);
+}
+
+bool geom::Region::empty() const
+{
+    return rectangles.empty();
+}
+
+bool geom::Region::contains(Point const& point) const
+{
+    return std::any_of(rectangles.begin(), rectangles.end(),
+        [&](Rectangle const& rect) { return rect.contains(point); });
+}
+
+bool geom::Region::contains(Rectangle const& rect) const
+{
+    Region uncovered{rect};
+    uncovered.subtract(*this);
+    return uncovered.empty();
+}
+
+geom::Rectangle geom::Region::bounding_rectangle() const
+{
+    if (rectangles.empty())
+        return Rectangle{};
+
+    auto left = rectangles.front().top_left.x;
+    auto right = rectangles.front().top_right().x;
+
+    for (auto const& rect : rectangles)
+    {
+        left = std::min(left, rect.top_left.x);
+        right = std::max(right, rect.top_right().x);
+    }
+
+    auto const top = rectangles.front().top_left.y;
+    auto const bottom = rectangles.back().bottom_left().y;
+
+    return {{left, top}, {right.as_int() - left.as_int(), bottom.as_int() - top.as_int()}};
+}
+
+void geom::Region::unite(Region const& other)
+{
+    rectangles = combine(rectangles, other.rectangles, [](bool a, bool b) { return a || b; });
+}
+
+void geom::Region::intersect(Region const& other)
+{
+    rectangles = combine(rectangles, other.rectangles, [](bool a, bool b) { return a && b; });
+}
+
+void geom::Region::subtract(Region const& other)
+{
+    rectangles = combine(rectangles, other.rectangles, [](bool a, bool b) { return a && !b; });
+}
+
+void geom::Region::translate(Displacement const& displacement)
+{
+    for (auto& rect : rectangles)
+        rect.top_left = rect.top_left + displacement;
+}
+
+void geom::Region::clear()
+{
+    rectangles.clear();
+}
+
+geom::Region::const_iterator geom::Region::begin() const
+{
+    return rectangles.begin();
+}
+
+geom::Region::const_iterator geom::Region::end() const
+{
+    return rectangles.end();
+}
+
+geom::Region::size_type geom::Region::size() const
+{
+    return rectangles.size();
+}
+
+bool geom::Region::operator==(Region const& other) const
+{
+    return rectangles == other.rectangles;
+}
+
+bool geom::Region::operator!=(Region const& other) const
+{
+    return !(*this == other);
+}
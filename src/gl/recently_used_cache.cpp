@@ -42,9 +42,46 @@ std::shared_ptr<mgl::Texture> mgl::RecentlyUsedCache::load(mg::Renderable const&
 
     if ((texture.last_bound_buffer != buffer_id) || (!texture.valid_binding))
     {
-        texture_source->bind();
+        auto const damaged_source = dynamic_cast<mrgl::DamagedTextureSource*>(buffer->native_buffer_base());
+        auto const size = buffer->size();
+        auto const format = buffer->pixel_format();
+        bool const has_storage =
+            format != mir_pixel_format_invalid && texture.size == size && texture.format == format;
+
+        if (damaged_source && has_storage)
+        {
+            // An entry surviving from the previous frame holds the buffer this renderable
+            // last showed, which is what the renderable's buffer damage is relative to.
+            // Otherwise the contents are stale but the storage can still be reused.
+            std::experimental::optional<geom::Rectangles> damage;
+            if (texture.valid_binding)
+                damage = renderable.buffer_damage();
+
+            uploaded += damaged_source->bind_damaged(damage.value_or(geom::Rectangles{{{}, size}}));
+        }
+        else
+        {
+            texture_source->bind();
+
+            // Other sources (EGLImages and the like) are bound rather than copied
+            if (damaged_source)
+                uploaded += size.width.as_int() * size.height.as_int() * MIR_BYTES_PER_PIXEL(format);
+        }
+
         texture.resource = buffer;
         texture.last_bound_buffer = buffer_id;
+
+        // Only storage we allocated ourselves can be uploaded into; an EGLImage's can't
+        if (damaged_source)
+        {
+            texture.size = size;
+            texture.format = format;
+        }
+        else
+        {
+            texture.size = geom::Size{};
+            texture.format = mir_pixel_format_invalid;
+        }
     }
     texture_source->secure_for_render();
 
@@ -62,6 +99,8 @@ void mgl::RecentlyUsedCache::invalidate()
 
 void mgl::RecentlyUsedCache::drop_unused()
 {
+    uploaded = 0;
+
     auto t = textures.begin();
     while (t != textures.end())
     {
@@ -78,3 +117,8 @@ void mgl::RecentlyUsedCache::drop_unused()
         }
     }
 }
+
+std::size_t mgl::RecentlyUsedCache::bytes_uploaded() const
+{
+    return uploaded;
+}
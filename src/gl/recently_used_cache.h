@@ -24,6 +24,8 @@
 #include "mir/gl/texture.h"
 #include "mir/graphics/buffer_id.h"
 #include "mir/graphics/renderable.h"
+#include "mir/geometry/size.h"
+#include "mir_toolkit/common.h"
 #include <unordered_map>
 
 namespace mir
@@ -37,6 +39,7 @@ public:
     std::shared_ptr<Texture> load(graphics::Renderable const& renderable) override;
     void invalidate() override;
     void drop_unused() override;
+    std::size_t bytes_uploaded() const override;
 
 private:
     struct Entry
@@ -46,12 +49,15 @@ private:
         {}
         std::shared_ptr<Texture> texture;
         graphics::BufferID last_bound_buffer;
+        geometry::Size size;
+        MirPixelFormat format{mir_pixel_format_invalid};
         bool used{true};
         bool valid_binding{false};
         std::shared_ptr<graphics::Buffer> resource;
     };
 
     std::unordered_map<graphics::Renderable::ID, Entry> textures;
+    std::size_t uploaded{0};
 };
 }
 }
@@ -25,6 +25,7 @@
 
 #include <capnp/message.h>
 
+#include <cstddef>
 #include <cstring>
 
 struct MirEvent
@@ -72,11 +73,33 @@ struct MirEvent
 
     static mir::EventUPtr deserialize(std::string const& bytes);
     static std::string serialize(MirEvent const* event);
+    /// The number of bytes serialize(event) would return
+    static size_t serialized_size(MirEvent const* event);
+    /// Writes the same bytes as serialize(event) to the serialized_size(event) bytes at output
+    static void serialize_into(MirEvent const* event, char* output);
+
+    /// Events are allocated from mir::events::event_pool
+    static void* operator new(std::size_t size);
+    static void operator delete(void* event, std::size_t size);
 
 protected:
     MirEvent() = default;
 
-    ::capnp::MallocMessageBuilder message;
+private:
+    /// Storage, from the event_pool, that an input event's message fits in
+    struct FirstSegment
+    {
+        FirstSegment();
+        ~FirstSegment();
+        FirstSegment(FirstSegment const&) = delete;
+        FirstSegment& operator=(FirstSegment const&) = delete;
+
+        static std::size_t const words = 128;
+        ::capnp::word* const segment;
+    } first_segment;
+
+protected:
+    ::capnp::MallocMessageBuilder message{kj::arrayPtr(first_segment.segment, FirstSegment::words)};
     mir::capnp::Event::Builder event{message.initRoot<mir::capnp::Event>()};
 };
 
@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMMON_EVENT_POOL_H_
+#define MIR_COMMON_EVENT_POOL_H_
+
+#include "mir/events/event_builders.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace mir
+{
+namespace events
+{
+/**
+ * Fixed-size blocks for building events from: the MirEvent itself, the
+ * first segment of its message and the control block of the shared_ptr it
+ * is dispatched in. Released blocks are kept for reuse rather than handed
+ * back to the heap, so the steady flow of input events doesn't malloc.
+ *
+ * Each thread caches the blocks it releases and trades them in batches with
+ * a depot shared by all threads, so events built on one thread and released
+ * on another are still recycled.
+ */
+namespace event_pool
+{
+/// The largest block the pool recycles; larger requests go to the heap
+std::size_t const max_block_size = 1024;
+
+/**
+ * \return  A block of at least size bytes. A fresh block is zero-filled; a
+ *          recycled one holds whatever its last user left in it.
+ * \throws  std::bad_alloc
+ */
+void* allocate(std::size_t size);
+/// Return a block from allocate(size)
+void release(void* block, std::size_t size);
+}
+
+/// A standard allocator drawing on the event_pool
+template<typename T>
+struct EventPoolAllocator
+{
+    using value_type = T;
+
+    EventPoolAllocator() = default;
+    template<typename U>
+    EventPoolAllocator(EventPoolAllocator<U> const&) {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(event_pool::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        event_pool::release(p, n * sizeof(T));
+    }
+};
+
+template<typename T, typename U>
+bool operator==(EventPoolAllocator<T> const&, EventPoolAllocator<U> const&) { return true; }
+template<typename T, typename U>
+bool operator!=(EventPoolAllocator<T> const&, EventPoolAllocator<U> const&) { return false; }
+
+/// Take shared ownership of event without allocating the control block from the heap
+inline std::shared_ptr<MirEvent> share_event(EventUPtr&& event)
+{
+    auto const deleter = event.get_deleter();
+    return {event.release(), deleter, EventPoolAllocator<MirEvent>{}};
+}
+}
+}
+
+#endif /* MIR_COMMON_EVENT_POOL_H_ */
@@ -26,6 +26,7 @@
 
 #include <xkbcommon/xkbcommon.h>
 #include <xkbcommon/xkbcommon-compose.h>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
@@ -42,7 +43,18 @@ using XKBKeymapPtr = std::unique_ptr<xkb_keymap, void(*)(xkb_keymap*)>;
 XKBKeymapPtr make_unique_keymap(xkb_context* context, Keymap const& keymap);
 XKBKeymapPtr make_unique_keymap(xkb_context* context, char const* buffer, size_t size);
 
+/**
+ * A compiled keymap shared with every other user of the same keymap in the
+ * process, so that it is compiled once however many devices or clients use it.
+ *
+ * xkbcommon's reference counting isn't thread safe: create states of shared
+ * keymaps with make_unique_state().
+ */
+std::shared_ptr<xkb_keymap> make_shared_keymap(Keymap const& keymap);
+std::shared_ptr<xkb_keymap> make_shared_keymap(char const* buffer, size_t size);
+
 using XKBStatePtr = std::unique_ptr<xkb_state, void(*)(xkb_state*)>;
+XKBStatePtr make_unique_state(xkb_keymap* keymap);
 using XKBComposeTablePtr = std::unique_ptr<xkb_compose_table, void(*)(xkb_compose_table*)>;
 using XKBComposeStatePtr = std::unique_ptr<xkb_compose_state, void(*)(xkb_compose_state*)>;
 
@@ -70,8 +82,8 @@ protected:
     XKBMapper& operator=(XKBMapper const&) = delete;
 
 private:
-    void set_keymap(MirInputDeviceId id, XKBKeymapPtr map);
-    void set_keymap(XKBKeymapPtr map);
+    void set_keymap(MirInputDeviceId id, std::shared_ptr<xkb_keymap> const& map);
+    void set_keymap(std::shared_ptr<xkb_keymap> const& map);
     void update_modifier();
 
     std::mutex mutable guard;
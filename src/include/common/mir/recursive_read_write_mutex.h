@@ -19,18 +19,29 @@
 #ifndef MIR_RECURSIVE_READ_WRITE_MUTEX_H_
 #define MIR_RECURSIVE_READ_WRITE_MUTEX_H_
 
+#include <array>
+#include <atomic>
 #include <condition_variable>
+#include <mutex>
 #include <thread>
-#include <vector>
 
 namespace mir
 {
 /** a recursive read-write mutex.
  * Note that a write lock can be acquired if no other threads have a read lock.
+ *
+ * Readers don't share a lock: each thread counts itself in one of several
+ * reader slots, so uncontended read locks from different threads touch
+ * different cache lines. Nested read locks on a thread are counted in
+ * thread-local storage and cost no shared writes at all.
+ *
+ * Waiting writers take priority over threads that don't yet hold a read lock.
  */
 class RecursiveReadWriteMutex
 {
 public:
+    RecursiveReadWriteMutex();
+
     void read_lock();
 
     void read_unlock();
@@ -40,17 +51,33 @@ public:
     void write_unlock();
 
 private:
-    std::mutex mutex;
-    std::condition_variable cv;
-    struct ThreadLockCount
+    RecursiveReadWriteMutex(RecursiveReadWriteMutex const&) = delete;
+    RecursiveReadWriteMutex& operator=(RecursiveReadWriteMutex const&) = delete;
+
+    static std::size_t const reader_slots = 8;
+
+    // Padded so that each slot has a cache line to itself
+    struct ReaderSlot
     {
-        ThreadLockCount() : id(), count(0) {}
-        ThreadLockCount(std::thread::id id, unsigned int count) : id(id), count(count) {}
-        std::thread::id id;
-        unsigned int count;
+        std::atomic<unsigned int> count;
+        char padding[64 - sizeof(std::atomic<unsigned int>)];
     };
-    std::vector<ThreadLockCount> read_locking_threads;
-    ThreadLockCount write_locking_thread;
+
+    bool other_readers(unsigned int own_reads) const;
+
+    /// Identifies this mutex's thread-local read counts, even after an address is reused
+    unsigned long long const instance;
+
+    std::array<ReaderSlot, reader_slots> readers;
+
+    /// Set while a writer holds or is waiting for the lock
+    std::atomic<bool> writer;
+    std::atomic<std::thread::id> write_locking_thread;
+    unsigned int write_count;
+    unsigned int waiting_writers;
+
+    std::mutex mutex;
+    std::condition_variable cv;
 };
 
 class RecursiveReadLock
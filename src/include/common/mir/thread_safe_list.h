@@ -20,10 +20,12 @@
 #ifndef MIR_THREAD_SAFE_LIST_H_
 #define MIR_THREAD_SAFE_LIST_H_
 
-#include "mir/recursive_read_write_mutex.h"
-
+#include <algorithm>
 #include <atomic>
-#include <functional>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace mir
 {
@@ -31,155 +33,190 @@ namespace mir
 /*
  * Requirements for type 'Element'
  *  - for_each():
- *    - copy-assignable
+ *    - copy-constructible
  *  - add():
- *    - copy-assignable
+ *    - copy-constructible
  *    - conversion to bool: indicates whether this is a valid element
  *  - remove(), remove_all():
- *    - copy-assignable
- *    - Element{}: default construction should create an invalid element
  *    - bool operator==: equality of elements
- *    - bool operator!=: inequality of elements
  *  - clear():
- *    - copy-assignable
- *    - Element{}: value initialization should create an invalid element
+ *    - no additional requirements
+ *
+ * for_each() walks an immutable snapshot of the elements without taking a
+ * lock; add(), remove(), remove_all() and clear() publish a new snapshot.
+ * An element that is removed is not called after remove() returns, and
+ * remove() waits for calls to it that are in progress on other threads.
+ * (It is fine to add or remove elements from within for_each().)
  */
 
 template<class Element>
 class ThreadSafeList
 {
 public:
+    ThreadSafeList();
+
     void add(Element const& element);
     void remove(Element const& element);
     unsigned int remove_all(Element const& element);
     void clear();
-    void for_each(std::function<void(Element const& element)> const& f);
+    template<typename Function>
+    void for_each(Function const& f);
 
 private:
-    struct ListItem
+    struct Entry
     {
-        ListItem() {}
-        RecursiveReadWriteMutex mutex;
-        Element element{};
-        std::atomic<ListItem*> next{nullptr};
+        explicit Entry(Element const& element) : element{element} {}
+
+        Element const element;
+        std::atomic<bool> removed{false};
+        std::atomic<unsigned int> calls_in_progress{0};
+    };
+
+    using Snapshot = std::vector<std::shared_ptr<Entry>>;
+
+    /// The entries the current thread is calling, innermost last
+    static std::vector<Entry const*>& calls_on_this_thread();
+    template<typename Predicate>
+    unsigned int remove_if(Predicate const& matches, bool first_only);
+    void publish(Snapshot const& next);
+
+    // Serialises changes to the list, and wakes removers when calls finish
+    std::mutex mutex;
+    std::condition_variable calls_finished;
 
-        ~ListItem() { delete next.load(); }
-    } head;
+    // Only accessed through std::atomic_load()/std::atomic_store()
+    std::shared_ptr<Snapshot const> snapshot;
 };
 
 template<class Element>
-void ThreadSafeList<Element>::for_each(
-    std::function<void(Element const& element)> const& f)
+ThreadSafeList<Element>::ThreadSafeList() :
+    snapshot{std::make_shared<Snapshot const>()}
 {
-    ListItem* current_item = &head;
-
-    while (current_item)
-    {
-        RecursiveReadLock lock{current_item->mutex};
-
-        // We need to take a copy in case we recursively remove during call
-        if (auto const copy_of_element = current_item->element) f(copy_of_element);
+}
 
-        current_item = current_item->next;
-    }
+template<class Element>
+std::vector<typename ThreadSafeList<Element>::Entry const*>& ThreadSafeList<Element>::calls_on_this_thread()
+{
+    thread_local std::vector<Entry const*> calls;
+    return calls;
 }
 
 template<class Element>
-void ThreadSafeList<Element>::add(Element const& element)
+template<typename Function>
+void ThreadSafeList<Element>::for_each(Function const& f)
 {
-    ListItem* current_item = &head;
+    auto const entries = std::atomic_load(&snapshot);
 
-    do
+    for (auto const& entry : *entries)
     {
-        // Note: we release the read lock to avoid two threads calling add at
-        // the same time mutually blocking the other's upgrade to write lock.
-        {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element) continue;
-        }
-
-        RecursiveWriteLock lock{current_item->mutex};
+        // Counting ourselves in before checking removed pairs with remove()
+        // marking the entry before waiting for calls to finish
+        ++entry->calls_in_progress;
 
-        if (!current_item->element)
+        struct CallInProgress
         {
-            current_item->element = element;
-            return;
-        }
+            CallInProgress(ThreadSafeList& list, Entry& entry) : list(list), entry(entry)
+            {
+                calls_on_this_thread().push_back(&entry);
+            }
+
+            ~CallInProgress()
+            {
+                calls_on_this_thread().pop_back();
+
+                --entry.calls_in_progress;
+                if (entry.removed)
+                {
+                    std::lock_guard<decltype(list.mutex)> lock{list.mutex};
+                    list.calls_finished.notify_all();
+                }
+            }
+
+            ThreadSafeList& list;
+            Entry& entry;
+        } const call{*this, *entry};
+
+        if (!entry->removed)
+            f(entry->element);
     }
-    while (current_item->next && (current_item = current_item->next));
+}
+
+template<class Element>
+void ThreadSafeList<Element>::add(Element const& element)
+{
+    if (!element)
+        return;
 
-    // No empty Items so append a new one
-    auto new_item = new ListItem;
-    new_item->element = element;
+    std::lock_guard<decltype(mutex)> lock{mutex};
 
-    for (ListItem* expected{nullptr};
-        !current_item->next.compare_exchange_weak(expected, new_item);
-        expected = nullptr)
-    {
-        if (expected) current_item = expected;
-    }
+    auto next = *std::atomic_load(&snapshot);
+    next.push_back(std::make_shared<Entry>(element));
+    publish(next);
 }
 
 template<class Element>
 void ThreadSafeList<Element>::remove(Element const& element)
 {
-    ListItem* current_item = &head;
-
-    do
-    {
-        {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element != element) continue;
-        }
+    remove_if([&element](Element const& candidate) { return candidate == element; }, true);
+}
 
-        RecursiveWriteLock lock{current_item->mutex};
+template<class Element>
+unsigned int ThreadSafeList<Element>::remove_all(Element const& element)
+{
+    return remove_if([&element](Element const& candidate) { return candidate == element; }, false);
+}
 
-        if (current_item->element == element)
-        {
-            current_item->element = Element{};
-            return;
-        }
-    }
-    while ((current_item = current_item->next));
+template<class Element>
+void ThreadSafeList<Element>::clear()
+{
+    remove_if([](Element const&) { return true; }, false);
 }
 
 template<class Element>
-unsigned int ThreadSafeList<Element>::remove_all(Element const& element)
+template<typename Predicate>
+unsigned int ThreadSafeList<Element>::remove_if(Predicate const& matches, bool first_only)
 {
-    ListItem* current_item = &head;
-    auto removed = 0u;
+    std::unique_lock<decltype(mutex)> lock{mutex};
 
-    do
+    Snapshot removed;
+    Snapshot next;
+
+    for (auto const& entry : *std::atomic_load(&snapshot))
     {
+        if ((!first_only || removed.empty()) && matches(entry->element))
         {
-            RecursiveReadLock lock{current_item->mutex};
-            if (current_item->element != element) continue;
+            entry->removed = true;
+            removed.push_back(entry);
         }
-
-        RecursiveWriteLock lock{current_item->mutex};
-
-        if (current_item->element == element)
+        else
         {
-            current_item->element = Element{};
-            ++removed;
+            next.push_back(entry);
         }
     }
-    while ((current_item = current_item->next));
 
-    return removed;
-}
+    if (removed.empty())
+        return 0;
 
-template<class Element>
-void ThreadSafeList<Element>::clear()
-{
-    ListItem* current_item = &head;
+    publish(next);
 
-    do
+    // Wait for calls on other threads; calls on this thread are further up our stack
+    auto const& calls_here = calls_on_this_thread();
+
+    for (auto const& entry : removed)
     {
-        RecursiveWriteLock lock{current_item->mutex};
-        current_item->element = Element{};
+        auto const own_calls = std::count(calls_here.begin(), calls_here.end(), entry.get());
+
+        calls_finished.wait(lock, [&]
+            { return entry->calls_in_progress == static_cast<unsigned int>(own_calls); });
     }
-    while ((current_item = current_item->next));
+
+    return removed.size();
+}
+
+template<class Element>
+void ThreadSafeList<Element>::publish(Snapshot const& next)
+{
+    std::atomic_store(&snapshot, std::shared_ptr<Snapshot const>{std::make_shared<Snapshot const>(next)});
 }
 
 }
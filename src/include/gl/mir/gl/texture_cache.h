@@ -20,6 +20,7 @@
 #ifndef MIR_GL_TEXTURE_CACHE_H_
 #define MIR_GL_TEXTURE_CACHE_H_
 
+#include <cstddef>
 #include <memory>
 
 namespace mir
@@ -57,6 +58,12 @@ public:
      */
     virtual void drop_unused() = 0;
 
+    /**
+     * The number of bytes of pixel data load() has copied into textures
+     * since the last drop_unused().
+     */
+    virtual std::size_t bytes_uploaded() const = 0;
+
 protected:
     TextureCache() = default;
 private:
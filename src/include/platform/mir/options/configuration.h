@@ -28,6 +28,7 @@ namespace mir
 namespace options
 {
 extern char const* const wayland_socket_name_opt;
+extern char const* const wayland_shm_zero_copy_opt;
 extern char const* const server_socket_opt;
 extern char const* const prompt_socket_opt;
 extern char const* const no_server_socket_opt;
@@ -38,6 +39,7 @@ extern char const* const msg_processor_report_opt;
 extern char const* const shared_library_prober_report_opt;
 extern char const* const shell_report_opt;
 extern char const* const compositor_report_opt;
+extern char const* const compositor_metrics_file_opt;
 extern char const* const display_report_opt;
 extern char const* const legacy_input_report_opt;
 extern char const* const connector_report_opt;
@@ -53,6 +55,10 @@ extern char const* const fatal_except_opt;
 extern char const* const debug_opt;
 extern char const* const composite_delay_opt;
 extern char const* const enable_key_repeat_opt;
+extern char const* const motion_coalescing_opt;
+extern char const* const client_send_queue_limit_opt;
+extern char const* const client_send_queue_overflow_opt;
+extern char const* const client_buffer_pool_opt;
 
 extern char const* const name_opt;
 extern char const* const offscreen_opt;
@@ -62,6 +68,7 @@ extern char const* const enable_key_repeat_opt;
 extern char const* const off_opt_value;
 extern char const* const log_opt_value;
 extern char const* const lttng_opt_value;
+extern char const* const metrics_opt_value;
 
 extern char const* const platform_graphics_lib;
 extern char const* const platform_input_lib;
@@ -44,7 +44,15 @@ public:
 
     virtual std::shared_ptr<graphics::Buffer>
         lock_compositor_buffer(void const* user_id) = 0;
+    /**
+     * The regions (in buffer coordinates) of the buffer last returned by
+     * lock_compositor_buffer(user_id) that differ from the buffer returned
+     * to the same user_id before it.
+     */
+    virtual geometry::Rectangles compositor_buffer_damage(void const* user_id) const = 0;
     virtual geometry::Size stream_size() = 0;
+    /// The region set by set_opaque_region(), in buffer coordinates
+    virtual geometry::Region opaque_region() const = 0;
     virtual int buffers_ready_for_compositor(void const* user_id) const = 0;
     virtual void drop_old_buffers() = 0;
     virtual bool has_submitted_buffer() const = 0;
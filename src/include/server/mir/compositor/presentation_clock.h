@@ -0,0 +1,95 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_COMPOSITOR_PRESENTATION_CLOCK_H_
+#define MIR_COMPOSITOR_PRESENTATION_CLOCK_H_
+
+#include "mir/graphics/frame.h"
+
+#include <experimental/optional>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+
+/**
+ * Tells the frontends when composited frames reach the screen, so that
+ * clients can pace themselves to the display.
+ *
+ * Each display sync group presents its own frames, so presentations are
+ * waited for on the output that was compositing when they were requested.
+ *
+ * Presentation times are always reported on clock_id(), whatever clock the
+ * display itself timestamps vblanks with.
+ */
+class PresentationClock
+{
+public:
+    struct Presentation
+    {
+        time::PosixTimestamp time;          ///< When the frame is shown
+        std::chrono::nanoseconds refresh;   ///< Refresh period of the display, or zero if unknown
+        int64_t msc;                        ///< Vblank counter of the display, or zero if unknown
+        bool vsync;                         ///< Whether the frame is shown on a vblank
+    };
+
+    PresentationClock();
+
+    clockid_t clock_id() const;
+
+    /**
+     * Calls presented (on a compositor thread) when the next frame of the
+     * output compositing on this thread is shown. Off the compositor
+     * threads, the next frame of any output will do.
+     */
+    void on_next_presentation(std::function<void(Presentation const&)> const& presented);
+
+    /// Called by the compositor thread for output (a display sync group) before it composites
+    void compositing(void const* output);
+
+    /// Called by the compositor thread for output when it stops, handing on what it didn't present
+    void stopped_compositing(void const* output);
+
+    /**
+     * Called by the compositor after posting a frame of output, with the
+     * vblank it will be shown on and the measured refresh period. A frame
+     * that isn't synchronised to vblank (no vblank is given) is treated as
+     * shown now.
+     */
+    void frame_presented(
+        void const* output,
+        std::experimental::optional<graphics::Frame> const& vblank,
+        std::chrono::nanoseconds refresh);
+
+private:
+    using Callbacks = std::vector<std::function<void(Presentation const&)>>;
+
+    std::mutex mutex;
+    std::unordered_map<void const*, Callbacks> pending;
+    Callbacks pending_on_any_output;
+};
+
+}
+}
+
+#endif /* MIR_COMPOSITOR_PRESENTATION_CLOCK_H_ */
@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_FRONTEND_EVENT_BATCH_H_
+#define MIR_FRONTEND_EVENT_BATCH_H_
+
+#include <functional>
+
+namespace mir
+{
+namespace frontend
+{
+
+/**
+ * Marks a batch of events raised on the current thread, such as one input
+ * dispatch cycle. While a batch is in progress, event sinks may hold back the
+ * events raised on the thread and deliver them together when the (outermost)
+ * batch ends.
+ */
+class EventBatch
+{
+public:
+    EventBatch();
+    ~EventBatch();
+
+    /// Whether a batch is in progress on the calling thread
+    static bool in_progress();
+
+    /// Arranges for deliver to be called when the batch in progress on the calling thread ends
+    static void defer(std::function<void()> const& deliver);
+
+private:
+    EventBatch(EventBatch const&) = delete;
+    EventBatch& operator=(EventBatch const&) = delete;
+
+    bool const outermost;
+};
+
+}
+}
+
+#endif /* MIR_FRONTEND_EVENT_BATCH_H_ */
@@ -44,6 +44,8 @@ public:
         invocation(invocation) {}
 
     const ::std::string& method_name() const;
+    bool has_method_opcode() const;
+    google::protobuf::uint32 method_opcode() const;
     const ::std::string& parameters() const;
     google::protobuf::uint32 id() const;
 private:
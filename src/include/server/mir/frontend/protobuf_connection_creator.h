@@ -21,6 +21,8 @@
 
 #include "mir/frontend/connection_creator.h"
 #include "mir/frontend/connections.h"
+#include "mir/frontend/send_queue_limit.h"
+#include "mir/input/motion_coalescing.h"
 
 #include <atomic>
 
@@ -48,7 +50,9 @@ public:
         std::shared_ptr<ProtobufIpcFactory> const& ipc_factory,
         std::shared_ptr<SessionAuthorizer> const& session_authorizer,
         std::shared_ptr<graphics::PlatformIpcOperations> const& operations,
-        std::shared_ptr<MessageProcessorReport> const& report);
+        std::shared_ptr<MessageProcessorReport> const& report,
+        input::MotionCoalescing motion_coalescing,
+        SendQueueLimit const& send_queue_limit);
     ~ProtobufConnectionCreator() noexcept;
 
     void create_connection_for(
@@ -67,6 +71,8 @@ private:
     std::shared_ptr<SessionAuthorizer> const session_authorizer;
     std::shared_ptr<graphics::PlatformIpcOperations> const operations;
     std::shared_ptr<MessageProcessorReport> const report;
+    input::MotionCoalescing const motion_coalescing;
+    SendQueueLimit const send_queue_limit;
     std::atomic<int> next_session_id;
     std::shared_ptr<detail::Connections<detail::SocketConnection>> const connections;
 };
@@ -0,0 +1,50 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_FRONTEND_SEND_QUEUE_LIMIT_H_
+#define MIR_FRONTEND_SEND_QUEUE_LIMIT_H_
+
+#include <cstddef>
+#include <string>
+
+namespace mir
+{
+namespace frontend
+{
+/// Bounds the outgoing data that may pile up for a client that is not reading it
+struct SendQueueLimit
+{
+    /// What to do when a message would take the queue over max_bytes
+    enum class Overflow
+    {
+        drop_coalescible,   ///< Drop queued coalescible messages; disconnect if that is not enough
+        disconnect          ///< Disconnect the client
+    };
+
+    size_t max_bytes;
+    Overflow overflow;
+};
+
+/**
+ * Parses the value of the client-send-queue-overflow option ("drop-coalescible" or "disconnect").
+ * \throws std::invalid_argument if the name is not recognised
+ */
+SendQueueLimit::Overflow send_queue_overflow_from(std::string const& name);
+}
+}
+
+#endif /* MIR_FRONTEND_SEND_QUEUE_LIMIT_H_ */
@@ -0,0 +1,64 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_MOTION_COALESCING_H_
+#define MIR_INPUT_MOTION_COALESCING_H_
+
+#include <string>
+
+struct MirEvent;
+
+namespace mir
+{
+namespace input
+{
+/// Which input events may be merged while a client is yet to receive them
+enum class MotionCoalescing
+{
+    none,
+    pointer,            ///< Pointer motion
+    pointer_and_touch   ///< Pointer motion and touch contact changes
+};
+
+/**
+ * Parses the value of the input-motion-coalescing option ("off", "pointer" or "all").
+ * \throws std::invalid_argument if the name is not recognised
+ */
+MotionCoalescing motion_coalescing_from(std::string const& name);
+
+/**
+ * Merges next into pending, an event that has not yet been delivered.
+ *
+ * Only consecutive motion (with the same buttons held, or the same touch
+ * contacts) for the same window and device is merged, so the boundaries
+ * marked by button, enter/leave and touch down/up events are preserved. The
+ * merged event carries the latest position, timestamp and cookie and the sum
+ * of the relative motion and scrolling.
+ *
+ * \returns whether next was merged; pending is unchanged if it was not
+ */
+bool coalesce_motion(MirEvent& pending, MirEvent const& next, MotionCoalescing policy);
+
+/**
+ * Whether event is motion that policy lets a later event be merged into, and
+ * that a later event would entirely supersede: pointer motion carrying
+ * relative motion or scrolling is not, as dropping it would lose the deltas.
+ */
+bool is_coalescible_motion(MirEvent const& event, MotionCoalescing policy);
+}
+}
+
+#endif /* MIR_INPUT_MOTION_COALESCING_H_ */
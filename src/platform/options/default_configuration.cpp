@@ -28,6 +28,7 @@
 namespace mo = mir::options;
 
 char const* const mo::wayland_socket_name_opt     = "wayland-socket-name";
+char const* const mo::wayland_shm_zero_copy_opt   = "wayland-shm-zero-copy";
 char const* const mo::server_socket_opt           = "file,f";
 char const* const mo::prompt_socket_opt           = "prompt-file,p";
 char const* const mo::no_server_socket_opt        = "no-file";
@@ -36,6 +37,7 @@ char const* const mo::enable_input_opt            = "enable-input,i";
 char const* const mo::session_mediator_report_opt = "session-mediator-report";
 char const* const mo::msg_processor_report_opt    = "msg-processor-report";
 char const* const mo::compositor_report_opt       = "compositor-report";
+char const* const mo::compositor_metrics_file_opt = "compositor-metrics-file";
 char const* const mo::display_report_opt          = "display-report";
 char const* const mo::legacy_input_report_opt     = "legacy-input-report";
 char const* const mo::connector_report_opt        = "connector-report";
@@ -55,10 +57,15 @@ char const* const mo::fatal_except_opt            = "on-fatal-error-except";
 char const* const mo::debug_opt                   = "debug";
 char const* const mo::composite_delay_opt         = "composite-delay";
 char const* const mo::enable_key_repeat_opt       = "enable-key-repeat";
+char const* const mo::motion_coalescing_opt       = "input-motion-coalescing";
+char const* const mo::client_send_queue_limit_opt = "client-send-queue-limit";
+char const* const mo::client_send_queue_overflow_opt = "client-send-queue-overflow";
+char const* const mo::client_buffer_pool_opt     = "client-buffer-pool";
 
 char const* const mo::off_opt_value = "off";
 char const* const mo::log_opt_value = "log";
 char const* const mo::lttng_opt_value = "lttng";
+char const* const mo::metrics_opt_value = "metrics";
 
 char const* const mo::platform_graphics_lib = "platform-graphics-lib";
 char const* const mo::platform_input_lib = "platform-input-lib";
@@ -144,6 +151,9 @@ mo::DefaultConfiguration::DefaultConfiguration(
     add_options()
         (wayland_socket_name_opt, po::value<std::string>(),
          "Overrides the default socket name used for communicating with clients")
+        (wayland_shm_zero_copy_opt, po::value<bool>()->default_value(false),
+         "Upload Wayland shm buffers straight from client memory instead of "
+         "copying them on commit. The client's pool is held until the buffer is released.")
         (host_socket_opt, po::value<std::string>(),
             "Host socket filename")
         (server_socket_opt, po::value<std::string>()->default_value(::mir::default_server_socket),
@@ -160,7 +170,10 @@ mo::DefaultConfiguration::DefaultConfiguration(
         (enable_input_opt, po::value<bool>()->default_value(enable_input_default),
             "Enable input.")
         (compositor_report_opt, po::value<std::string>()->default_value(off_opt_value),
-            "Compositor reporting [{log,lttng,off}]")
+            "Compositor reporting [{log,lttng,metrics,off}]")
+        (compositor_metrics_file_opt, po::value<std::string>(),
+            "With --compositor-report=metrics, a file to keep updated with "
+            "per-output frame time distributions as JSON")
         (connector_report_opt, po::value<std::string>()->default_value(off_opt_value),
             "How to handle the Connector report. [{log,lttng,off}]")
         (display_report_opt, po::value<std::string>()->default_value(off_opt_value),
@@ -200,6 +213,16 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "Cursor (mouse pointer) to use [{auto,null,software}]")
         (enable_key_repeat_opt, po::value<bool>()->default_value(true),
              "Enable server generated key repeat")
+        (motion_coalescing_opt, po::value<std::string>()->default_value("pointer"),
+            "Merge consecutive motion events that a client has yet to receive "
+            "into the latest one. [{off,pointer,all}]")
+        (client_send_queue_limit_opt, po::value<int>()->default_value(4096),
+            "KiB of outgoing messages to queue for a client that is not reading them.")
+        (client_send_queue_overflow_opt, po::value<std::string>()->default_value("drop-coalescible"),
+            "What to do when a client's send queue is full: drop queued input motion "
+            "(disconnecting if that is not enough), or disconnect. [{drop-coalescible,disconnect}]")
+        (client_buffer_pool_opt, po::value<int>()->default_value(32),
+            "MiB of buffers a client has freed to keep for it to reuse (0 to never reuse them).")
         (fatal_except_opt, "On \"fatal error\" conditions [e.g. drivers behaving "
             "in unexpected ways] throw an exception (instead of a core dump)")
         (debug_opt, "Enable extra development debugging. "
@@ -21,13 +21,17 @@
 #include "mir/shm_file.h"
 #include "shm_buffer.h"
 #include "buffer_texture_binder.h"
+#include "mir/geometry/rectangles.h"
 
 #include MIR_SERVER_GL_H
 #include MIR_SERVER_GLEXT_H
 
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include <string.h>
 #include <endian.h>
@@ -184,6 +188,46 @@ void mgc::ShmBuffer::secure_for_render()
 {
 }
 
+std::size_t mgc::ShmBuffer::bind_damaged(geom::Rectangles const& damage)
+{
+    GLenum format, type;
+
+    if (!mg::get_gl_pixel_format(pixel_format_, format, type))
+        return 0;
+
+    // Our rows are tightly packed, so a run of whole rows is contiguous and
+    // can be uploaded without needing GL_EXT_unpack_subimage.
+    std::vector<std::pair<int, int>> rows; // [top, bottom)
+    for (auto const& rect : damage)
+    {
+        auto const area = rect.intersection_with({{}, size_});
+        if (area.size.width > geom::Width{} && area.size.height > geom::Height{})
+            rows.emplace_back(area.top_left.y.as_int(), area.bottom_right().y.as_int());
+    }
+    std::sort(rows.begin(), rows.end());
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    auto const row_bytes = stride_.as_int();
+    std::size_t uploaded{0};
+
+    for (auto run = rows.begin(); run != rows.end();)
+    {
+        auto const top = run->first;
+        auto bottom = run->second;
+
+        for (++run; run != rows.end() && run->first <= bottom; ++run)
+            bottom = std::max(bottom, run->second);
+
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, top,
+                        size_.width.as_int(), bottom - top,
+                        format, type, static_cast<unsigned char const*>(pixels) + top * row_bytes);
+        uploaded += (bottom - top) * row_bytes;
+    }
+
+    return uploaded;
+}
+
 void mir::graphics::common::ShmBuffer::bind_for_write()
 {
     gl_bind_to_texture();
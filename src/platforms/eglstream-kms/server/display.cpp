@@ -230,6 +230,11 @@ public:
         return std::chrono::milliseconds{0};
     }
 
+    std::experimental::optional<mg::Frame> next_vblank() const override
+    {
+        return {};
+    }
+
 private:
     EGLDisplay dpy;
     EGLContext ctx;
@@ -29,6 +29,7 @@
 #include "mir/input/touchpad_settings.h"
 #include "mir/input/input_device_info.h"
 #include "mir/events/event_builders.h"
+#include "mir/events/event_pool.h"
 #include "mir/geometry/displacement.h"
 #include "mir/dispatch/dispatchable.h"
 #include "mir/fd.h"
@@ -47,6 +48,7 @@
 #include <algorithm>
 
 namespace md = mir::dispatch;
+namespace mev = mir::events;
 namespace mi = mir::input;
 namespace mie = mi::evdev;
 using namespace std::literals::chrono_literals;
@@ -147,19 +149,19 @@ void mie::LibInputDevice::process_event(libinput_event* event)
         switch(libinput_event_get_type(event))
         {
         case LIBINPUT_EVENT_KEYBOARD_KEY:
-            sink->handle_input(convert_event(libinput_event_get_keyboard_event(event)));
+            sink->handle_input(mev::share_event(convert_event(libinput_event_get_keyboard_event(event))));
             break;
         case LIBINPUT_EVENT_POINTER_MOTION:
-            sink->handle_input(convert_motion_event(libinput_event_get_pointer_event(event)));
+            sink->handle_input(mev::share_event(convert_motion_event(libinput_event_get_pointer_event(event))));
             break;
         case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
-            sink->handle_input(convert_absolute_motion_event(libinput_event_get_pointer_event(event)));
+            sink->handle_input(mev::share_event(convert_absolute_motion_event(libinput_event_get_pointer_event(event))));
             break;
         case LIBINPUT_EVENT_POINTER_BUTTON:
-            sink->handle_input(convert_button_event(libinput_event_get_pointer_event(event)));
+            sink->handle_input(mev::share_event(convert_button_event(libinput_event_get_pointer_event(event))));
             break;
         case LIBINPUT_EVENT_POINTER_AXIS:
-            sink->handle_input(convert_axis_event(libinput_event_get_pointer_event(event)));
+            sink->handle_input(mev::share_event(convert_axis_event(libinput_event_get_pointer_event(event))));
             break;
         // touch events are processed as a batch of changes over all touch pointts
         case LIBINPUT_EVENT_TOUCH_DOWN:
@@ -177,7 +179,7 @@ void mie::LibInputDevice::process_event(libinput_event* event)
         case LIBINPUT_EVENT_TOUCH_FRAME:
             if (is_output_active())
             {
-                sink->handle_input(convert_touch_frame(libinput_event_get_touch_event(event)));
+                sink->handle_input(mev::share_event(convert_touch_frame(libinput_event_get_touch_event(event))));
             }
             break;
         default:
@@ -312,7 +314,8 @@ mir::EventUPtr mie::LibInputDevice::convert_touch_frame(libinput_event_touch* to
     // TODO make libinput indicate tool type
     auto const tool = mir_touch_tooltype_finger;
 
-    std::vector<events::ContactState> contacts;
+    auto& contacts = frame_contacts;
+    contacts.clear();
     for(auto it = begin(last_seen_properties); it != end(last_seen_properties);)
     {
         auto & id = it->first;
@@ -104,6 +104,8 @@ private:
         float x{0}, y{0}, major{0}, minor{0}, pressure{0}, orientation{0};
     };
     std::map<MirTouchId,ContactData> last_seen_properties;
+    /// Reused by each touch frame, to save allocating
+    std::vector<events::ContactState> frame_contacts;
 
     void update_contact_data(ContactData &data, MirTouchAction action, libinput_event_touch* touch);
 };
@@ -0,0 +1,134 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "atomic_kms_commit.h"
+#include "kms-utils/drm_mode_resources.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <stdexcept>
+#include <system_error>
+
+namespace mgm = mir::graphics::mesa;
+namespace mgk = mir::graphics::kms;
+namespace geom = mir::geometry;
+
+namespace
+{
+mgk::ObjectProperties plane_properties(int drm_fd, uint32_t plane_id)
+{
+    return mgk::ObjectProperties{drm_fd, plane_id, DRM_MODE_OBJECT_PLANE};
+}
+
+drmModeAtomicReqPtr allocate_request()
+{
+    if (auto const request = drmModeAtomicAlloc())
+        return request;
+
+    BOOST_THROW_EXCEPTION(std::runtime_error("Failed to allocate atomic KMS request"));
+}
+}
+
+mgm::AtomicPlane::AtomicPlane(int drm_fd, uint32_t plane_id)
+    : AtomicPlane{plane_properties(drm_fd, plane_id), plane_id}
+{
+}
+
+mgm::AtomicPlane::AtomicPlane(mgk::ObjectProperties const& properties, uint32_t plane_id)
+    : id{plane_id},
+      fb_id{properties.id_for("FB_ID")},
+      crtc_id{properties.id_for("CRTC_ID")},
+      src_x{properties.id_for("SRC_X")},
+      src_y{properties.id_for("SRC_Y")},
+      src_w{properties.id_for("SRC_W")},
+      src_h{properties.id_for("SRC_H")},
+      crtc_x{properties.id_for("CRTC_X")},
+      crtc_y{properties.id_for("CRTC_Y")},
+      crtc_w{properties.id_for("CRTC_W")},
+      crtc_h{properties.id_for("CRTC_H")}
+{
+}
+
+mgm::AtomicKMSCommit::AtomicKMSCommit(int drm_fd)
+    : drm_fd{drm_fd},
+      request{allocate_request(), &drmModeAtomicFree}
+{
+}
+
+void mgm::AtomicKMSCommit::set_plane(
+    AtomicPlane const& plane,
+    uint32_t crtc_id,
+    uint32_t fb_id,
+    geom::Rectangle const& destination,
+    geom::Point const& source)
+{
+    uint64_t const width = destination.size.width.as_uint32_t();
+    uint64_t const height = destination.size.height.as_uint32_t();
+
+    add(plane.id, plane.fb_id, fb_id);
+    add(plane.id, plane.crtc_id, crtc_id);
+    // The source rectangle is in 16.16 fixed point
+    add(plane.id, plane.src_x, uint64_t(source.x.as_int()) << 16);
+    add(plane.id, plane.src_y, uint64_t(source.y.as_int()) << 16);
+    add(plane.id, plane.src_w, width << 16);
+    add(plane.id, plane.src_h, height << 16);
+    // CRTC_X and CRTC_Y are signed, so planes may hang off the top left
+    add(plane.id, plane.crtc_x, static_cast<uint64_t>(int64_t{destination.top_left.x.as_int()}));
+    add(plane.id, plane.crtc_y, static_cast<uint64_t>(int64_t{destination.top_left.y.as_int()}));
+    add(plane.id, plane.crtc_w, width);
+    add(plane.id, plane.crtc_h, height);
+}
+
+void mgm::AtomicKMSCommit::clear_plane(AtomicPlane const& plane)
+{
+    add(plane.id, plane.fb_id, 0);
+    add(plane.id, plane.crtc_id, 0);
+}
+
+void mgm::AtomicKMSCommit::flip(uint32_t crtc_id, uint32_t connector_id)
+{
+    flips_.push_back({crtc_id, connector_id});
+}
+
+auto mgm::AtomicKMSCommit::flips() const -> std::vector<Flip> const&
+{
+    return flips_;
+}
+
+bool mgm::AtomicKMSCommit::test() const
+{
+    return drmModeAtomicCommit(drm_fd, request.get(), DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0;
+}
+
+bool mgm::AtomicKMSCommit::commit(void* flip_event_data)
+{
+    // The kernel refuses flip events for commits that don't touch a CRTC
+    uint32_t const flags = flips_.empty() ?
+        DRM_MODE_ATOMIC_NONBLOCK :
+        DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT;
+
+    return drmModeAtomicCommit(drm_fd, request.get(), flags, flip_event_data) == 0;
+}
+
+void mgm::AtomicKMSCommit::add(uint32_t object_id, uint32_t property_id, uint64_t value)
+{
+    auto const result = drmModeAtomicAddProperty(request.get(), object_id, property_id, value);
+    if (result < 0)
+    {
+        BOOST_THROW_EXCEPTION(
+            std::system_error(-result, std::system_category(), "Failed to add property to atomic KMS request"));
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_MESA_ATOMIC_KMS_COMMIT_H_
+#define MIR_GRAPHICS_MESA_ATOMIC_KMS_COMMIT_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <xf86drmMode.h>
+
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace kms
+{
+class ObjectProperties;
+}
+namespace mesa
+{
+
+/**
+ * The ids of the atomic KMS properties of a plane.
+ */
+struct AtomicPlane
+{
+    /// \throws std::out_of_range if the plane lacks any of the properties
+    AtomicPlane(int drm_fd, uint32_t plane_id);
+
+    uint32_t id;
+    uint32_t fb_id, crtc_id;
+    uint32_t src_x, src_y, src_w, src_h;
+    uint32_t crtc_x, crtc_y, crtc_w, crtc_h;
+
+private:
+    AtomicPlane(kms::ObjectProperties const& properties, uint32_t plane_id);
+};
+
+/**
+ * A set of plane updates, possibly spanning several CRTCs, that the kernel
+ * applies all at once.
+ */
+class AtomicKMSCommit
+{
+public:
+    struct Flip
+    {
+        uint32_t crtc_id;
+        uint32_t connector_id;
+    };
+
+    explicit AtomicKMSCommit(int drm_fd);
+
+    /**
+     * Show fb_id on plane, unscaled.
+     *
+     * \param [in] destination  Where to show it on the CRTC
+     * \param [in] source       The top left of the part of fb_id to show
+     */
+    void set_plane(
+        AtomicPlane const& plane,
+        uint32_t crtc_id,
+        uint32_t fb_id,
+        geometry::Rectangle const& destination,
+        geometry::Point const& source);
+    void clear_plane(AtomicPlane const& plane);
+
+    /// Ask for a page flip event from crtc_id once the commit takes effect
+    void flip(uint32_t crtc_id, uint32_t connector_id);
+    std::vector<Flip> const& flips() const;
+
+    /// Whether the kernel would accept the commit, without applying it
+    bool test() const;
+    /// Apply the commit at the next vblank without waiting for it
+    bool commit(void* flip_event_data);
+
+private:
+    void add(uint32_t object_id, uint32_t property_id, uint64_t value);
+
+    int const drm_fd;
+    std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)> const request;
+    std::vector<Flip> flips_;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_MESA_ATOMIC_KMS_COMMIT_H_ */
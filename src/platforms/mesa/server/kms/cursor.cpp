@@ -23,11 +23,15 @@
 #include "kms_display_configuration.h"
 #include "mir/geometry/rectangle.h"
 #include "mir/graphics/cursor_image.h"
+#include "mir/graphics/display_report.h"
+#include "mir/log.h"
 
 #include <xf86drm.h>
 
 #include <boost/exception/errinfo_errno.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <vector>
 
@@ -97,18 +101,82 @@ gbm_device* gbm_create_device_checked(int fd)
     }
     return device;
 }
+
+// Enough for the arrow, text, busy and resize cursors a client flips between
+std::size_t const max_cached_images = 8;
+std::size_t const max_cached_buffers = 8;
+
+std::size_t hash_of(void const* data, std::size_t count)
+{
+    auto const bytes = static_cast<uint8_t const*>(data);
+    uint64_t hash = 14695981039346656037ULL;
+
+    std::size_t i = 0;
+    for (; i + sizeof(uint64_t) <= count; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof word);
+        hash = (hash ^ word) * 1099511628211ULL;
+    }
+    for (; i != count; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+    return hash;
 }
 
-mgm::Cursor::GBMBOWrapper::GBMBOWrapper(int fd, MirOrientation orientation) :
-    device{gbm_create_device_checked(fd)},
+// Copies the width x height image at src into the (already cleared) dest, turned to
+// suit orientation. The loops are kept simple so that the compiler vectorizes them;
+// the sideways cases work in tiles so both images stay in cache.
+void copy_turned(
+    uint32_t* dest, std::size_t dest_stride,
+    uint32_t const* src, std::size_t src_stride,
+    unsigned int width, unsigned int height,
+    MirOrientation orientation)
+{
+    unsigned int const tile = 16;
+
+    switch (orientation)
+    {
+    case mir_orientation_normal:
+        for (unsigned int row = 0; row != height; ++row)
+            std::copy_n(src + row*src_stride, width, dest + row*dest_stride);
+        break;
+
+    case mir_orientation_inverted:
+        for (unsigned int row = 0; row != height; ++row)
+        {
+            auto const src_row = src + ((height-1)-row)*src_stride;
+            std::reverse_copy(src_row, src_row + width, dest + row*dest_stride);
+        }
+        break;
+
+    case mir_orientation_left:
+        for (unsigned int row0 = 0; row0 < width; row0 += tile)
+        for (unsigned int col0 = 0; col0 < height; col0 += tile)
+        for (unsigned int row = row0; row != std::min(row0 + tile, width); ++row)
+        for (unsigned int col = col0; col != std::min(col0 + tile, height); ++col)
+            dest[row*dest_stride + col] = src[col*src_stride + ((width-1)-row)];
+        break;
+
+    case mir_orientation_right:
+        for (unsigned int row0 = 0; row0 < width; row0 += tile)
+        for (unsigned int col0 = 0; col0 < height; col0 += tile)
+        for (unsigned int row = row0; row != std::min(row0 + tile, width); ++row)
+        for (unsigned int col = col0; col != std::min(col0 + tile, height); ++col)
+            dest[row*dest_stride + col] = src[((height-1)-col)*src_stride + row];
+        break;
+    }
+}
+}
+
+mgm::Cursor::GBMBOWrapper::GBMBOWrapper(gbm_device* device, int fd) :
     buffer{
         gbm_bo_create(
             device,
             get_drm_cursor_width(fd),
             get_drm_cursor_height(fd),
             GBM_FORMAT_ARGB8888,
-            GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE)},
-    current_orientation{orientation}
+            GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE)}
 {
     if (!buffer) BOOST_THROW_EXCEPTION(std::runtime_error("failed to create gbm buffer"));
 }
@@ -120,39 +188,41 @@ inline mgm::Cursor::GBMBOWrapper::operator gbm_bo*()
 
 inline mgm::Cursor::GBMBOWrapper::~GBMBOWrapper()
 {
-    if (device)
-        gbm_device_destroy(device);
     if (buffer)
         gbm_bo_destroy(buffer);
 }
 
 mgm::Cursor::GBMBOWrapper::GBMBOWrapper(GBMBOWrapper&& from)
-    : device{from.device},
-      buffer{from.buffer},
-      current_orientation{from.current_orientation}
+    : buffer{from.buffer}
 {
     from.buffer = nullptr;
-    from.device = nullptr;
 }
 
-auto mir::graphics::mesa::Cursor::GBMBOWrapper::change_orientation(MirOrientation new_orientation) -> bool
+mgm::Cursor::DeviceBuffers::DeviceBuffers(int drm_fd) :
+    drm_fd{drm_fd},
+    device{gbm_create_device_checked(drm_fd), &gbm_device_destroy}
 {
-    if (current_orientation == new_orientation)
-        return false;
-
-    current_orientation = new_orientation;
-    return true;
 }
 
 mgm::Cursor::Cursor(
     KMSOutputContainer& output_container,
-    std::shared_ptr<CurrentConfiguration> const& current_configuration) :
+    std::shared_ptr<CurrentConfiguration> const& current_configuration,
+    std::shared_ptr<DisplayReport> const& report) :
         output_container(output_container),
         current_position(),
         last_set_failed(false),
+        applied_sequence{0},
+        images{CachedImage{1, hash_of(nullptr, 0), geom::Size{}, {}}},
+        next_image_id{2},
         min_buffer_width{std::numeric_limits<uint32_t>::max()},
         min_buffer_height{std::numeric_limits<uint32_t>::max()},
-        current_configuration(current_configuration)
+        current_configuration(current_configuration),
+        report(report),
+        frame_interval{std::chrono::nanoseconds::zero()},
+        move_pending{false},
+        pending_sequence{0},
+        coalesced_moves{0},
+        stopping{false}
 {
     // Generate the buffers for the initial configuration.
     current_configuration->with_current_configuration_do(
@@ -162,17 +232,26 @@ mgm::Cursor::Cursor(
                 [this, &kms_conf](auto const& output)
                 {
                     // I'm not sure why g++ needs the explicit "this->" but it does - alan_g
-                    this->buffer_for_output(*kms_conf.get_output_for(output.id));
+                    this->buffers_for_device(*this->buffers.lock(), kms_conf.get_output_for(output.id)->drm_fd());
                 });
         });
 
     hide();
     if (last_set_failed)
         throw std::runtime_error("Initial KMS cursor set failed");
+
+    updater = std::thread{[this] { apply_pending_moves(); }};
 }
 
 mgm::Cursor::~Cursor() noexcept
 {
+    {
+        std::lock_guard<std::mutex> lock{pending_mutex};
+        stopping = true;
+    }
+    pending_changed.notify_all();
+    updater.join();
+
     hide();
 }
 
@@ -192,127 +271,165 @@ void mgm::Cursor::write_buffer_data_locked(
 
 void mgm::Cursor::pad_and_write_image_data_locked(
     std::lock_guard<std::mutex> const& lg,
-    GBMBOWrapper& buffer)
+    CachedImage const& image,
+    MirOrientation orientation,
+    gbm_bo* buffer)
 {
-    auto const orientation = buffer.orientation();
     bool const sideways = orientation == mir_orientation_left || orientation == mir_orientation_right;
 
     auto const min_width  = sideways ? min_buffer_width : min_buffer_height;
     auto const min_height = sideways ? min_buffer_height : min_buffer_width;
 
-    auto const image_width = std::min(min_width, size.width.as_uint32_t());
-    auto const image_height = std::min(min_height, size.height.as_uint32_t());
-    auto const image_stride = size.width.as_uint32_t() * 4;
+    auto const image_width = std::min(min_width, image.size.width.as_uint32_t());
+    auto const image_height = std::min(min_height, image.size.height.as_uint32_t());
 
     auto const buffer_stride = std::max(min_width*4, gbm_bo_get_stride(buffer));  // in bytes
     auto const buffer_height = std::max(min_height, gbm_bo_get_height(buffer));
     size_t const padded_size = buffer_stride * buffer_height;
 
-    auto padded = std::unique_ptr<uint8_t[]>(new uint8_t[padded_size]);
-    size_t rhs_padding = buffer_stride - 4*image_width;
+    // Anything outside the image is transparent
+    padded.assign(padded_size / 4, 0);
 
-    auto const filler = 0; // 0x3f; is useful to make buffer visible for debugging
-    uint8_t const* src = argb8888.data();
-    uint8_t* dest = &padded[0];
+    copy_turned(
+        padded.data(), buffer_stride / 4,
+        image.argb8888.data(), image.size.width.as_uint32_t(),
+        image_width, image_height,
+        orientation);
 
-    switch (orientation)
+    write_buffer_data_locked(lg, buffer, padded.data(), padded_size);
+}
+
+void mgm::Cursor::show()
+{
+    std::lock_guard<std::mutex> lg(guard);
+
+    if (!visible)
     {
-    case mir_orientation_normal:
-        for (unsigned int y = 0; y < image_height; y++)
-        {
-            memcpy(dest, src, 4*image_width);
-            memset(dest + 4*image_width, filler, rhs_padding);
-            dest += buffer_stride;
-            src += image_stride;
-        }
+        visible = true;
+        place_cursor_at_locked(lg, current_position, ForceState);
+    }
+}
 
-        memset(dest, 0, buffer_stride * (buffer_height - image_height));
-        break;
+void mgm::Cursor::show(CursorImage const& cursor_image)
+{
+    std::lock_guard<std::mutex> lg(guard);
 
-    case mir_orientation_inverted:
-        for (unsigned int row = 0; row != image_height; ++row)
+    auto const size = cursor_image.size();
+    auto const pixels = size.width.as_uint32_t() * size.height.as_uint32_t();
+    auto const data = cursor_image.as_argb_8888();
+    auto const hash = hash_of(data, pixels * 4);
+
+    auto const cached = std::find_if(images.begin(), images.end(), [&](CachedImage const& candidate)
         {
-            memset(dest+row*buffer_stride+4*image_width, filler, rhs_padding);
+            return candidate.hash == hash &&
+                   candidate.size == size &&
+                   memcmp(candidate.argb8888.data(), data, pixels * 4) == 0;
+        });
 
-            for (unsigned int col = 0; col != image_width; ++col)
-            {
-                memcpy(dest+row*buffer_stride+4*col, src + ((image_height-1)-row)*image_stride + 4*((image_width-1)-col), 4);
-            }
-        }
+    if (cached != images.end())
+    {
+        images.splice(images.begin(), images, cached);
+    }
+    else
+    {
+        std::vector<uint32_t> argb8888(pixels);
+        memcpy(argb8888.data(), data, pixels * 4);
+        images.push_front(CachedImage{next_image_id++, hash, size, std::move(argb8888)});
 
-        memset(dest+image_height*buffer_stride, filler, buffer_stride * (buffer_height - image_height));
-        break;
+        if (images.size() > max_cached_images)
+            images.pop_back();
+    }
 
-    case mir_orientation_left:
-        for (unsigned int row = 0; row != image_width; ++row)
-        {
-            memset(dest+row*buffer_stride+4*image_height, filler, rhs_padding);
+    hotspot = cursor_image.hotspot();
 
-            for (unsigned int col = 0; col != image_height; ++col)
-            {
-                memcpy(dest+row*buffer_stride+4*col, src + ((image_width-1)-row)*4 + image_stride*col, 4);
-            }
-        }
+    // Writing the data could throw an exception so don't leave the
+    // cursor marked visible unless we succeed.
+    visible = true;
+    try
+    {
+        place_cursor_at_locked(lg, current_position, ForceState);
+    }
+    catch (...)
+    {
+        visible = false;
+        throw;
+    }
+}
 
-        memset(dest+image_width*buffer_stride, filler, buffer_stride * (buffer_height - image_width));
-        break;
+void mgm::Cursor::move_to(geometry::Point position)
+{
+    unsigned long sequence;
+    {
+        std::lock_guard<std::mutex> lock{pending_mutex};
 
-    case mir_orientation_right:
-        for (unsigned int row = 0; row != image_width; ++row)
+        auto const now = std::chrono::steady_clock::now();
+        sequence = ++pending_sequence;
+
+        if (move_pending || now < next_move_due)
         {
-            memset(dest+row*buffer_stride+4*image_height, filler, rhs_padding);
+            if (move_pending)
+                ++coalesced_moves;
 
-            for (unsigned int col = 0; col != image_height; ++col)
-            {
-                memcpy(dest+row*buffer_stride+4*col, src + row*4 + image_stride*((image_height-1)-col), 4);
-            }
+            pending_position = position;
+            move_pending = true;
+            pending_changed.notify_one();
+            return;
         }
 
-        memset(dest+image_width*buffer_stride, filler, buffer_stride * (buffer_height - image_width));
-        break;
+        next_move_due = now + frame_interval.load();
     }
 
-    write_buffer_data_locked(lg, buffer, &padded[0], padded_size);
+    move_cursor_to(position, sequence);
 }
 
-void mgm::Cursor::show()
+void mgm::Cursor::apply_pending_moves()
 {
-    std::lock_guard<std::mutex> lg(guard);
+    std::unique_lock<std::mutex> lock{pending_mutex};
 
-    if (!visible)
+    while (true)
     {
-        visible = true;
-        place_cursor_at_locked(lg, current_position, ForceState);
-    }
-}
+        pending_changed.wait(lock, [this] { return move_pending || stopping; });
 
-void mgm::Cursor::show(CursorImage const& cursor_image)
-{
-    std::lock_guard<std::mutex> lg(guard);
+        // Later moves replace this one until the frame is up
+        if (pending_changed.wait_until(lock, next_move_due, [this] { return stopping; }))
+            return;
 
-    size = cursor_image.size();
+        auto const position = pending_position;
+        auto const sequence = pending_sequence;
+        auto const coalesced = coalesced_moves;
 
-    argb8888.resize(size.width.as_uint32_t() * size.height.as_uint32_t() * 4);
-    memcpy(argb8888.data(), cursor_image.as_argb_8888(), argb8888.size());
+        move_pending = false;
+        coalesced_moves = 0;
+        next_move_due = std::chrono::steady_clock::now() + frame_interval.load();
 
-    hotspot = cursor_image.hotspot();
-    {
-        auto locked_buffers = buffers.lock();
-        for (auto& pair : *locked_buffers)
+        lock.unlock();
+
+        if (coalesced)
+            report->report_cursor_moves_coalesced(coalesced);
+
+        try
         {
-            pad_and_write_image_data_locked(lg, pair.second);
+            move_cursor_to(position, sequence);
+        }
+        catch (std::exception const& error)
+        {
+            mir::log_warning("Failed to move hardware cursor: %s", error.what());
         }
-    }
 
-    // Writing the data could throw an exception so lets
-    // hold off on setting visible until after we have succeeded.
-    visible = true;
-    place_cursor_at_locked(lg, current_position, ForceState);
+        lock.lock();
+    }
 }
 
-void mgm::Cursor::move_to(geometry::Point position)
+void mgm::Cursor::move_cursor_to(geometry::Point position, unsigned long sequence)
 {
-    place_cursor_at(position, UpdateState);
+    std::lock_guard<std::mutex> lg(guard);
+
+    // The updater thread and move_to() can race to place successive positions
+    if (sequence < applied_sequence)
+        return;
+
+    applied_sequence = sequence;
+    place_cursor_at_locked(lg, position, UpdateState);
 }
 
 void mir::graphics::mesa::Cursor::suspend()
@@ -324,6 +441,7 @@ void mir::graphics::mesa::Cursor::suspend()
 void mir::graphics::mesa::Cursor::clear(std::lock_guard<std::mutex> const&)
 {
     last_set_failed = false;
+    shown_buffers.clear();
     output_container.for_each_output([&](std::shared_ptr<KMSOutput> const& output)
         {
             if (!output->clear_cursor())
@@ -381,28 +499,30 @@ void mgm::Cursor::place_cursor_at_locked(
         return;
 
     bool set_on_all_outputs = true;
+    int fastest_refresh_rate = 0;
 
     for_each_used_output([&](KMSOutput& output, geom::Rectangle const& output_rect, MirOrientation orientation)
     {
         if (output_rect.contains(position))
         {
+            fastest_refresh_rate = std::max(fastest_refresh_rate, output.max_refresh_rate());
+
             auto dp = transform(output_rect, position - output_rect.top_left, orientation);
-            auto hs = transform(geom::Rectangle{{0,0}, size}, hotspot, orientation);
+            auto hs = transform(geom::Rectangle{{0,0}, images.front().size}, hotspot, orientation);
 
             // It's a little strange that we implement hotspot this way as there is
             // drmModeSetCursor2 with hotspot support. However it appears to not actually
             // work on radeon and intel. There also seems to be precedent in weston for
             // implementing hotspot in this fashion.
             output.move_cursor(geom::Point{} + dp - hs);
-            auto& buffer = buffer_for_output(output);
+            auto const buffer = buffer_for_output(lg, output, orientation);
+            auto& shown_buffer = shown_buffers[&output];
 
-            auto const changed_orientation = buffer.change_orientation(orientation);
+            auto const changed_buffer = shown_buffer != buffer;
 
-            if (changed_orientation)
-                pad_and_write_image_data_locked(lg, buffer);
-
-            if (force_state || !output.has_cursor() || changed_orientation)
+            if (force_state || !output.has_cursor() || changed_buffer)
             {
+                shown_buffer = buffer;
                 if (!output.set_cursor(buffer) || !output.has_cursor())
                     set_on_all_outputs = false;
             }
@@ -413,32 +533,39 @@ void mgm::Cursor::place_cursor_at_locked(
             {
                 output.clear_cursor();
             }
+            shown_buffers.erase(&output);
         }
     });
 
     last_set_failed = !set_on_all_outputs;
+
+    if (fastest_refresh_rate > 0)
+        frame_interval = std::chrono::nanoseconds{std::chrono::seconds{1}} / fastest_refresh_rate;
+    else
+        frame_interval = std::chrono::nanoseconds::zero();
 }
 
-mgm::Cursor::GBMBOWrapper& mgm::Cursor::buffer_for_output(KMSOutput const& output)
+auto mgm::Cursor::buffers_for_device(std::list<DeviceBuffers>& devices, int drm_fd) -> DeviceBuffers&
 {
-    auto locked_buffers = buffers.lock();
-
-    auto buffer_it = std::find_if(
-        locked_buffers->begin(),
-        locked_buffers->end(),
-        [&output](auto const& candidate)
+    auto device_it = std::find_if(
+        devices.begin(),
+        devices.end(),
+        [drm_fd](auto const& candidate)
             {
-                return candidate.first == output.drm_fd();
+                return candidate.drm_fd == drm_fd;
             });
 
-    if (buffer_it != locked_buffers->end())
+    if (device_it != devices.end())
     {
-        return buffer_it->second;
+        return *device_it;
     }
 
-    locked_buffers->push_back(std::make_pair(output.drm_fd(), GBMBOWrapper(output.drm_fd(), mir_orientation_normal)));
+    devices.emplace_back(drm_fd);
+    auto& device = devices.back();
 
-    GBMBOWrapper& bo = locked_buffers->back().second;
+    device.buffers.push_back(CachedBuffer{0, mir_orientation_normal, GBMBOWrapper{device.device.get(), drm_fd}});
+
+    gbm_bo* const bo = device.buffers.back().buffer;
     if (gbm_bo_get_width(bo) < min_buffer_width)
     {
         min_buffer_width = gbm_bo_get_width(bo);
@@ -448,5 +575,55 @@ mgm::Cursor::GBMBOWrapper& mgm::Cursor::buffer_for_output(KMSOutput const& outpu
         min_buffer_height = gbm_bo_get_height(bo);
     }
 
-    return bo;
+    return device;
+}
+
+gbm_bo* mgm::Cursor::buffer_for_output(
+    std::lock_guard<std::mutex> const& lg,
+    KMSOutput const& output,
+    MirOrientation orientation)
+{
+    auto locked_buffers = buffers.lock();
+    auto& device = buffers_for_device(*locked_buffers, output.drm_fd());
+    auto& cached = device.buffers;
+    auto const& image = images.front();
+
+    auto const hit = std::find_if(cached.begin(), cached.end(), [&](CachedBuffer const& candidate)
+        {
+            return candidate.image_id == image.id && candidate.orientation == orientation;
+        });
+
+    if (hit != cached.end())
+    {
+        cached.splice(cached.begin(), cached, hit);
+        return cached.front().buffer;
+    }
+
+    // Use an empty buffer, or once the cache is full the least recently used
+    // one, so long as it isn't on screen
+    bool const full = cached.size() >= max_cached_buffers;
+    auto const victim = std::find_if(cached.rbegin(), cached.rend(), [&](CachedBuffer& candidate)
+        {
+            gbm_bo* const bo = candidate.buffer;
+            return (full || candidate.image_id == 0) &&
+                   std::none_of(shown_buffers.begin(), shown_buffers.end(),
+                        [bo](auto const& shown) { return shown.second == bo; });
+        });
+
+    if (victim == cached.rend())
+    {
+        cached.push_front(CachedBuffer{0, orientation, GBMBOWrapper{device.device.get(), device.drm_fd}});
+    }
+    else
+    {
+        cached.splice(cached.begin(), cached, std::next(victim).base());
+    }
+
+    auto& buffer = cached.front();
+    buffer.image_id = 0;    // In case writing fails
+    pad_and_write_image_data_locked(lg, image, orientation, buffer.buffer);
+    buffer.image_id = image.id;
+    buffer.orientation = orientation;
+
+    return buffer.buffer;
 }
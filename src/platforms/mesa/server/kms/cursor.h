@@ -29,9 +29,15 @@
 
 #include <gbm.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
+#include <list>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace mir
@@ -43,6 +49,7 @@ struct Rectangle;
 namespace graphics
 {
 class CursorImage;
+class DisplayReport;
 
 namespace mesa
 {
@@ -65,12 +72,25 @@ protected:
     CurrentConfiguration& operator=(CurrentConfiguration const&) = delete;
 };
 
+/**
+ * The hardware cursor.
+ *
+ * Pointer motion can arrive far faster than the display refreshes, so
+ * move_to() applies at most one position per frame of the fastest output
+ * showing the cursor. Positions that arrive sooner wait in a latest-value
+ * slot for an updater thread to apply, and the ones they replace are
+ * reported as coalesced.
+ *
+ * Recently shown images are kept, ready to scan out at each orientation
+ * they have been shown at, so switching back to one needs no copying.
+ */
 class Cursor : public graphics::Cursor
 {
 public:
     Cursor(
         KMSOutputContainer& output_container,
-        std::shared_ptr<CurrentConfiguration> const& current_configuration);
+        std::shared_ptr<CurrentConfiguration> const& current_configuration,
+        std::shared_ptr<DisplayReport> const& report);
 
     ~Cursor() noexcept;
 
@@ -85,9 +105,12 @@ public:
 
 private:
     enum ForceCursorState { UpdateState, ForceState };
-    struct GBMBOWrapper;
+    struct CachedImage;
+    struct DeviceBuffers;
     void for_each_used_output(std::function<void(KMSOutput&, geometry::Rectangle const&, MirOrientation orientation)> const& f);
     void place_cursor_at(geometry::Point position, ForceCursorState force_state);
+    void move_cursor_to(geometry::Point position, unsigned long sequence);
+    void apply_pending_moves();
     void place_cursor_at_locked(std::lock_guard<std::mutex> const&, geometry::Point position, ForceCursorState force_state);
     void write_buffer_data_locked(
         std::lock_guard<std::mutex> const&,
@@ -96,46 +119,92 @@ private:
         size_t count);
     void pad_and_write_image_data_locked(
         std::lock_guard<std::mutex> const&,
-        GBMBOWrapper& buffer);
+        CachedImage const& image,
+        MirOrientation orientation,
+        gbm_bo* buffer);
     void clear(std::lock_guard<std::mutex> const&);
 
-    GBMBOWrapper& buffer_for_output(KMSOutput const& output);
-    
+    DeviceBuffers& buffers_for_device(std::list<DeviceBuffers>& devices, int drm_fd);
+    gbm_bo* buffer_for_output(
+        std::lock_guard<std::mutex> const&,
+        KMSOutput const& output,
+        MirOrientation orientation);
+
     std::mutex guard;
 
     KMSOutputContainer& output_container;
     geometry::Point current_position;
     geometry::Displacement hotspot;
-    geometry::Size size;
-    std::vector<uint8_t> argb8888;
 
     bool visible;
     bool last_set_failed;
+    unsigned long applied_sequence;
 
     struct GBMBOWrapper
     {
-        GBMBOWrapper(int fd, MirOrientation orientation);
+        GBMBOWrapper(gbm_device* device, int fd);
         operator gbm_bo*();
 
-        auto orientation() const -> MirOrientation { return current_orientation; }
-        auto change_orientation(MirOrientation new_orientation) -> bool;
-
         ~GBMBOWrapper();
 
         GBMBOWrapper(GBMBOWrapper&& from);
     private:
-        gbm_device* device;
         gbm_bo* buffer;
-        MirOrientation current_orientation;
         GBMBOWrapper(GBMBOWrapper const&) = delete;
         GBMBOWrapper& operator=(GBMBOWrapper const&) = delete;
     };
-    Mutex<std::vector<std::pair<int, GBMBOWrapper>>> buffers;
+
+    struct CachedImage
+    {
+        unsigned long id;
+        std::size_t hash;
+        geometry::Size size;
+        std::vector<uint32_t> argb8888;
+    };
+
+    /// A buffer holding an image ready to scan out at one orientation
+    struct CachedBuffer
+    {
+        unsigned long image_id;     ///< 0 for a buffer that holds no image yet
+        MirOrientation orientation;
+        GBMBOWrapper buffer;
+    };
+
+    struct DeviceBuffers
+    {
+        explicit DeviceBuffers(int drm_fd);
+
+        int const drm_fd;
+        std::unique_ptr<gbm_device, void(*)(gbm_device*)> const device;
+        std::list<CachedBuffer> buffers;    ///< Most recently used first
+    };
+
+    /// Most recently shown first; the front is the current image
+    std::list<CachedImage> images;
+    unsigned long next_image_id;
+    Mutex<std::list<DeviceBuffers>> buffers;
+    /// The buffer last set on each output that shows the cursor
+    std::unordered_map<KMSOutput const*, gbm_bo*> shown_buffers;
+    std::vector<uint32_t> padded;
 
     uint32_t min_buffer_width;
     uint32_t min_buffer_height;
 
     std::shared_ptr<CurrentConfiguration> const current_configuration;
+    std::shared_ptr<DisplayReport> const report;
+
+    // Zero if no output showing the cursor knows its refresh rate
+    std::atomic<std::chrono::nanoseconds> frame_interval;
+
+    std::mutex pending_mutex;
+    std::condition_variable pending_changed;
+    bool move_pending;
+    geometry::Point pending_position;
+    unsigned long pending_sequence;
+    unsigned int coalesced_moves;
+    std::chrono::steady_clock::time_point next_move_due;
+    bool stopping;
+    std::thread updater;
 };
 }
 }
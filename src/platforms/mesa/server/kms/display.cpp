@@ -366,7 +366,8 @@ auto mgm::Display::create_hardware_cursor() -> std::shared_ptr<graphics::Cursor>
         {
             locked_cursor = std::make_shared<Cursor>(
                 *output_container,
-                std::make_shared<KMSCurrentConfiguration>(*this));
+                std::make_shared<KMSCurrentConfiguration>(*this),
+                listener);
         }
         catch (std::runtime_error const&)
         {
@@ -18,9 +18,11 @@
 
 #include "display_buffer.h"
 #include "kms_output.h"
+#include "atomic_kms_commit.h"
 #include "mir/graphics/display_report.h"
 #include "mir/graphics/transformation.h"
 #include "bypass.h"
+#include "plane_allocator.h"
 #include "gbm_buffer.h"
 #include "mir/fatal.h"
 #include "mir/log.h"
@@ -164,6 +166,17 @@ bool needs_bounce_buffer(mgm::KMSOutput const& destination, gbm_bo* source)
     return destination.buffer_requires_migration(source);
 }
 
+uint32_t drm_format_of(gbm_bo* bo)
+{
+    // As in fb_for(), translate any old GBM_BO_ enum format to fourcc
+    auto const format = gbm_bo_get_format(bo);
+    if (format == GBM_BO_FORMAT_XRGB8888)
+        return GBM_FORMAT_XRGB8888;
+    if (format == GBM_BO_FORMAT_ARGB8888)
+        return GBM_FORMAT_ARGB8888;
+    return format;
+}
+
 const GLchar* const vshader =
     {
         "attribute vec4 position;\n"
@@ -577,10 +590,14 @@ void mgm::DisplayBuffer::set_transformation(glm::mat2 const& t, geometry::Rectan
 {
     transform = t;
     area = a;
+    plane_allocator.reset();
+    tested_overlay_layout.clear();
 }
 
 bool mgm::DisplayBuffer::overlay(RenderableList const& renderable_list)
 {
+    overlay_frames.clear();
+
     glm::mat2 static const no_transformation(1);
     if (transform == no_transformation &&
        (bypass_option == mgm::BypassOption::allowed))
@@ -610,6 +627,102 @@ bool mgm::DisplayBuffer::overlay(RenderableList const& renderable_list)
     return false;
 }
 
+bool mgm::DisplayBuffer::overlay_where_possible(
+    RenderableList const& renderable_list,
+    RenderableList& to_render)
+{
+    if (overlay(renderable_list))
+        return true;
+
+    /*
+     * Overlay planes belong to a single CRTC, so there's no sharing them
+     * in clone mode, and they can't rotate the way the renderer can.
+     */
+    glm::mat2 static const no_transformation(1);
+    if (transform != no_transformation ||
+        bypass_option != mgm::BypassOption::allowed ||
+        outputs.size() != 1)
+    {
+        to_render = renderable_list;
+        return false;
+    }
+
+    auto const& output = outputs.front();
+
+    if (!plane_allocator)
+        plane_allocator = std::make_unique<PlaneAllocator>(output->overlay_planes());
+
+    if (plane_allocator->empty())
+    {
+        to_render = renderable_list;
+        return false;
+    }
+
+    auto const scanout_format = [&output](Renderable const& renderable) -> uint32_t
+        {
+            auto const buffer = renderable.buffer();
+            auto const native = std::dynamic_pointer_cast<mgm::NativeBuffer>(buffer->native_buffer_handle());
+            if (native && native->flags & mir_buffer_flag_can_scanout &&
+                buffer->size() == renderable.screen_position().size &&
+                !needs_bounce_buffer(*output, native->bo) &&
+                output->fb_for(native->bo))
+            {
+                return drm_format_of(native->bo);
+            }
+            return 0;
+        };
+
+    for (auto const& allocation : plane_allocator->allocate(renderable_list, area, scanout_format, to_render))
+    {
+        auto const buffer = allocation.renderable->buffer();
+        auto const native = std::dynamic_pointer_cast<mgm::NativeBuffer>(buffer->native_buffer_handle());
+        overlay_frames.push_back({allocation.plane_id, buffer, output->fb_for(native->bo), allocation.destination});
+    }
+
+    if (!overlay_frames.empty() && !overlays_pass_test())
+    {
+        overlay_frames.clear();
+        to_render = renderable_list;
+    }
+
+    return false;
+}
+
+/*
+ * Drivers may refuse combinations of planes (for bandwidth, scaler or
+ * ordering reasons) that we can't predict, so where we can we have the
+ * kernel check a layout before we stop compositing those renderables.
+ * Without atomic commits there is no such check, and update_overlay_planes()
+ * deals with failure after the fact.
+ */
+bool mgm::DisplayBuffer::overlays_pass_test()
+{
+    std::vector<std::pair<uint32_t, geom::Rectangle>> layout;
+    for (auto const& frame : overlay_frames)
+        layout.emplace_back(frame.plane_id, frame.destination);
+
+    if (layout == tested_overlay_layout)
+        return tested_overlay_layout_ok;
+
+    auto const& output = outputs.front();
+    AtomicKMSCommit commit{output->drm_fd()};
+
+    // The next composited frame matches the visible one in all that matters here
+    auto const primary = visible_composite_frame ? output->fb_for(visible_composite_frame) : nullptr;
+    if (!primary || !output->add_to_commit(commit, *primary))
+        return true;
+
+    for (auto const& frame : overlay_frames)
+    {
+        if (!output->add_overlay_to_commit(commit, frame.plane_id, frame.bufobj, frame.destination))
+            return true;
+    }
+
+    tested_overlay_layout = std::move(layout);
+    tested_overlay_layout_ok = commit.test();
+    return tested_overlay_layout_ok;
+}
+
 void mgm::DisplayBuffer::for_each_display_buffer(
     std::function<void(graphics::DisplayBuffer&)> const& f)
 {
@@ -666,10 +779,19 @@ void mgm::DisplayBuffer::post()
 
     /*
      * Try to schedule a page flip as first preference to avoid tearing.
+     * An atomic commit flips all our outputs and overlay planes together,
+     * so try that first.
      * [will complete in a background thread]
      */
-    if (!needs_set_crtc && !schedule_page_flip(*bufobj))
-        needs_set_crtc = true;
+    bool const flipped_atomically = !needs_set_crtc && schedule_atomic_commit(*bufobj);
+    if (!flipped_atomically)
+    {
+        update_overlay_planes();
+
+        if (!needs_set_crtc && !schedule_page_flip(*bufobj))
+            needs_set_crtc = true;
+    }
+    overlay_frames.clear();
 
     /*
      * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
@@ -679,6 +801,9 @@ void mgm::DisplayBuffer::post()
     {
         set_crtc(*bufobj);
         needs_set_crtc = false;
+        // Whoever had the CRTC last may have changed which planes we can use
+        plane_allocator.reset();
+        tested_overlay_layout.clear();
     }
 
     using namespace std;  // For operator""ms()
@@ -709,9 +834,10 @@ void mgm::DisplayBuffer::post()
         /*
          * Not in clone mode? We can afford to wait for the page flip then,
          * making us double-buffered (noticeably less laggy than the triple
-         * buffering that clone mode requires).
+         * buffering that clone mode requires). An atomic commit flips all
+         * the clones at once, so they're no worse than a single output.
          */
-        if (outputs.size() == 1)
+        if (outputs.size() == 1 || flipped_atomically)
             wait_for_page_flip();
 
         /*
@@ -734,14 +860,95 @@ void mgm::DisplayBuffer::post()
         auto const min_frame_interval = 1000ms / output->max_refresh_rate();
         if (predicted_render_time < min_frame_interval)
             recommend_sleep = min_frame_interval - predicted_render_time;
+
+        update_frame_period();
     }
 }
 
+void mgm::DisplayBuffer::update_overlay_planes()
+{
+    auto const& output = outputs.front();
+    std::vector<uint32_t> now_in_use;
+
+    for (auto const& frame : overlay_frames)
+    {
+        if (output->set_overlay_plane(frame.plane_id, *frame.bufobj, frame.destination))
+        {
+            scheduled_overlay_buffers.push_back(frame.buffer);
+            now_in_use.push_back(frame.plane_id);
+        }
+        else
+        {
+            /*
+             * The renderable misses this frame. Composite everything from
+             * now on rather than risk it going missing every frame.
+             */
+            mir::log_warning("Failed to set overlay plane %u; disabling overlay planes", frame.plane_id);
+            plane_allocator = std::make_unique<PlaneAllocator>(std::vector<OverlayPlane>{});
+        }
+    }
+
+    for (auto const plane_id : planes_in_use)
+    {
+        if (std::find(now_in_use.begin(), now_in_use.end(), plane_id) == now_in_use.end())
+            output->clear_overlay_plane(plane_id);
+    }
+
+    planes_in_use = std::move(now_in_use);
+}
+
 std::chrono::milliseconds mgm::DisplayBuffer::recommended_sleep() const
 {
     return recommend_sleep;
 }
 
+void mgm::DisplayBuffer::update_frame_period()
+{
+    auto const& output = outputs.front();
+    auto const last = output->last_frame();
+    std::chrono::nanoseconds const one_second{std::chrono::seconds{1}};
+
+    if (last.msc == 0 || output->max_refresh_rate() <= 0)
+        return;
+
+    auto const nominal = one_second / output->max_refresh_rate();
+
+    if (reference_frame.msc == 0 ||
+        reference_frame.ust.clock_id != last.ust.clock_id ||
+        last.msc < reference_frame.msc)
+    {
+        reference_frame = last;
+    }
+
+    frame_period = nominal;
+    if (last.msc > reference_frame.msc)
+    {
+        auto const measured = (last.ust - reference_frame.ust) / (last.msc - reference_frame.msc);
+
+        // Anything further out than this means the mode has changed under us
+        if (measured > nominal * 9 / 10 && measured < nominal * 11 / 10)
+            frame_period = measured;
+        else
+            reference_frame = last;
+    }
+}
+
+std::experimental::optional<mg::Frame> mgm::DisplayBuffer::next_vblank() const
+{
+    // In clone mode the outputs needn't be in phase, so there's no one vblank to aim for
+    if (outputs.size() != 1 || frame_period == frame_period.zero())
+        return {};
+
+    auto const last = outputs.front()->last_frame();
+    auto const now = Frame::Timestamp::now(last.ust.clock_id);
+    auto const frames_since_last = now > last.ust ? (now - last.ust) / frame_period : 0;
+
+    Frame next;
+    next.msc = last.msc + frames_since_last + 1;
+    next.ust = last.ust + (frames_since_last + 1) * frame_period;
+    return next;
+}
+
 bool mgm::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
 {
     /*
@@ -757,6 +964,50 @@ bool mgm::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
     return page_flips_pending;
 }
 
+bool mgm::DisplayBuffer::schedule_atomic_commit(FBHandle const& bufobj)
+{
+    auto const& output = outputs.front();
+    AtomicKMSCommit commit{output->drm_fd()};
+
+    for (auto& clone : outputs)
+    {
+        // One commit can't span devices
+        if (clone->drm_fd() != output->drm_fd() || !clone->add_to_commit(commit, bufobj))
+            return false;
+    }
+
+    // With every output powered off there's nothing to flip, which schedule_page_flip() handles
+    if (commit.flips().empty())
+        return false;
+
+    std::vector<uint32_t> now_in_use;
+    for (auto const& frame : overlay_frames)
+    {
+        if (!output->add_overlay_to_commit(commit, frame.plane_id, frame.bufobj, frame.destination))
+            return false;
+        now_in_use.push_back(frame.plane_id);
+    }
+
+    for (auto const plane_id : planes_in_use)
+    {
+        if (std::find(now_in_use.begin(), now_in_use.end(), plane_id) == now_in_use.end() &&
+            !output->add_overlay_to_commit(commit, plane_id, nullptr, {}))
+        {
+            return false;
+        }
+    }
+
+    if (!output->schedule_commit(commit))
+        return false;
+
+    page_flips_pending = true;
+    for (auto const& frame : overlay_frames)
+        scheduled_overlay_buffers.push_back(frame.buffer);
+    planes_in_use = std::move(now_in_use);
+
+    return true;
+}
+
 void mgm::DisplayBuffer::wait_for_page_flip()
 {
     if (page_flips_pending)
@@ -777,6 +1028,9 @@ void mgm::DisplayBuffer::wait_for_page_flip()
 
         visible_composite_frame = std::move(scheduled_composite_frame);
         scheduled_composite_frame = nullptr;
+
+        visible_overlay_buffers = std::move(scheduled_overlay_buffers);
+        scheduled_overlay_buffers.clear();
     }
 }
 
@@ -45,6 +45,7 @@ class Platform;
 class FBHandle;
 class KMSOutput;
 class NativeBuffer;
+class PlaneAllocator;
 
 class GBMOutputSurface : public renderer::gl::RenderTarget
 {
@@ -112,12 +113,14 @@ public:
     void release_current() override;
     void swap_buffers() override;
     bool overlay(RenderableList const& renderlist) override;
+    bool overlay_where_possible(RenderableList const& renderlist, RenderableList& to_render) override;
     void bind() override;
 
     void for_each_display_buffer(
         std::function<void(graphics::DisplayBuffer&)> const& f) override;
     void post() override;
     std::chrono::milliseconds recommended_sleep() const override;
+    std::experimental::optional<Frame> next_vblank() const override;
 
     glm::mat2 transformation() const override;
     NativeDisplayBuffer* native_display_buffer() override;
@@ -128,11 +131,31 @@ public:
 
 private:
     bool schedule_page_flip(FBHandle const& bufobj);
+    bool schedule_atomic_commit(FBHandle const& bufobj);
+    bool overlays_pass_test();
     void set_crtc(FBHandle const&);
+    void update_frame_period();
+    void update_overlay_planes();
+
+    struct OverlayFrame
+    {
+        uint32_t plane_id;
+        std::shared_ptr<Buffer> buffer;
+        FBHandle* bufobj;
+        geometry::Rectangle destination;
+    };
 
     std::shared_ptr<graphics::Buffer> visible_bypass_frame, scheduled_bypass_frame;
     std::shared_ptr<Buffer> bypass_buf{nullptr};
     FBHandle* bypass_bufobj{nullptr};
+    // Probed on first use, as the CRTC's planes are only known once it is set
+    std::unique_ptr<PlaneAllocator> plane_allocator;
+    std::vector<OverlayFrame> overlay_frames;
+    std::vector<std::shared_ptr<Buffer>> visible_overlay_buffers, scheduled_overlay_buffers;
+    std::vector<uint32_t> planes_in_use;
+    // The last overlay layout the kernel checked for us, and its verdict
+    std::vector<std::pair<uint32_t, geometry::Rectangle>> tested_overlay_layout;
+    bool tested_overlay_layout_ok{false};
     std::shared_ptr<DisplayReport> const listener;
     BypassOption bypass_option;
 
@@ -154,6 +177,10 @@ private:
     glm::mat2 transform;
     std::atomic<bool> needs_set_crtc;
     std::chrono::milliseconds recommend_sleep{0};
+    // Measured between reference_frame and the last flip, as an output's
+    // nominal refresh rate is only accurate to within 1Hz
+    std::chrono::nanoseconds frame_period{0};
+    Frame reference_frame;
     bool page_flips_pending;
 };
 
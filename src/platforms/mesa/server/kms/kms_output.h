@@ -22,6 +22,7 @@
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
 #include "mir/graphics/display_configuration.h"
 #include "mir/graphics/frame.h"
 #include "mir_toolkit/common.h"
@@ -30,6 +31,8 @@
 
 #include <gbm.h>
 
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -40,6 +43,17 @@ namespace mesa
 {
 
 class FBHandle;
+class AtomicKMSCommit;
+
+/**
+ * A hardware plane that can scan out a buffer over an output's primary plane.
+ */
+struct OverlayPlane
+{
+    uint32_t id;
+    /// The DRM fourcc formats the plane can scan out
+    std::vector<uint32_t> formats;
+};
 
 class KMSOutput
 {
@@ -74,6 +88,52 @@ public:
     virtual bool clear_cursor() = 0;
     virtual bool has_cursor() const = 0;
 
+    /**
+     * The overlay planes available to the CRTC driving this output.
+     *
+     * \return The usable overlay planes; empty if the output has no CRTC or
+     *          the driver exposes no overlay planes for it.
+     */
+    virtual std::vector<OverlayPlane> overlay_planes() = 0;
+    /**
+     * Scan out fb, unscaled, on one of this output's overlay planes.
+     *
+     * \param [in] plane_id    One of the planes listed by overlay_planes()
+     * \param [in] fb          The framebuffer to show
+     * \param [in] destination Where to show fb, relative to the top left of
+     *                         the output (as for move_cursor())
+     * \return  True if the plane now shows fb
+     */
+    virtual bool set_overlay_plane(uint32_t plane_id, FBHandle const& fb, geometry::Rectangle const& destination) = 0;
+    virtual void clear_overlay_plane(uint32_t plane_id) = 0;
+
+    /**
+     * Add showing fb on this output (as for schedule_page_flip()) to commit.
+     * An output that is powered off adds nothing, so has no flip to wait for.
+     *
+     * \return  False if this output can't take part in atomic commits, in
+     *          which case commit is unchanged
+     */
+    virtual bool add_to_commit(AtomicKMSCommit& commit, FBHandle const& fb) = 0;
+    /**
+     * Add showing fb on an overlay plane (as for set_overlay_plane()) to
+     * commit, or clearing the plane if fb is null.
+     *
+     * \return  False if this output can't take part in atomic commits or
+     *          is powered off, in which case commit is unchanged
+     */
+    virtual bool add_overlay_to_commit(
+        AtomicKMSCommit& commit,
+        uint32_t plane_id,
+        FBHandle const* fb,
+        geometry::Rectangle const& destination) = 0;
+    /**
+     * Schedule commit, which may include other outputs on the same device,
+     * in place of schedule_page_flip(). Each flipped output must still
+     * wait_for_page_flip().
+     */
+    virtual bool schedule_commit(AtomicKMSCommit& commit) = 0;
+
     virtual void set_power_mode(MirPowerMode mode) = 0;
     virtual void set_gamma(GammaCurves const& gamma) = 0;
     virtual Frame last_frame() const = 0;
@@ -17,6 +17,7 @@
  */
 
 #include "kms_page_flipper.h"
+#include "atomic_kms_commit.h"
 #include "mir/graphics/display_report.h"
 
 #include <stdexcept>
@@ -26,6 +27,7 @@
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 #include <chrono>
+#include <cstdlib>
 #include <cstring>
 
 namespace mg = mir::graphics;
@@ -33,6 +35,11 @@ namespace mgm = mir::graphics::mesa;
 
 namespace
 {
+#ifndef DRM_CAP_CRTC_IN_VBLANK_EVENT
+#define DRM_CAP_CRTC_IN_VBLANK_EVENT 0x12
+#endif
+
+char const* const disable_atomic_env = "MIR_MESA_KMS_DISABLE_ATOMIC";
 
 void page_flip_handler(int /*fd*/, unsigned int seq,
                        unsigned int sec, unsigned int usec,
@@ -44,6 +51,33 @@ void page_flip_handler(int /*fd*/, unsigned int seq,
                                               seq, ns);
 }
 
+/*
+ * An atomic commit gets one event per CRTC, all with the same data, so
+ * we rely on the kernel to tell us which CRTC flipped. Older kernels
+ * report 0, but then we never made an atomic commit.
+ */
+void page_flip_handler2(int /*fd*/, unsigned int seq,
+                        unsigned int sec, unsigned int usec,
+                        unsigned int crtc_id, void* data)
+{
+    auto page_flip_data = static_cast<mgm::PageFlipEventData*>(data);
+    std::chrono::nanoseconds ns{sec*1000000000LL + usec*1000LL};
+    page_flip_data->flipper->notify_page_flip(crtc_id ? crtc_id : page_flip_data->crtc_id,
+                                              seq, ns);
+}
+
+bool enable_atomic_commits(int drm_fd)
+{
+    if (getenv(disable_atomic_env))
+        return false;
+
+    uint64_t crtc_in_event = 0;
+    if (drmGetCap(drm_fd, DRM_CAP_CRTC_IN_VBLANK_EVENT, &crtc_in_event) || !crtc_in_event)
+        return false;
+
+    return drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1) == 0;
+}
+
 }
 
 mgm::KMSPageFlipper::KMSPageFlipper(
@@ -51,6 +85,8 @@ mgm::KMSPageFlipper::KMSPageFlipper(
     std::shared_ptr<DisplayReport> const& report) :
     drm_fd{drm_fd},
     report{report},
+    atomic{enable_atomic_commits(drm_fd)},
+    atomic_flip_data{0, 0, this},
     pending_page_flips(),
     worker_tid()
 {
@@ -88,12 +124,45 @@ bool mgm::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
     return (ret == 0);
 }
 
+bool mgm::KMSPageFlipper::atomic_commits_supported() const
+{
+    return atomic;
+}
+
+bool mgm::KMSPageFlipper::schedule_commit(AtomicKMSCommit& commit)
+{
+    if (!atomic)
+        BOOST_THROW_EXCEPTION(std::logic_error("Atomic commits are not supported"));
+
+    std::unique_lock<std::mutex> lock{pf_mutex};
+
+    for (auto const& flip : commit.flips())
+    {
+        if (pending_page_flips.find(flip.crtc_id) != pending_page_flips.end())
+            BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
+    }
+
+    for (auto const& flip : commit.flips())
+        pending_page_flips[flip.crtc_id] = PageFlipEventData{flip.crtc_id, flip.connector_id, this};
+
+    auto const committed = commit.commit(&atomic_flip_data);
+
+    if (!committed)
+    {
+        for (auto const& flip : commit.flips())
+            pending_page_flips.erase(flip.crtc_id);
+    }
+
+    return committed;
+}
+
 mg::Frame mgm::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
 {
     drmEventContext evctx;
     memset(&evctx, 0, sizeof evctx);
-    evctx.version = 2;  // We only support the old v2 page_flip_handler
+    evctx.version = 3;
     evctx.page_flip_handler = &page_flip_handler;
+    evctx.page_flip_handler2 = &page_flip_handler2;
 
     static std::thread::id const invalid_tid;
 
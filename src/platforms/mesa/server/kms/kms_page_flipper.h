@@ -54,6 +54,8 @@ public:
 
     bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) override;
     Frame wait_for_flip(uint32_t crtc_id) override;
+    bool atomic_commits_supported() const override;
+    bool schedule_commit(AtomicKMSCommit& commit) override;
 
     std::thread::id debug_get_worker_tid();
 
@@ -63,6 +65,9 @@ private:
 
     int const drm_fd;
     std::shared_ptr<DisplayReport> const report;
+    bool const atomic;
+    /* Shared by the events of every CRTC in an atomic commit */
+    PageFlipEventData atomic_flip_data;
     std::unordered_map<uint32_t,PageFlipEventData> pending_page_flips;
     std::unordered_map<uint32_t,Frame> completed_page_flips;
     std::mutex pf_mutex;
@@ -28,6 +28,7 @@ namespace graphics
 {
 namespace mesa
 {
+class AtomicKMSCommit;
 
 class PageFlipper
 {
@@ -37,6 +38,14 @@ public:
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
 
+    /// Whether schedule_commit() may be used on this device
+    virtual bool atomic_commits_supported() const = 0;
+    /**
+     * Schedule an atomic commit, waiting for a page flip on each CRTC
+     * the commit flips.
+     */
+    virtual bool schedule_commit(AtomicKMSCommit& commit) = 0;
+
 protected:
     PageFlipper() = default;
     PageFlipper(PageFlipper const&) = delete;
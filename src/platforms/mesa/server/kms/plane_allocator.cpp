@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "plane_allocator.h"
+
+#include <algorithm>
+
+namespace mg = mir::graphics;
+namespace mgm = mir::graphics::mesa;
+namespace geom = mir::geometry;
+
+namespace
+{
+bool can_be_overlaid(mg::Renderable const& renderable, geom::Rectangle const& area)
+{
+    glm::mat4 static const identity(1);
+
+    return renderable.alpha() == 1.0f &&
+           !renderable.shaped() &&
+           renderable.transformation() == identity &&
+           area.contains(renderable.screen_position());
+}
+}
+
+mgm::PlaneAllocator::PlaneAllocator(std::vector<OverlayPlane> const& planes)
+    : planes(planes)
+{
+}
+
+bool mgm::PlaneAllocator::empty() const
+{
+    return planes.empty();
+}
+
+auto mgm::PlaneAllocator::allocate(
+    RenderableList const& renderables,
+    geom::Rectangle const& area,
+    ScanoutFormat const& scanout_format,
+    RenderableList& to_composite) const -> std::vector<Allocation>
+{
+    std::vector<Allocation> allocations;
+    std::vector<bool> plane_used(planes.size(), false);
+    // Everything on screen above the renderable being considered
+    std::vector<geom::Rectangle> above;
+    geom::Point const origin;
+
+    to_composite.clear();
+
+    for (auto r = renderables.rbegin(); r != renderables.rend(); ++r)
+    {
+        auto const& renderable = *r;
+        auto const position = renderable->screen_position();
+
+        if (!area.overlaps(position))
+        {
+            to_composite.push_back(renderable);
+            continue;
+        }
+
+        bool overlaid = false;
+
+        if (allocations.size() < planes.size() &&
+            can_be_overlaid(*renderable, area) &&
+            std::none_of(above.begin(), above.end(),
+                [&](geom::Rectangle const& rect) { return rect.overlaps(position); }))
+        {
+            if (auto const format = scanout_format(*renderable))
+            {
+                for (size_t i = 0; i != planes.size() && !overlaid; ++i)
+                {
+                    auto const& formats = planes[i].formats;
+                    if (!plane_used[i] && std::find(formats.begin(), formats.end(), format) != formats.end())
+                    {
+                        plane_used[i] = true;
+                        allocations.push_back(
+                            {renderable, planes[i].id, {origin + (position.top_left - area.top_left), position.size}});
+                        overlaid = true;
+                    }
+                }
+            }
+        }
+
+        if (!overlaid)
+            to_composite.push_back(renderable);
+
+        above.push_back(position);
+    }
+
+    std::reverse(to_composite.begin(), to_composite.end());
+    return allocations;
+}
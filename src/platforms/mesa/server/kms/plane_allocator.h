@@ -0,0 +1,82 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_MESA_PLANE_ALLOCATOR_H_
+#define MIR_GRAPHICS_MESA_PLANE_ALLOCATOR_H_
+
+#include "kms_output.h"
+#include "mir/graphics/renderable.h"
+
+#include <functional>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace mesa
+{
+
+/**
+ * Decides which renderables can be shown on overlay planes instead of being
+ * composited onto the primary plane.
+ *
+ * Overlay planes are stacked above the primary plane in an unspecified
+ * order, so a renderable is only given a plane if it is opaque, untransformed
+ * and entirely on screen, and nothing else shown above it overlaps it.
+ */
+class PlaneAllocator
+{
+public:
+    /// The DRM fourcc format in which a renderable's buffer can be scanned out
+    /// unscaled, or 0 if it cannot be scanned out directly.
+    typedef std::function<uint32_t(Renderable const&)> ScanoutFormat;
+
+    struct Allocation
+    {
+        std::shared_ptr<Renderable> renderable;
+        uint32_t plane_id;
+        /// Where to show the renderable, relative to the top left of the area
+        geometry::Rectangle destination;
+    };
+
+    explicit PlaneAllocator(std::vector<OverlayPlane> const& planes);
+
+    /**
+     * \param [in]  renderables   The renderables to show, bottom to top
+     * \param [in]  area          The screen area covered by the planes
+     * \param [in]  scanout_format  Queried only for otherwise eligible renderables
+     * \param [out] to_composite  The renderables (bottom to top) left for the
+     *                            primary plane
+     * \return The renderables given an overlay plane, top to bottom
+     */
+    std::vector<Allocation> allocate(
+        RenderableList const& renderables,
+        geometry::Rectangle const& area,
+        ScanoutFormat const& scanout_format,
+        RenderableList& to_composite) const;
+
+    bool empty() const;
+
+private:
+    std::vector<OverlayPlane> const planes;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_MESA_PLANE_ALLOCATOR_H_ */
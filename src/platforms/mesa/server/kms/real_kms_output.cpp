@@ -19,6 +19,7 @@
 #include "real_kms_output.h"
 #include "mir/graphics/display_configuration.h"
 #include "page_flipper.h"
+#include "atomic_kms_commit.h"
 #include "kms-utils/kms_connector.h"
 #include "mir/fatal.h"
 #include "mir/log.h"
@@ -67,6 +68,38 @@ void bo_user_data_destroy(gbm_bo* /*bo*/, void *data)
     delete bufobj;
 }
 
+/*
+ * Call visit for each plane of the given type that crtc_id may use.
+ * Without DRM_CLIENT_CAP_UNIVERSAL_PLANES (implied by atomic commits) the
+ * kernel only lists overlay planes, and those may lack a "type" property.
+ */
+template<typename Visitor>
+void for_each_plane(int drm_fd, uint32_t crtc_id, uint64_t type, Visitor visit)
+{
+    mgk::DRMModeResources resources{drm_fd};
+    int crtc_index = 0;
+    for (auto& crtc : resources.crtcs())
+    {
+        if (crtc->crtc_id == crtc_id)
+            break;
+        ++crtc_index;
+    }
+
+    mgk::PlaneResources plane_res{drm_fd};
+    for (auto& plane : plane_res.planes())
+    {
+        if (!(plane->possible_crtcs & (1 << crtc_index)))
+            continue;
+
+        mgk::ObjectProperties plane_props{drm_fd, plane};
+        uint64_t const plane_type =
+            plane_props.has_property("type") ? plane_props["type"] : DRM_PLANE_TYPE_OVERLAY;
+
+        if (plane_type == type)
+            visit(plane);
+    }
+}
+
 }
 
 mgm::RealKMSOutput::RealKMSOutput(
@@ -81,7 +114,9 @@ mgm::RealKMSOutput::RealKMSOutput(
       saved_crtc(),
       using_saved_crtc{true},
       has_cursor_{false},
-      power_mode(mir_power_mode_on)
+      power_mode(mir_power_mode_on),
+      primary_plane_id{0},
+      primary_plane_crtc_id{0}
 {
     reset();
 
@@ -302,6 +337,170 @@ bool mgm::RealKMSOutput::has_cursor() const
     return has_cursor_;
 }
 
+std::vector<mgm::OverlayPlane> mgm::RealKMSOutput::overlay_planes()
+{
+    std::vector<OverlayPlane> overlays;
+
+    try
+    {
+        if (!ensure_crtc())
+            return overlays;
+
+        for_each_plane(drm_fd_, current_crtc->crtc_id, DRM_PLANE_TYPE_OVERLAY,
+            [&](mgk::DRMModePlaneUPtr const& plane)
+            {
+                overlays.push_back(
+                    {plane->plane_id, {plane->formats, plane->formats + plane->count_formats}});
+            });
+    }
+    catch (std::exception const& error)
+    {
+        mir::log_info("Not using overlay planes on output %s: %s",
+                      mgk::connector_name(connector).c_str(), error.what());
+        overlays.clear();
+    }
+
+    return overlays;
+}
+
+bool mgm::RealKMSOutput::set_overlay_plane(
+    uint32_t plane_id,
+    FBHandle const& fb,
+    geometry::Rectangle const& destination)
+{
+    if (!current_crtc)
+        return false;
+
+    uint32_t const width = destination.size.width.as_uint32_t();
+    uint32_t const height = destination.size.height.as_uint32_t();
+
+    // The source rectangle is in 16.16 fixed point
+    if (auto result = drmModeSetPlane(drm_fd_, plane_id, current_crtc->crtc_id, fb.get_drm_fb_id(), 0,
+                                      destination.top_left.x.as_int(), destination.top_left.y.as_int(),
+                                      width, height,
+                                      0, 0, width << 16, height << 16))
+    {
+        mir::log_warning("set_overlay_plane: drmModeSetPlane failed (%s)",
+                         strerror(-result));
+        return false;
+    }
+
+    return true;
+}
+
+void mgm::RealKMSOutput::clear_overlay_plane(uint32_t plane_id)
+{
+    if (!current_crtc)
+        return;
+
+    if (auto result = drmModeSetPlane(drm_fd_, plane_id, current_crtc->crtc_id, 0, 0,
+                                      0, 0, 0, 0, 0, 0, 0, 0))
+    {
+        mir::log_warning("clear_overlay_plane: drmModeSetPlane failed (%s)",
+                         strerror(-result));
+    }
+}
+
+bool mgm::RealKMSOutput::add_to_commit(AtomicKMSCommit& commit, FBHandle const& fb)
+{
+    std::unique_lock<std::mutex> lg(power_mutex);
+    if (power_mode != mir_power_mode_on)
+        return true;
+    if (!page_flipper->atomic_commits_supported() || !current_crtc)
+        return false;
+
+    auto const primary = atomic_primary_plane();
+    if (!primary)
+        return false;
+
+    auto const& mode = connector->modes[mode_index];
+    commit.set_plane(
+        *primary,
+        current_crtc->crtc_id,
+        fb.get_drm_fb_id(),
+        {{0, 0}, {mode.hdisplay, mode.vdisplay}},
+        {fb_offset.dx.as_int(), fb_offset.dy.as_int()});
+    commit.flip(current_crtc->crtc_id, connector->connector_id);
+    return true;
+}
+
+bool mgm::RealKMSOutput::add_overlay_to_commit(
+    AtomicKMSCommit& commit,
+    uint32_t plane_id,
+    FBHandle const* fb,
+    geometry::Rectangle const& destination)
+{
+    std::unique_lock<std::mutex> lg(power_mutex);
+    // The planes of a powered off CRTC are left as they are, for the legacy path to manage
+    if (power_mode != mir_power_mode_on)
+        return false;
+    if (!page_flipper->atomic_commits_supported() || !current_crtc)
+        return false;
+
+    auto const plane = atomic_plane(plane_id);
+    if (!plane)
+        return false;
+
+    if (fb)
+        commit.set_plane(*plane, current_crtc->crtc_id, fb->get_drm_fb_id(), destination, {0, 0});
+    else
+        commit.clear_plane(*plane);
+    return true;
+}
+
+bool mgm::RealKMSOutput::schedule_commit(AtomicKMSCommit& commit)
+{
+    return page_flipper->schedule_commit(commit);
+}
+
+mgm::AtomicPlane const* mgm::RealKMSOutput::atomic_plane(uint32_t plane_id)
+{
+    auto found = atomic_planes.find(plane_id);
+    if (found == atomic_planes.end())
+    {
+        try
+        {
+            found = atomic_planes.emplace(plane_id, AtomicPlane{drm_fd_, plane_id}).first;
+        }
+        catch (std::exception const& error)
+        {
+            mir::log_warning("Plane %u can't be used in atomic commits: %s", plane_id, error.what());
+            return nullptr;
+        }
+    }
+
+    return &found->second;
+}
+
+mgm::AtomicPlane const* mgm::RealKMSOutput::atomic_primary_plane()
+{
+    if (primary_plane_crtc_id != current_crtc->crtc_id)
+    {
+        primary_plane_id = 0;
+        try
+        {
+            /* Prefer the primary plane already showing this CRTC */
+            for_each_plane(drm_fd_, current_crtc->crtc_id, DRM_PLANE_TYPE_PRIMARY,
+                [this](mgk::DRMModePlaneUPtr const& plane)
+                {
+                    if (!primary_plane_id || plane->crtc_id == current_crtc->crtc_id)
+                        primary_plane_id = plane->plane_id;
+                });
+        }
+        catch (std::exception const& error)
+        {
+            mir::log_warning("Output %s has no usable primary plane: %s",
+                             mgk::connector_name(connector).c_str(), error.what());
+        }
+        primary_plane_crtc_id = current_crtc->crtc_id;
+    }
+
+    if (!primary_plane_id)
+        return nullptr;
+
+    return atomic_plane(primary_plane_id);
+}
+
 bool mgm::RealKMSOutput::ensure_crtc()
 {
     /* Nothing to do if we already have a crtc */
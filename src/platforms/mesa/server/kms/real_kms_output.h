@@ -21,10 +21,12 @@
 
 #include "mir/graphics/atomic_frame.h"
 #include "kms_output.h"
+#include "atomic_kms_commit.h"
 #include "kms-utils/drm_mode_resources.h"
 
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 
 namespace mir
 {
@@ -61,6 +63,18 @@ public:
     bool clear_cursor() override;
     bool has_cursor() const override;
 
+    std::vector<OverlayPlane> overlay_planes() override;
+    bool set_overlay_plane(uint32_t plane_id, FBHandle const& fb, geometry::Rectangle const& destination) override;
+    void clear_overlay_plane(uint32_t plane_id) override;
+
+    bool add_to_commit(AtomicKMSCommit& commit, FBHandle const& fb) override;
+    bool add_overlay_to_commit(
+        AtomicKMSCommit& commit,
+        uint32_t plane_id,
+        FBHandle const* fb,
+        geometry::Rectangle const& destination) override;
+    bool schedule_commit(AtomicKMSCommit& commit) override;
+
     void set_power_mode(MirPowerMode mode) override;
     void set_gamma(GammaCurves const& gamma) override;
 
@@ -76,6 +90,8 @@ public:
 private:
     bool ensure_crtc();
     void restore_saved_crtc();
+    AtomicPlane const* atomic_plane(uint32_t plane_id);
+    AtomicPlane const* atomic_primary_plane();
 
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
@@ -93,6 +109,10 @@ private:
 
     std::mutex power_mutex;
 
+    std::unordered_map<uint32_t, AtomicPlane> atomic_planes;
+    uint32_t primary_plane_id;
+    uint32_t primary_plane_crtc_id;
+
     AtomicFrame last_frame_;
 };
 
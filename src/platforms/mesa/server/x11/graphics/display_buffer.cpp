@@ -179,3 +179,8 @@ std::chrono::milliseconds mgx::DisplayBuffer::recommended_sleep() const
 {
     return std::chrono::milliseconds::zero();
 }
+
+std::experimental::optional<mg::Frame> mgx::DisplayBuffer::next_vblank() const
+{
+    return {};
+}
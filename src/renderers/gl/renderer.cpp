@@ -34,16 +34,26 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
 #include <cmath>
+#include <cstring>
+#include <algorithm>
 
 namespace mg = mir::graphics;
 namespace mgl = mir::gl;
 namespace mrg = mir::renderer::gl;
 namespace geom = mir::geometry;
 
+namespace
+{
+// Each scissor rectangle costs a pass over the renderables, so beyond this
+// we redraw the bounding rectangle of the damage instead.
+unsigned int const max_scissor_rects{4};
+}
+
 mrg::CurrentRenderTarget::CurrentRenderTarget(mg::DisplayBuffer* display_buffer)
     : render_target{
         dynamic_cast<renderer::gl::RenderTarget*>(display_buffer->native_display_buffer())}
@@ -137,12 +147,17 @@ mrg::Renderer::Renderer(graphics::DisplayBuffer& display_buffer)
       default_program(family.add_program(vshader, default_fshader)),
       alpha_program(family.add_program(vshader, alpha_fshader)),
       texture_cache(mgl::DefaultProgramFactory().create_texture_cache()),
-      display_transform(1)
+      display_transform(1),
+      buffer_age_supported{false},
+      last_bytes_uploaded{0}
 {
     eglBindAPI(MIR_SERVER_EGL_OPENGL_API);
     EGLDisplay disp = eglGetCurrentDisplay();
     if (disp != EGL_NO_DISPLAY)
     {
+        auto const extensions = eglQueryString(disp, EGL_EXTENSIONS);
+        buffer_age_supported = extensions && strstr(extensions, "EGL_EXT_buffer_age");
+
         struct {GLint id; char const* label;} const eglstrings[] =
         {
             {EGL_VENDOR,      "EGL vendor"},
@@ -207,16 +222,38 @@ void mrg::Renderer::render(mg::RenderableList const& renderables) const
 
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT);
 
     ++frameno;
-    for (auto const& r : renderables)
-        draw(*r, r->alpha() < 1.0f ? alpha_program : default_program);
+    auto const scissors = scissor_rects();
+    damage = std::experimental::nullopt;
+
+    if (!scissors)
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        for (auto const& r : renderables)
+            draw(*r, r->alpha() < 1.0f ? alpha_program : default_program);
+    }
+    else
+    {
+        glEnable(GL_SCISSOR_TEST);
+        for (auto const& scissor : *scissors)
+        {
+            glScissor(scissor.top_left.x.as_int(), scissor.top_left.y.as_int(),
+                      scissor.size.width.as_int(), scissor.size.height.as_int());
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            for (auto const& r : renderables)
+                draw(*r, r->alpha() < 1.0f ? alpha_program : default_program);
+        }
+        glDisable(GL_SCISSOR_TEST);
+    }
 
     render_target.swap_buffers();
 
     // Deleting unused textures only requires the GL context. This clean-up
     // does not affect screen contents so can happen after swap_buffers...
+    last_bytes_uploaded = texture_cache->bytes_uploaded();
     texture_cache->drop_unused();
 
     while (auto const gl_error = glGetError())
@@ -412,6 +449,11 @@ void mrg::Renderer::update_gl_viewport()
         GLint offset_y = (buf_height - reduced_height) / 2;
 
         glViewport(offset_x, offset_y, reduced_width, reduced_height);
+        gl_viewport = geom::Rectangle{{offset_x, offset_y}, {reduced_width, reduced_height}};
+    }
+    else
+    {
+        gl_viewport = std::experimental::nullopt;
     }
 }
 
@@ -430,3 +472,95 @@ void mrg::Renderer::suspend()
     texture_cache->invalidate();
 }
 
+unsigned int mrg::Renderer::buffer_age() const
+{
+    if (!buffer_age_supported)
+        return 0;
+
+    render_target.bind();
+
+    // If the render target draws into an FBO the EGL surface's age is meaningless
+    GLint framebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+    if (framebuffer != 0)
+        return 0;
+
+    EGLint age = 0;
+    if (!eglQuerySurface(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW), EGL_BUFFER_AGE_EXT, &age) ||
+        age < 0)
+    {
+        return 0;
+    }
+
+    return age;
+}
+
+void mrg::Renderer::set_damage(geom::Rectangles const& new_damage)
+{
+    damage = new_damage;
+}
+
+std::size_t mrg::Renderer::bytes_uploaded() const
+{
+    return last_bytes_uploaded;
+}
+
+/*
+ * Converts the damage from viewport coordinates into GL window coordinates.
+ * Returns nullopt if everything needs redrawing.
+ */
+std::experimental::optional<std::vector<geom::Rectangle>> mrg::Renderer::scissor_rects() const
+{
+    static glm::mat4 const identity(1);
+
+    if (!damage || !gl_viewport || display_transform != identity ||
+        viewport.size.width.as_int() <= 0 || viewport.size.height.as_int() <= 0)
+    {
+        return {};
+    }
+
+    std::vector<geom::Rectangle> damaged;
+    for (auto const& r : *damage)
+    {
+        auto const clipped = r.intersection_with(viewport);
+        if (clipped.size.width.as_int() <= 0 || clipped.size.height.as_int() <= 0)
+            continue;
+
+        auto const covered = std::any_of(damaged.begin(), damaged.end(),
+            [&](geom::Rectangle const& d) { return d.contains(clipped); });
+        if (!covered)
+            damaged.push_back(clipped);
+    }
+
+    if (damaged.size() > max_scissor_rects)
+    {
+        geom::Rectangles all;
+        for (auto const& d : damaged)
+            all.add(d);
+        damaged = {all.bounding_rectangle()};
+    }
+
+    auto const& gl = *gl_viewport;
+    double const scale_x = double(gl.size.width.as_int()) / viewport.size.width.as_int();
+    double const scale_y = double(gl.size.height.as_int()) / viewport.size.height.as_int();
+
+    std::vector<geom::Rectangle> scissors;
+    for (auto const& d : damaged)
+    {
+        auto const left = static_cast<int>(
+            std::floor((d.top_left.x.as_int() - viewport.top_left.x.as_int()) * scale_x));
+        auto const right = static_cast<int>(
+            std::ceil((d.bottom_right().x.as_int() - viewport.top_left.x.as_int()) * scale_x));
+        auto const top = static_cast<int>(
+            std::floor((d.top_left.y.as_int() - viewport.top_left.y.as_int()) * scale_y));
+        auto const bottom = static_cast<int>(
+            std::ceil((d.bottom_right().y.as_int() - viewport.top_left.y.as_int()) * scale_y));
+
+        // GL window coordinates start at the bottom left
+        scissors.push_back({
+            {gl.top_left.x.as_int() + left, gl.top_left.y.as_int() + gl.size.height.as_int() - bottom},
+            {right - left, bottom - top}});
+    }
+
+    return scissors;
+}
@@ -29,6 +29,7 @@
 #include "mir/renderer/gl/render_target.h"
 
 #include MIR_SERVER_GL_H
+#include <experimental/optional>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -67,6 +68,10 @@ public:
     void set_output_transform(glm::mat2 const&) override;
     void render(graphics::RenderableList const&) const override;
 
+    unsigned int buffer_age() const override;
+    void set_damage(geometry::Rectangles const& damage) override;
+    std::size_t bytes_uploaded() const override;
+
     // This is called _without_ a GL context:
     void suspend() override;
 
@@ -124,12 +129,17 @@ protected:
 
 private:
     void update_gl_viewport();
+    std::experimental::optional<std::vector<geometry::Rectangle>> scissor_rects() const;
 
     std::unique_ptr<mir::gl::TextureCache> const texture_cache;
     geometry::Rectangle viewport;
     glm::mat4 screen_to_gl_coords;
     glm::mat4 display_transform;
     std::vector<mir::gl::Primitive> mutable primitives;
+    std::experimental::optional<geometry::Rectangle> gl_viewport; // in GL window coordinates
+    bool buffer_age_supported;
+    std::experimental::optional<geometry::Rectangles> mutable damage;
+    std::size_t mutable last_bytes_uploaded;
 };
 
 }
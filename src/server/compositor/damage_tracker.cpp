@@ -0,0 +1,209 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "damage_tracker.h"
+#include "mir/graphics/buffer.h"
+#include "mir/geometry/displacement.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+// Enough for triple buffering with some slack
+unsigned int const max_buffer_age{4};
+
+glm::mat4 const identity(1);
+
+void add_damage(geom::Rectangles& damage, geom::Rectangle const& rect, geom::Rectangle const& area)
+{
+    auto const clipped = rect.intersection_with(area);
+    if (clipped.size.width.as_int() > 0 && clipped.size.height.as_int() > 0)
+        damage.add(clipped);
+}
+
+// Transformed renderables may draw anywhere, so they damage the whole area
+geom::Rectangle damaged_by(
+    geom::Rectangle const& position, glm::mat4 const& transformation, geom::Rectangle const& area)
+{
+    return transformation == identity ? position : area;
+}
+
+// Scales damage from buffer coordinates to the screen position the buffer is drawn at
+geom::Rectangle to_screen(geom::Rectangle const& damage, geom::Size const& buffer_size, geom::Rectangle const& position)
+{
+    if (buffer_size == position.size)
+        return {position.top_left + (damage.top_left - geom::Point{}), damage.size};
+
+    if (buffer_size.width.as_int() <= 0 || buffer_size.height.as_int() <= 0)
+        return position;
+
+    double const scale_x = double(position.size.width.as_int()) / buffer_size.width.as_int();
+    double const scale_y = double(position.size.height.as_int()) / buffer_size.height.as_int();
+
+    auto const left = static_cast<int>(std::floor(damage.top_left.x.as_int() * scale_x));
+    auto const top = static_cast<int>(std::floor(damage.top_left.y.as_int() * scale_y));
+    auto const right = static_cast<int>(std::ceil(damage.bottom_right().x.as_int() * scale_x));
+    auto const bottom = static_cast<int>(std::ceil(damage.bottom_right().y.as_int() * scale_y));
+
+    return {position.top_left + geom::Displacement{left, top}, geom::Size{right - left, bottom - top}};
+}
+}
+
+mc::DamageTracker::DamageTracker() :
+    previous_output_transformation(1),
+    previous_valid{false}
+{
+}
+
+geom::Rectangles mc::DamageTracker::damage_for(
+    mg::RenderableList const& renderables,
+    geom::Rectangle const& area,
+    glm::mat2 const& output_transformation,
+    unsigned int buffer_age)
+{
+    std::vector<RenderedState> current;
+    current.reserve(renderables.size());
+    for (auto const& r : renderables)
+    {
+        current.push_back({
+            r->id(),
+            r->screen_position(),
+            r->alpha(),
+            r->transformation(),
+            r->shaped(),
+            r->buffer()->id()});
+    }
+
+    if (previous_valid && area == previous_area && output_transformation == previous_output_transformation)
+        history.push_front(frame_damage(current, renderables, area));
+    else
+        history.push_front({area});
+
+    if (history.size() > max_buffer_age)
+        history.pop_back();
+
+    previous = std::move(current);
+    previous_area = area;
+    previous_output_transformation = output_transformation;
+    previous_valid = true;
+
+    if (buffer_age == 0 || buffer_age > history.size())
+        return {area};
+
+    geom::Rectangles damage;
+    for (unsigned int i = 0; i != buffer_age; ++i)
+    {
+        for (auto const& r : history[i])
+            damage.add(r);
+    }
+    return damage;
+}
+
+void mc::DamageTracker::reset()
+{
+    previous.clear();
+    previous_valid = false;
+    history.clear();
+}
+
+geom::Rectangles mc::DamageTracker::frame_damage(
+    std::vector<RenderedState> const& current,
+    mg::RenderableList const& renderables,
+    geom::Rectangle const& area) const
+{
+    geom::Rectangles damage;
+
+    std::unordered_map<mg::Renderable::ID, RenderedState const*> previous_by_id;
+    for (auto const& p : previous)
+        previous_by_id[p.id] = &p;
+
+    std::unordered_set<mg::Renderable::ID> current_ids;
+    for (auto i = 0u; i != current.size(); ++i)
+    {
+        auto const& now = current[i];
+        current_ids.insert(now.id);
+
+        auto const found = previous_by_id.find(now.id);
+        if (found == previous_by_id.end())
+        {
+            add_damage(damage, damaged_by(now.screen_position, now.transformation, area), area);
+            continue;
+        }
+
+        auto const& before = *found->second;
+        if (now.screen_position != before.screen_position ||
+            now.alpha != before.alpha ||
+            now.transformation != before.transformation ||
+            now.shaped != before.shaped)
+        {
+            add_damage(damage, damaged_by(before.screen_position, before.transformation, area), area);
+            add_damage(damage, damaged_by(now.screen_position, now.transformation, area), area);
+            continue;
+        }
+
+        auto const& renderable = *renderables[i];
+        if (auto const buffer_damage = renderable.buffer_damage())
+        {
+            auto const buffer_size = renderable.buffer()->size();
+            for (auto const& d : *buffer_damage)
+            {
+                if (now.transformation == identity)
+                    add_damage(damage, to_screen(d, buffer_size, now.screen_position), area);
+                else
+                    add_damage(damage, area, area);
+            }
+        }
+        else if (now.buffer_id != before.buffer_id)
+        {
+            add_damage(damage, damaged_by(now.screen_position, now.transformation, area), area);
+        }
+    }
+
+    std::vector<RenderedState const*> previous_order;
+    for (auto const& p : previous)
+    {
+        if (current_ids.count(p.id))
+            previous_order.push_back(&p);
+        else
+            add_damage(damage, damaged_by(p.screen_position, p.transformation, area), area);
+    }
+
+    // Restacking doesn't change any renderable, but does change the screen
+    std::vector<RenderedState const*> current_order;
+    for (auto const& c : current)
+    {
+        if (previous_by_id.count(c.id))
+            current_order.push_back(&c);
+    }
+
+    for (auto i = 0u; i != current_order.size() && i != previous_order.size(); ++i)
+    {
+        if (current_order[i]->id != previous_order[i]->id)
+        {
+            add_damage(damage, damaged_by(current_order[i]->screen_position, current_order[i]->transformation, area), area);
+            add_damage(damage, damaged_by(previous_order[i]->screen_position, previous_order[i]->transformation, area), area);
+        }
+    }
+
+    return damage;
+}
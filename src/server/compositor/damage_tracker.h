@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_DAMAGE_TRACKER_H_
+#define MIR_COMPOSITOR_DAMAGE_TRACKER_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/graphics/renderable.h"
+#include "mir/graphics/buffer_id.h"
+
+#include <glm/glm.hpp>
+#include <deque>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+
+/**
+ * Works out which parts of a DisplayBuffer need redrawing by comparing the
+ * renderables of successive frames, and keeps enough history to account
+ * for the age of the buffer being drawn into.
+ */
+class DamageTracker
+{
+public:
+    DamageTracker();
+
+    /**
+     * Records the renderables about to be rendered to area and returns the
+     * regions of area a buffer last drawn buffer_age frames ago needs
+     * redrawing (buffer_age zero meaning the buffer contents are undefined).
+     */
+    geometry::Rectangles damage_for(
+        graphics::RenderableList const& renderables,
+        geometry::Rectangle const& area,
+        glm::mat2 const& output_transformation,
+        unsigned int buffer_age);
+
+    /// Forgets previous frames (e.g. because they were not rendered by us)
+    void reset();
+
+private:
+    struct RenderedState
+    {
+        graphics::Renderable::ID id;
+        geometry::Rectangle screen_position;
+        float alpha;
+        glm::mat4 transformation;
+        bool shaped;
+        graphics::BufferID buffer_id;
+    };
+
+    geometry::Rectangles frame_damage(
+        std::vector<RenderedState> const& current,
+        graphics::RenderableList const& renderables,
+        geometry::Rectangle const& area) const;
+
+    std::vector<RenderedState> previous;
+    geometry::Rectangle previous_area;
+    glm::mat2 previous_output_transformation;
+    bool previous_valid;
+    std::deque<geometry::Rectangles> history; // most recent first
+};
+
+}
+}
+
+#endif // MIR_COMPOSITOR_DAMAGE_TRACKER_H_
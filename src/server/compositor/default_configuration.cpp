@@ -25,6 +25,7 @@
 #include "gl/renderer_factory.h"
 #include "compositing_screencast.h"
 #include "mir/main_loop.h"
+#include "mir/compositor/presentation_clock.h"
 
 #include "mir/frontend/screencast.h"
 #include "mir/options/configuration.h"
@@ -78,11 +79,22 @@ mir::DefaultServerConfiguration::the_compositor()
                 the_display_buffer_compositor_factory(),
                 the_shell(),
                 the_compositor_report(),
+                the_presentation_clock(),
                 composite_delay,
                 !the_options()->is_set(options::host_socket_opt));
         });
 }
 
+std::shared_ptr<mc::PresentationClock>
+mir::DefaultServerConfiguration::the_presentation_clock()
+{
+    return presentation_clock(
+        []()
+        {
+            return std::make_shared<mc::PresentationClock>();
+        });
+}
+
 std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration::the_renderer_factory()
 {
     return renderer_factory(
@@ -72,19 +72,28 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
      */
     scene_elements.clear();  // Those in use are still in renderable_list
 
-    if (display_buffer.overlay(renderable_list))
+    // Any renderables the display hardware can't show itself are left for us
+    mg::RenderableList to_render;
+    if (display_buffer.overlay_where_possible(renderable_list, to_render))
     {
+        // The renderer's buffers miss this frame, so their history is no use
+        damage.reset();
+
         report->renderables_in_frame(this, renderable_list);
         renderer->suspend();
     }
     else
     {
-        renderer->set_output_transform(display_buffer.transformation());
+        auto const transformation = display_buffer.transformation();
+        renderer->set_output_transform(transformation);
         renderer->set_viewport(view_area);
-        renderer->render(renderable_list);
+        renderer->set_damage(
+            damage.damage_for(to_render, view_area, transformation, renderer->buffer_age()));
+        renderer->render(to_render);
 
         report->renderables_in_frame(this, renderable_list);
         report->rendered_frame(this);
+        report->uploaded_textures(this, renderer->bytes_uploaded());
 
         /*
          * This is used for the 'early release' optimization to release buffers
@@ -97,6 +106,7 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
          *        problematic IPC (LP: #1395421) will instead occur in buffer
          *        acquisition calls when we composite the next frame.
          */
+        to_render.clear();
         renderable_list.clear();
     }
 
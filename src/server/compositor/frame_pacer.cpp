@@ -0,0 +1,71 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "frame_pacer.h"
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+
+using namespace std::literals::chrono_literals;
+
+namespace
+{
+// Until we've measured anything assume a frame takes most of a 60Hz frame
+auto const initial_render_time = 10ms;
+
+// Covers the GPU finishing after post() and scheduling jitter
+auto const min_margin = 2ms;
+auto const max_margin = 8ms;
+auto const margin_step = 1ms;
+
+// Roughly two seconds at 60Hz without a miss before trimming the margin
+unsigned int const frames_before_trimming_margin = 120;
+}
+
+mc::FramePacer::FramePacer() :
+    next_render_time{0},
+    margin{min_margin},
+    frames_since_miss{0}
+{
+    render_times.fill(initial_render_time);
+}
+
+std::chrono::nanoseconds mc::FramePacer::lead_time() const
+{
+    // Use the worst recent frame; a single slow frame is far more visible
+    // than a frame's worth of latency saved on average.
+    return *std::max_element(render_times.begin(), render_times.end()) + margin;
+}
+
+void mc::FramePacer::frame_rendered(std::chrono::nanoseconds render_time)
+{
+    render_times[next_render_time] = render_time;
+    next_render_time = (next_render_time + 1) % render_times.size();
+
+    if (++frames_since_miss >= frames_before_trimming_margin)
+    {
+        margin = std::max<std::chrono::nanoseconds>(margin - margin_step, min_margin);
+        frames_since_miss = 0;
+    }
+}
+
+void mc::FramePacer::vblank_missed()
+{
+    margin = std::min<std::chrono::nanoseconds>(margin + margin_step, max_margin);
+    frames_since_miss = 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_COMPOSITOR_FRAME_PACER_H_
+#define MIR_COMPOSITOR_FRAME_PACER_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+namespace mir
+{
+namespace compositor
+{
+
+/**
+ * Predicts how long before a vblank compositing has to start for the frame
+ * to be posted in time, from the render times of recent frames plus a safety
+ * margin that grows when a vblank is missed and slowly shrinks back while
+ * frames keep making it.
+ */
+class FramePacer
+{
+public:
+    FramePacer();
+
+    /// How long before the target vblank to sample the scene and start rendering
+    std::chrono::nanoseconds lead_time() const;
+
+    /// Records how long a frame took from sampling the scene to post()
+    void frame_rendered(std::chrono::nanoseconds render_time);
+
+    /// Records that a frame paced by lead_time() missed its vblank
+    void vblank_missed();
+
+private:
+    std::array<std::chrono::nanoseconds, 16> render_times;
+    std::size_t next_render_time;
+    std::chrono::nanoseconds margin;
+    unsigned int frames_since_miss;
+};
+
+}
+}
+
+#endif /* MIR_COMPOSITOR_FRAME_PACER_H_ */
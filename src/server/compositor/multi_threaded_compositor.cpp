@@ -17,6 +17,7 @@
  */
 
 #include "multi_threaded_compositor.h"
+#include "frame_pacer.h"
 #include "mir/graphics/display.h"
 #include "mir/graphics/display_buffer.h"
 #include "mir/compositor/display_buffer_compositor.h"
@@ -24,6 +25,7 @@
 #include "mir/compositor/display_listener.h"
 #include "mir/compositor/scene.h"
 #include "mir/compositor/compositor_report.h"
+#include "mir/compositor/presentation_clock.h"
 #include "mir/scene/legacy_scene_change_notification.h"
 #include "mir/scene/surface_observer.h"
 #include "mir/scene/surface.h"
@@ -57,7 +59,8 @@ public:
         std::shared_ptr<mc::Scene> const& scene,
         std::shared_ptr<DisplayListener> const& display_listener,
         std::chrono::milliseconds fixed_composite_delay,
-        std::shared_ptr<CompositorReport> const& report) :
+        std::shared_ptr<CompositorReport> const& report,
+        std::shared_ptr<PresentationClock> const& presentation_clock) :
         compositor_factory{db_compositor_factory},
         group(group),
         scene(scene),
@@ -66,6 +69,7 @@ public:
         force_sleep{fixed_composite_delay},
         display_listener{display_listener},
         report{report},
+        presentation_clock{presentation_clock},
         started_future{started.get_future()}
     {
     }
@@ -108,6 +112,17 @@ public:
                     scene->unregister_compositor(std::get<1>(compositor).get());
             });
 
+        {
+            std::lock_guard<std::mutex> lock{run_mutex};
+            for (auto const& compositor : compositors)
+                compositor_ids.push_back(std::get<1>(compositor).get());
+        }
+
+        // Buffers consumed while compositing on this thread are presented by this group's frames
+        auto presentation_registration = mir::raii::paired_calls(
+            [this]{ presentation_clock->compositing(this); },
+            [this]{ presentation_clock->stopped_compositing(this); });
+
         started.set_value();
 
         try
@@ -135,23 +150,44 @@ public:
                     not_posted_yet = false;
                     lock.unlock();
 
+                    auto const target_vblank = wait_until_just_before_vblank();
+
+                    auto const render_start = std::chrono::steady_clock::now();
                     for (auto& tuple : compositors)
                     {
                         auto& compositor = std::get<1>(tuple);
                         compositor->composite(scene->scene_elements_for(compositor.get()));
                     }
+                    pacer.frame_rendered(std::chrono::steady_clock::now() - render_start);
                     group.post();
 
                     /*
-                     * "Predictive bypass" optimization: If the last frame was
-                     * bypassed/overlayed or you simply have a fast GPU, it is
-                     * beneficial to sleep for most of the next frame. This reduces
-                     * the latency between snapshotting the scene and post()
-                     * completing by almost a whole frame.
+                     * A page flip scheduled by post() completes on the next
+                     * vblank. (Bypassed frames have already flipped, so for
+                     * those this is a frame late.)
                      */
-                    auto delay = force_sleep >= std::chrono::milliseconds::zero() ?
-                                 force_sleep : group.recommended_sleep();
-                    std::this_thread::sleep_for(delay);
+                    auto const next_vblank = group.next_vblank();
+                    presentation_clock->frame_presented(this, next_vblank, refresh_period(next_vblank));
+
+                    if (target_vblank)
+                    {
+                        // The vblank following the one we were aiming for should be next
+                        if (next_vblank && next_vblank->msc > target_vblank->msc + 1)
+                            pacer.vblank_missed();
+                    }
+                    else
+                    {
+                        /*
+                         * "Predictive bypass" optimization: If the last frame was
+                         * bypassed/overlayed or you simply have a fast GPU, it is
+                         * beneficial to sleep for most of the next frame. This reduces
+                         * the latency between snapshotting the scene and post()
+                         * completing by almost a whole frame.
+                         */
+                        auto delay = force_sleep >= std::chrono::milliseconds::zero() ?
+                                     force_sleep : group.recommended_sleep();
+                        std::this_thread::sleep_for(delay);
+                    }
 
                     lock.lock();
 
@@ -208,6 +244,12 @@ public:
         group.for_each_display_buffer([&](mg::DisplayBuffer& buffer)
             { if (damage.overlaps(buffer.view_area())) took_damage = true; });
 
+        if (!took_damage)
+        {
+            for (auto const id : compositor_ids)
+                report->skipped_wakeup(id);
+        }
+
         if (took_damage && num_frames > frames_scheduled)
         {
             frames_scheduled = num_frames;
@@ -215,6 +257,49 @@ public:
         }
     }
 
+    /*
+     * Sleeps until just enough time is left before the next vblank to render
+     * and post a frame, so that buffers (and input) arriving late in the
+     * frame still make it to the screen. Returns the vblank aimed for, or
+     * nullopt if we're not pacing frames (the platform can't predict vblanks,
+     * a fixed delay was requested, or there isn't enough time left anyway).
+     */
+    std::experimental::optional<mg::Frame> wait_until_just_before_vblank()
+    {
+        if (force_sleep >= std::chrono::milliseconds::zero())
+            return {};
+
+        auto const vblank = group.next_vblank();
+        if (!vblank)
+            return {};
+
+        auto const start = vblank->ust - pacer.lead_time();
+        if (start <= mg::Frame::Timestamp::now(start.clock_id))
+            return {};
+
+        mir::time::sleep_until(start);
+        return vblank;
+    }
+
+    /// Measures the refresh period from successive vblanks, zero until it's known
+    std::chrono::nanoseconds refresh_period(std::experimental::optional<mg::Frame> const& vblank)
+    {
+        if (!vblank)
+        {
+            last_vblank = {};
+            return {};
+        }
+
+        if (last_vblank && vblank->msc > last_vblank->msc &&
+            vblank->ust.clock_id == last_vblank->ust.clock_id)
+        {
+            refresh = (vblank->ust - last_vblank->ust) / (vblank->msc - last_vblank->msc);
+        }
+
+        last_vblank = vblank;
+        return refresh;
+    }
+
     void stop()
     {
         std::lock_guard<std::mutex> lock{run_mutex};
@@ -241,9 +326,14 @@ private:
     std::condition_variable run_cv;
     std::shared_ptr<DisplayListener> const display_listener;
     std::shared_ptr<CompositorReport> const report;
+    std::shared_ptr<PresentationClock> const presentation_clock;
     std::promise<void> started;
     std::future<void> started_future;
     bool not_posted_yet = true;
+    std::vector<CompositorReport::SubCompositorId> compositor_ids;
+    FramePacer pacer;
+    std::experimental::optional<mg::Frame> last_vblank;
+    std::chrono::nanoseconds refresh{0};
 };
 
 }
@@ -255,6 +345,7 @@ mc::MultiThreadedCompositor::MultiThreadedCompositor(
     std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory,
     std::shared_ptr<DisplayListener> const& display_listener,
     std::shared_ptr<CompositorReport> const& compositor_report,
+    std::shared_ptr<PresentationClock> const& presentation_clock,
     std::chrono::milliseconds fixed_composite_delay,
     bool compose_on_start)
     : display{display},
@@ -262,6 +353,7 @@ mc::MultiThreadedCompositor::MultiThreadedCompositor(
       display_buffer_compositor_factory{db_compositor_factory},
       display_listener{display_listener},
       report{compositor_report},
+      presentation_clock{presentation_clock},
       state{CompositorState::stopped},
       fixed_composite_delay{fixed_composite_delay},
       compose_on_start{compose_on_start},
@@ -368,7 +460,7 @@ void mc::MultiThreadedCompositor::create_compositing_threads()
     {
         auto thread_functor = std::make_unique<mc::CompositingFunctor>(
             display_buffer_compositor_factory, group, scene, display_listener,
-            fixed_composite_delay, report);
+            fixed_composite_delay, report, presentation_clock);
 
         futures.push_back(thread_pool.run(std::ref(*thread_functor), &group));
         thread_functors.push_back(std::move(thread_functor));
@@ -17,12 +17,11 @@
  */
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/region.h"
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
 #include "occlusion.h"
 
-#include <vector>
-
 using namespace mir::geometry;
 using namespace mir::graphics;
 using namespace mir::compositor;
@@ -32,7 +31,7 @@ namespace
 bool renderable_is_occluded(
     Renderable const& renderable, 
     Rectangle const& area,
-    std::vector<Rectangle>& coverage)
+    Region& coverage)
 {
     static glm::mat4 const identity(1);
     static Rectangle const empty{};
@@ -46,20 +45,25 @@ bool renderable_is_occluded(
     if (clipped_window == empty)
         return true;  // Not in the area; definitely occluded.
 
-    bool occluded = false;
-    for (auto const& r : coverage)
+    if (coverage.contains(clipped_window))
+        return true;
+
+    if (renderable.alpha() == 1.0f)
     {
-        if (r.contains(clipped_window))
+        if (!renderable.shaped())
         {
-            occluded = true;
-            break;
+            coverage.unite(clipped_window);
+        }
+        else
+        {
+            // Only the parts the client has declared opaque hide what's beneath
+            auto opaque = renderable.opaque_region();
+            opaque.intersect(clipped_window);
+            coverage.unite(opaque);
         }
     }
 
-    if (!occluded && renderable.alpha() == 1.0f && !renderable.shaped())
-        coverage.push_back(clipped_window);
-
-    return occluded;
+    return false;
 }
 }
 
@@ -68,7 +72,7 @@ SceneElementSequence mir::compositor::filter_occlusions_from(
     Rectangle const& area)
 {
     SceneElementSequence occluded;
-    std::vector<Rectangle> coverage;
+    Region coverage;
 
     auto it = elements.rbegin();
     while (it != elements.rend())
@@ -0,0 +1,103 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mir/compositor/presentation_clock.h"
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+
+namespace
+{
+// The output being composited on this thread, if any
+thread_local void const* compositing_output{nullptr};
+
+// Displays may timestamp vblanks on another clock (eg. CLOCK_REALTIME for older DRM drivers)
+mir::time::PosixTimestamp on_clock(clockid_t clock_id, mir::time::PosixTimestamp const& time)
+{
+    if (time.clock_id == clock_id)
+        return time;
+
+    auto const age = mir::time::PosixTimestamp::now(time.clock_id) - time;
+    return mir::time::PosixTimestamp::now(clock_id) - age;
+}
+}
+
+mc::PresentationClock::PresentationClock()
+{
+}
+
+clockid_t mc::PresentationClock::clock_id() const
+{
+    return CLOCK_MONOTONIC;
+}
+
+void mc::PresentationClock::on_next_presentation(std::function<void(Presentation const&)> const& presented)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    auto const output = pending.find(compositing_output);
+    if (output != pending.end())
+        output->second.push_back(presented);
+    else
+        pending_on_any_output.push_back(presented);
+}
+
+void mc::PresentationClock::compositing(void const* output)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    pending[output];
+    compositing_output = output;
+}
+
+void mc::PresentationClock::stopped_compositing(void const* output)
+{
+    std::lock_guard<std::mutex> lock{mutex};
+    auto const stopped = pending.find(output);
+    if (stopped != pending.end())
+    {
+        pending_on_any_output.insert(
+            pending_on_any_output.end(), stopped->second.begin(), stopped->second.end());
+        pending.erase(stopped);
+    }
+    if (compositing_output == output)
+        compositing_output = nullptr;
+}
+
+void mc::PresentationClock::frame_presented(
+    void const* output,
+    std::experimental::optional<mg::Frame> const& vblank,
+    std::chrono::nanoseconds refresh)
+{
+    Callbacks presented;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto const presenting = pending.find(output);
+        if (presenting != pending.end())
+            presented.swap(presenting->second);
+        presented.insert(presented.end(), pending_on_any_output.begin(), pending_on_any_output.end());
+        pending_on_any_output.clear();
+    }
+
+    if (presented.empty())
+        return;
+
+    Presentation const presentation = vblank ?
+        Presentation{on_clock(clock_id(), vblank->ust), refresh, vblank->msc, true} :
+        Presentation{time::PosixTimestamp::now(clock_id()), refresh, 0, false};
+
+    for (auto const& callback : presented)
+        callback(presentation);
+}
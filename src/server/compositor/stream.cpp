@@ -22,6 +22,7 @@
 #include "dropping_schedule.h"
 #include "mir/graphics/buffer.h"
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 
 namespace mc = mir::compositor;
 namespace geom = mir::geometry;
@@ -29,6 +30,14 @@ namespace mg = mir::graphics;
 namespace ms = mir::scene;
 namespace geom = mir::geometry;
 
+namespace
+{
+// Enough to cover a client rendering a few frames ahead of a slow output
+unsigned int const max_damage_history{16};
+// Beyond this we just damage the bounding rectangle
+unsigned int const max_damage_rects{16};
+}
+
 enum class mc::Stream::ScheduleMode {
     Queueing,
     Dropping
@@ -42,6 +51,7 @@ mc::Stream::Stream(
     size(size),
     pf(pf),
     first_frame_posted(false),
+    next_serial{1},
     frame_callback{[](auto){}}
 {
 }
@@ -49,6 +59,20 @@ mc::Stream::Stream(
 mc::Stream::~Stream() = default;
 
 void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
+{
+    submit(buffer, {});
+}
+
+void mc::Stream::submit_damaged_buffer(
+    std::shared_ptr<mg::Buffer> const& buffer,
+    geom::Rectangles const& damage)
+{
+    submit(buffer, damage);
+}
+
+void mc::Stream::submit(
+    std::shared_ptr<mg::Buffer> const& buffer,
+    std::experimental::optional<geom::Rectangles> const& damage)
 {
     if (!buffer)
         BOOST_THROW_EXCEPTION(std::invalid_argument("cannot submit null buffer"));
@@ -57,6 +81,9 @@ void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
         std::lock_guard<decltype(mutex)> lk(mutex); 
         first_frame_posted = true;
         pf = buffer->pixel_format();
+        submissions.push_back({next_serial++, buffer->id(), buffer->size(), damage});
+        if (submissions.size() > max_damage_history)
+            submissions.pop_front();
         schedule->schedule(buffer);
     }
     {
@@ -86,7 +113,80 @@ void mc::Stream::set_frame_posted_callback(
 
 std::shared_ptr<mg::Buffer> mc::Stream::lock_compositor_buffer(void const* id)
 {
-    return arbiter->compositor_acquire(id);
+    auto const buffer = arbiter->compositor_acquire(id);
+
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    update_damage_for(id, *buffer, lk);
+    return buffer;
+}
+
+geom::Rectangles mc::Stream::compositor_buffer_damage(void const* id) const
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    auto const found = user_damage.find(id);
+    if (found == user_damage.end())
+        return {};
+    return found->second.damage;
+}
+
+void mc::Stream::update_damage_for(void const* id, mg::Buffer const& buffer, std::lock_guard<std::mutex> const&)
+{
+    geom::Rectangle const whole_buffer{{}, buffer.size()};
+    auto& user = user_damage[id];
+
+    // A buffer can't be resubmitted until released, and we hold it, so the
+    // most recent submission of this buffer is the one we've acquired.
+    auto const latest = std::find_if(submissions.rbegin(), submissions.rend(),
+        [&](Submission const& s) { return s.id == buffer.id(); });
+
+    if (latest == submissions.rend())
+    {
+        user = {0, {whole_buffer}};
+        return;
+    }
+
+    if (user.serial == latest->serial)
+    {
+        user.damage.clear();
+        return;
+    }
+
+    auto const previous = user.serial;
+    user.serial = latest->serial;
+    user.damage = {whole_buffer};
+
+    if (previous == 0 || previous > latest->serial || submissions.front().serial > previous + 1)
+        return;
+
+    std::vector<geom::Rectangle> rects;
+    for (auto s = submissions.begin(); s != latest.base(); ++s)
+    {
+        if (s->serial <= previous)
+            continue;
+
+        if (!s->damage || s->size != buffer.size())
+            return;
+
+        for (auto const& r : *s->damage)
+            rects.push_back(r.intersection_with(whole_buffer));
+    }
+
+    user.damage.clear();
+    if (rects.size() > max_damage_rects)
+    {
+        geom::Rectangles bounds;
+        for (auto const& r : rects)
+            bounds.add(r);
+        user.damage.add(bounds.bounding_rectangle());
+    }
+    else
+    {
+        for (auto const& r : rects)
+        {
+            if (r.size.width.as_int() > 0 && r.size.height.as_int() > 0)
+                user.damage.add(r);
+        }
+    }
 }
 
 geom::Size mc::Stream::stream_size()
@@ -167,3 +267,15 @@ bool mc::Stream::has_submitted_buffer() const
 void mc::Stream::set_scale(float)
 {
 }
+
+void mc::Stream::set_opaque_region(geom::Region const& region)
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    opaque = region;
+}
+
+geom::Region mc::Stream::opaque_region() const
+{
+    std::lock_guard<decltype(mutex)> lk(mutex);
+    return opaque;
+}
@@ -25,10 +25,14 @@
 #include "mir/frontend/buffer_stream_id.h"
 #include "mir/lockable_callback.h"
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
 #include "multi_monitor_arbiter.h"
+#include <experimental/optional>
 #include <mutex>
 #include <memory>
 #include <set>
+#include <deque>
+#include <unordered_map>
 
 namespace mir
 {
@@ -43,12 +47,16 @@ public:
     ~Stream();
 
     void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) override;
+    void submit_damaged_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Rectangles const& damage) override;
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& exec) override;
     MirPixelFormat pixel_format() const override;
     void set_frame_posted_callback(
         std::function<void(geometry::Size const&)> const& callback) override;
     std::shared_ptr<graphics::Buffer>
         lock_compositor_buffer(void const* user_id) override;
+    geometry::Rectangles compositor_buffer_damage(void const* user_id) const override;
     geometry::Size stream_size() override;
     void resize(geometry::Size const& size) override;
     void allow_framedropping(bool) override;
@@ -57,10 +65,31 @@ public:
     void drop_old_buffers() override;
     bool has_submitted_buffer() const override;
     void set_scale(float scale) override;
+    void set_opaque_region(geometry::Region const& region) override;
+    geometry::Region opaque_region() const override;
 
 private:
     enum class ScheduleMode;
     void transition_schedule(std::shared_ptr<Schedule>&& new_schedule, std::lock_guard<std::mutex> const&);
+    void submit(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        std::experimental::optional<geometry::Rectangles> const& damage);
+    void update_damage_for(void const* user_id, graphics::Buffer const& buffer, std::lock_guard<std::mutex> const&);
+
+    // Damage of recently submitted buffers, oldest first. A nullopt damage
+    // means the whole buffer.
+    struct Submission
+    {
+        unsigned long long serial;
+        graphics::BufferID id;
+        geometry::Size size;
+        std::experimental::optional<geometry::Rectangles> damage;
+    };
+    struct UserDamage
+    {
+        unsigned long long serial;
+        geometry::Rectangles damage;
+    };
 
     std::mutex mutable mutex;
     ScheduleMode schedule_mode;
@@ -69,6 +98,10 @@ private:
     geometry::Size size; 
     MirPixelFormat pf;
     bool first_frame_posted;
+    unsigned long long next_serial;
+    std::deque<Submission> submissions;
+    std::unordered_map<void const*, UserDamage> user_damage;
+    geometry::Region opaque;
 
     std::mutex callback_mutex;
     std::function<void(geometry::Size const&)> frame_callback;
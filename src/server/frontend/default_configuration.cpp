@@ -27,12 +27,26 @@
 #include "mir/graphics/platform_ipc_operations.h"
 #include "mir/frontend/protobuf_connection_creator.h"
 #include "mir/frontend/session_authorizer.h"
+#include "mir/main_loop.h"
 #include "mir/options/configuration.h"
 #include "mir/options/option.h"
 
+#include <algorithm>
+
 namespace mf = mir::frontend;
 namespace mg = mir::graphics;
 namespace ms = mir::scene;
+namespace mi = mir::input;
+
+namespace
+{
+mf::SendQueueLimit client_send_queue_limit(mir::options::Option const& options)
+{
+    return {
+        static_cast<size_t>(options.get<int>(mir::options::client_send_queue_limit_opt)) * 1024,
+        mf::send_queue_overflow_from(options.get<std::string>(mir::options::client_send_queue_overflow_opt))};
+}
+}
 
 std::shared_ptr<mf::ConnectionCreator>
 mir::DefaultServerConfiguration::the_connection_creator()
@@ -44,7 +58,9 @@ mir::DefaultServerConfiguration::the_connection_creator()
                 new_ipc_factory(session_authorizer),
                 session_authorizer,
                 the_graphics_platform()->make_ipc_operations(),
-                the_message_processor_report());
+                the_message_processor_report(),
+                mi::motion_coalescing_from(the_options()->get<std::string>(options::motion_coalescing_opt)),
+                client_send_queue_limit(*the_options()));
         });
 }
 
@@ -124,7 +140,9 @@ mir::DefaultServerConfiguration::the_prompt_connection_creator()
                 new_ipc_factory(session_authorizer),
                 session_authorizer,
                 the_graphics_platform()->make_ipc_operations(),
-                the_message_processor_report());
+                the_message_processor_report(),
+                mi::motion_coalescing_from(the_options()->get<std::string>(options::motion_coalescing_opt)),
+                client_send_queue_limit(*the_options()));
         });
 }
 
@@ -168,7 +186,10 @@ mir::DefaultServerConfiguration::new_ipc_factory(
                 the_application_not_responding_detector(),
                 the_cookie_authority(),
                 the_input_configuration_changer(),
-                the_extensions());
+                the_extensions(),
+                the_clock(),
+                the_main_loop(),
+                static_cast<size_t>(std::max(the_options()->get<int>(options::client_buffer_pool_opt), 0)) * 1024 * 1024);
 }
 
 std::shared_ptr<mf::SessionMediatorObserver>
@@ -24,6 +24,7 @@
 #include "authorizing_input_config_changer.h"
 #include "unauthorized_screencast.h"
 #include "resource_cache.h"
+#include "recycling_buffer_allocator.h"
 #include "mir/frontend/session_authorizer.h"
 #include "mir/frontend/event_sink.h"
 #include "event_sink_factory.h"
@@ -42,6 +43,8 @@ namespace ms = mir::scene;
 
 namespace
 {
+std::chrono::seconds const client_buffer_max_idle{3};
+
 class ThreadExecutor : public mir::Executor
 {
 public:
@@ -234,7 +237,10 @@ mf::DefaultIpcFactory::DefaultIpcFactory(
     std::shared_ptr<scene::ApplicationNotRespondingDetector> const& anr_detector,
     std::shared_ptr<mir::cookie::Authority> const& cookie_authority,
     std::shared_ptr<InputConfigurationChanger> const& input_changer,
-    std::vector<mir::ExtensionDescription> const& extensions) :
+    std::vector<mir::ExtensionDescription> const& extensions,
+    std::shared_ptr<time::Clock> const& clock,
+    std::shared_ptr<time::AlarmFactory> const& alarm_factory,
+    size_t client_buffer_pool_bytes) :
     shell(shell),
     no_prompt_shell(std::make_shared<NoPromptShell>(shell)),
     sm_observer(sm_observer),
@@ -249,7 +255,10 @@ mf::DefaultIpcFactory::DefaultIpcFactory(
     anr_detector{anr_detector},
     cookie_authority(cookie_authority),
     input_changer(input_changer),
-    extensions(extensions)
+    extensions(extensions),
+    clock{clock},
+    alarm_factory{alarm_factory},
+    client_buffer_pool_bytes{client_buffer_pool_bytes}
 {
 }
 
@@ -321,6 +330,14 @@ std::shared_ptr<mf::detail::DisplayServer> mf::DefaultIpcFactory::make_mediator(
     std::shared_ptr<mi::CursorImages> const& cursor_images,
     std::shared_ptr<InputConfigurationChanger> const& input_changer)
 {
+    // Each session reuses only the buffers it has freed itself
+    auto session_allocator = buffer_allocator;
+    if (client_buffer_pool_bytes)
+    {
+        session_allocator = std::make_shared<RecyclingBufferAllocator>(
+            buffer_allocator, client_buffer_pool_bytes, client_buffer_max_idle, clock, alarm_factory);
+    }
+
     return std::make_shared<SessionMediator>(
         shell,
         platform_ipc_operations,
@@ -338,6 +355,6 @@ std::shared_ptr<mf::detail::DisplayServer> mf::DefaultIpcFactory::make_mediator(
         cookie_authority,
         input_changer,
         extensions,
-        buffer_allocator,
+        session_allocator,
         buffer_return_ipc_executor());
 }
@@ -46,6 +46,11 @@ namespace scene
 class ApplicationNotRespondingDetector;
 class CoordinateTranslator;
 }
+namespace time
+{
+class AlarmFactory;
+class Clock;
+}
 
 namespace frontend
 {
@@ -73,7 +78,10 @@ public:
         std::shared_ptr<scene::ApplicationNotRespondingDetector> const& anr_detector,
         std::shared_ptr<cookie::Authority> const& cookie_authority,
         std::shared_ptr<InputConfigurationChanger> const& input_Changer,
-        std::vector<mir::ExtensionDescription> const& extensions);
+        std::vector<mir::ExtensionDescription> const& extensions,
+        std::shared_ptr<time::Clock> const& clock,
+        std::shared_ptr<time::AlarmFactory> const& alarm_factory,
+        size_t client_buffer_pool_bytes);
 
     std::shared_ptr<detail::DisplayServer> make_ipc_server(
         SessionCredentials const &creds,
@@ -112,6 +120,9 @@ private:
     std::shared_ptr<cookie::Authority> const cookie_authority;
     std::shared_ptr<InputConfigurationChanger> const input_changer;
     std::vector<mir::ExtensionDescription> const extensions;
+    std::shared_ptr<time::Clock> const clock;
+    std::shared_ptr<time::AlarmFactory> const alarm_factory;
+    size_t const client_buffer_pool_bytes;
     std::shared_ptr<mir::Executor> const execution_queue;
 };
 }
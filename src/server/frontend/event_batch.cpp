@@ -0,0 +1,65 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mir/frontend/event_batch.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+namespace mf = mir::frontend;
+
+namespace
+{
+thread_local bool batch_in_progress{false};
+thread_local std::vector<std::function<void()>> deferred_deliveries;
+}
+
+mf::EventBatch::EventBatch() :
+    outermost{!batch_in_progress}
+{
+    batch_in_progress = true;
+}
+
+mf::EventBatch::~EventBatch()
+{
+    if (!outermost)
+        return;
+
+    batch_in_progress = false;
+
+    // Deliveries may raise further events; those are sent directly now
+    auto deliveries = std::move(deferred_deliveries);
+    deferred_deliveries.clear();
+
+    for (auto const& deliver : deliveries)
+        deliver();
+}
+
+bool mf::EventBatch::in_progress()
+{
+    return batch_in_progress;
+}
+
+void mf::EventBatch::defer(std::function<void()> const& deliver)
+{
+    if (!batch_in_progress)
+        BOOST_THROW_EXCEPTION(std::logic_error("No event batch in progress"));
+
+    deferred_deliveries.push_back(deliver);
+}
@@ -18,15 +18,16 @@
 
 #include "event_sender.h"
 #include "mir/events/event.h"
-#include "mir/frontend/client_constants.h"
+#include "mir/events/event_builders.h"
+#include "mir/events/input_event.h"
 #include "mir/graphics/display_configuration.h"
-#include "mir/variable_length_array.h"
 #include "mir/input/device.h"
 #include "mir/input/mir_input_config.h"
 #include "mir/input/mir_input_config_serialization.h"
 #include "mir/input/mir_pointer_config.h"
 #include "mir/input/mir_touchpad_config.h"
 #include "mir/input/mir_keyboard_config.h"
+#include "mir/frontend/event_batch.h"
 #include "message_sender.h"
 #include "protobuf_buffer_packer.h"
 
@@ -36,29 +37,216 @@
 #include "mir_protobuf_wire.pb.h"
 #include "mir_protobuf.pb.h"
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
 namespace mg = mir::graphics;
 namespace mfd = mir::frontend::detail;
 namespace mev = mir::events;
 namespace mp = mir::protobuf;
 namespace mi = mir::input;
 
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+namespace
+{
+/*
+ * Messages are wire::Result{events: [EventSequence]} and an Event is just
+ * Event{raw: bytes}, so rather than build (and copy) each layer of message
+ * we write the few length-delimited field headers ourselves.
+ */
+uint32_t length_delimited_tag(int field_number)
+{
+    return WireFormatLite::MakeTag(field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+}
+
+size_t length_delimited_size(int field_number, size_t payload_size)
+{
+    return CodedOutputStream::VarintSize32(length_delimited_tag(field_number)) +
+           CodedOutputStream::VarintSize32(payload_size) +
+           payload_size;
+}
+
+char* write_length_delimited_header(int field_number, size_t payload_size, char* output)
+{
+    auto out = reinterpret_cast<google::protobuf::uint8*>(output);
+    out = CodedOutputStream::WriteTagToArray(length_delimited_tag(field_number), out);
+    out = CodedOutputStream::WriteVarint32ToArray(payload_size, out);
+    return reinterpret_cast<char*>(out);
+}
+}
+
+mfd::EventSender::Outbox::Outbox(std::shared_ptr<MessageSender> const& sender, mi::MotionCoalescing motion_coalescing) :
+    sender{sender},
+    motion_coalescing{motion_coalescing},
+    delivery_deferred{false}
+{
+}
+
+void mfd::EventSender::Outbox::send_events(std::lock_guard<std::mutex> const& lock)
+{
+    if (events.empty())
+        return;
+
+    if (events.size() == 1 &&
+        motion_coalescing != mi::MotionCoalescing::none &&
+        events.front()->type() == mir_event_type_input)
+    {
+        auto event = std::move(events.front());
+        events.clear();
+        send_in_stream(std::move(event), lock);
+        return;
+    }
+
+    // All the events go in one EventSequence, in one message
+    bool coalescible = true;
+    for (auto const& event : events)
+        coalescible = coalescible && mi::is_coalescible_motion(*event, motion_coalescing);
+
+    serialize(events.data(), events.size());
+    events.clear();
+
+    if (!coalescible)
+    {
+        send({}, lock);
+        return;
+    }
+
+    streamed.clear();
+
+    try
+    {
+        sender->send_coalescible(send_buffer.data(), send_buffer.size());
+    }
+    catch (std::exception const& error)
+    {
+        // TODO: We should report this state.
+        (void) error;
+    }
+}
+
+void mfd::EventSender::Outbox::send_in_stream(EventUPtr&& event, std::lock_guard<std::mutex> const&)
+{
+    auto const& input = *event->to_input();
+    MessageStream const stream{input.window_id(), input.device_id()};
+    auto last = streamed.find(stream);
+
+    try
+    {
+        // If the client is yet to receive the stream's last message, bring that up to date
+        if (last != streamed.end())
+        {
+            auto merged = mev::clone_event(*last->second);
+            if (mi::coalesce_motion(*merged, *event, motion_coalescing))
+            {
+                serialize(&merged, 1);
+                if (sender->replace_unsent(
+                        stream,
+                        send_buffer.data(),
+                        send_buffer.size(),
+                        mi::is_coalescible_motion(*merged, motion_coalescing)))
+                {
+                    last->second = std::move(merged);
+                    return;
+                }
+            }
+            streamed.erase(last);
+        }
+
+        serialize(&event, 1);
+        bool const coalescible = mi::is_coalescible_motion(*event, motion_coalescing);
+        streamed.emplace(stream, std::move(event));
+        sender->send_in_stream(stream, send_buffer.data(), send_buffer.size(), coalescible);
+    }
+    catch (std::exception const& error)
+    {
+        // TODO: We should report this state.
+        (void) error;
+    }
+}
+
+void mfd::EventSender::Outbox::send(FdSets const& fds, std::lock_guard<std::mutex> const&)
+{
+    // Nothing queued before this can be replaced any more
+    streamed.clear();
+
+    try
+    {
+        sender->send(send_buffer.data(), send_buffer.size(), fds);
+    }
+    catch (std::exception const& error)
+    {
+        // TODO: We should report this state.
+        (void) error;
+    }
+}
+
+void mfd::EventSender::Outbox::serialize(EventUPtr const* events, size_t count)
+{
+    size_t sequence_size = 0;
+    event_sizes.clear();
+    for (size_t i = 0; i != count; ++i)
+    {
+        auto const raw_size = MirEvent::serialized_size(events[i].get());
+        event_sizes.push_back(raw_size);
+        sequence_size += length_delimited_size(
+            mp::EventSequence::kEventFieldNumber,
+            length_delimited_size(mp::Event::kRawFieldNumber, raw_size));
+    }
+
+    send_buffer.resize(length_delimited_size(mp::wire::Result::kEventsFieldNumber, sequence_size));
+    auto out = write_length_delimited_header(
+        mp::wire::Result::kEventsFieldNumber, sequence_size, send_buffer.data());
+
+    for (size_t i = 0; i != count; ++i)
+    {
+        out = write_length_delimited_header(
+            mp::EventSequence::kEventFieldNumber,
+            length_delimited_size(mp::Event::kRawFieldNumber, event_sizes[i]),
+            out);
+        out = write_length_delimited_header(mp::Event::kRawFieldNumber, event_sizes[i], out);
+        MirEvent::serialize_into(events[i].get(), out);
+        out += event_sizes[i];
+    }
+}
+
 mfd::EventSender::EventSender(
     std::shared_ptr<MessageSender> const& socket_sender,
-    std::shared_ptr<mg::PlatformIpcOperations> const& buffer_packer) :
-    sender(socket_sender),
-    buffer_packer(buffer_packer)
+    std::shared_ptr<mg::PlatformIpcOperations> const& buffer_packer,
+    mi::MotionCoalescing motion_coalescing) :
+    outbox(std::make_shared<Outbox>(socket_sender, motion_coalescing)),
+    buffer_packer(buffer_packer),
+    motion_coalescing(motion_coalescing)
 {
 }
 
 void mfd::EventSender::handle_event(EventUPtr&& event)
 {
-    // In future we might send multiple events, or insert them into messages
-    // containing other responses, but for now we send them individually.
-    mp::EventSequence seq;
-    mp::Event *ev = seq.add_event();
-    ev->set_raw(MirEvent::serialize(event.get()));
+    std::lock_guard<std::mutex> lock{outbox->mutex};
 
-    send_event_sequence(seq, {});
+    // Motion held back for the batch is stale: bring it up to date instead of queueing more
+    if (!outbox->events.empty() &&
+        mi::coalesce_motion(*outbox->events.back(), *event, motion_coalescing))
+        return;
+
+    outbox->events.push_back(std::move(event));
+
+    if (!EventBatch::in_progress())
+    {
+        outbox->send_events(lock);
+    }
+    else if (!outbox->delivery_deferred)
+    {
+        // Send everything raised for this session during the batch as one message
+        outbox->delivery_deferred = true;
+        EventBatch::defer([outbox = outbox]
+            {
+                std::lock_guard<std::mutex> lock{outbox->mutex};
+                outbox->delivery_deferred = false;
+                outbox->send_events(lock);
+            });
+    }
 }
 
 void mfd::EventSender::handle_display_config_change(
@@ -103,25 +291,20 @@ void mfd::EventSender::handle_input_config_change(MirInputConfig const& config)
 
 void mfd::EventSender::send_event_sequence(mp::EventSequence& seq, FdSets const& fds)
 {
-    mir::VariableLengthArray<frontend::serialization_buffer_size>
-        send_buffer{static_cast<size_t>(seq.ByteSize())};
+    std::lock_guard<std::mutex> lock{outbox->mutex};
 
-    seq.SerializeWithCachedSizesToArray(send_buffer.data());
+    // Anything held back for a batch was raised first, so goes first
+    outbox->send_events(lock);
 
-    mir::protobuf::wire::Result result;
-    result.add_events(send_buffer.data(), send_buffer.size());
-    send_buffer.resize(result.ByteSize());
-    result.SerializeWithCachedSizesToArray(send_buffer.data());
+    size_t const sequence_size = seq.ByteSize();
+    auto& send_buffer = outbox->send_buffer;
+    send_buffer.resize(length_delimited_size(mp::wire::Result::kEventsFieldNumber, sequence_size));
 
-    try
-    {
-        sender->send(reinterpret_cast<char*>(send_buffer.data()), send_buffer.size(), fds);
-    }
-    catch (std::exception const& error)
-    {
-        // TODO: We should report this state.
-        (void) error;
-    }
+    auto const out = write_length_delimited_header(
+        mp::wire::Result::kEventsFieldNumber, sequence_size, send_buffer.data());
+    seq.SerializeWithCachedSizesToArray(reinterpret_cast<google::protobuf::uint8*>(out));
+
+    outbox->send(fds, lock);
 }
 
 void mfd::EventSender::add_buffer(graphics::Buffer& buffer)
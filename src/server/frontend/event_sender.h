@@ -21,7 +21,12 @@
 
 #include "mir/frontend/event_sink.h"
 #include "mir/frontend/fd_sets.h"
+#include "mir/input/motion_coalescing.h"
+#include "message_sender.h"
+#include <map>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace mir
 {
@@ -32,17 +37,16 @@ class EventSequence;
 }
 namespace frontend
 {
-class MessageSender;
-
 namespace detail
 {
 
 class EventSender : public  mir::frontend::EventSink
 {
 public:
-    explicit EventSender(
+    EventSender(
         std::shared_ptr<MessageSender> const& socket_sender,
-        std::shared_ptr<graphics::PlatformIpcOperations> const& buffer_packer);
+        std::shared_ptr<graphics::PlatformIpcOperations> const& buffer_packer,
+        input::MotionCoalescing motion_coalescing);
     void handle_event(EventUPtr&& event) override;
     void handle_lifecycle_event(MirLifecycleState state) override;
     void handle_display_config_change(graphics::DisplayConfiguration const& config) override;
@@ -55,11 +59,36 @@ public:
     void update_buffer(graphics::Buffer&) override;
 
 private:
+    /*
+     * Messages waiting to be sent. Shared with the deliveries deferred to the
+     * end of an EventBatch, which may outlive the EventSender.
+     */
+    struct Outbox
+    {
+        Outbox(std::shared_ptr<MessageSender> const& sender, input::MotionCoalescing motion_coalescing);
+
+        void send_events(std::lock_guard<std::mutex> const&);
+        void send_in_stream(EventUPtr&& event, std::lock_guard<std::mutex> const&);
+        void send(FdSets const& fds, std::lock_guard<std::mutex> const&);
+        void serialize(EventUPtr const* events, size_t count);
+
+        std::shared_ptr<MessageSender> const sender;
+        input::MotionCoalescing const motion_coalescing;
+        std::mutex mutex;
+        std::vector<EventUPtr> events;
+        bool delivery_deferred;
+        std::vector<size_t> event_sizes;
+        std::vector<char> send_buffer;  // Reused, to avoid allocating for every message
+        // The last event sent in each stream since anything was sent outside one
+        std::map<MessageStream, EventUPtr> streamed;
+    };
+
     void send_event_sequence(protobuf::EventSequence&, FdSets const&);
     void send_buffer(protobuf::EventSequence&, graphics::Buffer&, graphics::BufferIpcMsgType);
 
-    std::shared_ptr<MessageSender> const sender;
+    std::shared_ptr<Outbox> const outbox;
     std::shared_ptr<graphics::PlatformIpcOperations> const buffer_packer;
+    input::MotionCoalescing const motion_coalescing;
 };
 
 }
@@ -20,17 +20,69 @@
 
 #include "mir/frontend/fd_sets.h"
 
+#include <cstdint>
+#include <tuple>
 #include <sys/types.h>
 
 namespace mir
 {
 namespace frontend
 {
+/// Messages in which each brings the last up to date, such as one device's motion over one surface
+struct MessageStream
+{
+    int surface;
+    int64_t device;
+};
+
+inline bool operator==(MessageStream const& lhs, MessageStream const& rhs)
+{
+    return lhs.surface == rhs.surface && lhs.device == rhs.device;
+}
+
+inline bool operator<(MessageStream const& lhs, MessageStream const& rhs)
+{
+    return std::tie(lhs.surface, lhs.device) < std::tie(rhs.surface, rhs.device);
+}
+
 class MessageSender
 {
 public:
     virtual void send(char const* data, size_t length, FdSets const& fds) = 0;
 
+    /**
+     * Send a message that any later coalescible message supersedes (such as
+     * pointer motion), so may be dropped rather than queued behind a client
+     * that is not keeping up. By default it is sent like any other message.
+     */
+    virtual void send_coalescible(char const* data, size_t length) { send(data, length, {}); }
+
+    /**
+     * Send the latest message in stream, as send_coalescible() if coalescible
+     * and otherwise as send(). Until the client starts to receive it, it may be
+     * brought up to date by replace_unsent().
+     */
+    virtual void send_in_stream(MessageStream const&, char const* data, size_t length, bool coalescible)
+    {
+        if (coalescible)
+            send_coalescible(data, length);
+        else
+            send(data, length, {});
+    }
+
+    /**
+     * Replace the last message sent in stream, in its place in the queue, if
+     * the client has yet to receive any of it and nothing but other streams'
+     * messages has been sent since.
+     *
+     * \return False, having sent nothing, if there is no such message. By
+     *         default there never is.
+     */
+    virtual bool replace_unsent(MessageStream const&, char const* /*data*/, size_t /*length*/, bool /*coalescible*/)
+    {
+        return false;
+    }
+
 protected:
     MessageSender() = default;
     virtual ~MessageSender() = default;
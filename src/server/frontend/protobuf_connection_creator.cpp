@@ -37,11 +37,15 @@ mf::ProtobufConnectionCreator::ProtobufConnectionCreator(
     std::shared_ptr<ProtobufIpcFactory> const& ipc_factory,
     std::shared_ptr<SessionAuthorizer> const& session_authorizer,
     std::shared_ptr<mir::graphics::PlatformIpcOperations> const& operations,
-    std::shared_ptr<MessageProcessorReport> const& report)
+    std::shared_ptr<MessageProcessorReport> const& report,
+    input::MotionCoalescing motion_coalescing,
+    SendQueueLimit const& send_queue_limit)
 :   ipc_factory(ipc_factory),
     session_authorizer(session_authorizer),
     operations(operations),
     report(report),
+    motion_coalescing(motion_coalescing),
+    send_queue_limit(send_queue_limit),
     next_session_id(0),
     connections(std::make_shared<mfd::Connections<mfd::SocketConnection>>())
 {
@@ -62,18 +66,22 @@ namespace
 class ProtobufEventFactory : public mf::EventSinkFactory
 {
 public:
-    ProtobufEventFactory(std::shared_ptr<mir::graphics::PlatformIpcOperations> const& operations)
-        : ops{operations}
+    ProtobufEventFactory(
+        std::shared_ptr<mir::graphics::PlatformIpcOperations> const& operations,
+        mir::input::MotionCoalescing motion_coalescing)
+        : ops{operations},
+          motion_coalescing{motion_coalescing}
     {
     }
 
     std::unique_ptr<mf::EventSink>
     create_sink(std::shared_ptr<mf::MessageSender> const& messenger)
     {
-        return std::make_unique<mf::detail::EventSender>(messenger, ops);
+        return std::make_unique<mf::detail::EventSender>(messenger, ops, motion_coalescing);
     };
 private:
     std::shared_ptr<mir::graphics::PlatformIpcOperations> const ops;
+    mir::input::MotionCoalescing const motion_coalescing;
 };
 }
 
@@ -81,7 +89,7 @@ void mf::ProtobufConnectionCreator::create_connection_for(
     std::shared_ptr<boost::asio::local::stream_protocol::socket> const& socket,
     ConnectionContext const& connection_context)
 {
-    auto const messenger = std::make_shared<detail::SocketMessenger>(socket);
+    auto const messenger = std::make_shared<detail::SocketMessenger>(socket, send_queue_limit);
     auto const creds = messenger->client_creds();
 
     if (session_authorizer->connection_is_allowed(creds))
@@ -95,7 +103,7 @@ void mf::ProtobufConnectionCreator::create_connection_for(
             message_sender,
             ipc_factory->make_ipc_server(
                 creds,
-                std::make_shared<ProtobufEventFactory>(operations),
+                std::make_shared<ProtobufEventFactory>(operations, motion_coalescing),
                 messenger,
                 connection_context),
             report);
@@ -27,6 +27,9 @@
 
 #include "mir_protobuf_wire.pb.h"
 
+#include <functional>
+#include <unordered_map>
+
 namespace mfd = mir::frontend::detail;
 
 namespace
@@ -172,6 +175,16 @@ const std::string& mfd::Invocation::method_name() const
     return invocation.method_name();
 }
 
+bool mfd::Invocation::has_method_opcode() const
+{
+    return invocation.has_method_opcode();
+}
+
+google::protobuf::uint32 mfd::Invocation::method_opcode() const
+{
+    return invocation.method_opcode();
+}
+
 const std::string& mfd::Invocation::parameters() const
 {
     return invocation.parameters();
@@ -187,179 +200,174 @@ void mfd::ProtobufMessageProcessor::client_pid(int pid)
     display_server->client_pid(pid);
 }
 
+struct mfd::ProtobufMessageProcessor::Method
+{
+    std::string name;
+
+    // Returns false if the connection should be closed afterwards
+    std::function<bool(
+        ProtobufMessageProcessor& self,
+        Invocation const& invocation,
+        std::vector<mir::Fd> const& side_channel_fds)> handle;
+};
+
+struct mfd::ProtobufMessageProcessor::MethodTable
+{
+    // Indexed by opcode. Clients learn the opcodes from Connection.method_opcode
+    // so new methods can go anywhere, but nothing may be removed while clients
+    // of the current protocol version might hold the table.
+    std::vector<Method> by_opcode;
+    std::unordered_map<std::string, Method const*> by_name;
+};
+
+auto mfd::ProtobufMessageProcessor::method_table() -> MethodTable const&
+{
+    auto const call = [](auto function)
+        {
+            return [function](ProtobufMessageProcessor& self, Invocation const& invocation, std::vector<mir::Fd> const&)
+                {
+                    invoke(&self, self.display_server.get(), function, invocation);
+                    return true;
+                };
+        };
+
+    static MethodTable const table = [&]
+    {
+        MethodTable table;
+
+        table.by_opcode = {
+            {"connect", call(&DisplayServer::connect)},
+            {"create_surface", call(&DisplayServer::create_surface)},
+            {"submit_buffer",
+                [](ProtobufMessageProcessor& self, Invocation const& invocation, std::vector<mir::Fd> const& side_channel_fds)
+                {
+                    auto request = parse_parameter<mir::protobuf::BufferRequest>(invocation);
+                    request.mutable_buffer()->clear_fd();
+                    for (auto& fd : side_channel_fds)
+                        request.mutable_buffer()->add_fd(fd);
+                    invoke(self.shared_from_this(), self.display_server.get(), &DisplayServer::submit_buffer,
+                           invocation.id(), &request);
+                    return true;
+                }},
+            {"allocate_buffers", call(&DisplayServer::allocate_buffers)},
+            {"release_buffers", call(&DisplayServer::release_buffers)},
+            {"release_surface", call(&DisplayServer::release_surface)},
+            {"platform_operation",
+                [](ProtobufMessageProcessor& self, Invocation const& invocation, std::vector<mir::Fd> const& side_channel_fds)
+                {
+                    auto request = parse_parameter<mir::protobuf::PlatformOperationMessage>(invocation);
+
+                    request.clear_fd();
+                    for (auto& fd : side_channel_fds)
+                        request.add_fd(fd);
+
+                    invoke(self.shared_from_this(), self.display_server.get(), &DisplayServer::platform_operation,
+                           invocation.id(), &request);
+                    return true;
+                }},
+            {"configure_display", call(&DisplayServer::configure_display)},
+            {"remove_session_configuration", call(&DisplayServer::remove_session_configuration)},
+            {"set_base_display_configuration", call(&DisplayServer::set_base_display_configuration)},
+            {"configure_surface", call(&DisplayServer::configure_surface)},
+            {"modify_surface", call(&DisplayServer::modify_surface)},
+            {"create_screencast", call(&DisplayServer::create_screencast)},
+            {"screencast_buffer", call(&DisplayServer::screencast_buffer)},
+            {"screencast_to_buffer", call(&DisplayServer::screencast_to_buffer)},
+            {"release_screencast", call(&DisplayServer::release_screencast)},
+            {"create_buffer_stream", call(&DisplayServer::create_buffer_stream)},
+            {"release_buffer_stream", call(&DisplayServer::release_buffer_stream)},
+            {"configure_cursor", call(&protobuf::DisplayServer::configure_cursor)},
+            {"new_fds_for_prompt_providers", call(&protobuf::DisplayServer::new_fds_for_prompt_providers)},
+            {"start_prompt_session", call(&protobuf::DisplayServer::start_prompt_session)},
+            {"stop_prompt_session", call(&protobuf::DisplayServer::stop_prompt_session)},
+            {"request_operation", call(&protobuf::DisplayServer::request_operation)},
+            {"disconnect",
+                [](ProtobufMessageProcessor& self, Invocation const& invocation, std::vector<mir::Fd> const&)
+                {
+                    invoke(&self, self.display_server.get(), &DisplayServer::disconnect, invocation);
+                    return false;
+                }},
+            {"pong", call(&DisplayServer::pong)},
+            {"configure_buffer_stream", call(&DisplayServer::configure_buffer_stream)},
+            {"translate_surface_to_screen",
+                [](ProtobufMessageProcessor& self, Invocation const& invocation, std::vector<mir::Fd> const&)
+                {
+                    try
+                    {
+                        auto debug_interface = dynamic_cast<mir::protobuf::DisplayServerDebug*>(self.display_server.get());
+                        invoke(&self, debug_interface, &mir::protobuf::DisplayServerDebug::translate_surface_to_screen, invocation);
+                    }
+                    catch (std::runtime_error const&)
+                    {
+                        std::string message{"Server does not support the client debugging interface"};
+                        invoke(&self,
+                               &message,
+                               &mir::protobuf::DisplayServerDebug::translate_surface_to_screen,
+                               invocation);
+                        std::runtime_error err{"Client attempted to use unavailable debug interface"};
+                        self.report->exception_handled(self.display_server.get(), invocation.id(), err);
+                    }
+                    return true;
+                }},
+            {"request_persistent_surface_id", call(&protobuf::DisplayServer::request_persistent_surface_id)},
+            {"preview_base_display_configuration", call(&protobuf::DisplayServer::preview_base_display_configuration)},
+            {"confirm_base_display_configuration", call(&protobuf::DisplayServer::confirm_base_display_configuration)},
+            {"cancel_base_display_configuration_preview",
+                call(&protobuf::DisplayServer::cancel_base_display_configuration_preview)},
+            {"apply_input_configuration", call(&protobuf::DisplayServer::apply_input_configuration)},
+            {"set_base_input_configuration", call(&protobuf::DisplayServer::set_base_input_configuration)},
+        };
+
+        for (auto const& method : table.by_opcode)
+            table.by_name[method.name] = &method;
+
+        return table;
+    }();
+
+    return table;
+}
+
 bool mfd::ProtobufMessageProcessor::dispatch(
     Invocation const& invocation,
     std::vector<mir::Fd> const& side_channel_fds)
 {
-    report->received_invocation(display_server.get(), invocation.id(), invocation.method_name());
+    auto const& methods = method_table();
+    Method const* method{nullptr};
 
-    bool result = true;
+    if (invocation.has_method_opcode())
+    {
+        if (invocation.method_opcode() < methods.by_opcode.size())
+            method = &methods.by_opcode[invocation.method_opcode()];
+    }
+    else
+    {
+        auto const i = methods.by_name.find(invocation.method_name());
+        if (i != methods.by_name.end())
+            method = i->second;
+    }
 
-    try
+    std::string unknown_method;
+    if (!method)
     {
-        // TODO comparing strings in an if-else chain isn't efficient.
-        // It is probably possible to generate a Trie at compile time.
-        if ("connect" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::connect, invocation);
-        }
-        else if ("create_surface" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::create_surface, invocation);
-        }
-        else if ("submit_buffer" == invocation.method_name())
-        {
-            auto request = parse_parameter<mir::protobuf::BufferRequest>(invocation);
-            request.mutable_buffer()->clear_fd();
-            for (auto& fd : side_channel_fds)
-                request.mutable_buffer()->add_fd(fd);
-            invoke(shared_from_this(), display_server.get(), &DisplayServer::submit_buffer, invocation.id(), &request);
-        }
-        else if ("allocate_buffers" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::allocate_buffers, invocation);
-        }
-        else if ("release_buffers" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::release_buffers, invocation);
-        }
-        else if ("release_surface" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::release_surface, invocation);
-        }
-        else if ("platform_operation" == invocation.method_name())
-        {
-            auto request = parse_parameter<mir::protobuf::PlatformOperationMessage>(invocation);
+        unknown_method = invocation.has_method_opcode() ?
+            "opcode " + std::to_string(invocation.method_opcode()) :
+            invocation.method_name();
+    }
+    auto const& method_name = method ? method->name : unknown_method;
 
-            request.clear_fd();
-            for (auto& fd : side_channel_fds)
-                request.add_fd(fd);
+    report->received_invocation(display_server.get(), invocation.id(), method_name);
 
-            invoke(shared_from_this(), display_server.get(), &DisplayServer::platform_operation,
-                   invocation.id(), &request);
-        }
-        else if ("configure_display" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::configure_display, invocation);
-        }
-        else if ("remove_session_configuration" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::remove_session_configuration, invocation);
-        }
-        else if ("set_base_display_configuration" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::set_base_display_configuration, invocation);
-        }
-        else if ("configure_surface" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::configure_surface, invocation);
-        }
-        else if ("modify_surface" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::modify_surface, invocation);
-        }
-        else if ("create_screencast" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::create_screencast, invocation);
-        }
-        else if ("screencast_buffer" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::screencast_buffer, invocation);
-        }
-        else if ("screencast_to_buffer" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::screencast_to_buffer, invocation);
-        }
-        else if ("release_screencast" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::release_screencast, invocation);
-        }
-        else if ("create_buffer_stream" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::create_buffer_stream, invocation);
-        }
-        else if ("release_buffer_stream" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::release_buffer_stream, invocation);
-        }
-        else if ("configure_cursor" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &protobuf::DisplayServer::configure_cursor, invocation);
-        }
-        else if ("new_fds_for_prompt_providers" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &protobuf::DisplayServer::new_fds_for_prompt_providers, invocation);
-        }
-        else if ("start_prompt_session" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &protobuf::DisplayServer::start_prompt_session, invocation);
-        }
-        else if ("stop_prompt_session" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &protobuf::DisplayServer::stop_prompt_session, invocation);
-        }
-        else if ("request_operation" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &protobuf::DisplayServer::request_operation, invocation);
-        }
-        else if ("disconnect" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::disconnect, invocation);
-            result = false;
-        }
-        else if ("pong" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::pong, invocation);
-        }
-        else if ("configure_buffer_stream" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &DisplayServer::configure_buffer_stream, invocation);
-        }
-        else if ("translate_surface_to_screen" == invocation.method_name())
-        {
-            try
-            {
-                auto debug_interface = dynamic_cast<mir::protobuf::DisplayServerDebug*>(display_server.get());
-                invoke(this, debug_interface, &mir::protobuf::DisplayServerDebug::translate_surface_to_screen, invocation);
-            }
-            catch (std::runtime_error const&)
-            {
-                std::string message{"Server does not support the client debugging interface"};
-                invoke(this,
-                       &message,
-                       &mir::protobuf::DisplayServerDebug::translate_surface_to_screen,
-                       invocation);
-                std::runtime_error err{"Client attempted to use unavailable debug interface"};
-                report->exception_handled(display_server.get(), invocation.id(), err);
-            }
-        }
-        else if ("request_persistent_surface_id" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &protobuf::DisplayServer::request_persistent_surface_id, invocation);
-        }
-        else if ("preview_base_display_configuration" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &protobuf::DisplayServer::preview_base_display_configuration, invocation);
-        }
-        else if ("confirm_base_display_configuration" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &protobuf::DisplayServer::confirm_base_display_configuration, invocation);
-        }
-        else if ("cancel_base_display_configuration_preview" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &protobuf::DisplayServer::cancel_base_display_configuration_preview, invocation);
-        }
-        else if ("apply_input_configuration" == invocation.method_name())
-        {
-            invoke(this, display_server.get(), &protobuf::DisplayServer::apply_input_configuration, invocation);
-        }
-        else if ("set_base_input_configuration" == invocation.method_name())
+    bool result = true;
+
+    try
+    {
+        if (method)
         {
-            invoke(this, display_server.get(), &protobuf::DisplayServer::set_base_input_configuration, invocation);
+            result = method->handle(*this, invocation, side_channel_fds);
         }
         else
         {
-            report->unknown_method(display_server.get(), invocation.id(), invocation.method_name());
+            report->unknown_method(display_server.get(), invocation.id(), method_name);
             result = false;
         }
     }
@@ -391,6 +399,11 @@ void mfd::ProtobufMessageProcessor::send_response(::google::protobuf::uint32 id,
 
 void mfd::ProtobufMessageProcessor::send_response(::google::protobuf::uint32 id, mir::protobuf::Connection* response)
 {
+    // Let the client invoke methods by opcode rather than by name from now on
+    response->clear_method_opcode();
+    for (auto const& method : method_table().by_opcode)
+        response->add_method_opcode(method.name);
+
     if (response->has_platform())
         sender->send_response(id, response, {extract_fds_from(response->mutable_platform())});
     else
@@ -62,6 +62,10 @@ public:
     void send_response(google::protobuf::uint32 id, std::shared_ptr<protobuf::PlatformOperationMessage> response);
 
 private:
+    struct Method;
+    struct MethodTable;
+    static MethodTable const& method_table();
+
     bool dispatch(Invocation const& invocation, std::vector<mir::Fd> const& side_channel_fds) override;
 
     std::shared_ptr<ProtobufMessageSender> const sender;
@@ -0,0 +1,291 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "recycling_buffer_allocator.h"
+
+#include "mir/graphics/buffer_basic.h"
+#include "mir/graphics/buffer_properties.h"
+#include "mir/time/alarm.h"
+#include "mir/time/alarm_factory.h"
+#include "mir/time/clock.h"
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// What a buffer was allocated for: only a request for exactly the same gets its storage
+struct Request
+{
+    enum class Kind { properties, native, software };
+
+    Kind kind;
+    geom::Size size;
+    uint32_t format;
+    uint32_t flags;
+
+    bool operator==(Request const& other) const
+    {
+        return kind == other.kind && size == other.size && format == other.format && flags == other.flags;
+    }
+};
+
+std::chrono::milliseconds rounded_up(mir::time::Duration duration)
+{
+    auto const milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+    return milliseconds < duration ? milliseconds + std::chrono::milliseconds{1} : milliseconds;
+}
+
+size_t bytes_of(mg::Buffer const& buffer)
+{
+    // Natively allocated buffers may not have a MirPixelFormat; assume the common 32bpp
+    auto const bytes_per_pixel = std::max(MIR_BYTES_PER_PIXEL(buffer.pixel_format()), 4);
+    return size_t(buffer.size().width.as_uint32_t()) * buffer.size().height.as_uint32_t() * bytes_per_pixel;
+}
+}
+
+class mf::RecyclingBufferAllocator::Pool
+{
+public:
+    Pool(
+        size_t max_bytes,
+        time::Duration max_idle,
+        std::shared_ptr<time::Clock> const& clock,
+        time::AlarmFactory& alarm_factory) :
+        max_bytes{max_bytes},
+        max_idle{max_idle},
+        clock{clock},
+        trim_alarm{alarm_factory.create_alarm([this] { trim_idle(); })}
+    {
+    }
+
+    /// Freed storage for request, or null if there is none
+    std::shared_ptr<mg::Buffer> take(Request const& request)
+    {
+        std::list<Entry> dropped;
+        std::shared_ptr<mg::Buffer> taken;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            trim(lock, dropped);
+
+            // The most recently freed match is the likeliest to still be cache-hot
+            auto const match = std::find_if(
+                entries.rbegin(), entries.rend(), [&request](Entry const& entry) { return entry.request == request; });
+
+            if (match != entries.rend())
+            {
+                total_bytes -= match->bytes;
+                taken = std::move(match->storage);
+                entries.erase(std::next(match).base());
+            }
+        }
+        return taken;
+    }
+
+    void give_back(Request const& request, std::shared_ptr<mg::Buffer>&& storage)
+    {
+        std::list<Entry> dropped;
+        auto const bytes = bytes_of(*storage);
+
+        if (bytes > max_bytes)
+            return;
+
+        time::Duration expiry;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            total_bytes += bytes;
+            entries.push_back(Entry{request, bytes, clock->now(), std::move(storage)});
+            trim(lock, dropped);
+            expiry = time_until_oldest_expires(lock);
+        }
+
+        trim_alarm->reschedule_in(rounded_up(expiry));
+    }
+
+    size_t bytes_held() const
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return total_bytes;
+    }
+
+private:
+    struct Entry
+    {
+        Request request;
+        size_t bytes;
+        time::Timestamp freed;
+        std::shared_ptr<mg::Buffer> storage;
+    };
+
+    /// Called by the alarm, so that storage doesn't outlive max_idle when a client stops allocating
+    void trim_idle()
+    {
+        std::list<Entry> dropped;
+        bool held;
+        time::Duration expiry;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            trim(lock, dropped);
+            held = !entries.empty();
+            expiry = time_until_oldest_expires(lock);
+        }
+
+        if (held)
+            trim_alarm->reschedule_in(rounded_up(expiry));
+    }
+
+    // Storage is moved to dropped to be destroyed once the lock is released
+    void trim(std::lock_guard<std::mutex> const&, std::list<Entry>& dropped)
+    {
+        auto const oldest_kept = clock->now() - max_idle;
+
+        while (!entries.empty() && (total_bytes > max_bytes || entries.front().freed <= oldest_kept))
+        {
+            total_bytes -= entries.front().bytes;
+            dropped.splice(dropped.end(), entries, entries.begin());
+        }
+    }
+
+    time::Duration time_until_oldest_expires(std::lock_guard<std::mutex> const&) const
+    {
+        if (entries.empty())
+            return max_idle;
+
+        return std::max(entries.front().freed + max_idle - clock->now(), time::Duration::zero());
+    }
+
+    size_t const max_bytes;
+    time::Duration const max_idle;
+    std::shared_ptr<time::Clock> const clock;
+
+    std::mutex mutable mutex;
+    /// Least recently freed first
+    std::list<Entry> entries;
+    size_t total_bytes{0};
+
+    // Last, so that its callback is done with before anything else is destroyed
+    std::unique_ptr<time::Alarm> const trim_alarm;
+};
+
+/// Storage handed out with a BufferID of its own, which returns to the pool when the last user lets go
+class mf::RecyclingBufferAllocator::RecycledBuffer : public mg::BufferBasic
+{
+public:
+    RecycledBuffer(std::shared_ptr<mg::Buffer>&& storage, Request const& request, std::weak_ptr<Pool> const& pool) :
+        storage{std::move(storage)},
+        request{request},
+        pool{pool}
+    {
+    }
+
+    ~RecycledBuffer()
+    {
+        if (auto const live_pool = pool.lock())
+            live_pool->give_back(request, std::move(storage));
+    }
+
+    std::shared_ptr<mg::NativeBuffer> native_buffer_handle() const override
+    {
+        return storage->native_buffer_handle();
+    }
+
+    geom::Size size() const override
+    {
+        return storage->size();
+    }
+
+    MirPixelFormat pixel_format() const override
+    {
+        return storage->pixel_format();
+    }
+
+    mg::NativeBufferBase* native_buffer_base() override
+    {
+        return storage->native_buffer_base();
+    }
+
+private:
+    std::shared_ptr<mg::Buffer> storage;
+    Request const request;
+    std::weak_ptr<Pool> const pool;
+};
+
+mf::RecyclingBufferAllocator::RecyclingBufferAllocator(
+    std::shared_ptr<mg::GraphicBufferAllocator> const& allocator,
+    size_t max_bytes,
+    time::Duration max_idle,
+    std::shared_ptr<time::Clock> const& clock,
+    std::shared_ptr<time::AlarmFactory> const& alarm_factory) :
+    allocator{allocator},
+    pool{std::make_shared<Pool>(max_bytes, max_idle, clock, *alarm_factory)}
+{
+}
+
+mf::RecyclingBufferAllocator::~RecyclingBufferAllocator() = default;
+
+std::shared_ptr<mg::Buffer> mf::RecyclingBufferAllocator::alloc_buffer(mg::BufferProperties const& properties)
+{
+    Request const request{
+        Request::Kind::properties,
+        properties.size,
+        static_cast<uint32_t>(properties.format),
+        static_cast<uint32_t>(properties.usage)};
+
+    auto storage = pool->take(request);
+    if (!storage)
+        storage = allocator->alloc_buffer(properties);
+
+    return std::make_shared<RecycledBuffer>(std::move(storage), request, pool);
+}
+
+std::vector<MirPixelFormat> mf::RecyclingBufferAllocator::supported_pixel_formats()
+{
+    return allocator->supported_pixel_formats();
+}
+
+std::shared_ptr<mg::Buffer> mf::RecyclingBufferAllocator::alloc_buffer(
+    geom::Size size, uint32_t native_format, uint32_t native_flags)
+{
+    Request const request{Request::Kind::native, size, native_format, native_flags};
+
+    auto storage = pool->take(request);
+    if (!storage)
+        storage = allocator->alloc_buffer(size, native_format, native_flags);
+
+    return std::make_shared<RecycledBuffer>(std::move(storage), request, pool);
+}
+
+std::shared_ptr<mg::Buffer> mf::RecyclingBufferAllocator::alloc_software_buffer(
+    geom::Size size, MirPixelFormat format)
+{
+    Request const request{Request::Kind::software, size, static_cast<uint32_t>(format), 0};
+
+    auto storage = pool->take(request);
+    if (!storage)
+        storage = allocator->alloc_software_buffer(size, format);
+
+    return std::make_shared<RecycledBuffer>(std::move(storage), request, pool);
+}
+
+size_t mf::RecyclingBufferAllocator::bytes_held() const
+{
+    return pool->bytes_held();
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_RECYCLING_BUFFER_ALLOCATOR_H_
+#define MIR_FRONTEND_RECYCLING_BUFFER_ALLOCATOR_H_
+
+#include "mir/graphics/graphic_buffer_allocator.h"
+#include "mir/time/types.h"
+
+#include <memory>
+
+namespace mir
+{
+namespace time
+{
+class AlarmFactory;
+class Clock;
+}
+
+namespace frontend
+{
+
+/**
+ * Allocates the buffers of one session, keeping those that are freed to hand
+ * out again for a request with the same size, format and usage.
+ *
+ * A buffer is freed once nothing (neither the client's nor the compositor's
+ * reference) holds it. Only the session it was allocated for gets its storage
+ * back, so no client is given memory another client may still have mapped;
+ * each reuse gets a new BufferID, as the client may not yet have forgotten
+ * the old one.
+ *
+ * Freed storage is kept for at most max_idle, and the least recently freed is
+ * dropped first when more than max_bytes would be kept.
+ */
+class RecyclingBufferAllocator : public graphics::GraphicBufferAllocator
+{
+public:
+    RecyclingBufferAllocator(
+        std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
+        size_t max_bytes,
+        time::Duration max_idle,
+        std::shared_ptr<time::Clock> const& clock,
+        std::shared_ptr<time::AlarmFactory> const& alarm_factory);
+    ~RecyclingBufferAllocator();
+
+    std::shared_ptr<graphics::Buffer> alloc_buffer(graphics::BufferProperties const& properties) override;
+    std::vector<MirPixelFormat> supported_pixel_formats() override;
+    std::shared_ptr<graphics::Buffer> alloc_buffer(
+        geometry::Size size, uint32_t native_format, uint32_t native_flags) override;
+    std::shared_ptr<graphics::Buffer> alloc_software_buffer(geometry::Size size, MirPixelFormat format) override;
+
+    /// Bytes of freed storage being kept for reuse
+    size_t bytes_held() const;
+
+private:
+    class Pool;
+    class RecycledBuffer;
+
+    std::shared_ptr<graphics::GraphicBufferAllocator> const allocator;
+    std::shared_ptr<Pool> const pool;
+};
+
+}
+}
+
+#endif /* MIR_FRONTEND_RECYCLING_BUFFER_ALLOCATOR_H_ */
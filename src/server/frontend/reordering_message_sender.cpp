@@ -43,6 +43,47 @@ void mf::ReorderingMessageSender::send(
     sink->send(data, length, fds);
 }
 
+void mf::ReorderingMessageSender::send_coalescible(char const* data, size_t length)
+{
+    {
+        std::lock_guard<decltype(message_lock)> lock{message_lock};
+        if (corked)
+        {
+            buffered_messages.emplace_back(Message {std::vector<char>(data, data + length), {}});
+            return;
+        }
+    }
+
+    sink->send_coalescible(data, length);
+}
+
+void mf::ReorderingMessageSender::send_in_stream(
+    MessageStream const& stream, char const* data, size_t length, bool coalescible)
+{
+    {
+        std::lock_guard<decltype(message_lock)> lock{message_lock};
+        if (corked)
+        {
+            buffered_messages.emplace_back(Message {std::vector<char>(data, data + length), {}});
+            return;
+        }
+    }
+
+    sink->send_in_stream(stream, data, length, coalescible);
+}
+
+bool mf::ReorderingMessageSender::replace_unsent(
+    MessageStream const& stream, char const* data, size_t length, bool coalescible)
+{
+    {
+        std::lock_guard<decltype(message_lock)> lock{message_lock};
+        if (corked)
+            return false;
+    }
+
+    return sink->replace_unsent(stream, data, length, coalescible);
+}
+
 void mf::ReorderingMessageSender::uncork()
 {
     {
@@ -38,6 +38,9 @@ public:
     explicit ReorderingMessageSender(std::shared_ptr<MessageSender> const& sink);
 
     void send(char const* data, size_t length, FdSets const& fds) override;
+    void send_coalescible(char const* data, size_t length) override;
+    void send_in_stream(MessageStream const& stream, char const* data, size_t length, bool coalescible) override;
+    bool replace_unsent(MessageStream const& stream, char const* data, size_t length, bool coalescible) override;
 
     /**
      * Stop diverting messages into the buffer.
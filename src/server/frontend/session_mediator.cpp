@@ -618,7 +618,8 @@ void mf::SessionMediator::release_surface(
         legacy_default_stream_map.erase(it);
     }
 
-    // TODO: We rely on this sending responses synchronously.
+    // The client relies on the response following everything already sent
+    // for the surface. Sends may be queued, but they are never reordered.
     done->Run();
 }
 
@@ -23,26 +23,123 @@
 #include "mir/raii.h"
 
 #include <boost/throw_exception.hpp>
+#include <boost/version.hpp>
 
 #include <errno.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
+#include <algorithm>
 #include <stdexcept>
+#include <system_error>
+#include <utility>
 
 namespace mf = mir::frontend;
 namespace mfd = mf::detail;
 namespace bs = boost::system;
 namespace ba = boost::asio;
 
-mfd::SocketMessenger::SocketMessenger(std::shared_ptr<ba::local::stream_protocol::socket> const& socket)
+namespace
+{
+size_t const header_size{2};
+size_t const max_iovecs{64};
+
+/// Writes what the socket will take without blocking (possibly nothing)
+size_t write_some(mir::Fd const& socket, iovec* iov, size_t iov_count)
+{
+    msghdr header{};
+    header.msg_iov = iov;
+    header.msg_iovlen = iov_count;
+
+    for (;;)
+    {
+        auto const sent = sendmsg(socket, &header, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if (sent >= 0)
+            return sent;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+        if (errno != EINTR)
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to send message to client"}));
+    }
+}
+
+/// Runs handler on the thread running the socket's io_service
+template<typename Handler>
+void post_to_io_thread(ba::local::stream_protocol::socket& socket, Handler&& handler)
+{
+#if BOOST_VERSION >= 106600
+    ba::post(socket.get_executor(), std::forward<Handler>(handler));
+#else
+    socket.get_io_service().post(std::forward<Handler>(handler));
+#endif
+}
+
+/// As mir::send_fds(), but returns false (having sent nothing) if the socket is full
+bool try_send_fds(mir::Fd const& socket, std::vector<mir::Fd> const& fds)
+{
+    if (fds.empty())
+        return true;
+
+    // The fds ride on a single byte of dummy data
+    char dummy_iov_data = 'M';
+    iovec iov{&dummy_iov_data, 1};
+
+    static auto const builtin_n_fds = 5;
+    static auto const builtin_cmsg_space = CMSG_SPACE(builtin_n_fds * sizeof(int));
+    auto const fds_bytes = fds.size() * sizeof(int);
+    mir::VariableLengthArray<builtin_cmsg_space> control{CMSG_SPACE(fds_bytes)};
+    memset(control.data(), 0, control.size());
+
+    msghdr header{};
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    header.msg_controllen = control.size();
+    header.msg_control = control.data();
+
+    auto const message = CMSG_FIRSTHDR(&header);
+    message->cmsg_len = CMSG_LEN(fds_bytes);
+    message->cmsg_level = SOL_SOCKET;
+    message->cmsg_type = SCM_RIGHTS;
+
+    auto const data = reinterpret_cast<int*>(CMSG_DATA(message));
+    for (size_t i = 0; i != fds.size(); ++i)
+        data[i] = fds[i];
+
+    for (;;)
+    {
+        if (sendmsg(socket, &header, MSG_NOSIGNAL | MSG_DONTWAIT) >= 0)
+            return true;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return false;
+        if (errno != EINTR)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to send fds: " + std::string(strerror(errno))));
+    }
+}
+}
+
+mf::SendQueueLimit::Overflow mf::send_queue_overflow_from(std::string const& name)
+{
+    if (name == "drop-coalescible")
+        return SendQueueLimit::Overflow::drop_coalescible;
+    else if (name == "disconnect")
+        return SendQueueLimit::Overflow::disconnect;
+
+    BOOST_THROW_EXCEPTION(std::invalid_argument{"Unknown client send queue overflow policy: " + name});
+}
+
+mfd::SocketMessenger::SocketMessenger(
+    std::shared_ptr<ba::local::stream_protocol::socket> const& socket,
+    SendQueueLimit const& send_queue_limit)
     : socket(socket),
-      socket_fd{IntOwnedFd{socket->native_handle()}}
+      socket_fd{IntOwnedFd{socket->native_handle()}},
+      send_queue_limit(send_queue_limit)
 {
     // Make the socket non-blocking to avoid hanging the server when a client
-    // is unresponsive. Also increase the send buffer size to 64KiB to allow
-    // more leeway for transient client freezes.
+    // is unresponsive; what the socket won't take is queued. Also increase the
+    // send buffer size to 64KiB to allow more leeway for transient client freezes.
     // See https://bugs.launchpad.net/mir/+bug/1350207
-    // TODO: Rework the messenger to support asynchronous sends
     socket->non_blocking(true);
     boost::asio::socket_base::send_buffer_size option(64*1024);
     socket->set_option(option);
@@ -71,26 +168,254 @@ mf::SessionCredentials mfd::SocketMessenger::client_creds()
     return creator_creds();
 }
 
-void mfd::SocketMessenger::send(char const* data, size_t length, FdSets const& fd_set)
+void mfd::SocketMessenger::send(char const* data, size_t length, FdSets const& fds)
 {
-    static size_t const header_size{2};
-    mir::VariableLengthArray<mf::serialization_buffer_size> whole_message{header_size + length};
+    send(data, length, fds, false, nullptr);
+}
 
-    whole_message.data()[0] = static_cast<unsigned char>((length >> 8) & 0xff);
-    whole_message.data()[1] = static_cast<unsigned char>((length >> 0) & 0xff);
-    std::copy(data, data + length, whole_message.data() + header_size);
+void mfd::SocketMessenger::send_coalescible(char const* data, size_t length)
+{
+    send(data, length, {}, true, nullptr);
+}
 
-    std::unique_lock<std::mutex> lg(message_lock);
+void mfd::SocketMessenger::send_in_stream(
+    MessageStream const& stream, char const* data, size_t length, bool coalescible)
+{
+    send(data, length, {}, coalescible, &stream);
+}
+
+bool mfd::SocketMessenger::replace_unsent(
+    MessageStream const& stream, char const* data, size_t length, bool coalescible)
+{
+    std::lock_guard<std::mutex> lock(message_lock);
 
-    // TODO: This should be asynchronous, but we are not making sure
-    // that a potential call to send_fds is executed _after_ this
-    // function has completed (if it would be executed asynchronously.
-    // NOTE: we rely on this synchronous behavior as per the comment in
-    // mf::SessionMediator::create_surface
-    ba::write(*socket, ba::buffer(whole_message.data(), whole_message.size()));
+    // Only other streams' messages may have been queued since, as replacing
+    // this one must not reorder it with anything else
+    for (auto i = send_queue.rbegin(); i != send_queue.rend() && i->in_stream; ++i)
+    {
+        if (!(i->stream == stream))
+            continue;
+
+        if (i->bytes_sent != 0)
+            return false;
 
-    for (auto const& fds : fd_set)
-        mir::send_fds(socket_fd, fds);
+        queued_bytes -= i->bytes.size();
+        i->bytes.resize(header_size);
+        i->bytes[0] = static_cast<char>((length >> 8) & 0xff);
+        i->bytes[1] = static_cast<char>((length >> 0) & 0xff);
+        i->bytes.insert(i->bytes.end(), data, data + length);
+        i->coalescible = coalescible;
+        queued_bytes += i->bytes.size();
+        return true;
+    }
+
+    return false;
+}
+
+void mfd::SocketMessenger::send(
+    char const* data, size_t length, FdSets const& fds, bool coalescible, MessageStream const* stream)
+{
+    char const header[header_size] = {
+        static_cast<char>((length >> 8) & 0xff),
+        static_cast<char>((length >> 0) & 0xff)};
+    size_t const message_size{header_size + length};
+
+    std::lock_guard<std::mutex> lock(message_lock);
+
+    if (disconnected)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Client has been disconnected"));
+
+    Outgoing message{{}, 0, fds, 0, coalescible, stream != nullptr, stream ? *stream : MessageStream{}};
+
+    // Nothing queued to go first, so try writing straight from the caller's buffer
+    if (send_queue.empty())
+    {
+        iovec iov[] = {
+            {const_cast<char*>(header), header_size},
+            {const_cast<char*>(data), length}};
+
+        message.bytes_sent = write_some(socket_fd, iov, 2);
+
+        if (message.bytes_sent == message_size && write_fds(message))
+            return;
+    }
+
+    // A message the client has started to receive can no longer be dropped
+    message.coalescible = coalescible && message.bytes_sent == 0;
+
+    auto const unsent = message_size - message.bytes_sent;
+    if (!make_room_for(unsent, message.coalescible, lock))
+        return;
+
+    message.bytes.reserve(message_size);
+    message.bytes.insert(message.bytes.end(), header, header + header_size);
+    message.bytes.insert(message.bytes.end(), data, data + length);
+
+    send_queue.push_back(std::move(message));
+    queued_bytes += unsent;
+
+    wait_until_writable(lock);
+}
+
+bool mfd::SocketMessenger::write_queued(std::lock_guard<std::mutex> const&)
+{
+    while (!send_queue.empty())
+    {
+        // Gather as many messages as we can into one write, stopping at any
+        // with fds as those must follow their message's bytes
+        iovec iov[max_iovecs];
+        size_t iov_count = 0;
+        for (auto& message : send_queue)
+        {
+            if (iov_count == max_iovecs)
+                break;
+
+            if (message.bytes_sent < message.bytes.size())
+                iov[iov_count++] = {
+                    message.bytes.data() + message.bytes_sent,
+                    message.bytes.size() - message.bytes_sent};
+
+            if (message.fd_sets_sent < message.fds.size())
+                break;
+        }
+
+        if (iov_count > 0)
+        {
+            auto written = write_some(socket_fd, iov, iov_count);
+            if (written == 0)
+                return false;
+
+            queued_bytes -= written;
+            for (auto& message : send_queue)
+            {
+                auto const taken = std::min(written, message.bytes.size() - message.bytes_sent);
+                message.bytes_sent += taken;
+                written -= taken;
+                if (written == 0)
+                    break;
+            }
+        }
+
+        while (!send_queue.empty() && send_queue.front().bytes_sent == send_queue.front().bytes.size())
+        {
+            if (!write_fds(send_queue.front()))
+                return false;
+            send_queue.pop_front();
+        }
+    }
+
+    return true;
+}
+
+bool mfd::SocketMessenger::write_fds(Outgoing& message)
+{
+    for (; message.fd_sets_sent != message.fds.size(); ++message.fd_sets_sent)
+    {
+        if (!try_send_fds(socket_fd, message.fds[message.fd_sets_sent]))
+            return false;
+    }
+    return true;
+}
+
+bool mfd::SocketMessenger::make_room_for(size_t bytes, bool coalescible, std::lock_guard<std::mutex> const& lock)
+{
+    auto const fits = [&] { return queued_bytes + bytes <= send_queue_limit.max_bytes; };
+
+    if (fits())
+        return true;
+
+    if (send_queue_limit.overflow == SendQueueLimit::Overflow::drop_coalescible)
+    {
+        // Queued coalescible messages are superseded by what follows them, so
+        // drop those the client has yet to see any of, oldest first. Streams
+        // already keep to one queued message each, which the stream's next
+        // message must be able to replace.
+        for (auto i = send_queue.begin(); i != send_queue.end() && !fits();)
+        {
+            if (i->coalescible && !i->in_stream && i->bytes_sent == 0)
+            {
+                queued_bytes -= i->bytes.size();
+                i = send_queue.erase(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        if (fits())
+            return true;
+
+        if (coalescible)
+            return false;
+    }
+
+    disconnect(lock);
+    BOOST_THROW_EXCEPTION(std::runtime_error("Client is not reading its messages: disconnecting"));
+}
+
+void mfd::SocketMessenger::disconnect(std::lock_guard<std::mutex> const&)
+{
+    disconnected = true;
+    send_queue.clear();
+    queued_bytes = 0;
+
+    // The socket is only used on its io_service's thread, where a read is
+    // pending on it. The connection notices the end of its input and cleans up.
+    auto const socket = this->socket;
+    post_to_io_thread(
+        *socket,
+        [socket]
+        {
+            bs::error_code ignored;
+            socket->shutdown(ba::local::stream_protocol::socket::shutdown_both, ignored);
+        });
+}
+
+void mfd::SocketMessenger::wait_until_writable(std::lock_guard<std::mutex> const&)
+{
+    if (waiting_until_writable || send_queue.empty())
+        return;
+
+    waiting_until_writable = true;
+
+    // As for disconnect(), start the wait on the io_service's thread
+    std::weak_ptr<SocketMessenger> const weak_self{shared_from_this()};
+    post_to_io_thread(
+        *socket,
+        [weak_self]
+        {
+            if (auto const self = weak_self.lock())
+            {
+                self->socket->async_write_some(
+                    ba::null_buffers(),
+                    [weak_self](bs::error_code const& error, size_t)
+                    {
+                        if (auto const self = weak_self.lock())
+                            self->on_writable(error);
+                    });
+            }
+        });
+}
+
+void mfd::SocketMessenger::on_writable(bs::error_code const& error)
+{
+    std::lock_guard<std::mutex> lock(message_lock);
+    waiting_until_writable = false;
+
+    // An error means the socket is going away: the receiving side deals with that
+    if (error || disconnected)
+        return;
+
+    try
+    {
+        if (!write_queued(lock))
+            wait_until_writable(lock);
+    }
+    catch (std::exception const&)
+    {
+        disconnect(lock);
+    }
 }
 
 void mfd::SocketMessenger::async_receive_msg(
@@ -21,7 +21,12 @@
 #include "message_sender.h"
 #include "message_receiver.h"
 #include "mir/frontend/session_credentials.h"
+#include "mir/frontend/send_queue_limit.h"
+
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 namespace mir
 {
@@ -29,13 +34,28 @@ namespace frontend
 {
 namespace detail
 {
+/**
+ * Sends without ever waiting on the client: whatever the socket will not take
+ * immediately is queued (file descriptors included, in order) and written as
+ * the socket drains. The queue is bounded by a SendQueueLimit.
+ *
+ * A queued message in a MessageStream can be replaced by a newer one until the
+ * client starts to receive it, so a client that falls behind has at most one
+ * message per stream waiting.
+ */
 class SocketMessenger : public MessageSender,
-                        public MessageReceiver
+                        public MessageReceiver,
+                        public std::enable_shared_from_this<SocketMessenger>
 {
 public:
-    SocketMessenger(std::shared_ptr<boost::asio::local::stream_protocol::socket> const& socket);
+    SocketMessenger(
+        std::shared_ptr<boost::asio::local::stream_protocol::socket> const& socket,
+        SendQueueLimit const& send_queue_limit);
 
     void send(char const* data, size_t length, FdSets const& fds) override;
+    void send_coalescible(char const* data, size_t length) override;
+    void send_in_stream(MessageStream const& stream, char const* data, size_t length, bool coalescible) override;
+    bool replace_unsent(MessageStream const& stream, char const* data, size_t length, bool coalescible) override;
 
     void async_receive_msg(MirReadHandler const& handler, boost::asio::mutable_buffers_1 const& buffer) override;
     boost::system::error_code receive_msg(boost::asio::mutable_buffers_1 const& buffer) override;
@@ -44,14 +64,38 @@ public:
     void receive_fds(std::vector<Fd>& fds) override;
 
 private:
+    struct Outgoing
+    {
+        std::vector<char> bytes;
+        size_t bytes_sent;
+        FdSets fds;         // Sent, one set at a time, once all the bytes have been
+        size_t fd_sets_sent;
+        bool coalescible;
+        bool in_stream;
+        MessageStream stream;
+    };
+
     void set_passcred(int opt);
     void update_session_creds();
     SessionCredentials creator_creds() const;
 
+    void send(char const* data, size_t length, FdSets const& fds, bool coalescible, MessageStream const* stream);
+    bool write_queued(std::lock_guard<std::mutex> const&);
+    bool write_fds(Outgoing& message);
+    bool make_room_for(size_t bytes, bool coalescible, std::lock_guard<std::mutex> const&);
+    void disconnect(std::lock_guard<std::mutex> const&);
+    void wait_until_writable(std::lock_guard<std::mutex> const&);
+    void on_writable(boost::system::error_code const& error);
+
     std::shared_ptr<boost::asio::local::stream_protocol::socket> socket;
     mir::Fd socket_fd;
+    SendQueueLimit const send_queue_limit;
 
     std::mutex message_lock;
+    std::deque<Outgoing> send_queue;
+    size_t queued_bytes{0};
+    bool waiting_until_writable{false};
+    bool disconnected{false};
     SessionCredentials session_creds{0, 0, 0};
 };
 }
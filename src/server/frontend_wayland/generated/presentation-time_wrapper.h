@@ -0,0 +1,149 @@
+/*
+ * AUTOGENERATED - DO NOT EDIT
+ *
+ * This header is generated by wrapper_generator.cpp from presentation-time.xml
+ * To regenerate, run the “refresh-wayland-wrapper” target.
+ */
+
+#ifndef MIR_FRONTEND_WAYLAND_PRESENTATION_TIME_XML_WRAPPER
+#define MIR_FRONTEND_WAYLAND_PRESENTATION_TIME_XML_WRAPPER
+
+#include <experimental/optional>
+#include <boost/throw_exception.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+
+#include "presentation-time.h"
+
+#include "mir/fd.h"
+#include "mir/log.h"
+
+namespace mir
+{
+namespace frontend
+{
+namespace wayland
+{
+class Presentation
+{
+protected:
+    Presentation(struct wl_display* display, uint32_t max_version)
+        : global{wl_global_create(display, &wp_presentation_interface, max_version,
+                                  this, &Presentation::bind_thunk)},
+            max_version{max_version}
+    {
+        if (global == nullptr)
+        {
+            BOOST_THROW_EXCEPTION((std::runtime_error{
+                "Failed to export wp_presentation interface"}));
+        }
+    }
+    virtual ~Presentation()
+    {
+        wl_global_destroy(global);
+    }
+
+    virtual void bind(struct wl_client* client, struct wl_resource* resource) { (void)client; (void)resource; }
+    virtual void destroy(struct wl_client* client, struct wl_resource* resource) = 0;
+    virtual void feedback(struct wl_client* client, struct wl_resource* resource, struct wl_resource* surface, uint32_t callback) = 0;
+
+    struct wl_global* const global;
+    uint32_t const max_version;
+
+private:
+    static void destroy_thunk(struct wl_client* client, struct wl_resource* resource)
+    {
+        auto me = static_cast<Presentation*>(wl_resource_get_user_data(resource));
+        try
+        {
+            me->destroy(client, resource);
+        }
+        catch(...)
+        {
+            ::mir::log(
+                ::mir::logging::Severity::critical,
+                "frontend:Wayland",
+                std::current_exception(),
+                "Exception processing Presentation::destroy() request");
+        }
+    }
+
+    static void feedback_thunk(struct wl_client* client, struct wl_resource* resource, struct wl_resource* surface, uint32_t callback)
+    {
+        auto me = static_cast<Presentation*>(wl_resource_get_user_data(resource));
+        try
+        {
+            me->feedback(client, resource, surface, callback);
+        }
+        catch(...)
+        {
+            ::mir::log(
+                ::mir::logging::Severity::critical,
+                "frontend:Wayland",
+                std::current_exception(),
+                "Exception processing Presentation::feedback() request");
+        }
+    }
+
+    static void bind_thunk(struct wl_client* client, void* data, uint32_t version, uint32_t id)
+    {
+        auto me = static_cast<Presentation*>(data);
+        auto resource = wl_resource_create(client, &wp_presentation_interface,
+                                           std::min(version, me->max_version), id);
+        if (resource == nullptr)
+        {
+            wl_client_post_no_memory(client);
+            BOOST_THROW_EXCEPTION((std::bad_alloc{}));
+        }
+        wl_resource_set_implementation(resource, get_vtable(), me, nullptr);
+        try
+        {
+          me->bind(client, resource);
+        }
+        catch(...)
+        {
+            ::mir::log(
+                ::mir::logging::Severity::critical,
+                "frontend:Wayland",
+                std::current_exception(),
+                "Exception processing Presentation::bind() request");
+        }
+    }
+
+    static inline struct wp_presentation_interface const* get_vtable()
+    {
+        static struct wp_presentation_interface const vtable = {
+            destroy_thunk,
+            feedback_thunk,
+        };
+        return &vtable;
+    }
+};
+
+
+class PresentationFeedback
+{
+protected:
+    PresentationFeedback(struct wl_client* client, struct wl_resource* parent, uint32_t id)
+        : client{client},
+          resource{wl_resource_create(client, &wp_presentation_feedback_interface, wl_resource_get_version(parent), id)}
+    {
+        if (resource == nullptr)
+        {
+            wl_resource_post_no_memory(parent);
+            BOOST_THROW_EXCEPTION((std::bad_alloc{}));
+        }
+    }
+    virtual ~PresentationFeedback() = default;
+
+
+    struct wl_client* const client;
+    struct wl_resource* const resource;
+
+};
+
+
+}
+}
+}
+
+#endif // MIR_FRONTEND_WAYLAND_PRESENTATION_TIME_XML_WRAPPER
@@ -26,6 +26,7 @@
 #include "wl_surface.h"
 #include "wl_seat.h"
 #include "xdg_shell_v6.h"
+#include "wp_presentation.h"
 #include "wl_region.h"
 
 #include "wl_surface_event_sink.h"
@@ -265,16 +266,22 @@ public:
     WlCompositor(
         struct wl_display* display,
         std::shared_ptr<mir::Executor> const& executor,
-        std::shared_ptr<mg::WaylandAllocator> const& allocator)
+        std::shared_ptr<mg::WaylandAllocator> const& allocator,
+        std::shared_ptr<mc::PresentationClock> const& presentation_clock,
+        bool shm_zero_copy)
         : Compositor(display, 3),
           allocator{allocator},
-          executor{executor}
+          presentation_clock{presentation_clock},
+          executor{executor},
+          shm_zero_copy{shm_zero_copy}
     {
     }
 
 private:
     std::shared_ptr<mg::WaylandAllocator> const allocator;
+    std::shared_ptr<mc::PresentationClock> const presentation_clock;
     std::shared_ptr<mir::Executor> const executor;
+    bool const shm_zero_copy;
 
     void create_surface(wl_client* client, wl_resource* resource, uint32_t id) override;
     void create_region(wl_client* client, wl_resource* resource, uint32_t id) override;
@@ -282,7 +289,7 @@ private:
 
 void WlCompositor::create_surface(wl_client* client, wl_resource* resource, uint32_t id)
 {
-    new WlSurface{client, resource, id, executor, allocator};
+    new WlSurface{client, resource, id, get_session(client), executor, allocator, presentation_clock, shm_zero_copy};
 }
 
 void WlCompositor::create_region(wl_client* client, wl_resource* resource, uint32_t id)
@@ -619,8 +626,11 @@ mf::WaylandConnector::WaylandConnector(
     std::shared_ptr<mi::InputDeviceHub> const& input_hub,
     std::shared_ptr<mi::Seat> const& seat,
     std::shared_ptr<mg::GraphicBufferAllocator> const& allocator,
+    std::shared_ptr<mc::PresentationClock> const& presentation_clock,
     std::shared_ptr<mf::SessionAuthorizer> const& session_authorizer,
-    bool arw_socket)
+    bool arw_socket,
+    bool shm_zero_copy,
+    mi::MotionCoalescing motion_coalescing)
     : display{wl_display_create(), &cleanup_display},
       pause_signal{eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE)},
       allocator{allocator_for_display(allocator, display.get())}
@@ -652,9 +662,11 @@ mf::WaylandConnector::WaylandConnector(
     compositor_global = std::make_unique<mf::WlCompositor>(
         display.get(),
         executor,
-        this->allocator);
+        this->allocator,
+        presentation_clock,
+        shm_zero_copy);
     subcompositor_global = std::make_unique<mf::WlSubcompositor>(display.get());
-    seat_global = std::make_unique<mf::WlSeat>(display.get(), input_hub, seat, executor);
+    seat_global = std::make_unique<mf::WlSeat>(display.get(), input_hub, seat, executor, motion_coalescing);
     output_manager = std::make_unique<mf::OutputManager>(
         display.get(),
         display_config);
@@ -662,6 +674,7 @@ mf::WaylandConnector::WaylandConnector(
     data_device_manager_global = mf::create_data_device_manager(display.get());
     if (!getenv("MIR_DISABLE_XDG_SHELL_V6_UNSTABLE"))
         xdg_shell_global = std::make_unique<XdgShellV6>(display.get(), shell, *seat_global, output_manager.get());
+    presentation_global = std::make_unique<WpPresentation>(display.get(), presentation_clock);
 
     wl_display_init_shm(display.get());
 
@@ -33,12 +33,17 @@ namespace input
 {
 class InputDeviceHub;
 class Seat;
+enum class MotionCoalescing;
 }
 namespace graphics
 {
 class GraphicBufferAllocator;
 class WaylandAllocator;
 }
+namespace compositor
+{
+class PresentationClock;
+}
 namespace geometry
 {
 struct Size;
@@ -50,6 +55,7 @@ class WlSubcompositor;
 class WlApplication;
 class WlShell;
 class XdgShellV6;
+class WpPresentation;
 class WlSeat;
 class OutputManager;
 
@@ -68,8 +74,11 @@ public:
         std::shared_ptr<input::InputDeviceHub> const& input_hub,
         std::shared_ptr<input::Seat> const& seat,
         std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
+        std::shared_ptr<compositor::PresentationClock> const& presentation_clock,
         std::shared_ptr<SessionAuthorizer> const& session_authorizer,
-        bool arw_socket);
+        bool arw_socket,
+        bool shm_zero_copy,
+        input::MotionCoalescing motion_coalescing);
 
     ~WaylandConnector() override;
 
@@ -96,6 +105,7 @@ private:
     std::unique_ptr<WlShell> shell_global;
     std::unique_ptr<DataDeviceManager> data_device_manager_global;
     std::unique_ptr<XdgShellV6> xdg_shell_global;
+    std::unique_ptr<WpPresentation> presentation_global;
     std::thread dispatch_thread;
     wl_event_source* pause_source;
     std::string wayland_display;
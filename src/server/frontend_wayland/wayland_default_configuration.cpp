@@ -21,6 +21,7 @@
 
 #include "mir/frontend/display_changer.h"
 #include "mir/graphics/platform.h"
+#include "mir/input/motion_coalescing.h"
 #include "mir/options/default_configuration.h"
 
 namespace mf = mir::frontend;
@@ -32,6 +33,9 @@ std::shared_ptr<mf::Connector>
         [this]() -> std::shared_ptr<mf::Connector>
         {
             bool const arw_socket = the_options()->is_set(options::arw_server_socket_opt);
+            bool const shm_zero_copy = the_options()->get<bool>(options::wayland_shm_zero_copy_opt);
+            auto const motion_coalescing =
+                input::motion_coalescing_from(the_options()->get<std::string>(options::motion_coalescing_opt));
 
             optional_value<std::string> display_name;
 
@@ -45,7 +49,10 @@ std::shared_ptr<mf::Connector>
                 the_input_device_hub(),
                 the_seat(),
                 the_buffer_allocator(),
+                the_presentation_clock(),
                 the_session_authorizer(),
-                arw_socket);
+                arw_socket,
+                shm_zero_copy,
+                motion_coalescing);
         });
 }
@@ -25,12 +25,14 @@
 #include "mir/client/event.h"
 #include "mir/anonymous_shm_file.h"
 #include "mir/input/keymap.h"
+#include "mir/input/xkb_mapper.h"
 
 #include <xkbcommon/xkbcommon.h>
 
 #include <cstring> // memcpy
 
 namespace mf = mir::frontend;
+namespace mi = mir::input;
 
 mf::WlKeyboard::WlKeyboard(
     wl_client* client,
@@ -40,9 +42,7 @@ mf::WlKeyboard::WlKeyboard(
     std::function<void(WlKeyboard*)> const& on_destroy,
     std::function<std::vector<uint32_t>()> const& acquire_current_keyboard_state)
     : Keyboard(client, parent, id),
-      keymap{nullptr, &xkb_keymap_unref},
       state{nullptr, &xkb_state_unref},
-      context{xkb_context_new(XKB_CONTEXT_NO_FLAGS), &xkb_context_unref},
       on_destroy{on_destroy},
       acquire_current_keyboard_state{acquire_current_keyboard_state}
 {
@@ -134,7 +134,7 @@ void mf::WlKeyboard::handle_window_event(MirWindowEvent const* event, WlSurface*
                 keyboard_state.size() * sizeof(decltype(keyboard_state)::value_type));
 
             // Rebuild xkb state
-            state = decltype(state)(xkb_state_new(keymap.get()), &xkb_state_unref);
+            state = mi::make_unique_state(keymap.get());
             for (auto scancode : keyboard_state)
             {
                 xkb_state_update_key(state.get(), scancode + 8, XKB_KEY_DOWN);
@@ -167,35 +167,16 @@ void mf::WlKeyboard::handle_keymap_event(MirKeymapEvent const* event, WlSurface*
         shm_buffer.fd(),
         length);
 
-    keymap = decltype(keymap)(xkb_keymap_new_from_buffer(
-        context.get(),
-        buffer,
-        length,
-        XKB_KEYMAP_FORMAT_TEXT_V1,
-        XKB_KEYMAP_COMPILE_NO_FLAGS),
-        &xkb_keymap_unref);
-
-    state = decltype(state)(xkb_state_new(keymap.get()), &xkb_state_unref);
+    keymap = mi::make_shared_keymap(buffer, length);
+    state = mi::make_unique_state(keymap.get());
 }
 
 void mf::WlKeyboard::set_keymap(mir::input::Keymap const& new_keymap)
 {
-    xkb_rule_names const names = {
-        "evdev",
-        new_keymap.model.c_str(),
-        new_keymap.layout.c_str(),
-        new_keymap.variant.c_str(),
-        new_keymap.options.c_str()
-    };
-    keymap = decltype(keymap){
-        xkb_keymap_new_from_names(
-            context.get(),
-            &names,
-            XKB_KEYMAP_COMPILE_NO_FLAGS),
-        &xkb_keymap_unref};
+    keymap = mi::make_shared_keymap(new_keymap);
 
     // TODO: We might need to copy across the existing depressed keys?
-    state = decltype(state)(xkb_state_new(keymap.get()), &xkb_state_unref);
+    state = mi::make_unique_state(keymap.get());
 
     std::unique_ptr<char, void(*)(void*)> buffer{xkb_keymap_get_as_string(keymap.get(), XKB_KEYMAP_FORMAT_TEXT_V1), free};
     auto length = strlen(buffer.get());
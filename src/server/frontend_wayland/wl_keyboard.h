@@ -21,12 +21,12 @@
 
 #include "generated/wayland_wrapper.h"
 
+#include <memory>
 #include <vector>
 
 // from <xkbcommon/xkbcommon.h>
 struct xkb_keymap;
 struct xkb_state;
-struct xkb_context;
 
 // from "mir_toolkit/events/event.h"
 struct MirKeyboardEvent;
@@ -69,9 +69,8 @@ public:
 private:
     void update_modifier_state();
 
-    std::unique_ptr<xkb_keymap, void (*)(xkb_keymap *)> keymap;
+    std::shared_ptr<xkb_keymap> keymap;
     std::unique_ptr<xkb_state, void (*)(xkb_state *)> state;
-    std::unique_ptr<xkb_context, void (*)(xkb_context *)> const context;
 
     std::function<void(WlKeyboard*)> on_destroy;
     std::function<std::vector<uint32_t>()> const acquire_current_keyboard_state;
@@ -142,7 +142,8 @@ mf::WlSeat::WlSeat(
     wl_display* display,
     std::shared_ptr<mi::InputDeviceHub> const& input_hub,
     std::shared_ptr<mi::Seat> const& seat,
-    std::shared_ptr<mir::Executor> const& executor)
+    std::shared_ptr<mir::Executor> const& executor,
+    mi::MotionCoalescing motion_coalescing)
     :   Seat(display, 5),
         keymap{std::make_unique<input::Keymap>()},
         config_observer{
@@ -157,7 +158,8 @@ mf::WlSeat::WlSeat(
         touch_listeners{std::make_shared<ListenerList<WlTouch>>()},
         input_hub{input_hub},
         seat{seat},
-        executor{executor}
+        executor{executor},
+        motion_coalescing_{motion_coalescing}
 {
     input_hub->add_observer(config_observer);
 }
@@ -198,6 +200,11 @@ void mf::WlSeat::spawn(std::function<void()>&& work)
     executor->spawn(std::move(work));
 }
 
+auto mf::WlSeat::motion_coalescing() const -> mi::MotionCoalescing
+{
+    return motion_coalescing_;
+}
+
 void mf::WlSeat::bind(wl_client* /*client*/, wl_resource* resource)
 {
     // TODO: Read the actual capabilities. Do we have a keyboard? Mouse? Touch?
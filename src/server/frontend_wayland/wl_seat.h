@@ -20,6 +20,7 @@
 #define MIR_FRONTEND_WL_SEAT_H
 
 #include "generated/wayland_wrapper.h"
+#include "mir/input/motion_coalescing.h"
 
 #include <unordered_map>
 #include <vector>
@@ -53,7 +54,8 @@ public:
         wl_display* display,
         std::shared_ptr<mir::input::InputDeviceHub> const& input_hub,
         std::shared_ptr<mir::input::Seat> const& seat,
-        std::shared_ptr<mir::Executor> const& executor);
+        std::shared_ptr<mir::Executor> const& executor,
+        input::MotionCoalescing motion_coalescing);
 
     ~WlSeat();
 
@@ -65,6 +67,8 @@ public:
 
     void spawn(std::function<void()>&& work);
 
+    auto motion_coalescing() const -> input::MotionCoalescing;
+
     class ListenerTracker
     {
     public:
@@ -100,6 +104,7 @@ private:
     std::shared_ptr<input::Seat> const seat;
 
     std::shared_ptr<mir::Executor> const executor;
+    input::MotionCoalescing const motion_coalescing_;
 
     void bind(wl_client* client, wl_resource* resource) override;
     void get_pointer(wl_client* client, wl_resource* resource, uint32_t id) override;
@@ -26,17 +26,106 @@
 #include "deleted_for_resource.h"
 
 #include "generated/wayland_wrapper.h"
+#include "generated/presentation-time.h"
 
 #include "mir/graphics/buffer_properties.h"
 #include "mir/frontend/session.h"
 #include "mir/compositor/buffer_stream.h"
+#include "mir/compositor/presentation_clock.h"
 #include "mir/executor.h"
 #include "mir/graphics/wayland_allocator.h"
 #include "mir/shell/surface_specification.h"
 
+#include <algorithm>
+#include <limits>
+#include <mutex>
+
 namespace mf = mir::frontend;
+namespace mc = mir::compositor;
 namespace geom = mir::geometry;
 
+namespace
+{
+// Clients commonly damage (0, 0, INT32_MAX, INT32_MAX), so clip without overflowing
+geom::Rectangles clip_damage(std::vector<geom::Rectangle> const& damage, geom::Size const& buffer_size)
+{
+    geom::Rectangles clipped;
+    for (auto const& rect : damage)
+    {
+        int64_t const left = std::max(rect.top_left.x.as_int(), 0);
+        int64_t const top = std::max(rect.top_left.y.as_int(), 0);
+        int64_t const right = std::min<int64_t>(
+            int64_t{rect.top_left.x.as_int()} + rect.size.width.as_int(), buffer_size.width.as_int());
+        int64_t const bottom = std::min<int64_t>(
+            int64_t{rect.top_left.y.as_int()} + rect.size.height.as_int(), buffer_size.height.as_int());
+
+        if (right > left && bottom > top)
+            clipped.add({{left, top}, {right - left, bottom - top}});
+    }
+    return clipped;
+}
+
+uint32_t to_milliseconds(mir::time::PosixTimestamp const& time)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.nanoseconds).count();
+}
+
+void send_presented(
+    std::vector<mf::WlSurfaceState::Callback> const& feedbacks,
+    mc::PresentationClock::Presentation const& presentation)
+{
+    auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(presentation.time.nanoseconds);
+    uint64_t const tv_sec = seconds.count();
+    uint32_t const tv_nsec = (presentation.time.nanoseconds - seconds).count();
+    uint64_t const seq = presentation.msc;
+    uint32_t const flags = presentation.vsync ? WP_PRESENTATION_FEEDBACK_KIND_VSYNC : 0;
+
+    for (auto const& feedback : feedbacks)
+    {
+        if (!*feedback.destroyed)
+        {
+            wp_presentation_feedback_send_presented(
+                feedback.resource,
+                tv_sec >> 32, tv_sec & 0xffffffff, tv_nsec,
+                presentation.refresh.count(),
+                seq >> 32, seq & 0xffffffff,
+                flags);
+            wl_resource_destroy(feedback.resource);
+        }
+    }
+}
+
+void send_discarded(std::vector<mf::WlSurfaceState::Callback> const& feedbacks)
+{
+    for (auto const& feedback : feedbacks)
+    {
+        if (!*feedback.destroyed)
+        {
+            wp_presentation_feedback_send_discarded(feedback.resource);
+            wl_resource_destroy(feedback.resource);
+        }
+    }
+}
+}
+
+/*
+ * Presentation feedback for a committed buffer is claimed either by the compositor
+ * consuming the buffer, or by a later commit that replaces the buffer first.
+ */
+struct mf::WlSurface::UnclaimedFeedback
+{
+    std::mutex mutex;
+    std::vector<WlSurfaceState::Callback> feedbacks;
+
+    std::vector<WlSurfaceState::Callback> claim()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        std::vector<WlSurfaceState::Callback> claimed;
+        claimed.swap(feedbacks);
+        return claimed;
+    }
+};
+
 void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
 {
     if (source.buffer)
@@ -48,10 +137,19 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
     if (source.input_shape)
         input_shape = source.input_shape;
 
+    if (source.opaque_region)
+        opaque_region = source.opaque_region;
+
     frame_callbacks.insert(end(frame_callbacks),
                            begin(source.frame_callbacks),
                            end(source.frame_callbacks));
 
+    presentation_feedbacks.insert(end(presentation_feedbacks),
+                                  begin(source.presentation_feedbacks),
+                                  end(source.presentation_feedbacks));
+
+    damage.insert(end(damage), begin(source.damage), end(source.damage));
+
     if (source.surface_data_invalidated)
         surface_data_invalidated = true;
 }
@@ -67,16 +165,22 @@ mf::WlSurface::WlSurface(
     wl_client* client,
     wl_resource* parent,
     uint32_t id,
+    std::shared_ptr<Session> const& session,
     std::shared_ptr<Executor> const& executor,
-    std::shared_ptr<graphics::WaylandAllocator> const& allocator)
+    std::shared_ptr<graphics::WaylandAllocator> const& allocator,
+    std::shared_ptr<mc::PresentationClock> const& presentation_clock,
+    bool shm_zero_copy)
     : Surface(client, parent, id),
-        session{mf::get_session(client)},
+        session{session},
         stream_id{session->create_buffer_stream({{}, mir_pixel_format_invalid, graphics::BufferUsage::undefined})},
         stream{session->get_buffer_stream(stream_id)},
         allocator{allocator},
+        presentation_clock{presentation_clock},
         executor{executor},
+        shm_zero_copy{shm_zero_copy},
         null_role{this},
         role{&null_role},
+        unclaimed_feedback{std::make_shared<UnclaimedFeedback>()},
         destroyed{std::make_shared<bool>(false)}
 {
     // wl_surface is specified to act in mailbox mode
@@ -95,6 +199,9 @@ mf::WlSurface::~WlSurface()
         listener.second();
     }
 
+    send_discarded(unclaimed_feedback->claim());
+    send_discarded(pending.presentation_feedbacks);
+
     role->destroy();
     session->destroy_buffer_stream(stream_id);
 }
@@ -205,14 +312,19 @@ mf::WlSurface* mf::WlSurface::from(wl_resource* resource)
     return static_cast<WlSurface*>(static_cast<wayland::Surface*>(raw_surface));
 }
 
-void mf::WlSurface::send_frame_callbacks()
+void mf::WlSurface::presentation_feedback(wl_resource* feedback)
+{
+    pending.presentation_feedbacks.emplace_back(
+        WlSurfaceState::Callback{feedback, deleted_flag_for_resource(feedback)});
+}
+
+void mf::WlSurface::send_frame_callbacks(uint32_t timestamp_ms)
 {
     for (auto const& frame : frame_callbacks)
     {
         if (!*frame.destroyed)
         {
-            // TODO: argument should be a timestamp
-            wl_callback_send_done(frame.resource, 0);
+            wl_callback_send_done(frame.resource, timestamp_ms);
             wl_resource_destroy(frame.resource);
         }
     }
@@ -239,20 +351,13 @@ void mf::WlSurface::attach(std::experimental::optional<wl_resource*> const& buff
 
 void mf::WlSurface::damage(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    pending.damage.push_back({{x, y}, {width, height}});
 }
 
 void mf::WlSurface::damage_buffer(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    // Without buffer transform or scale, buffer and surface coordinates are the same
+    pending.damage.push_back({{x, y}, {width, height}});
 }
 
 void mf::WlSurface::frame(uint32_t callback)
@@ -264,8 +369,10 @@ void mf::WlSurface::frame(uint32_t callback)
 
 void mf::WlSurface::set_opaque_region(std::experimental::optional<wl_resource*> const& region)
 {
-    (void)region;
-    // This isn't essential, but could enable optimizations
+    if (region)
+        pending.opaque_region = WlRegion::from(region.value())->region();
+    else
+        pending.opaque_region = geom::Region{};
 }
 
 void mf::WlSurface::set_input_region(std::experimental::optional<wl_resource*> const& region)
@@ -296,26 +403,46 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.input_shape)
         input_shape = state.input_shape.value();
 
+    if (state.opaque_region)
+        stream->set_opaque_region(state.opaque_region.value());
+
     if (state.buffer)
     {
         wl_resource * buffer = *state.buffer;
 
+        // Whatever buffer the compositor has yet to consume is being replaced
+        send_discarded(unclaimed_feedback->claim());
+
         if (buffer == nullptr)
         {
             // TODO: unmap surface, and unmap all subsurfaces
             buffer_size_ = std::experimental::nullopt;
-            send_frame_callbacks();
+            send_discarded(state.presentation_feedbacks);
+            send_frame_callbacks(to_milliseconds(time::PosixTimestamp::now(presentation_clock->clock_id())));
         }
         else
         {
-            auto const executor_send_frame_callbacks = [this, executor = executor, destroyed = destroyed]()
+            unclaimed_feedback = std::make_shared<UnclaimedFeedback>();
+            unclaimed_feedback->feedbacks = state.presentation_feedbacks;
+
+            // Once the compositor has consumed the buffer, the next frame it presents includes it
+            auto const executor_send_frame_callbacks =
+                [this, executor = executor, destroyed = destroyed,
+                 clock = presentation_clock, feedback = unclaimed_feedback]()
                 {
-                    executor->spawn(run_unless(
-                        destroyed,
-                        [this]()
+                    clock->on_next_presentation(
+                        [this, executor, destroyed, feedbacks = feedback->claim()]
+                        (mc::PresentationClock::Presentation const& presentation)
                         {
-                            send_frame_callbacks();
-                        }));
+                            executor->spawn(
+                                [this, destroyed, feedbacks, presentation]()
+                                {
+                                    send_presented(feedbacks, presentation);
+
+                                    if (!*destroyed)
+                                        send_frame_callbacks(to_milliseconds(presentation.time));
+                                });
+                        });
                 };
 
             std::shared_ptr<graphics::Buffer> mir_buffer;
@@ -324,6 +451,8 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             {
                 mir_buffer = WlShmBuffer::mir_buffer_from_wl_buffer(
                     buffer,
+                    shm_zero_copy,
+                    executor,
                     std::move(executor_send_frame_callbacks));
             }
             else
@@ -358,12 +487,20 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             }
             buffer_size_ = mir_buffer->size();
             stream->resize(buffer_size_.value());
-            stream->submit_buffer(mir_buffer);
+
+            // A client that attaches without damaging anything is technically asking for the new buffer to be
+            // ignored, but it's more likely to be buggy. Play safe and treat the whole buffer as damaged.
+            if (state.damage.empty())
+                stream->submit_buffer(mir_buffer);
+            else
+                stream->submit_damaged_buffer(mir_buffer, clip_damage(state.damage, buffer_size_.value()));
         }
     }
     else
     {
-        send_frame_callbacks();
+        // Without a new buffer there's no new frame to give feedback on
+        send_discarded(state.presentation_feedbacks);
+        send_frame_callbacks(to_milliseconds(time::PosixTimestamp::now(presentation_clock->clock_id())));
     }
 
     for (WlSubsurface* child: children)
@@ -29,6 +29,7 @@
 #include "mir/geometry/displacement.h"
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
+#include "mir/geometry/region.h"
 
 #include <vector>
 
@@ -40,6 +41,10 @@ namespace graphics
 {
 class WaylandAllocator;
 }
+namespace compositor
+{
+class PresentationClock;
+}
 namespace shell
 {
 struct StreamSpecification;
@@ -78,7 +83,13 @@ struct WlSurfaceState
 
     std::experimental::optional<geometry::Displacement> offset;
     std::experimental::optional<std::experimental::optional<std::vector<geometry::Rectangle>>> input_shape;
+    // An empty region (rather than nullopt) when the client unsets the opaque region
+    std::experimental::optional<geometry::Region> opaque_region;
     std::vector<Callback> frame_callbacks;
+    std::vector<Callback> presentation_feedbacks;
+    // Unclipped, as requested by the client (surface and buffer coordinates are the same as we don't support
+    // buffer transform or scale)
+    std::vector<geometry::Rectangle> damage;
 
 private:
     // only set to true if invalidate_surface_data() is called
@@ -115,8 +126,11 @@ public:
     WlSurface(wl_client* client,
               wl_resource* parent,
               uint32_t id,
+              std::shared_ptr<mir::frontend::Session> const& session,
               std::shared_ptr<mir::Executor> const& executor,
-              std::shared_ptr<mir::graphics::WaylandAllocator> const& allocator);
+              std::shared_ptr<mir::graphics::WaylandAllocator> const& allocator,
+              std::shared_ptr<mir::compositor::PresentationClock> const& presentation_clock,
+              bool shm_zero_copy);
 
     ~WlSurface();
 
@@ -141,6 +155,8 @@ public:
     void commit(WlSurfaceState const& state);
     void add_destroy_listener(void const* key, std::function<void()> listener);
     void remove_destroy_listener(void const* key);
+    /// Requests wp_presentation_feedback for the pending content update
+    void presentation_feedback(wl_resource* feedback);
 
     std::shared_ptr<mir::frontend::Session> const session;
     mir::frontend::BufferStreamId const stream_id;
@@ -149,8 +165,12 @@ public:
     static WlSurface* from(wl_resource* resource);
 
 private:
+    struct UnclaimedFeedback;
+
     std::shared_ptr<mir::graphics::WaylandAllocator> const allocator;
+    std::shared_ptr<mir::compositor::PresentationClock> const presentation_clock;
     std::shared_ptr<mir::Executor> const executor;
+    bool const shm_zero_copy;
 
     NullWlSurfaceRole null_role;
     WlSurfaceRole* role;
@@ -160,11 +180,12 @@ private:
     geometry::Displacement offset_;
     std::experimental::optional<geometry::Size> buffer_size_;
     std::vector<WlSurfaceState::Callback> frame_callbacks;
+    std::shared_ptr<UnclaimedFeedback> unclaimed_feedback;
     std::experimental::optional<std::vector<mir::geometry::Rectangle>> input_shape;
     std::map<void const*, std::function<void()>> destroy_listeners;
     std::shared_ptr<bool> const destroyed;
 
-    void send_frame_callbacks();
+    void send_frame_callbacks(uint32_t timestamp_ms);
 
     void destroy() override;
     void attach(std::experimental::optional<wl_resource*> const& buffer, int32_t x, int32_t y) override;
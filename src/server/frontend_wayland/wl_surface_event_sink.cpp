@@ -25,10 +25,13 @@
 #include "wayland_utils.h"
 #include "window_wl_surface_role.h"
 
+#include "mir/input/motion_coalescing.h"
+
 #include <linux/input-event-codes.h>
 
 namespace mf = mir::frontend;
 namespace geom = mir::geometry;
+namespace mi = mir::input;
 
 mf::WlSurfaceEventSink::WlSurfaceEventSink(WlSeat* seat, wl_client* client, WlSurface* surface,
                                            WindowWlSurfaceRole* window)
@@ -48,10 +51,28 @@ mf::WlSurfaceEventSink::~WlSurfaceEventSink()
 
 void mf::WlSurfaceEventSink::handle_event(EventUPtr&& event)
 {
+    std::shared_ptr<MirEvent> const spawned_event{move(event)};
+
+    {
+        std::lock_guard<std::mutex> lock{pending_event_mutex};
+
+        // If the client is yet to see the last (motion) event, bring that up to date rather than queue more
+        if (pending_event && mi::coalesce_motion(*pending_event, *spawned_event, seat->motion_coalescing()))
+            return;
+
+        pending_event = spawned_event;
+    }
+
     seat->spawn(run_unless(
         destroyed,
-        [this, event = std::shared_ptr<MirEvent>{move(event)}]()
+        [this, event = spawned_event]()
         {
+            {
+                std::lock_guard<std::mutex> lock{pending_event_mutex};
+                if (pending_event == event)
+                    pending_event.reset();
+            }
+
             switch (mir_event_get_type(event.get()))
             {
                 case mir_event_type_resize:
@@ -21,6 +21,8 @@
 
 #include "mir/frontend/event_sink.h"
 
+#include <mutex>
+
 struct wl_client;
 
 namespace mir
@@ -85,6 +87,10 @@ protected:
     std::shared_ptr<bool> const destroyed;
 
 private:
+    std::mutex pending_event_mutex;
+    /// The last event spawned to the Wayland thread, while it has yet to be handled
+    std::shared_ptr<MirEvent> pending_event;
+
     void handle_input_event(MirInputEvent const* event);
     void handle_keymap_event(MirKeymapEvent const* event);
     void handle_window_event(MirWindowEvent const* event);
@@ -21,6 +21,9 @@
 #include "wlshmbuffer.h"
 
 #include <mir/log.h>
+#include <mir/executor.h>
+#include <mir/geometry/rectangles.h>
+#include <mir/graphics/gl_extensions_base.h>
 
 #include <wayland-server-protocol.h>
 
@@ -120,6 +123,23 @@ GLenum const abgr = GL_INVALID_ENUM;
 
     return gl_format != GL_INVALID_ENUM && gl_type != GL_INVALID_ENUM;
 }
+
+#ifdef GL_UNPACK_ROW_LENGTH
+GLenum const unpack_row_length = GL_UNPACK_ROW_LENGTH;
+#else
+GLenum const unpack_row_length = GL_UNPACK_ROW_LENGTH_EXT;
+#endif
+
+bool unpack_row_length_supported()
+{
+#ifdef GL_UNPACK_ROW_LENGTH
+    return true;
+#else
+    mir::graphics::GLExtensionsBase const extensions{
+        reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS))};
+    return extensions.support("GL_EXT_unpack_subimage");
+#endif
+}
 }
 
 namespace mf = mir::frontend;
@@ -132,10 +152,17 @@ mf::WlShmBuffer::~WlShmBuffer()
     if (buffer) {
         wl_resource_queue_event(resource, WL_BUFFER_RELEASE);
     }
+
+    if (pool) {
+        // The pool can only be safely released from the Wayland thread
+        executor->spawn([pool = pool]() { wl_shm_pool_unref(pool); });
+    }
 }
 
 std::shared_ptr<mg::Buffer> mf::WlShmBuffer::mir_buffer_from_wl_buffer(
     wl_resource *buffer,
+    bool zero_copy,
+    std::shared_ptr<Executor> const& executor,
     std::function<void()> &&on_consumed)
 {
     std::shared_ptr <WlShmBuffer> mir_buffer;
@@ -152,11 +179,11 @@ std::shared_ptr<mg::Buffer> mf::WlShmBuffer::mir_buffer_from_wl_buffer(
              *
              * Recreate a new WlShmBuffer to track the new compositor lifetime.
              */
-            mir_buffer = std::shared_ptr < WlShmBuffer > {new WlShmBuffer{buffer, std::move(on_consumed)}};
+            mir_buffer = std::shared_ptr < WlShmBuffer > {new WlShmBuffer{buffer, zero_copy, executor, std::move(on_consumed)}};
             shim->associated_buffer = mir_buffer;
         }
     } else {
-        mir_buffer = std::shared_ptr < WlShmBuffer > {new WlShmBuffer{buffer, std::move(on_consumed)}};
+        mir_buffer = std::shared_ptr < WlShmBuffer > {new WlShmBuffer{buffer, zero_copy, executor, std::move(on_consumed)}};
         shim = new DestructionShim;
         shim->destruction_listener.notify = &on_buffer_destroyed;
         shim->associated_buffer = mir_buffer;
@@ -216,6 +243,60 @@ void mf::WlShmBuffer::gl_bind_to_texture()
     }
 }
 
+std::size_t mf::WlShmBuffer::bind_damaged(Rectangles const& damage)
+{
+    GLenum format, type;
+
+    if (!get_gl_pixel_format(format_, format, type))
+        return 0;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(format_);
+    bool const row_length =
+        stride_.as_int() % bytes_per_pixel == 0 && unpack_row_length_supported();
+    if (row_length)
+        glPixelStorei(unpack_row_length, stride_.as_int() / bytes_per_pixel);
+
+    std::size_t uploaded{0};
+    read(
+        [&](unsigned char const* pixels)
+        {
+            for (auto const& rect : damage)
+            {
+                auto const area = rect.intersection_with({{}, size_});
+                if (area.size.width == Width{} || area.size.height == Height{})
+                    continue;
+
+                auto const x = area.top_left.x.as_int();
+                auto const y = area.top_left.y.as_int();
+                auto const rows = pixels + y * stride_.as_int();
+
+                if (row_length)
+                {
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y,
+                                    area.size.width.as_int(), area.size.height.as_int(),
+                                    format, type, rows + x * bytes_per_pixel);
+                    uploaded += area.size.width.as_int() * area.size.height.as_int() * bytes_per_pixel;
+                }
+                else
+                {
+                    // Without GL_EXT_unpack_subimage a sub-image must be tightly packed,
+                    // so upload whole rows as glTexImage2D() above does.
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y,
+                                    size_.width.as_int(), area.size.height.as_int(),
+                                    format, type, rows);
+                    uploaded += size_.width.as_int() * area.size.height.as_int() * bytes_per_pixel;
+                }
+            }
+        });
+
+    if (row_length)
+        glPixelStorei(unpack_row_length, 0);
+
+    return uploaded;
+}
+
 void mf::WlShmBuffer::bind()
 {
     gl_bind_to_texture();
@@ -247,7 +328,14 @@ void mf::WlShmBuffer::read(std::function<void(unsigned char const *)> const &do_
         consumed = true;
     }
 
-    do_with_pixels(static_cast<unsigned char const *>(data.get()));
+    if (pool) {
+        // Guard against the client truncating the pool from under us
+        wl_shm_buffer_begin_access(buffer);
+        do_with_pixels(data);
+        wl_shm_buffer_end_access(buffer);
+    } else {
+        do_with_pixels(data);
+    }
 }
 
 Stride mf::WlShmBuffer::stride() const
@@ -257,6 +345,8 @@ Stride mf::WlShmBuffer::stride() const
 
 mf::WlShmBuffer::WlShmBuffer(
     wl_resource *buffer,
+    bool zero_copy,
+    std::shared_ptr<Executor> const& executor,
     std::function<void()> &&on_consumed)
     :
     buffer{shm_buffer_from_resource_checked(buffer)},
@@ -264,7 +354,9 @@ mf::WlShmBuffer::WlShmBuffer(
     size_{wl_shm_buffer_get_width(this->buffer), wl_shm_buffer_get_height(this->buffer)},
     stride_{wl_shm_buffer_get_stride(this->buffer)},
     format_{wl_format_to_mir_format(wl_shm_buffer_get_format(this->buffer))},
-    data{std::make_unique<uint8_t[]>(size_.height.as_int() * stride_.as_int())},
+    executor{executor},
+    pool{nullptr},
+    data{nullptr},
     consumed{false},
     on_consumed{std::move(on_consumed)}
 {
@@ -280,9 +372,17 @@ mf::WlShmBuffer::WlShmBuffer(
                                   std::runtime_error{"Buffer has invalid stride"}));
     }
 
-    wl_shm_buffer_begin_access(this->buffer);
-    std::memcpy(data.get(), wl_shm_buffer_get_data(this->buffer), size_.height.as_int() * stride_.as_int());
-    wl_shm_buffer_end_access(this->buffer);
+    if (zero_copy) {
+        // Holding a reference defers any wl_shm_pool.resize, so data stays mapped until we're released
+        pool = wl_shm_buffer_ref_pool(this->buffer);
+        data = static_cast<unsigned char const*>(wl_shm_buffer_get_data(this->buffer));
+    } else {
+        copy = std::make_unique<uint8_t[]>(size_.height.as_int() * stride_.as_int());
+        wl_shm_buffer_begin_access(this->buffer);
+        std::memcpy(copy.get(), wl_shm_buffer_get_data(this->buffer), size_.height.as_int() * stride_.as_int());
+        wl_shm_buffer_end_access(this->buffer);
+        data = copy.get();
+    }
 }
 
 void mf::WlShmBuffer::on_buffer_destroyed(wl_listener *listener, void *)
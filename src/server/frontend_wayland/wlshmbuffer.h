@@ -32,6 +32,8 @@
 
 namespace mir
 {
+class Executor;
+
 namespace frontend
 {
 
@@ -39,13 +41,22 @@ class WlShmBuffer :
     public graphics::BufferBasic,
     public graphics::NativeBufferBase,
     public renderer::gl::TextureSource,
+    public renderer::gl::DamagedTextureSource,
     public renderer::software::PixelSource
 {
 public:
     ~WlShmBuffer();
 
+    /**
+     * \param [in] zero_copy   Read straight from the client's shm pool (keeping it
+     *                          referenced until the buffer is released) rather than
+     *                          taking a copy at commit.
+     * \param [in] executor    Runs work on the Wayland event loop
+     */
     static std::shared_ptr <graphics::Buffer> mir_buffer_from_wl_buffer(
         wl_resource *buffer,
+        bool zero_copy,
+        std::shared_ptr<Executor> const& executor,
         std::function<void()> &&on_consumed);
 
     std::shared_ptr <graphics::NativeBuffer> native_buffer_handle() const override;
@@ -62,6 +73,8 @@ public:
 
     void secure_for_render() override;
 
+    std::size_t bind_damaged(geometry::Rectangles const& damage) override;
+
     void write(unsigned char const *pixels, size_t size) override;
 
     void read(std::function<void(unsigned char const *)> const &do_with_pixels) override;
@@ -71,6 +84,8 @@ public:
 private:
     WlShmBuffer(
         wl_resource *buffer,
+        bool zero_copy,
+        std::shared_ptr<Executor> const& executor,
         std::function<void()> &&on_consumed);
 
     static void on_buffer_destroyed(wl_listener *listener, void *);
@@ -91,7 +106,10 @@ private:
     geometry::Stride const stride_;
     MirPixelFormat const format_;
 
-    std::unique_ptr<uint8_t[]> const data;
+    std::shared_ptr<Executor> const executor;
+    wl_shm_pool* pool;                  // Only set in zero-copy mode
+    std::unique_ptr<uint8_t[]> copy;    // Only set otherwise
+    unsigned char const* data;
 
     bool consumed;
     std::function<void()> on_consumed;
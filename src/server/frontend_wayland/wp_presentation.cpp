@@ -0,0 +1,59 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "wp_presentation.h"
+#include "wl_surface.h"
+
+#include "mir/compositor/presentation_clock.h"
+
+namespace mf = mir::frontend;
+namespace mc = mir::compositor;
+
+mf::WpPresentation::WpPresentation(
+    struct wl_display* display,
+    std::shared_ptr<mc::PresentationClock> const& clock) :
+    wayland::Presentation(display, 1),
+    clock{clock}
+{
+}
+
+void mf::WpPresentation::bind(struct wl_client* /*client*/, struct wl_resource* resource)
+{
+    wp_presentation_send_clock_id(resource, clock->clock_id());
+}
+
+void mf::WpPresentation::destroy(struct wl_client* /*client*/, struct wl_resource* resource)
+{
+    wl_resource_destroy(resource);
+}
+
+void mf::WpPresentation::feedback(
+    struct wl_client* client,
+    struct wl_resource* resource,
+    struct wl_resource* surface,
+    uint32_t callback)
+{
+    auto const feedback = wl_resource_create(
+        client, &wp_presentation_feedback_interface, wl_resource_get_version(resource), callback);
+
+    if (feedback == nullptr)
+    {
+        wl_client_post_no_memory(client);
+        return;
+    }
+
+    WlSurface::from(surface)->presentation_feedback(feedback);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_WP_PRESENTATION_H
+#define MIR_FRONTEND_WP_PRESENTATION_H
+
+#include "generated/presentation-time_wrapper.h"
+
+#include <memory>
+
+namespace mir
+{
+namespace compositor
+{
+class PresentationClock;
+}
+
+namespace frontend
+{
+
+class WpPresentation : public wayland::Presentation
+{
+public:
+    WpPresentation(struct wl_display* display, std::shared_ptr<compositor::PresentationClock> const& clock);
+
+private:
+    std::shared_ptr<compositor::PresentationClock> const clock;
+
+    void bind(struct wl_client* client, struct wl_resource* resource) override;
+    void destroy(struct wl_client* client, struct wl_resource* resource) override;
+    void feedback(struct wl_client* client, struct wl_resource* resource, struct wl_resource* surface,
+                  uint32_t callback) override;
+};
+
+}
+}
+
+#endif // MIR_FRONTEND_WP_PRESENTATION_H
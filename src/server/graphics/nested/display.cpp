@@ -171,6 +171,12 @@ mgn::detail::DisplaySyncGroup::recommended_sleep() const
     return std::chrono::milliseconds::zero();
 }
 
+std::experimental::optional<mg::Frame>
+mgn::detail::DisplaySyncGroup::next_vblank() const
+{
+    return {};
+}
+
 geom::Rectangle mgn::detail::DisplaySyncGroup::view_area() const
 {
     return output->view_area();
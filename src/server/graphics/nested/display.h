@@ -101,6 +101,7 @@ public:
     void for_each_display_buffer(std::function<void(graphics::DisplayBuffer&)> const&) override;
     void post() override;
     std::chrono::milliseconds recommended_sleep() const override;
+    std::experimental::optional<Frame> next_vblank() const override;
 
     geometry::Rectangle view_area() const;
 private:
@@ -94,6 +94,12 @@ mgo::detail::DisplaySyncGroup::recommended_sleep() const
     return std::chrono::milliseconds::zero();
 }
 
+std::experimental::optional<mg::Frame>
+mgo::detail::DisplaySyncGroup::next_vblank() const
+{
+    return {};
+}
+
 mgo::Display::Display(
     EGLNativeDisplayType egl_native_display,
     std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
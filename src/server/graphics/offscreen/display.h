@@ -66,6 +66,7 @@ public:
     void for_each_display_buffer(std::function<void(DisplayBuffer&)> const&) override;
     void post() override;
     std::chrono::milliseconds recommended_sleep() const override;
+    std::experimental::optional<Frame> next_vblank() const override;
 private:
     std::unique_ptr<DisplayBuffer> const output;
 };
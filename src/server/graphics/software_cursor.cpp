@@ -70,6 +70,16 @@ public:
         return 1;
     }
 
+    std::experimental::optional<geom::Rectangles> buffer_damage() const override
+    {
+        return {};
+    }
+
+    geom::Region opaque_region() const override
+    {
+        return {};
+    }
+
     mg::Renderable::ID id() const override
     {
         return this;
@@ -250,7 +250,10 @@ mir::DefaultServerConfiguration::the_input_reading_multiplexer()
     return input_reading_multiplexer(
         []() -> std::shared_ptr<mir::dispatch::MultiplexingDispatchable>
         {
-            return std::make_shared<mir::dispatch::MultiplexingDispatchable>();
+            // A single input thread dispatches this, so it may as well take every
+            // ready device in one go (and in one EventBatch)
+            int const max_events_per_dispatch{16};
+            return std::make_shared<mir::dispatch::MultiplexingDispatchable>(max_events_per_dispatch);
         }
     );
 }
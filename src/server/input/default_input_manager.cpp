@@ -22,6 +22,7 @@
 #include "mir/dispatch/action_queue.h"
 #include "mir/dispatch/multiplexing_dispatchable.h"
 #include "mir/dispatch/threaded_dispatcher.h"
+#include "mir/frontend/event_batch.h"
 
 #include "mir/main_loop.h"
 #include "mir/thread_name.h"
@@ -31,6 +32,39 @@
 #include <future>
 
 namespace mi = mir::input;
+namespace md = mir::dispatch;
+
+namespace
+{
+/// Delivers the client events raised by each dispatch of the input sources as one batch
+class BatchingDispatchable : public md::Dispatchable
+{
+public:
+    BatchingDispatchable(std::shared_ptr<md::Dispatchable> const& dispatchee) :
+        dispatchee{dispatchee}
+    {
+    }
+
+    mir::Fd watch_fd() const override
+    {
+        return dispatchee->watch_fd();
+    }
+
+    bool dispatch(md::FdEvents events) override
+    {
+        mir::frontend::EventBatch batch;
+        return dispatchee->dispatch(events);
+    }
+
+    md::FdEvents relevant_events() const override
+    {
+        return dispatchee->relevant_events();
+    }
+
+private:
+    std::shared_ptr<md::Dispatchable> const dispatchee;
+};
+}
 
 mi::DefaultInputManager::DefaultInputManager(
     std::shared_ptr<dispatch::MultiplexingDispatchable> const& multiplexer,
@@ -88,7 +122,7 @@ void mi::DefaultInputManager::start()
 
     input_thread = std::make_unique<dispatch::ThreadedDispatcher>(
         "Mir/Input Reader",
-        multiplexer,
+        std::make_shared<BatchingDispatchable>(multiplexer),
         [this]()
         {
             stop_platforms();
@@ -0,0 +1,173 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "input_region_index.h"
+
+#include "mir/input/scene.h"
+#include "mir/input/surface.h"
+
+#include <algorithm>
+
+namespace mi = mir::input;
+namespace geom = mir::geometry;
+
+namespace
+{
+int floor_div(int value, int divisor)
+{
+    return value / divisor - (value % divisor < 0 ? 1 : 0);
+}
+
+uint64_t cell_key(int column, int row)
+{
+    return (uint64_t{static_cast<uint32_t>(column)} << 32) | static_cast<uint32_t>(row);
+}
+}
+
+mi::InputRegionIndex::InputRegionIndex(std::shared_ptr<Scene> const& scene, int cell_size)
+    : scene{scene},
+      cell_size{cell_size}
+{
+}
+
+void mi::InputRegionIndex::invalidate()
+{
+    stale = true;
+}
+
+void mi::InputRegionIndex::update(Surface const* surface)
+{
+    if (stale)
+        return;
+
+    auto const entry = entries.find(surface);
+    if (entry == entries.end())
+    {
+        // Not seen since the last rebuild, so we don't know where it stacks
+        stale = true;
+        return;
+    }
+
+    auto const bounds = surface->input_extents();
+    if (bounds == entry->second.bounds)
+        return;
+
+    erase(surface, entry->second.bounds);
+    entry->second.bounds = bounds;
+    insert(surface, bounds);
+}
+
+void mi::InputRegionIndex::remove(Surface const* surface)
+{
+    auto const entry = entries.find(surface);
+    if (entry == entries.end())
+        return;
+
+    erase(surface, entry->second.bounds);
+    entries.erase(entry);
+}
+
+std::shared_ptr<mi::Surface> mi::InputRegionIndex::surface_at(geom::Point const& point)
+{
+    if (stale)
+        rebuild();
+
+    auto const cell = cells.find(cell_containing(point));
+    if (cell == cells.end())
+        return nullptr;
+
+    std::vector<Entry const*> candidates;
+    for (auto const surface : cell->second)
+    {
+        auto const& entry = entries.at(surface);
+        if (entry.bounds.contains(point))
+            candidates.push_back(&entry);
+    }
+
+    std::sort(begin(candidates), end(candidates),
+        [](Entry const* lhs, Entry const* rhs) { return lhs->stacking_rank > rhs->stacking_rank; });
+
+    // Bounds are only a coarse filter: the surface has the final say
+    for (auto const entry : candidates)
+    {
+        if (auto const surface = entry->surface.lock())
+        {
+            if (surface->input_area_contains(point))
+                return surface;
+        }
+    }
+
+    return nullptr;
+}
+
+void mi::InputRegionIndex::rebuild()
+{
+    entries.clear();
+    cells.clear();
+
+    size_t stacking_rank = 0;
+    scene->for_each([&](std::shared_ptr<Surface> const& surface)
+        {
+            auto const bounds = surface->input_extents();
+            entries[surface.get()] = Entry{surface, bounds, stacking_rank++};
+            insert(surface.get(), bounds);
+        });
+
+    stale = false;
+}
+
+void mi::InputRegionIndex::insert(Surface const* surface, geom::Rectangle const& bounds)
+{
+    for_each_cell(bounds, [&](uint64_t key) { cells[key].push_back(surface); });
+}
+
+void mi::InputRegionIndex::erase(Surface const* surface, geom::Rectangle const& bounds)
+{
+    for_each_cell(bounds, [&](uint64_t key)
+        {
+            auto const cell = cells.find(key);
+            if (cell == cells.end())
+                return;
+
+            auto& surfaces = cell->second;
+            surfaces.erase(std::remove(begin(surfaces), end(surfaces), surface), end(surfaces));
+            if (surfaces.empty())
+                cells.erase(cell);
+        });
+}
+
+template<typename Action>
+void mi::InputRegionIndex::for_each_cell(geom::Rectangle const& bounds, Action const& action)
+{
+    if (bounds.size.width <= geom::Width{0} || bounds.size.height <= geom::Height{0})
+        return;
+
+    auto const bottom_right = bounds.bottom_right();
+    int const first_column = floor_div(bounds.top_left.x.as_int(), cell_size);
+    int const last_column = floor_div(bottom_right.x.as_int() - 1, cell_size);
+    int const first_row = floor_div(bounds.top_left.y.as_int(), cell_size);
+    int const last_row = floor_div(bottom_right.y.as_int() - 1, cell_size);
+
+    for (int column = first_column; column <= last_column; ++column)
+        for (int row = first_row; row <= last_row; ++row)
+            action(cell_key(column, row));
+}
+
+uint64_t mi::InputRegionIndex::cell_containing(geom::Point const& point) const
+{
+    return cell_key(floor_div(point.x.as_int(), cell_size), floor_div(point.y.as_int(), cell_size));
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_INPUT_INPUT_REGION_INDEX_H_
+#define MIR_INPUT_INPUT_REGION_INDEX_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace input
+{
+class Surface;
+class Scene;
+
+/**
+ * Finds the topmost surface whose input area contains a point without
+ * visiting every surface in the scene.
+ *
+ * Surfaces are bucketed into a fixed grid by their input extents, so a lookup
+ * only considers the surfaces overlapping the cell under the point. Moves,
+ * resizes and input region changes update just the affected surface; additions
+ * and reorders change the stacking order, so they invalidate the index and the
+ * next lookup rebuilds it from the scene.
+ *
+ * Not thread safe: the caller is expected to serialize access.
+ */
+class InputRegionIndex
+{
+public:
+    explicit InputRegionIndex(std::shared_ptr<Scene> const& scene, int cell_size = 256);
+
+    /// The stacking order has changed (or is unknown); rebuild on the next lookup
+    void invalidate();
+
+    /// Re-bucket a surface whose input extents may have changed
+    void update(Surface const* surface);
+
+    /// Forget a surface that has left the scene
+    void remove(Surface const* surface);
+
+    /// The topmost surface whose input area contains point (or null)
+    std::shared_ptr<Surface> surface_at(geometry::Point const& point);
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<Surface> surface;
+        geometry::Rectangle bounds;
+        size_t stacking_rank;
+    };
+
+    void rebuild();
+    void insert(Surface const* surface, geometry::Rectangle const& bounds);
+    void erase(Surface const* surface, geometry::Rectangle const& bounds);
+
+    template<typename Action>
+    void for_each_cell(geometry::Rectangle const& bounds, Action const& action);
+    uint64_t cell_containing(geometry::Point const& point) const;
+
+    std::shared_ptr<Scene> const scene;
+    int const cell_size;
+
+    bool stale{true};
+    std::unordered_map<Surface const*, Entry> entries;
+    std::unordered_map<uint64_t, std::vector<Surface const*>> cells;
+};
+}
+}
+
+#endif /* MIR_INPUT_INPUT_REGION_INDEX_H_ */
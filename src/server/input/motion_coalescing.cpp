@@ -0,0 +1,171 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/input/motion_coalescing.h"
+#include "mir/events/pointer_event.h"
+#include "mir/events/touch_event.h"
+#include "mir_blob.h"
+
+#include <boost/throw_exception.hpp>
+#include <memory>
+#include <stdexcept>
+
+namespace mi = mir::input;
+
+namespace
+{
+bool same_source(MirInputEvent const& pending, MirInputEvent const& next)
+{
+    return pending.input_type() == next.input_type() &&
+           pending.window_id() == next.window_id() &&
+           pending.device_id() == next.device_id() &&
+           pending.modifiers() == next.modifiers();
+}
+
+void take_latest_stamp(MirInputEvent& pending, MirInputEvent const& next)
+{
+    pending.set_event_time(next.event_time());
+    pending.set_cookie(next.cookie());
+}
+
+bool has_dnd_handle(MirPointerEvent const& event)
+{
+    std::unique_ptr<MirBlob> const handle{event.dnd_handle()};
+    return handle != nullptr;
+}
+
+bool is_motion(MirPointerEvent const& event)
+{
+    return event.action() == mir_pointer_action_motion && !has_dnd_handle(event);
+}
+
+bool is_motion(MirTouchEvent const& event)
+{
+    for (size_t i = 0; i != event.pointer_count(); ++i)
+    {
+        if (event.action(i) != mir_touch_action_change)
+            return false;
+    }
+    return true;
+}
+
+bool has_deltas(MirPointerEvent const& event)
+{
+    return event.dx() != 0 || event.dy() != 0 || event.vscroll() != 0 || event.hscroll() != 0;
+}
+
+bool coalesce(MirPointerEvent& pending, MirPointerEvent const& next)
+{
+    if (!is_motion(pending) || !is_motion(next) ||
+        pending.buttons() != next.buttons())
+        return false;
+
+    pending.set_x(next.x());
+    pending.set_y(next.y());
+    pending.set_dx(pending.dx() + next.dx());
+    pending.set_dy(pending.dy() + next.dy());
+    pending.set_vscroll(pending.vscroll() + next.vscroll());
+    pending.set_hscroll(pending.hscroll() + next.hscroll());
+    take_latest_stamp(pending, next);
+    return true;
+}
+
+bool coalesce(MirTouchEvent& pending, MirTouchEvent const& next)
+{
+    auto const count = pending.pointer_count();
+
+    if (next.pointer_count() != count || !is_motion(pending) || !is_motion(next))
+        return false;
+
+    for (size_t i = 0; i != count; ++i)
+    {
+        if (pending.id(i) != next.id(i) ||
+            pending.tool_type(i) != next.tool_type(i))
+            return false;
+    }
+
+    for (size_t i = 0; i != count; ++i)
+    {
+        pending.set_x(i, next.x(i));
+        pending.set_y(i, next.y(i));
+        pending.set_touch_major(i, next.touch_major(i));
+        pending.set_touch_minor(i, next.touch_minor(i));
+        pending.set_pressure(i, next.pressure(i));
+        pending.set_orientation(i, next.orientation(i));
+    }
+    take_latest_stamp(pending, next);
+    return true;
+}
+}
+
+mi::MotionCoalescing mi::motion_coalescing_from(std::string const& name)
+{
+    if (name == "off")
+        return MotionCoalescing::none;
+    else if (name == "pointer")
+        return MotionCoalescing::pointer;
+    else if (name == "all")
+        return MotionCoalescing::pointer_and_touch;
+
+    BOOST_THROW_EXCEPTION(std::invalid_argument{"Unknown input motion coalescing: " + name});
+}
+
+bool mi::coalesce_motion(MirEvent& pending, MirEvent const& next, MotionCoalescing policy)
+{
+    if (policy == MotionCoalescing::none ||
+        pending.type() != mir_event_type_input ||
+        next.type() != mir_event_type_input)
+        return false;
+
+    auto& pending_input = *pending.to_input();
+    auto const& next_input = *next.to_input();
+
+    if (!same_source(pending_input, next_input))
+        return false;
+
+    switch (next_input.input_type())
+    {
+    case mir_input_event_type_pointer:
+        return coalesce(*pending_input.to_pointer(), *next_input.to_pointer());
+
+    case mir_input_event_type_touch:
+        return policy == MotionCoalescing::pointer_and_touch &&
+               coalesce(*pending_input.to_touch(), *next_input.to_touch());
+
+    default:
+        return false;
+    }
+}
+
+bool mi::is_coalescible_motion(MirEvent const& event, MotionCoalescing policy)
+{
+    if (policy == MotionCoalescing::none || event.type() != mir_event_type_input)
+        return false;
+
+    auto const& input = *event.to_input();
+
+    switch (input.input_type())
+    {
+    case mir_input_event_type_pointer:
+        return is_motion(*input.to_pointer()) && !has_deltas(*input.to_pointer());
+
+    case mir_input_event_type_touch:
+        return policy == MotionCoalescing::pointer_and_touch && is_motion(*input.to_touch());
+
+    default:
+        return false;
+    }
+}
@@ -45,17 +45,22 @@ struct InputDispatcherSceneObserver :
     public std::enable_shared_from_this<InputDispatcherSceneObserver>
 {
     InputDispatcherSceneObserver(
+        std::function<void()> const& on_stacking_changed,
         std::function<void(ms::Surface*)> const& on_removed,
         std::function<void(ms::Surface const*)> const& on_surface_moved,
-        std::function<void()> const& on_surface_resized)
-        : on_removed(on_removed),
+        std::function<void(ms::Surface const*)> const& on_surface_resized,
+        std::function<void(ms::Surface const*)> const& on_input_region_changed)
+        : on_stacking_changed{on_stacking_changed},
+          on_removed(on_removed),
           on_surface_moved{on_surface_moved},
-          on_surface_resized{on_surface_resized}
+          on_surface_resized{on_surface_resized},
+          on_input_region_changed{on_input_region_changed}
     {
     }
     void surface_added(ms::Surface* surface) override
     {
         surface->add_observer(shared_from_this());
+        on_stacking_changed();
     }
     void surface_removed(ms::Surface* surface) override
     {
@@ -63,6 +68,7 @@ struct InputDispatcherSceneObserver :
     }
     void surfaces_reordered() override
     {
+        on_stacking_changed();
     }
     void scene_changed() override
     {
@@ -70,6 +76,7 @@ struct InputDispatcherSceneObserver :
 
     void surface_exists(ms::Surface* surface) override
     {
+        // The input region index starts out stale, so it will pick this up
         surface->add_observer(shared_from_this());
     }
     void end_observation() override
@@ -81,9 +88,9 @@ struct InputDispatcherSceneObserver :
         // TODO: Do we need to listen to visibility events?
     }
 
-    void resized_to(ms::Surface const*, mir::geometry::Size const& /*size*/) override
+    void resized_to(ms::Surface const* surf, mir::geometry::Size const& /*size*/) override
     {
-        on_surface_resized();
+        on_surface_resized(surf);
     }
 
     void moved_to(ms::Surface const* surf, mir::geometry::Point const& /*top_left*/) override
@@ -158,9 +165,16 @@ struct InputDispatcherSceneObserver :
     {
     }
 
+    void input_region_set_to(ms::Surface const* surf, std::vector<mir::geometry::Rectangle> const&) override
+    {
+        on_input_region_changed(surf);
+    }
+
+    std::function<void()> const on_stacking_changed;
     std::function<void(ms::Surface*)> const on_removed;
     std::function<void(ms::Surface const*)> const on_surface_moved;
-    std::function<void()> const on_surface_resized;
+    std::function<void(ms::Surface const*)> const on_surface_resized;
+    std::function<void(ms::Surface const*)> const on_input_region_changed;
 };
 
 void deliver_without_relative_motion(
@@ -218,9 +232,11 @@ void deliver(
 
 mi::SurfaceInputDispatcher::SurfaceInputDispatcher(std::shared_ptr<mi::Scene> const& scene)
     : scene(scene),
+      input_regions(scene),
       started(false)
 {
     scene_observer = std::make_shared<InputDispatcherSceneObserver>(
+        [this]{stacking_changed();},
         [this](ms::Surface* s){surface_removed(s);},
         std::bind(
             std::mem_fn(&SurfaceInputDispatcher::surface_moved),
@@ -228,7 +244,9 @@ mi::SurfaceInputDispatcher::SurfaceInputDispatcher(std::shared_ptr<mi::Scene> co
             std::placeholders::_1),
         std::bind(
             std::mem_fn(&SurfaceInputDispatcher::surface_resized),
-            this));
+            this,
+            std::placeholders::_1),
+        [this](ms::Surface const* s){input_region_changed(s);});
     scene->add_observer(scene_observer);
 }
 
@@ -256,10 +274,24 @@ bool compare_surfaces(std::shared_ptr<mi::Surface> const& input_surface, ms::Sur
 }
 }
 
+void mi::SurfaceInputDispatcher::stacking_changed()
+{
+    std::lock_guard<std::mutex> lg(dispatcher_mutex);
+    input_regions.invalidate();
+}
+
+void mi::SurfaceInputDispatcher::input_region_changed(ms::Surface const* surface)
+{
+    std::lock_guard<std::mutex> lg(dispatcher_mutex);
+    input_regions.update(surface);
+}
+
 void mi::SurfaceInputDispatcher::surface_removed(ms::Surface *surface)
 {
     std::lock_guard<std::mutex> lg(dispatcher_mutex);
 
+    input_regions.remove(surface);
+
     auto strong_focus = focus_surface.lock();
     if (strong_focus && compare_surfaces(strong_focus, surface))
     {
@@ -410,6 +442,8 @@ void mi::SurfaceInputDispatcher::surface_moved(ms::Surface const* moved_surface)
 {
     std::lock_guard<std::mutex> lock{dispatcher_mutex};
 
+    input_regions.update(moved_surface);
+
     if (!last_pointer_event)
         return;
 
@@ -437,10 +471,12 @@ void mi::SurfaceInputDispatcher::surface_moved(ms::Surface const* moved_surface)
     }
 }
 
-void mi::SurfaceInputDispatcher::surface_resized()
+void mi::SurfaceInputDispatcher::surface_resized(ms::Surface const* resized_surface)
 {
     std::lock_guard<std::mutex> lock{dispatcher_mutex};
 
+    input_regions.update(resized_surface);
+
     if (!last_pointer_event)
         return;
 
@@ -516,12 +552,7 @@ bool is_gesture_terminator(MirPointerEvent const* pev)
 
 std::shared_ptr<mi::Surface> mi::SurfaceInputDispatcher::find_target_surface(geom::Point const& point)
 {
-    std::shared_ptr<mi::Surface> top_target = nullptr;
-    scene->for_each([&top_target, &point](std::shared_ptr<mi::Surface> const& target) {
-            if (target->input_area_contains(point))
-                top_target = target;
-    });
-    return top_target;
+    return input_regions.surface_at(point);
 }
 
 void mi::SurfaceInputDispatcher::send_enter_exit_event(std::shared_ptr<mi::Surface> const& surface,
@@ -21,6 +21,7 @@
 
 #include "mir/input/input_dispatcher.h"
 #include "mir/shell/input_targeter.h"
+#include "input_region_index.h"
 #include "mir/geometry/point.h"
 
 #include <memory>
@@ -71,10 +72,12 @@ private:
 
     void set_focus_locked(std::lock_guard<std::mutex> const&, std::shared_ptr<input::Surface> const&);
 
+    void stacking_changed();
+    void input_region_changed(scene::Surface const* surface);
     void surface_removed(scene::Surface* surface);
 
     void surface_moved(scene::Surface const* moved_surface);
-    void surface_resized();
+    void surface_resized(scene::Surface const* resized_surface);
 
     // Look in to homognizing index on KeyInputState and PointerInputState (wrt to device id)
     struct PointerInputState
@@ -93,6 +96,7 @@ private:
     TouchInputState& ensure_touch_state(MirInputDeviceId id);
     
     std::shared_ptr<input::Scene> const scene;
+    InputRegionIndex input_regions;
 
     std::shared_ptr<scene::Observer> scene_observer;
 
@@ -23,6 +23,7 @@
 #include "lttng_report_factory.h"
 #include "logging_report_factory.h"
 #include "null_report_factory.h"
+#include "metrics/compositor_report.h"
 
 #include "mir/abnormal_exit.h"
 
@@ -66,6 +67,17 @@ auto mir::DefaultServerConfiguration::the_compositor_report() -> std::shared_ptr
     return compositor_report(
         [this]()->std::shared_ptr<mc::CompositorReport>
         {
+            auto const options = the_options();
+
+            // Only the compositor has a metrics report, so it isn't a ReportFactory
+            if (options->get<std::string>(options::compositor_report_opt) == options::metrics_opt_value)
+            {
+                return std::make_shared<report::metrics::CompositorReport>(
+                    the_clock(),
+                    options->is_set(options::compositor_metrics_file_opt) ?
+                        options->get<std::string>(options::compositor_metrics_file_opt) : std::string{});
+            }
+
             return report_factory(options::compositor_report_opt)->create_compositor_report();
         });
 }
@@ -74,6 +74,12 @@ void mrl::CompositorReport::rendered_frame(SubCompositorId id)
     inst.bypassed = false;
 }
 
+void mrl::CompositorReport::uploaded_textures(SubCompositorId id, std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    instance[id].uploaded_sum += bytes;
+}
+
 void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id)
 {
     // The first report is a valid sample, but don't log anything because
@@ -95,6 +101,8 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
             ).count();
 
         long bypass_percent = dn ? (nbypassed - last_reported_bypassed) * 100L / dn : 0;
+        long long avg_uploaded_kib = dn ? (uploaded_sum - last_reported_uploaded_sum) / dn / 1024 : 0;
+        long skipped = nskipped - last_reported_skipped;
 
         // Keep everything premultiplied by 1000 to guarantee accuracy
         // and avoid floating point.
@@ -103,12 +111,14 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
         long avg_latency_usec = dn ? dl / dn : 0;
         long dt_msec = dt / 1000L;
 
-        char msg[128];
+        char msg[224];
         snprintf(msg, sizeof msg, "Display %p averaged %ld.%03ld FPS, "
                  "%ld.%03ld ms/frame, "
                  "latency %ld.%03ld ms, "
                  "%ld frames over %ld.%03ld sec, "
-                 "%ld%% bypassed",
+                 "%ld%% bypassed, "
+                 "%lld KiB/frame uploaded, "
+                 "%ld wakeups skipped",
                  id,
                  frames_per_1000sec / 1000,
                  frames_per_1000sec % 1000,
@@ -119,7 +129,9 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
                  dn,
                  dt_msec / 1000,
                  dt_msec % 1000,
-                 bypass_percent
+                 bypass_percent,
+                 avg_uploaded_kib,
+                 skipped
                  );
 
         logger.log(ml::Severity::informational, msg, component);
@@ -130,6 +142,8 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
     last_reported_latency_sum = latency_sum;
     last_reported_nframes = nframes;
     last_reported_bypassed = nbypassed;
+    last_reported_uploaded_sum = uploaded_sum;
+    last_reported_skipped = nskipped;
 }
 
 void mrl::CompositorReport::finished_frame(SubCompositorId id)
@@ -184,3 +198,9 @@ void mrl::CompositorReport::scheduled()
     std::lock_guard<std::mutex> lock(mutex);
     last_scheduled = now();
 }
+
+void mrl::CompositorReport::skipped_wakeup(SubCompositorId id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ++instance[id].nskipped;
+}
@@ -46,10 +46,12 @@ public:
     void began_frame(SubCompositorId id) override;
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
+    void uploaded_textures(SubCompositorId id, std::size_t bytes) override;
     void finished_frame(SubCompositorId id) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
+    void skipped_wakeup(SubCompositorId id) override;
 
 private:
     std::shared_ptr<mir::logging::Logger> const logger;
@@ -67,6 +69,8 @@ private:
         TimePoint latency_sum;
         long nframes = 0;
         long nbypassed = 0;
+        long long uploaded_sum = 0;
+        long nskipped = 0;
         bool bypassed = true;
         bool prev_bypassed = false;
 
@@ -75,6 +79,8 @@ private:
         TimePoint last_reported_latency_sum;
         long last_reported_nframes = 0;
         long last_reported_bypassed = 0;
+        long long last_reported_uploaded_sum = 0;
+        long last_reported_skipped = 0;
 
         void log(mir::logging::Logger& logger, SubCompositorId id);
     };
@@ -192,3 +192,9 @@ void mrl::DisplayReport::report_vsync(unsigned int output_id,
     }
     prev_frame[output_id] = frame;
 }
+
+void mrl::DisplayReport::report_cursor_moves_coalesced(unsigned int moves)
+{
+    logger->log(component(), ml::Severity::debug,
+        "%u cursor move%s coalesced", moves, moves == 1 ? "" : "s");
+}
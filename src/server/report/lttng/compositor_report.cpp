@@ -58,7 +58,17 @@ void mir::report::lttng::CompositorReport::rendered_frame(SubCompositorId id)
     mir_tracepoint(mir_server_compositor, rendered_frame, id);
 }
 
+void mir::report::lttng::CompositorReport::uploaded_textures(SubCompositorId id, std::size_t bytes)
+{
+    mir_tracepoint(mir_server_compositor, uploaded_textures, id, bytes);
+}
+
 void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
 }
+
+void mir::report::lttng::CompositorReport::skipped_wakeup(SubCompositorId id)
+{
+    mir_tracepoint(mir_server_compositor, skipped_wakeup, id);
+}
@@ -52,3 +52,8 @@ void mir::report::lttng::DisplayReport::report_vsync(unsigned int output_id,
 {
     mir_tracepoint(mir_server_display, report_vsync, output_id);
 }
+
+void mir::report::lttng::DisplayReport::report_cursor_moves_coalesced(unsigned int moves)
+{
+    mir_tracepoint(mir_server_display, report_cursor_moves_coalesced, moves);
+}
@@ -46,6 +46,7 @@ public:
     virtual void report_vt_switch_away_failure() override;
     virtual void report_vt_switch_back_failure() override;
     virtual void report_vsync(unsigned int output_id, graphics::Frame const&) override;
+    virtual void report_cursor_moves_coalesced(unsigned int moves) override;
 
 private:
     ServerTracepointProvider tp_provider;
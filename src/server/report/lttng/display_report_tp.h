@@ -71,6 +71,15 @@ TRACEPOINT_EVENT(
      )
 )
 
+TRACEPOINT_EVENT(
+    mir_server_display,
+    report_cursor_moves_coalesced,
+    TP_ARGS(unsigned int, moves),
+    TP_FIELDS(
+        ctf_integer(unsigned int, moves, moves)
+     )
+)
+
 #endif /* MIR_LTTNG_DISPLAY_REPORT_TP_H_ */
 
 #include <lttng/tracepoint-event.h>
@@ -0,0 +1,328 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "compositor_report.h"
+
+#include "mir/thread_name.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace mrm = mir::report::metrics;
+
+namespace
+{
+auto const dump_interval = std::chrono::seconds(1);
+
+std::uint64_t microseconds_between(std::int64_t start_ns, std::int64_t end_ns)
+{
+    return end_ns > start_ns ? (end_ns - start_ns) / 1000 : 0;
+}
+
+void write_json(std::ostream& out, char const* name, mrm::Histogram::Snapshot const& histogram)
+{
+    out << "\"" << name << "\":{"
+        << "\"count\":" << histogram.count()
+        << ",\"mean\":" << histogram.mean()
+        << ",\"p50\":" << histogram.percentile(50)
+        << ",\"p90\":" << histogram.percentile(90)
+        << ",\"p99\":" << histogram.percentile(99)
+        << ",\"p99.9\":" << histogram.percentile(99.9)
+        << ",\"max\":" << histogram.max()
+        << "}";
+}
+}
+
+void mrm::CompositorReport::Output::reset()
+{
+    {
+        std::lock_guard<std::mutex> lock{geometry_mutex};
+        width = height = x = y = 0;
+    }
+    start_of_frame = 0;
+    end_of_frame = 0;
+    bypassed = true;
+    frames = 0;
+    bypassed_frames = 0;
+    skipped_wakeups = 0;
+    uploaded_bytes = 0;
+    frame_time.reset();
+    render_time.reset();
+    latency.reset();
+    renderables.reset();
+}
+
+mrm::CompositorReport::CompositorReport(
+    std::shared_ptr<time::Clock> const& clock,
+    std::string const& dump_file)
+    : clock{clock},
+      dump_file{dump_file},
+      outputs{new Output[max_outputs]}
+{
+}
+
+mrm::CompositorReport::~CompositorReport()
+{
+    stop_dumping();
+}
+
+std::int64_t mrm::CompositorReport::now() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock->now().time_since_epoch()).count();
+}
+
+auto mrm::CompositorReport::output_for(SubCompositorId id) -> Output*
+{
+    for (auto i = 0u; i != max_outputs; ++i)
+    {
+        auto& output = outputs[i];
+        auto state = output.state.load(std::memory_order_acquire);
+
+        if (state == Output::unused &&
+            output.state.compare_exchange_strong(state, Output::claiming, std::memory_order_acquire))
+        {
+            output.id.store(id, std::memory_order_relaxed);
+            output.state.store(Output::in_use, std::memory_order_release);
+            return &output;
+        }
+
+        // Only for as long as another thread takes to store its id
+        while (state == Output::claiming)
+        {
+            std::this_thread::yield();
+            state = output.state.load(std::memory_order_acquire);
+        }
+
+        if (state == Output::in_use && output.id.load(std::memory_order_relaxed) == id)
+            return &output;
+    }
+
+    return nullptr;
+}
+
+void mrm::CompositorReport::added_display(int width, int height, int x, int y, SubCompositorId id)
+{
+    if (auto const output = output_for(id))
+    {
+        std::lock_guard<std::mutex> lock{output->geometry_mutex};
+        output->width = width;
+        output->height = height;
+        output->x = x;
+        output->y = y;
+    }
+}
+
+void mrm::CompositorReport::began_frame(SubCompositorId id)
+{
+    if (auto const output = output_for(id))
+    {
+        auto const t = now();
+        output->start_of_frame.store(t, std::memory_order_relaxed);
+        output->bypassed.store(true, std::memory_order_relaxed);
+
+        auto const scheduled = last_scheduled.load(std::memory_order_relaxed);
+        if (scheduled)
+            output->latency.record(microseconds_between(scheduled, t));
+    }
+}
+
+void mrm::CompositorReport::renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables)
+{
+    if (auto const output = output_for(id))
+        output->renderables.record(renderables.size());
+}
+
+void mrm::CompositorReport::rendered_frame(SubCompositorId id)
+{
+    if (auto const output = output_for(id))
+    {
+        auto const start = output->start_of_frame.load(std::memory_order_relaxed);
+        output->render_time.record(microseconds_between(start, now()));
+        output->bypassed.store(false, std::memory_order_relaxed);
+    }
+}
+
+void mrm::CompositorReport::uploaded_textures(SubCompositorId id, std::size_t bytes)
+{
+    if (auto const output = output_for(id))
+        output->uploaded_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void mrm::CompositorReport::finished_frame(SubCompositorId id)
+{
+    auto const t = now();
+
+    if (auto const output = output_for(id))
+    {
+        auto const previous = output->end_of_frame.exchange(t, std::memory_order_relaxed);
+        if (previous)
+            output->frame_time.record(microseconds_between(previous, t));
+
+        output->frames.fetch_add(1, std::memory_order_relaxed);
+        if (output->bypassed.load(std::memory_order_relaxed))
+            output->bypassed_frames.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void mrm::CompositorReport::started()
+{
+    // File I/O has no place on the compositing threads
+    if (!dump_file.empty() && !dumper.joinable())
+    {
+        dumping = true;
+        dumper = std::thread{[this] { dump_periodically(); }};
+    }
+}
+
+void mrm::CompositorReport::stopped()
+{
+    if (!dump_file.empty())
+    {
+        stop_dumping();
+        dump();
+    }
+
+    // The compositing threads are gone, and the next ones will likely be
+    // compositing different outputs
+    for (auto i = 0u; i != max_outputs; ++i)
+    {
+        auto& output = outputs[i];
+        if (output.state.exchange(Output::unused, std::memory_order_acq_rel) == Output::in_use)
+            output.reset();
+    }
+}
+
+void mrm::CompositorReport::scheduled()
+{
+    last_scheduled.store(now(), std::memory_order_relaxed);
+}
+
+void mrm::CompositorReport::skipped_wakeup(SubCompositorId id)
+{
+    if (auto const output = output_for(id))
+        output->skipped_wakeups.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto mrm::CompositorReport::metrics() const -> std::vector<OutputMetrics>
+{
+    std::vector<OutputMetrics> result;
+
+    for (auto i = 0u; i != max_outputs; ++i)
+    {
+        auto const& output = outputs[i];
+        if (output.state.load(std::memory_order_acquire) != Output::in_use)
+            continue;
+
+        std::lock_guard<std::mutex> lock{output.geometry_mutex};
+        result.push_back(OutputMetrics{
+            output.id.load(std::memory_order_relaxed),
+            output.width, output.height, output.x, output.y,
+            output.frames.load(std::memory_order_relaxed),
+            output.bypassed_frames.load(std::memory_order_relaxed),
+            output.skipped_wakeups.load(std::memory_order_relaxed),
+            output.uploaded_bytes.load(std::memory_order_relaxed),
+            output.frame_time.snapshot(),
+            output.render_time.snapshot(),
+            output.latency.snapshot(),
+            output.renderables.snapshot()});
+    }
+
+    return result;
+}
+
+std::string mrm::CompositorReport::json() const
+{
+    std::ostringstream out;
+
+    out << "{\"outputs\":[";
+    char const* separator = "";
+    for (auto const& output : metrics())
+    {
+        char id[32];
+        snprintf(id, sizeof id, "%p", output.id);
+
+        out << separator << "{"
+            << "\"id\":\"" << id << "\""
+            << ",\"width\":" << output.width
+            << ",\"height\":" << output.height
+            << ",\"x\":" << output.x
+            << ",\"y\":" << output.y
+            << ",\"frames\":" << output.frames
+            << ",\"bypassed_frames\":" << output.bypassed_frames
+            << ",\"bypass_rate\":"
+                << (output.frames ? static_cast<double>(output.bypassed_frames) / output.frames : 0.0)
+            << ",\"skipped_wakeups\":" << output.skipped_wakeups
+            << ",\"uploaded_bytes\":" << output.uploaded_bytes
+            << ",";
+        write_json(out, "frame_time_us", output.frame_time);
+        out << ",";
+        write_json(out, "render_time_us", output.render_time);
+        out << ",";
+        write_json(out, "latency_us", output.latency);
+        out << ",";
+        write_json(out, "renderables", output.renderables);
+        out << "}";
+        separator = ",";
+    }
+    out << "]}\n";
+
+    return out.str();
+}
+
+void mrm::CompositorReport::dump_periodically()
+{
+    mir::set_thread_name("Mir/Metrics");
+    std::unique_lock<std::mutex> lock{dump_mutex};
+
+    while (!dump_cv.wait_for(lock, dump_interval, [this] { return !dumping; }))
+    {
+        lock.unlock();
+        dump();
+        lock.lock();
+    }
+}
+
+void mrm::CompositorReport::stop_dumping()
+{
+    if (!dumper.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock{dump_mutex};
+        dumping = false;
+    }
+    dump_cv.notify_all();
+    dumper.join();
+}
+
+void mrm::CompositorReport::dump() const
+{
+    // Readers only ever see a complete file. A report has nowhere to
+    // report its own failures, so a dump that can't be written is dropped.
+    auto const temporary = dump_file + ".tmp";
+    {
+        std::ofstream file{temporary, std::ios::trunc};
+        file << json();
+        if (!file.flush())
+            return;
+    }
+    std::rename(temporary.c_str(), dump_file.c_str());
+}
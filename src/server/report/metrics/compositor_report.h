@@ -0,0 +1,146 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_REPORT_METRICS_COMPOSITOR_REPORT_H_
+#define MIR_REPORT_METRICS_COMPOSITOR_REPORT_H_
+
+#include "histogram.h"
+
+#include "mir/compositor/compositor_report.h"
+#include "mir/time/clock.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mir
+{
+namespace report
+{
+namespace metrics
+{
+/**
+ * Keeps distributions of per-output frame statistics, rather than logging
+ * averages, so tail latencies can be read back.
+ *
+ * Reporting frames takes no locks, so it can be done from every
+ * compositing thread at once. Metrics cover the time since the compositor
+ * last started, and are read back through the dump file.
+ */
+class CompositorReport : public mir::compositor::CompositorReport
+{
+public:
+    /// Outputs beyond this many are not measured
+    static std::size_t const max_outputs = 16;
+
+    /**
+     * \param [in] clock        Timestamps frames
+     * \param [in] dump_file    If not empty, a file to rewrite with json()
+     *                          about once a second (from a thread of its
+     *                          own) and when the compositor stops
+     */
+    CompositorReport(std::shared_ptr<time::Clock> const& clock, std::string const& dump_file);
+    ~CompositorReport();
+
+    void added_display(int width, int height, int x, int y, SubCompositorId id) override;
+    void began_frame(SubCompositorId id) override;
+    void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
+    void rendered_frame(SubCompositorId id) override;
+    void uploaded_textures(SubCompositorId id, std::size_t bytes) override;
+    void finished_frame(SubCompositorId id) override;
+    void started() override;
+    void stopped() override;
+    void scheduled() override;
+    void skipped_wakeup(SubCompositorId id) override;
+
+    /// The metrics of every output, as written to the dump file
+    std::string json() const;
+
+private:
+    struct OutputMetrics
+    {
+        SubCompositorId id;
+        int width, height, x, y;
+        std::uint64_t frames;
+        std::uint64_t bypassed_frames;
+        std::uint64_t skipped_wakeups;
+        std::uint64_t uploaded_bytes;
+        /// Between the ends of consecutive frames, in microseconds
+        Histogram::Snapshot frame_time;
+        /// From starting a frame until it's rendered (not bypassed), in microseconds
+        Histogram::Snapshot render_time;
+        /// From compositing being scheduled until a frame starts, in microseconds
+        Histogram::Snapshot latency;
+        Histogram::Snapshot renderables;
+    };
+
+    struct Output
+    {
+        enum State { unused, claiming, in_use };
+        std::atomic<int> state{unused};
+        std::atomic<SubCompositorId> id{nullptr};
+
+        // Written when a compositor starts, so it can afford a lock to be read as a whole
+        std::mutex mutable geometry_mutex;
+        int width{0}, height{0}, x{0}, y{0};
+
+        std::atomic<std::int64_t> start_of_frame{0};
+        std::atomic<std::int64_t> end_of_frame{0};
+        std::atomic<bool> bypassed{true};
+
+        std::atomic<std::uint64_t> frames{0};
+        std::atomic<std::uint64_t> bypassed_frames{0};
+        std::atomic<std::uint64_t> skipped_wakeups{0};
+        std::atomic<std::uint64_t> uploaded_bytes{0};
+
+        Histogram frame_time;
+        Histogram render_time;
+        Histogram latency;
+        Histogram renderables;
+
+        void reset();
+    };
+
+    /// The output measuring id (claimed if need be), or null if all are taken
+    Output* output_for(SubCompositorId id);
+    std::int64_t now() const;
+    std::vector<OutputMetrics> metrics() const;
+    void dump() const;
+    void dump_periodically();
+    void stop_dumping();
+
+    std::shared_ptr<time::Clock> const clock;
+    std::string const dump_file;
+
+    std::unique_ptr<Output[]> const outputs;
+    std::atomic<std::int64_t> last_scheduled{0};
+
+    std::mutex dump_mutex;
+    std::condition_variable dump_cv;
+    bool dumping{false};
+    std::thread dumper;
+};
+}
+}
+}
+
+#endif /* MIR_REPORT_METRICS_COMPOSITOR_REPORT_H_ */
@@ -0,0 +1,131 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "histogram.h"
+
+#include <cmath>
+
+namespace mrm = mir::report::metrics;
+
+namespace
+{
+unsigned highest_bit(std::uint64_t value)
+{
+    return 63 - __builtin_clzll(value);
+}
+}
+
+mrm::Histogram::Histogram()
+{
+    reset();
+}
+
+std::size_t mrm::Histogram::bucket_for(std::uint64_t value)
+{
+    if (value > max_trackable_value)
+        value = max_trackable_value;
+
+    if (value < (1u << sub_bucket_bits))
+        return value;
+
+    // Every power of two above the linear range gets half a range of
+    // buckets, each 2^shift wide
+    auto const shift = highest_bit(value) - (sub_bucket_bits - 1);
+    return (shift << (sub_bucket_bits - 1)) + (value >> shift);
+}
+
+std::uint64_t mrm::Histogram::highest_value_in(std::size_t bucket)
+{
+    if (bucket < (1u << sub_bucket_bits))
+        return bucket;
+
+    auto const shift = (bucket >> (sub_bucket_bits - 1)) - 1;
+    auto const mantissa = bucket - (shift << (sub_bucket_bits - 1));
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void mrm::Histogram::record(std::uint64_t value)
+{
+    counts[bucket_for(value)].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    auto current_max = max.load(std::memory_order_relaxed);
+    while (value > current_max &&
+           !max.compare_exchange_weak(current_max, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void mrm::Histogram::reset()
+{
+    for (auto& count : counts)
+        count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+auto mrm::Histogram::snapshot() const -> Snapshot
+{
+    Snapshot result;
+    result.counts.reserve(bucket_count);
+    for (auto const& count : counts)
+    {
+        result.counts.push_back(count.load(std::memory_order_relaxed));
+        result.count_ += result.counts.back();
+    }
+    result.sum = sum.load(std::memory_order_relaxed);
+    result.max_ = max.load(std::memory_order_relaxed);
+    return result;
+}
+
+std::uint64_t mrm::Histogram::Snapshot::count() const
+{
+    return count_;
+}
+
+std::uint64_t mrm::Histogram::Snapshot::max() const
+{
+    return max_;
+}
+
+double mrm::Histogram::Snapshot::mean() const
+{
+    return count_ ? static_cast<double>(sum) / count_ : 0.0;
+}
+
+std::uint64_t mrm::Histogram::Snapshot::percentile(double percent) const
+{
+    if (!count_)
+        return 0;
+
+    auto rank = static_cast<std::uint64_t>(std::ceil(percent / 100.0 * count_));
+    if (rank < 1)
+        rank = 1;
+
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket != counts.size(); ++bucket)
+    {
+        seen += counts[bucket];
+        if (seen >= rank)
+        {
+            auto const highest = highest_value_in(bucket);
+            return highest < max_ ? highest : max_;
+        }
+    }
+
+    return max_;
+}
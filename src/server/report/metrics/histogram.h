@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_REPORT_METRICS_HISTOGRAM_H_
+#define MIR_REPORT_METRICS_HISTOGRAM_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace mir
+{
+namespace report
+{
+namespace metrics
+{
+/**
+ * A log-linear ("HDR") histogram that can be recorded into from any number
+ * of threads without locking.
+ *
+ * Values below 64 are counted exactly; above that each power of two is
+ * split into 32 buckets, so any value read back is within 1/32 of the
+ * value recorded. Values too large to track are counted in the top bucket.
+ */
+class Histogram
+{
+public:
+    /// The largest value counted in a bucket of its own
+    static std::uint64_t const max_trackable_value = (1ull << 32) - 1;
+
+    class Snapshot
+    {
+    public:
+        std::uint64_t count() const;
+        std::uint64_t max() const;
+        double mean() const;
+        /**
+         * The value that percent of recorded values are at or below.
+         *
+         * \param [in] percent  In the range [0, 100]
+         * \return  The highest value that shares a bucket with that
+         *          percentile (never more than max()), or 0 if nothing has
+         *          been recorded
+         */
+        std::uint64_t percentile(double percent) const;
+
+    private:
+        friend class Histogram;
+        std::vector<std::uint64_t> counts;
+        std::uint64_t count_ = 0;
+        std::uint64_t sum = 0;
+        std::uint64_t max_ = 0;
+    };
+
+    Histogram();
+
+    void record(std::uint64_t value);
+    /// Forget everything recorded; not safe to call while recording
+    void reset();
+
+    /// Counts recorded concurrently may or may not be included
+    Snapshot snapshot() const;
+
+    static std::size_t bucket_for(std::uint64_t value);
+    static std::uint64_t highest_value_in(std::size_t bucket);
+
+private:
+    static unsigned const sub_bucket_bits = 6;
+    static unsigned const value_bits = 32;
+    static std::size_t const bucket_count = (value_bits - sub_bucket_bits + 2) << (sub_bucket_bits - 1);
+
+    std::atomic<std::uint64_t> counts[bucket_count];
+    std::atomic<std::uint64_t> sum;
+    std::atomic<std::uint64_t> max;
+
+    Histogram(Histogram const&) = delete;
+    Histogram& operator=(Histogram const&) = delete;
+};
+}
+}
+}
+
+#endif /* MIR_REPORT_METRICS_HISTOGRAM_H_ */
@@ -36,6 +36,10 @@ void mrn::CompositorReport::rendered_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::uploaded_textures(SubCompositorId, std::size_t)
+{
+}
+
 void mrn::CompositorReport::finished_frame(SubCompositorId)
 {
 }
@@ -51,3 +55,7 @@ void mrn::CompositorReport::stopped()
 void mrn::CompositorReport::scheduled()
 {
 }
+
+void mrn::CompositorReport::skipped_wakeup(SubCompositorId)
+{
+}
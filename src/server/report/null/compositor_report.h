@@ -35,10 +35,12 @@ public:
     void began_frame(SubCompositorId id) override;
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
+    void uploaded_textures(SubCompositorId id, std::size_t bytes) override;
     void finished_frame(SubCompositorId id) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
+    void skipped_wakeup(SubCompositorId id) override;
 };
 
 } // namespace compositor
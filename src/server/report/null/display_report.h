@@ -44,6 +44,7 @@ public:
     void report_vt_switch_back_failure() override;
     void report_egl_configuration(EGLDisplay disp, EGLConfig cfg) override;
     void report_vsync(unsigned int output_id, graphics::Frame const&) override;
+    void report_cursor_moves_coalesced(unsigned int moves) override;
 };
 }
 }
@@ -26,6 +26,7 @@
 #include "mir/graphics/cursor_image.h"
 #include "mir/graphics/pixel_format_utils.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/renderer/sw/pixel_source.h"
 
 #include "mir/scene/scene_report.h"
@@ -153,6 +154,12 @@ void ms::SurfaceObservers::start_drag_and_drop(Surface const* surf, std::vector<
                  { observer->start_drag_and_drop(surf, handle); });
 }
 
+void ms::SurfaceObservers::input_region_set_to(Surface const* surf, std::vector<geometry::Rectangle> const& region)
+{
+    for_each([&](std::shared_ptr<SurfaceObserver> const& observer)
+                 { observer->input_region_set_to(surf, region); });
+}
+
 
 struct ms::CursorStreamImageAdapter
 {
@@ -315,8 +322,11 @@ std::shared_ptr<mf::BufferStream> ms::BasicSurface::primary_buffer_stream() cons
 
 void ms::BasicSurface::set_input_region(std::vector<geom::Rectangle> const& input_rectangles)
 {
-    std::unique_lock<std::mutex> lock(guard);
-    custom_input_rectangles = input_rectangles;
+    {
+        std::unique_lock<std::mutex> lock(guard);
+        custom_input_rectangles = input_rectangles;
+    }
+    observers.input_region_set_to(this, input_rectangles);
 }
 
 void ms::BasicSurface::resize(geom::Size const& desired_size)
@@ -357,6 +367,21 @@ geom::Rectangle ms::BasicSurface::input_bounds() const
     return surface_rect;
 }
 
+geom::Rectangle ms::BasicSurface::input_extents() const
+{
+    std::unique_lock<std::mutex> lk(guard);
+
+    if (custom_input_rectangles.empty())
+        return surface_rect;
+
+    // The custom region is not clipped to the surface (subsurfaces may lie outside it)
+    geom::Rectangles region;
+    for (auto const& rectangle : custom_input_rectangles)
+        region.add({rectangle.top_left + (surface_rect.top_left - geom::Point{}), rectangle.size});
+
+    return region.bounding_rectangle();
+}
+
 // TODO: Does not account for transformation().
 bool ms::BasicSurface::input_area_contains(geom::Point const& point) const
 {
@@ -819,6 +844,25 @@ public:
 
     mg::Renderable::ID id() const override
     { return id_; }
+
+    std::experimental::optional<geom::Rectangles> buffer_damage() const override
+    {
+        buffer(); // damage is relative to the buffer acquired
+        return underlying_buffer_stream->compositor_buffer_damage(compositor_id);
+    }
+
+    geom::Region opaque_region() const override
+    {
+        // The region is in buffer coordinates; when the buffer is scaled to
+        // fit we can't be sure which screen pixels are opaque.
+        if (screen_position_.size != underlying_buffer_stream->stream_size())
+            return {};
+
+        auto region = underlying_buffer_stream->opaque_region();
+        region.translate(screen_position_.top_left - geom::Point{});
+        region.intersect(screen_position_);
+        return region;
+    }
 private:
     std::shared_ptr<mc::BufferStream> const underlying_buffer_stream;
     std::shared_ptr<mg::Buffer> mutable compositor_buffer;
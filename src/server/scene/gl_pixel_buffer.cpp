@@ -17,15 +17,30 @@
  */
 
 #include "gl_pixel_buffer.h"
+#include "pixel_conversion.h"
 #include "mir/graphics/buffer.h"
 #include "mir/renderer/gl/context.h"
 #include "mir/renderer/gl/texture_source.h"
 
 #include <stdexcept>
+#include <cstdlib>
+#include <cstring>
 #include <boost/throw_exception.hpp>
+#include <EGL/egl.h>
 #include MIR_SERVER_GL_H
 #include MIR_SERVER_GLEXT_H
 
+/* Pixel pack buffers are GLES 3 (and desktop GL 2.1) but we build against GLES 2 */
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+
 namespace mg = mir::graphics;
 namespace ms = mir::scene;
 namespace geom = mir::geometry;
@@ -39,19 +54,27 @@ bool is_big_endian()
     return (*reinterpret_cast<char*>(&n) != 1);
 }
 
-inline uint32_t abgr_to_argb(uint32_t p)
+bool has_pixel_pack_buffers()
 {
-    return ((p << 16) & 0x00ff0000) | /* Move R to new position */
-           ((p) & 0x0000ff00) |       /* G remains at same position */
-           ((p >> 16) & 0x000000ff) | /* Move B to new position */
-           ((p) & 0xff000000);        /* A remains at same position */
+    auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+    if (!version)
+        return false;
+
+    static char const es_prefix[] = "OpenGL ES ";
+    bool const is_es = strncmp(version, es_prefix, sizeof es_prefix - 1) == 0;
+    auto const major = atoi(is_es ? version + sizeof es_prefix - 1 : version);
+
+    // Desktop GL has had them since 2.1, but we need glMapBufferRange() from 3.0
+    return major >= 3;
 }
 
 }
 
 ms::GLPixelBuffer::GLPixelBuffer(std::unique_ptr<renderer::gl::Context> gl_context)
     : gl_context{std::move(gl_context)},
-      tex{0}, fbo{0}, gl_pixel_format{0}, pixels_need_y_flip{false}
+      tex{0}, fbo{0}, pbo{0}, pbo_size{0},
+      map_buffer_range{nullptr}, unmap_buffer{nullptr}, probed_pbo_support{false},
+      gl_pixel_format{0}, bgra_unreadable{false}, pixels_in_pbo{false}, pixels_need_y_flip{false}
 {
     /*
      * TODO: Handle systems that are big-endian, and therefore GL_BGRA doesn't
@@ -70,13 +93,15 @@ ms::GLPixelBuffer::~GLPixelBuffer() noexcept
      * This may be called from a different thread
      * than the one that called prepare
      */
-    if (tex != 0 || fbo != 0)
+    if (tex != 0 || fbo != 0 || pbo != 0)
         gl_context->make_current();
 
     if (tex != 0)
         glDeleteTextures(1, &tex);
     if (fbo != 0)
         glDeleteFramebuffers(1, &fbo);
+    if (pbo != 0)
+        glDeleteBuffers(1, &pbo);
 }
 
 void ms::GLPixelBuffer::prepare()
@@ -93,6 +118,40 @@ void ms::GLPixelBuffer::prepare()
         glGenFramebuffers(1, &fbo);
 
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    if (!probed_pbo_support)
+    {
+        probed_pbo_support = true;
+
+        if (has_pixel_pack_buffers())
+        {
+            map_buffer_range = reinterpret_cast<MapBufferRange>(eglGetProcAddress("glMapBufferRange"));
+            unmap_buffer = reinterpret_cast<UnmapBuffer>(eglGetProcAddress("glUnmapBuffer"));
+
+            if (map_buffer_range && unmap_buffer)
+                glGenBuffers(1, &pbo);
+        }
+    }
+}
+
+void ms::GLPixelBuffer::read_pixels(GLsizei width, GLsizei height, void* destination)
+{
+    /* First try to get pixels as BGRA, unless we already know we can't */
+    if (!bgra_unreadable)
+    {
+        glGetError();
+        gl_pixel_format = GL_BGRA_EXT;
+        glReadPixels(0, 0, width, height, gl_pixel_format, GL_UNSIGNED_BYTE, destination);
+
+        if (glGetError() == GL_NO_ERROR)
+            return;
+
+        bgra_unreadable = true;
+    }
+
+    /* If getting pixels as BGRA failed, fall back to RGBA */
+    gl_pixel_format = GL_RGBA;
+    glReadPixels(0, 0, width, height, gl_pixel_format, GL_UNSIGNED_BYTE, destination);
 }
 
 void ms::GLPixelBuffer::fill_from(graphics::Buffer& buffer)
@@ -113,25 +172,66 @@ void ms::GLPixelBuffer::fill_from(graphics::Buffer& buffer)
 
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
 
-    /* First try to get pixels as BGRA */
-    glGetError();
-    gl_pixel_format = GL_BGRA_EXT;
-    glReadPixels(0, 0, width, height, gl_pixel_format, GL_UNSIGNED_BYTE, pixels.data());
+    if (pbo != 0)
+    {
+        /*
+         * Have the GPU copy into the pack buffer in its own time; we only
+         * wait for it when the pixels are wanted.
+         */
+        GLsizeiptr const data_size = pixels.size();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        if (pbo_size != data_size)
+        {
+            glBufferData(GL_PIXEL_PACK_BUFFER, data_size, nullptr, GL_STREAM_READ);
+            pbo_size = data_size;
+        }
 
-    /* If getting pixels as BGRA failed, fall back to RGBA */
-    if (glGetError() != GL_NO_ERROR)
+        read_pixels(width, height, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glFlush();
+    }
+    else
     {
-        gl_pixel_format = GL_RGBA;
-        glReadPixels(0, 0, width, height, gl_pixel_format, GL_UNSIGNED_BYTE, pixels.data());
+        read_pixels(width, height, pixels.data());
     }
 
     size_ = buffer.size();
+    pixels_in_pbo = pbo != 0;
     pixels_need_y_flip = true;
 }
 
 void const* ms::GLPixelBuffer::as_argb_8888()
 {
-    if (pixels_need_y_flip)
+    if (pixels_in_pbo)
+    {
+        auto const stride_val = stride().as_uint32_t();
+        auto const height = size_.height.as_uint32_t();
+
+        gl_context->make_current();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+
+        auto const mapped = static_cast<char const*>(
+            map_buffer_range(GL_PIXEL_PACK_BUFFER, 0, pixels.size(), GL_MAP_READ_BIT));
+        if (!mapped)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to map pixel pack buffer"));
+        }
+
+        /* We have to copy out of the mapping anyway, so flip as we go */
+        for (unsigned int i = 0; i < height; i++)
+        {
+            copy_and_convert_pixel_line(&mapped[(height - i - 1) * stride_val],
+                                        &pixels[i * stride_val]);
+        }
+
+        unmap_buffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        pixels_in_pbo = false;
+        pixels_need_y_flip = false;
+    }
+    else if (pixels_need_y_flip)
     {
         auto const stride_val = stride().as_uint32_t();
         auto const height = size_.height.as_uint32_t();
@@ -175,20 +275,17 @@ geom::Stride ms::GLPixelBuffer::stride() const
     return geom::Stride{size_.width.as_uint32_t() * sizeof(uint32_t)};
 }
 
-void ms::GLPixelBuffer::copy_and_convert_pixel_line(char* src, char* dst)
+void ms::GLPixelBuffer::copy_and_convert_pixel_line(char const* src, char* dst)
 {
     if (gl_pixel_format == GL_RGBA)
     {
         /* Convert from abgr_8888 to argb_8888 while copying */
-        auto pixels_src = reinterpret_cast<uint32_t*>(src);
-        auto pixels_dst = reinterpret_cast<uint32_t*>(dst);
-        auto const width = size_.width.as_uint32_t();
-
-        for (uint32_t n = 0; n < width; n++)
-            pixels_dst[n] = abgr_to_argb(pixels_src[n]);
+        abgr_to_argb(reinterpret_cast<uint32_t const*>(src),
+                     reinterpret_cast<uint32_t*>(dst),
+                     size_.width.as_uint32_t());
     }
     else if (src != dst)
     {
-        std::copy(src, src + stride().as_uint32_t(), dst);
+        memcpy(dst, src, stride().as_uint32_t());
     }
 }
@@ -42,7 +42,13 @@ class Context;
 
 namespace scene
 {
-/** Extracts the pixels from a graphics::Buffer using GL facilities. */
+/**
+ * Extracts the pixels from a graphics::Buffer using GL facilities.
+ *
+ * Where GL has pixel pack buffers, fill_from() only queues the copy of the
+ * pixels and as_argb_8888() collects them, so the buffer isn't held while
+ * the GPU catches up.
+ */
 class GLPixelBuffer : public PixelBuffer
 {
 public:
@@ -55,14 +61,25 @@ public:
     geometry::Stride stride() const;
 
 private:
+    typedef void* (*MapBufferRange)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+    typedef GLboolean (*UnmapBuffer)(GLenum target);
+
     void prepare();
-    void copy_and_convert_pixel_line(char* src, char* dst);
+    void read_pixels(GLsizei width, GLsizei height, void* destination);
+    void copy_and_convert_pixel_line(char const* src, char* dst);
 
     std::unique_ptr<renderer::gl::Context> const gl_context;
     GLuint tex;
     GLuint fbo;
+    GLuint pbo;
+    GLsizeiptr pbo_size;
+    MapBufferRange map_buffer_range;
+    UnmapBuffer unmap_buffer;
+    bool probed_pbo_support;
     std::vector<char> pixels;
     GLuint gl_pixel_format;
+    bool bgra_unreadable;
+    bool pixels_in_pbo;
     bool pixels_need_y_flip;
     geometry::Size size_;
     geometry::Stride stride_;
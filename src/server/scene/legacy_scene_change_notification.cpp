@@ -20,9 +20,12 @@
 
 #include "mir/scene/legacy_scene_change_notification.h"
 #include "mir/scene/surface.h"
+#include "mir/geometry/rectangles.h"
 
 #include <boost/throw_exception.hpp>
 
+#include <mutex>
+
 namespace ms = mir::scene;
 
 ms::LegacySceneChangeNotification::LegacySceneChangeNotification(
@@ -49,6 +52,11 @@ ms::LegacySceneChangeNotification::~LegacySceneChangeNotification()
 
 namespace
 {
+/*
+ * Reports what a surface change could have redrawn as damage, so that only
+ * the outputs showing it need to recomposite. Changes whose extent we can't
+ * tell (e.g. an arbitrary transformation) still notify the whole scene.
+ */
 class NonLegacySurfaceChangeNotification : public ms::LegacySurfaceChangeNotification
 {
 public:
@@ -57,48 +65,119 @@ public:
         std::function<void(int frames, mir::geometry::Rectangle const& damage)> const& damage_notify_change,
         ms::Surface* surface);
 
+    void resized_to(ms::Surface const* surf, mir::geometry::Size const& size) override;
     void moved_to(ms::Surface const* surf, const mir::geometry::Point&) override;
+    void hidden_set_to(ms::Surface const* surf, bool) override;
+    void alpha_set_to(ms::Surface const* surf, float) override;
     void frame_posted(ms::Surface const* surf, int frames_available, const mir::geometry::Size& size) override;
 
 private:
-    mir::geometry::Point top_left;
+    /// Whether a change to surf can show on screen; must hold mutex
+    bool update_visibility(ms::Surface const* surf);
+    void notify_damage(
+        ms::Surface const* surf,
+        mir::geometry::Rectangle const& damage,
+        std::unique_lock<std::mutex>& lock);
+
     std::function<void(int frames, mir::geometry::Rectangle const& damage)> const damage_notify_change;
+
+    std::mutex mutex;
+    mir::geometry::Point top_left;
+    mir::geometry::Size size;
+    bool was_visible;
 };
 
 NonLegacySurfaceChangeNotification::NonLegacySurfaceChangeNotification(
     std::function<void()> const& notify_scene_change,
     std::function<void(int frames, mir::geometry::Rectangle const& damage)> const& damage_notify_change,
     ms::Surface* surface) :
-    ms::LegacySurfaceChangeNotification(notify_scene_change, {}),
-    damage_notify_change(damage_notify_change)
+    ms::LegacySurfaceChangeNotification(
+        [this, notify_scene_change, surface]
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            if (update_visibility(surface))
+            {
+                lock.unlock();
+                notify_scene_change();
+            }
+        },
+        {}),
+    damage_notify_change(damage_notify_change),
+    top_left{surface->top_left()},
+    size{surface->size()},
+    was_visible{surface->visible()}
+{
+}
+
+void NonLegacySurfaceChangeNotification::resized_to(ms::Surface const* surf, mir::geometry::Size const& size)
 {
-    top_left = surface->top_left();
+    std::unique_lock<std::mutex> lock{mutex};
+    auto const damage = mir::geometry::Rectangles{{top_left, this->size}, {top_left, size}}.bounding_rectangle();
+    this->size = size;
+    notify_damage(surf, damage, lock);
 }
 
 void NonLegacySurfaceChangeNotification::moved_to(ms::Surface const* surf, const mir::geometry::Point& top_left)
 {
+    std::unique_lock<std::mutex> lock{mutex};
+    auto const damage = mir::geometry::Rectangles{{this->top_left, size}, {top_left, size}}.bounding_rectangle();
     this->top_left = top_left;
-    ms::LegacySurfaceChangeNotification::moved_to(surf, top_left);
+    notify_damage(surf, damage, lock);
+}
+
+void NonLegacySurfaceChangeNotification::hidden_set_to(ms::Surface const* surf, bool)
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    notify_damage(surf, {top_left, size}, lock);
+}
+
+void NonLegacySurfaceChangeNotification::alpha_set_to(ms::Surface const* surf, float)
+{
+    std::unique_lock<std::mutex> lock{mutex};
+    notify_damage(surf, {top_left, size}, lock);
 }
 
 void NonLegacySurfaceChangeNotification::frame_posted(ms::Surface const*, int frames_available, const mir::geometry::Size& size)
 {
+    std::unique_lock<std::mutex> lock{mutex};
     mir::geometry::Rectangle const update_region{top_left, size};
+    lock.unlock();
+
     damage_notify_change(frames_available, update_region);
 }
+
+bool NonLegacySurfaceChangeNotification::update_visibility(ms::Surface const* surf)
+{
+    bool const visible = surf->visible();
+    bool const shows = visible || was_visible;
+    was_visible = visible;
+    return shows;
 }
 
-void ms::LegacySceneChangeNotification::add_surface_observer(ms::Surface* surface)
+void NonLegacySurfaceChangeNotification::notify_damage(
+    ms::Surface const* surf,
+    mir::geometry::Rectangle const& damage,
+    std::unique_lock<std::mutex>& lock)
 {
-    auto notifier = [surface, this, was_visible = false] () mutable
-        {
-            if (surface->visible() || was_visible)
-                scene_notify_change();
-            was_visible = surface->visible();
-        };
+    if (update_visibility(surf))
+    {
+        lock.unlock();
+        damage_notify_change(1, damage);
+    }
+}
+}
 
+void ms::LegacySceneChangeNotification::add_surface_observer(ms::Surface* surface)
+{
     if (buffer_notify_change)
     {
+        auto notifier = [surface, this, was_visible = false] () mutable
+            {
+                if (surface->visible() || was_visible)
+                    scene_notify_change();
+                was_visible = surface->visible();
+            };
+
         auto observer = std::make_shared<LegacySurfaceChangeNotification>(notifier, buffer_notify_change);
         surface->add_observer(observer);
 
@@ -107,7 +186,8 @@ void ms::LegacySceneChangeNotification::add_surface_observer(ms::Surface* surfac
     }
     else
     {
-        auto observer = std::make_shared<NonLegacySurfaceChangeNotification>(notifier, damage_notify_change, surface);
+        auto observer = std::make_shared<NonLegacySurfaceChangeNotification>(
+            scene_notify_change, damage_notify_change, surface);
         surface->add_observer(observer);
 
         std::unique_lock<decltype(surface_observers_guard)> lg(surface_observers_guard);
@@ -121,7 +201,7 @@ void ms::LegacySceneChangeNotification::surface_added(ms::Surface* surface)
 
     // If the surface already has content we need to (re)composite
     if (!buffer_notify_change && surface->visible())
-        scene_notify_change();
+        damage_notify_change(1, {surface->top_left(), surface->size()});
 }
 
 void ms::LegacySceneChangeNotification::surface_exists(ms::Surface* surface)
@@ -142,7 +222,12 @@ void ms::LegacySceneChangeNotification::surface_removed(ms::Surface* surface)
     }
 
     if (surface->visible())
-        scene_notify_change();
+    {
+        if (buffer_notify_change)
+            scene_notify_change();
+        else
+            damage_notify_change(1, {surface->top_left(), surface->size()});
+    }
 }
 
 void ms::LegacySceneChangeNotification::surfaces_reordered()
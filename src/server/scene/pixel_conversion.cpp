@@ -0,0 +1,129 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "pixel_conversion.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace ms = mir::scene;
+
+namespace
+{
+typedef void (*Converter)(uint32_t const* src, uint32_t* dst, size_t count);
+
+inline uint32_t abgr_to_argb_pixel(uint32_t p)
+{
+    return ((p << 16) & 0x00ff0000) | /* Move R to new position */
+           ((p) & 0xff00ff00) |       /* A and G remain at same position */
+           ((p >> 16) & 0x000000ff);  /* Move B to new position */
+}
+
+#if defined(__SSE2__)
+void abgr_to_argb_sse2(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    auto const keep = _mm_set1_epi32(0xff00ff00);
+    auto const low = _mm_set1_epi32(0x000000ff);
+    auto const high = _mm_set1_epi32(0x00ff0000);
+
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4)
+    {
+        auto const p = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + n));
+        auto const converted = _mm_or_si128(
+            _mm_and_si128(p, keep),
+            _mm_or_si128(
+                _mm_and_si128(_mm_slli_epi32(p, 16), high),
+                _mm_and_si128(_mm_srli_epi32(p, 16), low)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n), converted);
+    }
+
+    for (; n < count; ++n)
+        dst[n] = abgr_to_argb_pixel(src[n]);
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+/* Built for AVX2 whatever the baseline, and only used if the CPU has it */
+__attribute__((target("avx2")))
+void abgr_to_argb_avx2(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    auto const swap_r_and_b = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8)
+    {
+        auto const p = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + n));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + n), _mm256_shuffle_epi8(p, swap_r_and_b));
+    }
+
+    for (; n < count; ++n)
+        dst[n] = abgr_to_argb_pixel(src[n]);
+}
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+void abgr_to_argb_neon(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    size_t n = 0;
+    for (; n + 16 <= count; n += 16)
+    {
+        auto channels = vld4q_u8(reinterpret_cast<uint8_t const*>(src + n));
+        auto const r = channels.val[0];
+        channels.val[0] = channels.val[2];
+        channels.val[2] = r;
+        vst4q_u8(reinterpret_cast<uint8_t*>(dst + n), channels);
+    }
+
+    for (; n < count; ++n)
+        dst[n] = abgr_to_argb_pixel(src[n]);
+}
+#endif
+
+Converter best_converter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2"))
+        return &abgr_to_argb_avx2;
+#endif
+#if defined(__SSE2__)
+    return &abgr_to_argb_sse2;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    return &abgr_to_argb_neon;
+#else
+    return &ms::detail::abgr_to_argb_scalar;
+#endif
+}
+}
+
+void ms::abgr_to_argb(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    static Converter const convert = best_converter();
+    convert(src, dst, count);
+}
+
+void ms::detail::abgr_to_argb_scalar(uint32_t const* src, uint32_t* dst, size_t count)
+{
+    for (size_t n = 0; n < count; ++n)
+        dst[n] = abgr_to_argb_pixel(src[n]);
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef MIR_SCENE_PIXEL_CONVERSION_H_
+#define MIR_SCENE_PIXEL_CONVERSION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mir
+{
+namespace scene
+{
+/**
+ * Converts count pixels from 0xAABBGGRR (GL_RGBA bytes on little endian) to
+ * 0xAARRGGBB, using the widest vector instructions the CPU has.
+ *
+ * src and dst may be the same row, but must not otherwise overlap.
+ */
+void abgr_to_argb(uint32_t const* src, uint32_t* dst, size_t count);
+
+namespace detail
+{
+/// The portable version of abgr_to_argb(), for comparison
+void abgr_to_argb_scalar(uint32_t const* src, uint32_t* dst, size_t count);
+}
+}
+}
+
+#endif /* MIR_SCENE_PIXEL_CONVERSION_H_ */
@@ -46,17 +46,23 @@ class SurfaceSceneElement : public mc::SceneElement
 {
 public:
     SurfaceSceneElement(
-        std::string name,
         std::shared_ptr<mg::Renderable> const& renderable,
         std::shared_ptr<ms::RenderingTracker> const& tracker,
         mc::CompositorID id)
         : renderable_{renderable},
           tracker{tracker},
-          cid{id},
-          surface_name(name)
+          cid{id}
     {
     }
 
+    void reuse_for(
+        std::shared_ptr<mg::Renderable> const& renderable,
+        std::shared_ptr<ms::RenderingTracker> const& tracker)
+    {
+        renderable_ = renderable;
+        this->tracker = tracker;
+    }
+
     std::shared_ptr<mg::Renderable> renderable() const override
     {
         return renderable_;
@@ -73,10 +79,9 @@ public:
     }
 
 private:
-    std::shared_ptr<mg::Renderable> const renderable_;
-    std::shared_ptr<ms::RenderingTracker> const tracker;
-    mc::CompositorID cid;
-    std::string const surface_name;
+    std::shared_ptr<mg::Renderable> renderable_;
+    std::shared_ptr<ms::RenderingTracker> tracker;
+    mc::CompositorID const cid;
 };
 
 //note: something different than a 2D/HWC overlay
@@ -108,35 +113,107 @@ private:
 
 }
 
+struct ms::SurfaceStack::Snapshot
+{
+    struct Entry
+    {
+        std::shared_ptr<Surface> surface;
+        std::shared_ptr<RenderingTracker> tracker;
+    };
+
+    std::vector<Entry> surfaces;
+    std::vector<std::shared_ptr<mg::Renderable>> overlays;
+    std::map<mc::CompositorID, std::shared_ptr<ElementPool>> element_pools;
+};
+
+/*
+ * The scene elements handed to a registered compositor. Rather than allocate
+ * new elements every frame we reuse those the compositor has let go of.
+ */
+class ms::SurfaceStack::ElementPool
+{
+public:
+    ElementPool(mc::CompositorID id) : id{id} {}
+
+    void fill(mc::SceneElementSequence& elements, Snapshot const& scene)
+    {
+        // Uncontended: each compositor asks for its scene from one thread at a time
+        std::lock_guard<std::mutex> lock{mutex};
+
+        size_t next = 0;
+        for (auto const& entry : scene.surfaces)
+        {
+            if (!entry.surface->visible())
+                continue;
+
+            for (auto const& renderable : entry.surface->generate_renderables(id))
+            {
+                if (next == pool.size())
+                    pool.emplace_back();
+
+                auto& element = pool[next++];
+
+                // Only this pool holds a reference, so the compositor has finished with it
+                if (element && element.use_count() == 1)
+                    element->reuse_for(renderable, entry.tracker);
+                else
+                    element = std::make_shared<SurfaceSceneElement>(renderable, entry.tracker, id);
+
+                elements.emplace_back(element);
+            }
+        }
+
+        // Don't hang on to what the scene no longer needs
+        pool.resize(next);
+    }
+
+    /// Set by emit_scene_changed() until this compositor next asks for its scene
+    std::atomic<bool> scene_changed{false};
+
+private:
+    mc::CompositorID const id;
+    std::mutex mutex;
+    std::vector<std::shared_ptr<SurfaceSceneElement>> pool;
+};
+
 ms::SurfaceStack::SurfaceStack(
     std::shared_ptr<SceneReport> const& report) :
     report{report},
+    snapshot{std::make_shared<Snapshot>()},
     scene_changed{false}
 {
 }
 
 mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID id)
 {
-    RecursiveReadLock lg(guard);
+    auto const scene = std::atomic_load(&snapshot);
 
-    scene_changed = false;
     mc::SceneElementSequence elements;
-    for (auto const& surface : surfaces)
+
+    auto const pool = scene->element_pools.find(id);
+    if (pool != scene->element_pools.end())
     {
-        if (surface->visible())
+        pool->second->scene_changed = false;
+        pool->second->fill(elements, *scene);
+    }
+    else
+    {
+        scene_changed = false;
+
+        for (auto const& entry : scene->surfaces)
         {
-            for (auto& renderable : surface->generate_renderables(id))
+            if (entry.surface->visible())
             {
-                elements.emplace_back(
-                    std::make_shared<SurfaceSceneElement>(
-                        surface->name(),
-                        renderable,
-                        rendering_trackers[surface.get()],
-                        id));
+                for (auto& renderable : entry.surface->generate_renderables(id))
+                {
+                    elements.emplace_back(
+                        std::make_shared<SurfaceSceneElement>(renderable, entry.tracker, id));
+                }
             }
         }
     }
-    for (auto const& renderable : overlays)
+
+    for (auto const& renderable : scene->overlays)
     {
         elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
     }
@@ -145,23 +222,24 @@ mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID i
 
 int ms::SurfaceStack::frames_pending(mc::CompositorID id) const
 {
-    RecursiveReadLock lg(guard);
+    auto const scene = std::atomic_load(&snapshot);
 
-    int result = scene_changed ? 1 : 0;
-    for (auto const& surface : surfaces)
+    // Each registered compositor keeps its own flag, so that one output
+    // compositing doesn't hide a scene change from the others
+    auto const pool = scene->element_pools.find(id);
+    bool const changed = pool != scene->element_pools.end() ? pool->second->scene_changed.load() : scene_changed.load();
+
+    int result = changed ? 1 : 0;
+    for (auto const& entry : scene->surfaces)
     {
-        if (surface->visible())
+        if (entry.surface->visible() && entry.tracker->is_exposed_in(id))
         {
-            auto const tracker = rendering_trackers.find(surface.get());
-            if (tracker != rendering_trackers.end() && tracker->second->is_exposed_in(id))
-            {
-                // Note that we ask the surface and not a Renderable.
-                // This is because we don't want to waste time and resources
-                // on a snapshot till we're sure we need it...
-                int ready = surface->buffers_ready_for_compositor(id);
-                if (ready > result)
-                    result = ready;
-            }
+            // Note that we ask the surface and not a Renderable.
+            // This is because we don't want to waste time and resources
+            // on a snapshot till we're sure we need it...
+            int ready = entry.surface->buffers_ready_for_compositor(id);
+            if (ready > result)
+                result = ready;
         }
     }
     return result;
@@ -172,8 +250,10 @@ void ms::SurfaceStack::register_compositor(mc::CompositorID cid)
     RecursiveWriteLock lg(guard);
 
     registered_compositors.insert(cid);
+    element_pools[cid] = std::make_shared<ElementPool>(cid);
 
     update_rendering_tracker_compositors();
+    publish_snapshot();
 }
 
 void ms::SurfaceStack::unregister_compositor(mc::CompositorID cid)
@@ -181,8 +261,10 @@ void ms::SurfaceStack::unregister_compositor(mc::CompositorID cid)
     RecursiveWriteLock lg(guard);
 
     registered_compositors.erase(cid);
+    element_pools.erase(cid);
 
     update_rendering_tracker_compositors();
+    publish_snapshot();
 }
 
 void ms::SurfaceStack::add_input_visualization(
@@ -191,6 +273,7 @@ void ms::SurfaceStack::add_input_visualization(
     {
         RecursiveWriteLock lg(guard);
         overlays.push_back(overlay);
+        publish_snapshot();
     }
     emit_scene_changed();
 }
@@ -207,6 +290,7 @@ void ms::SurfaceStack::remove_input_visualization(
             BOOST_THROW_EXCEPTION(std::runtime_error("Attempt to remove an overlay which was never added or which has been previously removed"));
         }
         overlays.erase(p);
+        publish_snapshot();
     }
     
     emit_scene_changed();
@@ -217,6 +301,8 @@ void ms::SurfaceStack::emit_scene_changed()
     {
         RecursiveWriteLock lg(guard);
         scene_changed = true;
+        for (auto const& pool : element_pools)
+            pool.second->scene_changed = true;
     }
     observers.scene_changed();
 }
@@ -229,6 +315,7 @@ void ms::SurfaceStack::add_surface(
         RecursiveWriteLock lg(guard);
         surfaces.push_back(surface);
         create_rendering_tracker_for(surface);
+        publish_snapshot();
     }
     surface->set_reception_mode(input_mode);
     observers.surface_added(surface.get());
@@ -250,6 +337,7 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
         {
             surfaces.erase(surface);
             rendering_trackers.erase(keep_alive.get());
+            publish_snapshot();
             found_surface = true;
         }
     }
@@ -316,6 +404,7 @@ void ms::SurfaceStack::raise(std::weak_ptr<Surface> const& s)
         {
             surfaces.erase(p);
             surfaces.push_back(surface);
+            publish_snapshot();
             surfaces_reordered = true;
         }
     }
@@ -339,7 +428,10 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
             [&](std::weak_ptr<Surface> const& s) { return !ss.count(s); });
 
         if (old_surfaces != surfaces)
+        {
+            publish_snapshot();
             surfaces_reordered = true;
+        }
     }
 
     if (surfaces_reordered)
@@ -363,6 +455,22 @@ void ms::SurfaceStack::update_rendering_tracker_compositors()
         pair.second->active_compositors(registered_compositors);
 }
 
+void ms::SurfaceStack::publish_snapshot()
+{
+    RecursiveReadLock ul(guard);
+
+    auto const next = std::make_shared<Snapshot>();
+
+    next->surfaces.reserve(surfaces.size());
+    for (auto const& surface : surfaces)
+        next->surfaces.push_back({surface, rendering_trackers.at(surface.get())});
+
+    next->overlays = overlays;
+    next->element_pools = element_pools;
+
+    std::atomic_store(&snapshot, std::shared_ptr<Snapshot const>{next});
+}
+
 void ms::SurfaceStack::add_observer(std::shared_ptr<ms::Observer> const& observer)
 {
     observers.add(observer);
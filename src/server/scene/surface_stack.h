@@ -106,6 +106,10 @@ private:
     SurfaceStack& operator=(const SurfaceStack&) = delete;
     void create_rendering_tracker_for(std::shared_ptr<Surface> const&);
     void update_rendering_tracker_compositors();
+    void publish_snapshot();
+
+    struct Snapshot;
+    class ElementPool;
 
     RecursiveReadWriteMutex mutable guard;
 
@@ -116,6 +120,12 @@ private:
     std::set<compositor::CompositorID> registered_compositors;
     
     std::vector<std::shared_ptr<graphics::Renderable>> overlays;
+    std::map<compositor::CompositorID, std::shared_ptr<ElementPool>> element_pools;
+
+    // An immutable copy of the above, republished by writers (holding guard)
+    // so that compositors can read it without taking the lock. Only accessed
+    // through std::atomic_load()/std::atomic_store().
+    std::shared_ptr<Snapshot const> snapshot;
 
     Observers observers;
     std::atomic<bool> scene_changed;
@@ -100,11 +100,27 @@ public:
         return 1u;
     }
 
+    std::experimental::optional<geometry::Rectangles> buffer_damage() const override
+    {
+        return {};
+    }
+
+    void set_opaque_region(geometry::Region const& region)
+    {
+        opaque = region;
+    }
+
+    geometry::Region opaque_region() const override
+    {
+        return opaque;
+    }
+
 private:
     std::shared_ptr<graphics::Buffer> buf;
     mir::geometry::Rectangle rect;
     float opacity;
     bool rectangular;
+    geometry::Region opaque;
 };
 
 } // namespace doubles
@@ -59,6 +59,7 @@ struct MockBufferStream : public compositor::BufferStream
     MOCK_METHOD1(release_client_buffer, void(graphics::Buffer*));
     MOCK_METHOD1(lock_compositor_buffer,
                  std::shared_ptr<graphics::Buffer>(void const*));
+    MOCK_CONST_METHOD1(compositor_buffer_damage, geometry::Rectangles(void const*));
     MOCK_METHOD1(set_frame_posted_callback, void(std::function<void(geometry::Size const&)> const&));
 
     MOCK_METHOD0(get_stream_pixel_format, MirPixelFormat());
@@ -73,12 +74,16 @@ struct MockBufferStream : public compositor::BufferStream
     MOCK_METHOD0(drop_client_requests, void());
 
     MOCK_METHOD1(submit_buffer, void(std::shared_ptr<graphics::Buffer> const&));
+    MOCK_METHOD2(submit_damaged_buffer,
+                 void(std::shared_ptr<graphics::Buffer> const&, geometry::Rectangles const&));
     MOCK_METHOD1(with_most_recent_buffer_do, void(std::function<void(graphics::Buffer&)> const&));
     MOCK_CONST_METHOD0(pixel_format, MirPixelFormat());
     MOCK_CONST_METHOD0(has_submitted_buffer, bool());
     MOCK_METHOD1(disassociate_buffer, void(graphics::BufferID));
     MOCK_METHOD1(associate_buffer, void(graphics::BufferID));
     MOCK_METHOD1(set_scale, void(float));
+    MOCK_METHOD1(set_opaque_region, void(geometry::Region const&));
+    MOCK_CONST_METHOD0(opaque_region, geometry::Region());
 
 };
 }
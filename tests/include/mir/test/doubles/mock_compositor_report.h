@@ -41,11 +41,14 @@ public:
                  void(compositor::CompositorReport::SubCompositorId, graphics::RenderableList const&));
     MOCK_METHOD1(rendered_frame,
                  void(compositor::CompositorReport::SubCompositorId));
+    MOCK_METHOD2(uploaded_textures,
+                 void(compositor::CompositorReport::SubCompositorId, std::size_t));
     MOCK_METHOD1(finished_frame,
                  void(compositor::CompositorReport::SubCompositorId));
     MOCK_METHOD0(started, void());
     MOCK_METHOD0(stopped, void());
     MOCK_METHOD0(scheduled, void());
+    MOCK_METHOD1(skipped_wakeup, void(SubCompositorId));
 };
 
 } // namespace doubles
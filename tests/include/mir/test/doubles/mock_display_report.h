@@ -43,6 +43,7 @@ public:
     MOCK_METHOD0(report_vt_switch_back_failure, void());
     MOCK_METHOD2(report_egl_configuration, void(EGLDisplay,EGLConfig));
     MOCK_METHOD2(report_vsync, void(unsigned int, graphics::Frame const&));
+    MOCK_METHOD1(report_cursor_moves_coalesced, void(unsigned int));
 };
 
 }
@@ -53,6 +53,8 @@ struct MockRenderable : public graphics::Renderable
     MOCK_CONST_METHOD0(visible, bool());
     MOCK_CONST_METHOD0(shaped, bool());
     MOCK_CONST_METHOD0(swap_interval, unsigned int());
+    MOCK_CONST_METHOD0(buffer_damage, std::experimental::optional<geometry::Rectangles>());
+    MOCK_CONST_METHOD0(opaque_region, geometry::Region());
 };
 }
 }
@@ -35,6 +35,9 @@ struct MockRenderer : public renderer::Renderer
     MOCK_METHOD1(set_output_transform, void(glm::mat2 const&));
     MOCK_CONST_METHOD1(render, void(graphics::RenderableList const&));
     MOCK_METHOD0(suspend, void());
+    MOCK_CONST_METHOD0(buffer_age, unsigned int());
+    MOCK_METHOD1(set_damage, void(geometry::Rectangles const&));
+    MOCK_CONST_METHOD0(bytes_uploaded, std::size_t());
 
     ~MockRenderer() noexcept {}
 };
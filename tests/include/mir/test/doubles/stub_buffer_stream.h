@@ -47,6 +47,11 @@ public:
         return stub_compositor_buffer;
     }
 
+    geometry::Rectangles compositor_buffer_damage(void const*) const override
+    {
+        return {{{}, stub_compositor_buffer->size()}};
+    }
+
     geometry::Size stream_size() override
     {
         return geometry::Size();
@@ -70,6 +75,10 @@ public:
     {
         if (b) ++nready;
     }
+    void submit_damaged_buffer(std::shared_ptr<graphics::Buffer> const& b, geometry::Rectangles const&) override
+    {
+        submit_buffer(b);
+    }
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& fn) override
     {
         thread_name = current_thread_name();
@@ -79,6 +88,8 @@ public:
     void set_frame_posted_callback(std::function<void(geometry::Size const&)> const&) override {}
     bool has_submitted_buffer() const override { return true; }
     void set_scale(float) override {}
+    void set_opaque_region(geometry::Region const&) override {}
+    geometry::Region opaque_region() const override { return {}; }
 
     std::shared_ptr<graphics::Buffer> stub_compositor_buffer;
     int nready = 0;
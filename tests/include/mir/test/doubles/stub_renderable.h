@@ -91,6 +91,16 @@ public:
         return 1;
     }
 
+    std::experimental::optional<geometry::Rectangles> buffer_damage() const override
+    {
+        return {};
+    }
+
+    geometry::Region opaque_region() const override
+    {
+        return {};
+    }
+
 private:
     std::shared_ptr<graphics::Buffer> make_stub_buffer(geometry::Rectangle const& rect)
     {
@@ -36,6 +36,9 @@ public:
     void set_viewport(geometry::Rectangle const&) override {}
     void set_output_transform(glm::mat2 const&) override {}
     void suspend() override {}
+    unsigned int buffer_age() const override { return 0; }
+    void set_damage(geometry::Rectangles const&) override {}
+    std::size_t bytes_uploaded() const override { return 0; }
 
     void render(graphics::RenderableList const& renderables) const override
     {
@@ -616,6 +616,32 @@ int drmHandleEvent(int fd, drmEventContextPtr evctx)
     return global_mock->drmHandleEvent(fd, evctx);
 }
 
+// libdrm keeps this opaque; tests only ever see pointers to it
+struct _drmModeAtomicReq
+{
+};
+
+drmModeAtomicReqPtr drmModeAtomicAlloc()
+{
+    return new _drmModeAtomicReq;
+}
+
+void drmModeAtomicFree(drmModeAtomicReqPtr req)
+{
+    delete req;
+}
+
+int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id,
+                             uint32_t property_id, uint64_t value)
+{
+    return global_mock->drmModeAtomicAddProperty(req, object_id, property_id, value);
+}
+
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void *user_data)
+{
+    return global_mock->drmModeAtomicCommit(fd, req, flags, user_data);
+}
+
 int drmGetMagic(int fd, drm_magic_t *magic)
 {
     return global_mock->drmGetMagic(fd, magic);
@@ -29,6 +29,8 @@
 #include <xkbcommon/xkbcommon.h>
 
 #include <linux/input.h>
+#include <cstring>
+#include <memory>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -499,3 +501,42 @@ TEST_F(XKBMapperWithUsKeymap, compose_key_sequence_contains_text_on_key_down)
     map_event(keyboard, mir_keyboard_action_down, KEY_U);
     map_event(keyboard, mir_keyboard_action_up, KEY_U);
 }
+
+TEST(SharedKeymap, is_compiled_once_for_the_same_names)
+{
+    auto const first = mi::make_shared_keymap(mi::Keymap{"pc105", "de", "", ""});
+    auto const second = mi::make_shared_keymap(mi::Keymap{"pc105", "de", "", ""});
+
+    EXPECT_THAT(second, Eq(first));
+    EXPECT_THAT(mi::make_shared_keymap(mi::Keymap{"pc105", "fr", "", ""}), Ne(first));
+}
+
+TEST(SharedKeymap, is_compiled_once_for_the_same_text)
+{
+    auto const names_keymap = mi::make_shared_keymap(mi::Keymap{});
+    std::unique_ptr<char, void(*)(void*)> const text{
+        xkb_keymap_get_as_string(names_keymap.get(), XKB_KEYMAP_FORMAT_TEXT_V1), &free};
+
+    auto const first = mi::make_shared_keymap(text.get(), strlen(text.get()));
+    auto const second = mi::make_shared_keymap(text.get(), strlen(text.get()));
+
+    EXPECT_THAT(second, Eq(first));
+}
+
+TEST(SharedKeymap, states_of_a_shared_keymap_are_independent)
+{
+    auto const keymap = mi::make_shared_keymap(mi::Keymap{});
+    auto const shifted = mi::make_unique_state(keymap.get());
+    auto const unshifted = mi::make_unique_state(keymap.get());
+
+    auto const xkb_offset = 8;
+    xkb_state_update_key(shifted.get(), KEY_LEFTSHIFT + xkb_offset, XKB_KEY_DOWN);
+
+    EXPECT_THAT(xkb_state_key_get_one_sym(shifted.get(), KEY_A + xkb_offset), Eq(XKB_KEY_A));
+    EXPECT_THAT(xkb_state_key_get_one_sym(unshifted.get(), KEY_A + xkb_offset), Eq(XKB_KEY_a));
+}
+
+TEST(SharedKeymap, rejects_unknown_names)
+{
+    EXPECT_THROW(mi::make_shared_keymap(mi::Keymap{"pc105", "no-such-layout", "", ""}), std::invalid_argument);
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/damage_tracker.h"
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+namespace
+{
+struct DamagedRenderable : mtd::FakeRenderable
+{
+    using FakeRenderable::FakeRenderable;
+
+    std::experimental::optional<geom::Rectangles> buffer_damage() const override
+    {
+        return damage;
+    }
+
+    geom::Rectangles damage;
+};
+
+// The same renderable as an earlier one, in a new position
+struct MovedRenderable : mtd::FakeRenderable
+{
+    MovedRenderable(geom::Rectangle const& position, ID id) :
+        FakeRenderable{position},
+        id_{id}
+    {
+    }
+
+    ID id() const override
+    {
+        return id_;
+    }
+
+    ID const id_;
+};
+
+struct DamageTracker : Test
+{
+    geom::Rectangle const area{{0, 0}, {1920, 1080}};
+    glm::mat2 const no_transformation{1};
+    mc::DamageTracker tracker;
+};
+}
+
+TEST_F(DamageTracker, first_frame_damages_everything)
+{
+    auto const window = std::make_shared<mtd::FakeRenderable>(10, 10, 100, 100);
+
+    EXPECT_THAT(tracker.damage_for({window}, area, no_transformation, 1), Eq(geom::Rectangles{area}));
+}
+
+TEST_F(DamageTracker, unchanged_frame_has_no_damage)
+{
+    auto const window = std::make_shared<mtd::FakeRenderable>(10, 10, 100, 100);
+
+    tracker.damage_for({window}, area, no_transformation, 0);
+
+    EXPECT_THAT(tracker.damage_for({window}, area, no_transformation, 1), Eq(geom::Rectangles{}));
+}
+
+TEST_F(DamageTracker, undefined_buffer_contents_damage_everything)
+{
+    auto const window = std::make_shared<mtd::FakeRenderable>(10, 10, 100, 100);
+
+    tracker.damage_for({window}, area, no_transformation, 0);
+
+    EXPECT_THAT(tracker.damage_for({window}, area, no_transformation, 0), Eq(geom::Rectangles{area}));
+}
+
+TEST_F(DamageTracker, new_buffer_without_damage_tracking_damages_whole_renderable)
+{
+    geom::Rectangle const position{{10, 10}, {100, 100}};
+    auto const window = std::make_shared<mtd::FakeRenderable>(position);
+
+    tracker.damage_for({window}, area, no_transformation, 0);
+    window->set_buffer(std::make_shared<mtd::StubBuffer>());
+
+    EXPECT_THAT(tracker.damage_for({window}, area, no_transformation, 1), Eq(geom::Rectangles{position}));
+}
+
+TEST_F(DamageTracker, buffer_damage_is_offset_to_screen_position)
+{
+    auto const window = std::make_shared<DamagedRenderable>(10, 20, 100, 100);
+    window->set_buffer(std::make_shared<mtd::StubBuffer>(geom::Size{100, 100}));
+
+    tracker.damage_for({window}, area, no_transformation, 0);
+    window->damage = {{{5, 5}, {16, 16}}};
+
+    EXPECT_THAT(tracker.damage_for({window}, area, no_transformation, 1),
+        Eq(geom::Rectangles{{{15, 25}, {16, 16}}}));
+}
+
+TEST_F(DamageTracker, buffer_damage_is_scaled_to_screen_position)
+{
+    auto const window = std::make_shared<DamagedRenderable>(0, 0, 200, 200);
+    window->set_buffer(std::make_shared<mtd::StubBuffer>(geom::Size{100, 100}));
+
+    tracker.damage_for({window}, area, no_transformation, 0);
+    window->damage = {{{5, 5}, {16, 16}}};
+
+    EXPECT_THAT(tracker.damage_for({window}, area, no_transformation, 1),
+        Eq(geom::Rectangles{{{10, 10}, {32, 32}}}));
+}
+
+TEST_F(DamageTracker, moving_damages_old_and_new_positions)
+{
+    geom::Rectangle const before{{10, 10}, {100, 100}};
+    geom::Rectangle const after{{50, 60}, {100, 100}};
+    auto const window = std::make_shared<mtd::FakeRenderable>(before);
+
+    tracker.damage_for({window}, area, no_transformation, 0);
+
+    EXPECT_THAT(tracker.damage_for({std::make_shared<MovedRenderable>(after, window->id())}, area, no_transformation, 1),
+        Eq(geom::Rectangles{before, after}));
+}
+
+TEST_F(DamageTracker, removing_damages_old_position)
+{
+    geom::Rectangle const position{{10, 10}, {100, 100}};
+    auto const window = std::make_shared<mtd::FakeRenderable>(position);
+
+    tracker.damage_for({window}, area, no_transformation, 0);
+
+    EXPECT_THAT(tracker.damage_for({}, area, no_transformation, 1), Eq(geom::Rectangles{position}));
+}
+
+TEST_F(DamageTracker, restacking_damages_restacked_renderables)
+{
+    geom::Rectangle const bottom_position{{10, 10}, {100, 100}};
+    geom::Rectangle const top_position{{50, 50}, {100, 100}};
+    auto const bottom = std::make_shared<mtd::FakeRenderable>(bottom_position);
+    auto const top = std::make_shared<mtd::FakeRenderable>(top_position);
+
+    tracker.damage_for({bottom, top}, area, no_transformation, 0);
+
+    auto const damage = tracker.damage_for({top, bottom}, area, no_transformation, 1);
+
+    for (auto const& r : damage)
+        EXPECT_TRUE(r == bottom_position || r == top_position);
+    EXPECT_THAT(damage.bounding_rectangle(), Eq(geom::Rectangle{{10, 10}, {140, 140}}));
+}
+
+TEST_F(DamageTracker, older_buffers_accumulate_damage_of_previous_frames)
+{
+    geom::Rectangle const first{{10, 10}, {100, 100}};
+    geom::Rectangle const second{{500, 500}, {100, 100}};
+    auto const first_window = std::make_shared<mtd::FakeRenderable>(first);
+    auto const second_window = std::make_shared<mtd::FakeRenderable>(second);
+
+    tracker.damage_for({}, area, no_transformation, 0);
+    tracker.damage_for({first_window}, area, no_transformation, 1);
+
+    EXPECT_THAT(tracker.damage_for({first_window, second_window}, area, no_transformation, 2),
+        Eq(geom::Rectangles{first, second}));
+}
+
+TEST_F(DamageTracker, changing_output_damages_everything)
+{
+    geom::Rectangle const other_area{{1920, 0}, {1920, 1080}};
+    auto const window = std::make_shared<mtd::FakeRenderable>(10, 10, 100, 100);
+
+    tracker.damage_for({window}, area, no_transformation, 0);
+
+    EXPECT_THAT(tracker.damage_for({window}, other_area, no_transformation, 1), Eq(geom::Rectangles{other_area}));
+}
+
+TEST_F(DamageTracker, reset_damages_everything)
+{
+    auto const window = std::make_shared<mtd::FakeRenderable>(10, 10, 100, 100);
+
+    tracker.damage_for({window}, area, no_transformation, 0);
+    tracker.reset();
+
+    EXPECT_THAT(tracker.damage_for({window}, area, no_transformation, 1), Eq(geom::Rectangles{area}));
+}
@@ -143,6 +143,8 @@ TEST_F(DefaultDisplayBufferCompositor, optimization_skips_composition)
         .InSequence(seq);
     EXPECT_CALL(*report, rendered_frame(_))
         .Times(0);
+    EXPECT_CALL(*report, uploaded_textures(_,_))
+        .Times(0);
     EXPECT_CALL(*report, finished_frame(_))
         .InSequence(seq);
 
@@ -171,11 +173,15 @@ TEST_F(DefaultDisplayBufferCompositor, rendering_reports_everything)
         .InSequence(seq);
     EXPECT_CALL(*report, rendered_frame(_))
         .InSequence(seq);
+    EXPECT_CALL(*report, uploaded_textures(_, 1234))
+        .InSequence(seq);
     EXPECT_CALL(*report, finished_frame(_))
         .InSequence(seq);
 
     EXPECT_CALL(mock_renderer, render(_))
         .Times(1);
+    ON_CALL(mock_renderer, bytes_uploaded())
+        .WillByDefault(Return(1234));
 
     mc::DefaultDisplayBufferCompositor compositor(
         display_buffer,
@@ -329,6 +335,45 @@ TEST_F(DefaultDisplayBufferCompositor, occluded_surfaces_are_not_rendered)
     }));
 }
 
+namespace
+{
+// Shows the topmost renderable itself and leaves the rest to be composited
+struct TopmostOverlayDisplayBuffer : testing::NiceMock<mtd::MockDisplayBuffer>
+{
+    bool overlay_where_possible(mg::RenderableList const& renderlist, mg::RenderableList& to_render) override
+    {
+        to_render.assign(renderlist.begin(), renderlist.end() - 1);
+        return false;
+    }
+};
+}
+
+TEST_F(DefaultDisplayBufferCompositor, renders_only_what_the_display_buffer_does_not_overlay)
+{
+    using namespace testing;
+    TopmostOverlayDisplayBuffer partial_display_buffer;
+    ON_CALL(partial_display_buffer, view_area())
+        .WillByDefault(Return(screen));
+    ON_CALL(partial_display_buffer, transformation())
+        .WillByDefault(Return(no_transformation));
+
+    auto report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+
+    mg::RenderableList const everything{big, small};
+    mg::RenderableList const composited{big};
+
+    EXPECT_CALL(*report, renderables_in_frame(_, ContainerEq(everything)));
+    EXPECT_CALL(mock_renderer, render(ContainerEq(composited)));
+    EXPECT_CALL(mock_renderer, suspend())
+        .Times(0);
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        partial_display_buffer,
+        mt::fake_shared(mock_renderer),
+        report);
+    compositor.composite(make_scene_elements({big, small}));
+}
+
 namespace
 {
 struct MockSceneElement : mc::SceneElement
@@ -0,0 +1,92 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/frame_pacer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace std::literals::chrono_literals;
+
+namespace mc = mir::compositor;
+
+namespace
+{
+struct FramePacer : Test
+{
+    void render_frames(int count, std::chrono::nanoseconds render_time)
+    {
+        for (int i = 0; i != count; ++i)
+            pacer.frame_rendered(render_time);
+    }
+
+    mc::FramePacer pacer;
+};
+}
+
+TEST_F(FramePacer, leads_by_slowest_recent_frame_plus_margin)
+{
+    render_frames(16, 3ms);
+    auto const lead_for_fast_frames = pacer.lead_time();
+
+    pacer.frame_rendered(5ms);
+
+    EXPECT_THAT(lead_for_fast_frames, Gt(3ms));
+    EXPECT_THAT(pacer.lead_time(), Eq(lead_for_fast_frames + 2ms));
+}
+
+TEST_F(FramePacer, forgets_slow_frames_eventually)
+{
+    render_frames(16, 3ms);
+    auto const lead_for_fast_frames = pacer.lead_time();
+
+    pacer.frame_rendered(9ms);
+    render_frames(16, 3ms);
+
+    EXPECT_THAT(pacer.lead_time(), Eq(lead_for_fast_frames));
+}
+
+TEST_F(FramePacer, leads_by_more_after_missing_a_vblank)
+{
+    render_frames(16, 3ms);
+    auto const lead_before_miss = pacer.lead_time();
+
+    pacer.vblank_missed();
+
+    EXPECT_THAT(pacer.lead_time(), Gt(lead_before_miss));
+}
+
+TEST_F(FramePacer, margin_shrinks_back_once_vblanks_are_made_again)
+{
+    render_frames(16, 3ms);
+    auto const lead_before_miss = pacer.lead_time();
+
+    pacer.vblank_missed();
+    render_frames(1000, 3ms);
+
+    EXPECT_THAT(pacer.lead_time(), Eq(lead_before_miss));
+}
+
+TEST_F(FramePacer, margin_is_bounded)
+{
+    render_frames(16, 3ms);
+
+    for (int i = 0; i != 100; ++i)
+        pacer.vblank_missed();
+
+    EXPECT_THAT(pacer.lead_time(), Le(3ms + 8ms));
+}
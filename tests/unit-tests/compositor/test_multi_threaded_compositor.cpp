@@ -23,15 +23,18 @@
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/compositor/scene.h"
 #include "mir/compositor/display_buffer_compositor_factory.h"
+#include "mir/compositor/presentation_clock.h"
 #include "mir/scene/observer.h"
 #include "mir/raii.h"
 
 #include "mir/test/current_thread_name.h"
+#include "mir/test/signal.h"
 #include "mir/test/doubles/null_display.h"
 #include "mir/test/doubles/null_display_buffer.h"
 #include "mir/test/doubles/mock_display_buffer.h"
 #include "mir/test/doubles/mock_compositor_report.h"
 #include "mir/test/doubles/mock_scene.h"
+#include "mir/test/doubles/mock_surface.h"
 #include "mir/test/doubles/stub_scene.h"
 #include "mir/test/doubles/stub_display.h"
 #include "mir/test/doubles/null_display_buffer_compositor_factory.h"
@@ -87,6 +90,10 @@ private:
         {
             return std::chrono::milliseconds::zero();
         }
+        std::experimental::optional<mg::Frame> next_vblank() const override
+        {
+            return {};
+        }
         testing::NiceMock<mtd::MockDisplayBuffer> buffer; 
     };
 
@@ -131,6 +138,14 @@ public:
         std::this_thread::yield();
     }
 
+    void emit_surface_added(ms::Surface* surface)
+    {
+        std::lock_guard<std::mutex> lock{observer_mutex};
+
+        if (observer)
+            observer->surface_added(surface);
+    }
+
     void throw_on_add_observer(bool flag)
     {
         throw_on_add_observer_ = flag;
@@ -359,7 +374,38 @@ struct MockDisplayListener : mc::DisplayListener
     MOCK_METHOD1(remove_display, void(geom::Rectangle const& /*area*/));
 };
 
+class VblankPredictingDisplay : public mtd::NullDisplay
+{
+public:
+    VblankPredictingDisplay(mg::Frame::Timestamp const& vblank) : group{vblank} {}
+
+    void for_each_display_sync_group(std::function<void(mg::DisplaySyncGroup&)> const& f) override
+    {
+        f(group);
+    }
+
+private:
+    struct VblankPredictingSyncGroup : mtd::NullDisplaySyncGroup
+    {
+        VblankPredictingSyncGroup(mg::Frame::Timestamp const& vblank)
+        {
+            next.msc = 1;
+            next.ust = vblank;
+        }
+
+        std::experimental::optional<mg::Frame> next_vblank() const override
+        {
+            return next;
+        }
+
+        mg::Frame next;
+    };
+
+    VblankPredictingSyncGroup group;
+};
+
 auto const null_report = mr::null_compositor_report();
+auto const presentation_clock = std::make_shared<mc::PresentationClock>();
 unsigned int const composites_per_update{1};
 auto const null_display_listener = std::make_shared<StubDisplayListener>();
 std::chrono::milliseconds const default_delay{-1};
@@ -375,7 +421,7 @@ TEST(MultiThreadedCompositor, compositing_happens_in_different_threads)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, presentation_clock, default_delay, true};
 
     compositor.start();
 
@@ -388,6 +434,27 @@ TEST(MultiThreadedCompositor, compositing_happens_in_different_threads)
     EXPECT_TRUE(db_compositor_factory->buffers_rendered_in_different_threads());
 }
 
+TEST(MultiThreadedCompositor, reports_presentation_of_posted_frames)
+{
+    using namespace testing;
+
+    auto display = std::make_shared<mtd::StubDisplay>(1);
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto const clock = std::make_shared<mc::PresentationClock>();
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, clock, default_delay, false};
+
+    mt::Signal presented;
+    clock->on_next_presentation([&](mc::PresentationClock::Presentation const&) { presented.raise(); });
+
+    compositor.start();
+    scene->emit_change_event();
+
+    EXPECT_TRUE(presented.wait_for(std::chrono::seconds{5}));
+
+    compositor.stop();
+}
+
 TEST(MultiThreadedCompositor, does_not_deadlock_itself)
 {   // Regression test for LP: #1471909
     auto scene = std::make_shared<StubScene>();
@@ -416,6 +483,7 @@ TEST(MultiThreadedCompositor, does_not_deadlock_itself)
         std::make_shared<mtd::NullDisplayBufferCompositorFactory>(),
         std::make_shared<ReentrantDisplayListener>(scene),
         null_report,
+        presentation_clock,
         default_delay,
         true
     };
@@ -441,6 +509,7 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
                                            db_compositor_factory,
                                            null_display_listener,
                                            mock_report,
+                                           presentation_clock,
                                            default_delay,
                                            true};
 
@@ -486,7 +555,7 @@ TEST(MultiThreadedCompositor, composites_only_on_demand)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, presentation_clock, default_delay, true};
 
     // Verify we're actually starting at zero frames
     EXPECT_TRUE(db_compositor_factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -547,7 +616,7 @@ TEST(MultiThreadedCompositor, schedules_enough_frames)
     auto scene = std::make_shared<StubScene>();
     auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
     mc::MultiThreadedCompositor compositor{display, scene, factory,
-                                           null_display_listener, null_report, default_delay, true};
+                                           null_display_listener, null_report, presentation_clock, default_delay, true};
 
     EXPECT_TRUE(factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
 
@@ -610,6 +679,47 @@ TEST(MultiThreadedCompositor, schedules_enough_frames)
     compositor.stop();
 }
 
+TEST(MultiThreadedCompositor, wakes_only_displays_a_surface_change_touches)
+{
+    using namespace testing;
+
+    auto display = std::make_shared<StubDisplayWithMockBuffers>(2);
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto mock_report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+
+    int next_x{0};
+    display->for_each_mock_buffer([&next_x](mtd::MockDisplayBuffer& mock_buf)
+    {
+        ON_CALL(mock_buf, view_area())
+            .WillByDefault(Return(geom::Rectangle{{next_x, 0}, {100, 100}}));
+        next_x += 100;
+    });
+
+    NiceMock<mtd::MockSurface> surface;
+    ON_CALL(surface, visible()).WillByDefault(Return(true));
+    ON_CALL(surface, size()).WillByDefault(Return(geom::Size{50, 50}));
+
+    mc::MultiThreadedCompositor compositor{display, scene,
+                                           db_compositor_factory,
+                                           null_display_listener,
+                                           mock_report,
+                                           presentation_clock,
+                                           default_delay,
+                                           true};
+
+    compositor.start();
+    while (!db_compositor_factory->check_record_count_for_each_buffer(2, composites_per_update))
+        std::this_thread::yield();
+
+    // The surface is only on the first display
+    EXPECT_CALL(*mock_report, skipped_wakeup(_)).Times(1);
+
+    scene->emit_surface_added(&surface);
+
+    compositor.stop();
+}
+
 TEST(MultiThreadedCompositor, recommended_sleep_throttles_compositor_loop)
 {
     using namespace testing;
@@ -623,6 +733,7 @@ TEST(MultiThreadedCompositor, recommended_sleep_throttles_compositor_loop)
     auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
     mc::MultiThreadedCompositor compositor{display, scene, factory,
                                            null_display_listener, null_report,
+                                           presentation_clock,
                                            recommendation, false};
 
     EXPECT_TRUE(factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -662,6 +773,42 @@ TEST(MultiThreadedCompositor, recommended_sleep_throttles_compositor_loop)
     compositor.stop();
 }
 
+TEST(MultiThreadedCompositor, waits_until_just_before_predicted_vblank_to_composite)
+{
+    using namespace testing;
+    using namespace std::chrono;
+
+    milliseconds const time_to_vblank{200};
+    auto const start = mg::Frame::Timestamp::now(CLOCK_MONOTONIC);
+
+    auto display = std::make_shared<VblankPredictingDisplay>(start + time_to_vblank);
+    auto scene = std::make_shared<StubScene>();
+    auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    mc::MultiThreadedCompositor compositor{display, scene, factory,
+                                           null_display_listener, null_report,
+                                           presentation_clock,
+                                           default_delay, true};
+
+    compositor.start();
+
+    int const max_retries = 100;
+    int retry = 0;
+    while (retry < max_retries &&
+           !factory->check_record_count_for_each_buffer(1, 1))
+    {
+        std::this_thread::sleep_for(milliseconds(10));
+        ++retry;
+    }
+    ASSERT_LT(retry, max_retries);
+
+    // Rendering nothing can't be predicted to take anything like 50ms
+    auto const waited = mg::Frame::Timestamp::now(CLOCK_MONOTONIC) - start;
+    EXPECT_THAT(duration_cast<milliseconds>(waited).count(),
+                Ge((time_to_vblank - 50ms).count()));
+
+    compositor.stop();
+}
+
 TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_there_is_none)
 {
     using namespace testing;
@@ -671,7 +818,7 @@ TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_there_is_none)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, false};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, presentation_clock, default_delay, false};
 
     // Verify we're actually starting at zero frames
     ASSERT_TRUE(db_compositor_factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -694,7 +841,7 @@ TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_we_still_compo
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, false};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, presentation_clock, default_delay, false};
 
     compositor.start();
 
@@ -729,7 +876,7 @@ TEST(MultiThreadedCompositor, surface_update_from_render_doesnt_deadlock)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<SurfaceUpdatingDisplayBufferCompositorFactory>(scene);
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, presentation_clock, default_delay, true};
 
     compositor.start();
 
@@ -761,7 +908,7 @@ TEST(MultiThreadedCompositor, double_start_or_stop_ignored)
         .Times(AtLeast(0))
         .WillRepeatedly(Return(mc::SceneElementSequence{}));
 
-    mc::MultiThreadedCompositor compositor{display, mock_scene, db_compositor_factory, null_display_listener, mock_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, mock_scene, db_compositor_factory, null_display_listener, mock_report, presentation_clock, default_delay, true};
 
     compositor.start();
     compositor.start();
@@ -776,7 +923,7 @@ TEST(MultiThreadedCompositor, cleans_up_after_throw_in_start)
     auto display = std::make_shared<StubDisplayWithMockBuffers>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, presentation_clock, default_delay, true};
 
     scene->throw_on_add_observer(true);
 
@@ -826,7 +973,7 @@ TEST(MultiThreadedCompositor, names_compositor_threads)
     auto display = std::make_shared<StubDisplayWithMockBuffers>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<ThreadNameDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, presentation_clock, default_delay, true};
 
     compositor.start();
 
@@ -855,7 +1002,7 @@ TEST(MultiThreadedCompositor, registers_and_unregisters_with_scene)
     EXPECT_CALL(*mock_scene, register_compositor(_))
         .Times(nbuffers);
     mc::MultiThreadedCompositor compositor{
-        display, mock_scene, db_compositor_factory, null_display_listener, mock_report, default_delay, true};
+        display, mock_scene, db_compositor_factory, null_display_listener, mock_report, presentation_clock, default_delay, true};
 
     compositor.start();
 
@@ -878,7 +1025,7 @@ TEST(MultiThreadedCompositor, notifies_about_display_additions_and_removals)
     auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, presentation_clock, default_delay, true};
 
     EXPECT_CALL(*mock_display_listener, add_display(_)).Times(nbuffers);
 
@@ -900,7 +1047,7 @@ TEST(MultiThreadedCompositor, when_compositor_thread_fails_start_reports_error)
     auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, presentation_clock, default_delay, true};
 
     EXPECT_CALL(*mock_display_listener, add_display(_))
         .WillRepeatedly(Throw(std::runtime_error("Failed to add display")));
@@ -923,7 +1070,7 @@ TEST(MultiThreadedCompositor, can_schedule_from_display_observer_when_adding_dis
         .WillByDefault(InvokeWithoutArgs([&]{ stub_scene->emit_change_event(); }));
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, presentation_clock, default_delay, true};
     compositor.start();
 }
 
@@ -941,6 +1088,6 @@ TEST(MultiThreadedCompositor, can_schedule_from_display_observer_when_removing_d
         .WillByDefault(InvokeWithoutArgs([&]{ stub_scene->emit_change_event(); }));
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, presentation_clock, default_delay, true};
     compositor.start();
 }
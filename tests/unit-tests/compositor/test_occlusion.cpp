@@ -202,3 +202,55 @@ TEST_F(OcclusionFilterTest,
     EXPECT_THAT(renderables_from(occlusions), ElementsAre(partially_onscreen));
     EXPECT_THAT(renderables_from(elements), ElementsAre(covering));
 }
+
+TEST_F(OcclusionFilterTest, window_covered_by_several_others_together_is_occluded)
+{
+    auto left = std::make_shared<mtd::FakeRenderable>(0, 0, 60, 100);
+    auto right = std::make_shared<mtd::FakeRenderable>(50, 0, 50, 100);
+    auto bottom = std::make_shared<mtd::FakeRenderable>(10, 10, 80, 80);
+    auto elements = scene_elements_from({bottom, left, right});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(bottom));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(left, right));
+}
+
+TEST_F(OcclusionFilterTest, shaped_window_occludes_what_is_beneath_its_opaque_region)
+{
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{10, 10}, {100, 100}}, 1.0f, false);
+    top->set_opaque_region(Rectangle{{20, 20}, {80, 80}});
+    auto bottom = std::make_shared<mtd::FakeRenderable>(30, 30, 50, 50);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(bottom));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(top));
+}
+
+TEST_F(OcclusionFilterTest, shaped_window_does_not_occlude_beyond_its_opaque_region)
+{
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{10, 10}, {100, 100}}, 1.0f, false);
+    top->set_opaque_region(Rectangle{{20, 20}, {80, 80}});
+    auto bottom = std::make_shared<mtd::FakeRenderable>(15, 15, 50, 50);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
+}
+
+TEST_F(OcclusionFilterTest, translucent_window_with_opaque_region_occludes_nothing)
+{
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{10, 10}, {100, 100}}, 0.5f, false);
+    top->set_opaque_region(Rectangle{{10, 10}, {100, 100}});
+    auto bottom = std::make_shared<mtd::FakeRenderable>(30, 30, 50, 50);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mir/compositor/presentation_clock.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+
+using namespace testing;
+using namespace std::literals::chrono_literals;
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+
+namespace
+{
+struct PresentationClock : Test
+{
+    void record_presentations()
+    {
+        clock.on_next_presentation(
+            [this](mc::PresentationClock::Presentation const& presentation)
+            {
+                presentations.push_back(presentation);
+            });
+    }
+
+    /// Requests presentations as the compositor thread of output does
+    void record_presentations_of(void const* output)
+    {
+        std::thread{[this, output]
+            {
+                clock.compositing(output);
+                record_presentations();
+            }}.join();
+    }
+
+    void const* const output = "output";
+    mc::PresentationClock clock;
+    std::vector<mc::PresentationClock::Presentation> presentations;
+};
+}
+
+TEST_F(PresentationClock, reports_vblank_of_the_next_frame_only)
+{
+    mg::Frame vblank;
+    vblank.msc = 42;
+    vblank.ust = mir::time::PosixTimestamp::now(clock.clock_id()) + 5ms;
+
+    record_presentations();
+    clock.frame_presented(output, vblank, 16ms);
+    clock.frame_presented(output, vblank, 16ms);
+
+    ASSERT_THAT(presentations.size(), Eq(1u));
+    EXPECT_THAT(presentations[0].time, Eq(vblank.ust));
+    EXPECT_THAT(presentations[0].msc, Eq(42));
+    EXPECT_THAT(presentations[0].refresh, Eq(16ms));
+    EXPECT_TRUE(presentations[0].vsync);
+}
+
+TEST_F(PresentationClock, frame_without_vblank_is_presented_now_without_vsync)
+{
+    auto const before = mir::time::PosixTimestamp::now(clock.clock_id());
+
+    record_presentations();
+    clock.frame_presented(output, {}, 0ns);
+
+    ASSERT_THAT(presentations.size(), Eq(1u));
+    EXPECT_THAT(presentations[0].time, Ge(before));
+    EXPECT_THAT(presentations[0].time, Le(mir::time::PosixTimestamp::now(clock.clock_id())));
+    EXPECT_THAT(presentations[0].msc, Eq(0));
+    EXPECT_FALSE(presentations[0].vsync);
+}
+
+TEST_F(PresentationClock, converts_vblank_timestamps_to_the_presentation_clock)
+{
+    mg::Frame vblank;
+    vblank.msc = 1;
+    vblank.ust = mir::time::PosixTimestamp::now(CLOCK_REALTIME) + 10ms;
+
+    auto const expected = mir::time::PosixTimestamp::now(clock.clock_id()) + 10ms;
+
+    record_presentations();
+    clock.frame_presented(output, vblank, 16ms);
+
+    ASSERT_THAT(presentations.size(), Eq(1u));
+    EXPECT_THAT(presentations[0].time.clock_id, Eq(clock.clock_id()));
+    EXPECT_THAT((presentations[0].time - expected).count(), Lt(std::chrono::nanoseconds{1ms}.count()));
+    EXPECT_THAT((expected - presentations[0].time).count(), Lt(std::chrono::nanoseconds{1ms}.count()));
+}
+
+TEST_F(PresentationClock, waits_for_the_output_that_was_compositing)
+{
+    void const* const left = "left";
+    void const* const right = "right";
+
+    record_presentations_of(left);
+    clock.frame_presented(right, {}, 16ms);
+
+    EXPECT_THAT(presentations.size(), Eq(0u));
+
+    clock.frame_presented(left, {}, 16ms);
+
+    EXPECT_THAT(presentations.size(), Eq(1u));
+}
+
+TEST_F(PresentationClock, presentations_of_a_stopped_output_wait_for_any_other)
+{
+    void const* const left = "left";
+    void const* const right = "right";
+
+    record_presentations_of(left);
+    clock.stopped_compositing(left);
+    clock.frame_presented(right, {}, 16ms);
+
+    EXPECT_THAT(presentations.size(), Eq(1u));
+}
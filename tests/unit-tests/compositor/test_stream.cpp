@@ -226,3 +226,85 @@ TEST_F(Stream, returns_buffers_to_client_when_told_to_bring_queue_up_to_date)
     EXPECT_THAT(buffers[1].use_count(), Eq(1));
     EXPECT_THAT(buffers[2].use_count(), Eq(2));
 }
+
+TEST_F(Stream, reports_damage_of_buffer_acquired_since_last_acquisition)
+{
+    geom::Rectangle const damage{{1, 0}, {2, 1}};
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+
+    stream.submit_damaged_buffer(buffers[1], {damage});
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.compositor_buffer_damage(this), Eq(geom::Rectangles{damage}));
+}
+
+TEST_F(Stream, reports_whole_buffer_damaged_the_first_time_it_is_acquired)
+{
+    stream.submit_damaged_buffer(buffers[0], {{{1, 0}, {2, 1}}});
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.compositor_buffer_damage(this), Eq(geom::Rectangles{{{}, initial_size}}));
+}
+
+TEST_F(Stream, reports_whole_buffer_damaged_after_undamaged_submission)
+{
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+
+    stream.submit_buffer(buffers[1]);
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.compositor_buffer_damage(this), Eq(geom::Rectangles{{{}, initial_size}}));
+}
+
+TEST_F(Stream, reports_no_damage_when_reacquiring_the_same_buffer)
+{
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.compositor_buffer_damage(this), Eq(geom::Rectangles{}));
+}
+
+TEST_F(Stream, accumulates_damage_of_dropped_buffers)
+{
+    geom::Rectangle const first_damage{{0, 0}, {1, 1}};
+    geom::Rectangle const second_damage{{3, 1}, {1, 1}};
+    stream.allow_framedropping(true);
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+
+    stream.submit_damaged_buffer(buffers[1], {first_damage});
+    stream.submit_damaged_buffer(buffers[2], {second_damage});
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.compositor_buffer_damage(this), Eq(geom::Rectangles{first_damage, second_damage}));
+}
+
+TEST_F(Stream, tracks_damage_separately_for_each_compositor)
+{
+    int other_compositor;
+    geom::Rectangle const damage{{1, 0}, {2, 1}};
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+    stream.lock_compositor_buffer(&other_compositor);
+
+    stream.submit_damaged_buffer(buffers[1], {damage});
+    stream.lock_compositor_buffer(this);
+    stream.lock_compositor_buffer(&other_compositor);
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.compositor_buffer_damage(this), Eq(geom::Rectangles{}));
+    EXPECT_THAT(stream.compositor_buffer_damage(&other_compositor), Eq(geom::Rectangles{damage}));
+}
+
+TEST_F(Stream, has_no_opaque_region_until_one_is_set)
+{
+    EXPECT_TRUE(stream.opaque_region().empty());
+
+    geom::Region const opaque{geom::Rectangle{{1, 1}, {2, 2}}};
+    stream.set_opaque_region(opaque);
+
+    EXPECT_THAT(stream.opaque_region(), Eq(opaque));
+}
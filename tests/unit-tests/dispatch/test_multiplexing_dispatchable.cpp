@@ -490,3 +490,90 @@ TEST(MultiplexingDispatchableTest, automatic_removals_are_threadsafe)
     
     dispatchee->trigger();
 }
+
+TEST(MultiplexingDispatchableTest, batched_dispatch_dispatches_every_ready_dispatchee)
+{
+    int dispatched{0};
+    std::vector<std::shared_ptr<mt::TestDispatchable>> dispatchees;
+    md::MultiplexingDispatchable dispatcher(4);
+
+    for (int i = 0; i != 3; ++i)
+    {
+        dispatchees.push_back(std::make_shared<mt::TestDispatchable>([&dispatched]() { ++dispatched; }));
+        dispatcher.add_watch(dispatchees.back());
+        dispatchees.back()->trigger();
+    }
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatched, testing::Eq(3));
+    EXPECT_FALSE(mt::fd_is_readable(dispatcher.watch_fd()));
+}
+
+TEST(MultiplexingDispatchableTest, batched_dispatch_dispatches_no_more_than_batch_size)
+{
+    int dispatched{0};
+    std::vector<std::shared_ptr<mt::TestDispatchable>> dispatchees;
+    md::MultiplexingDispatchable dispatcher(2);
+
+    for (int i = 0; i != 3; ++i)
+    {
+        dispatchees.push_back(std::make_shared<mt::TestDispatchable>([&dispatched]() { ++dispatched; }));
+        dispatcher.add_watch(dispatchees.back());
+        dispatchees.back()->trigger();
+    }
+
+    dispatcher.dispatch(md::FdEvent::readable);
+    EXPECT_THAT(dispatched, testing::Eq(2));
+
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+    EXPECT_THAT(dispatched, testing::Eq(3));
+}
+
+TEST(MultiplexingDispatchableTest, batched_dispatch_rearms_sequential_dispatchees)
+{
+    int dispatched{0};
+    auto dispatchee = std::make_shared<mt::TestDispatchable>([&dispatched]() { ++dispatched; });
+    md::MultiplexingDispatchable dispatcher(4);
+    dispatcher.add_watch(dispatchee);
+
+    dispatchee->trigger();
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    dispatchee->trigger();
+    ASSERT_TRUE(mt::fd_is_readable(dispatcher.watch_fd()));
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatched, testing::Eq(2));
+}
+
+TEST(MultiplexingDispatchableTest, batched_dispatch_skips_dispatchee_removed_earlier_in_batch)
+{
+    int dispatched{0};
+    md::MultiplexingDispatchable dispatcher(4);
+    std::shared_ptr<mt::TestDispatchable> first, second;
+
+    // Whichever is dispatched first removes the other
+    first = std::make_shared<mt::TestDispatchable>(
+        [&]() { ++dispatched; dispatcher.remove_watch(second); });
+    second = std::make_shared<mt::TestDispatchable>(
+        [&]() { ++dispatched; dispatcher.remove_watch(first); });
+
+    dispatcher.add_watch(first);
+    dispatcher.add_watch(second);
+    first->trigger();
+    second->trigger();
+
+    dispatcher.dispatch(md::FdEvent::readable);
+
+    EXPECT_THAT(dispatched, testing::Eq(1));
+}
+
+TEST(MultiplexingDispatchableTest, rejects_invalid_batch_size)
+{
+    EXPECT_THROW(md::MultiplexingDispatchable(0), std::invalid_argument);
+    EXPECT_THROW(md::MultiplexingDispatchable(md::MultiplexingDispatchable::max_dispatch_batch + 1),
+                 std::invalid_argument);
+}
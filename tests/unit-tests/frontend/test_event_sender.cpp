@@ -21,7 +21,9 @@
 
 #include "src/server/frontend/message_sender.h"
 #include "src/server/frontend/event_sender.h"
+#include "mir/frontend/event_batch.h"
 
+#include "mir/events/event.h"
 #include "mir/events/event_builders.h"
 #include "mir/client_visible_error.h"
 
@@ -112,7 +114,10 @@ struct MockMsgSender : public mf::MessageSender
 struct EventSender : public testing::Test
 {
     EventSender()
-        : event_sender(mt::fake_shared(mock_msg_sender), mt::fake_shared(mock_buffer_packer))
+        : event_sender(
+            mt::fake_shared(mock_msg_sender),
+            mt::fake_shared(mock_buffer_packer),
+            mir::input::MotionCoalescing::pointer)
     {
     }
     MockMsgSender mock_msg_sender;
@@ -307,3 +312,189 @@ TEST_F(EventSender, sends_errors)
 
     event_sender.handle_error(error);
 }
+
+TEST_F(EventSender, sends_events_raised_during_a_batch_as_one_message_when_it_ends)
+{
+    using namespace testing;
+
+    auto msg_validator = make_validator(
+        [](auto const& seq)
+        {
+            ASSERT_THAT(seq.event_size(), Eq(3));
+            for (auto i = 0; i != seq.event_size(); ++i)
+            {
+                auto const ev = MirEvent::deserialize(seq.event(i).raw());
+                EXPECT_THAT(mir_event_get_type(ev.get()), Eq(mir_event_type_resize));
+                EXPECT_THAT(mir_resize_event_get_width(mir_event_get_resize_event(ev.get())), Eq(i + 1));
+            }
+        });
+
+    {
+        mf::EventBatch batch;
+
+        EXPECT_CALL(mock_msg_sender, send(_, _, _)).Times(0);
+        for (auto i = 1; i != 4; ++i)
+            event_sender.handle_event(mev::make_event(mf::SurfaceId{1}, {i, i}));
+
+        Mock::VerifyAndClearExpectations(&mock_msg_sender);
+        EXPECT_CALL(mock_msg_sender, send(_, _, _))
+            .Times(1)
+            .WillOnce(Invoke(msg_validator));
+    }
+}
+
+TEST_F(EventSender, sends_events_once_the_outermost_batch_ends)
+{
+    using namespace testing;
+
+    mf::EventBatch outer;
+    {
+        mf::EventBatch inner;
+        event_sender.handle_event(mev::make_event(mf::SurfaceId{1}, {10, 10}));
+    }
+
+    EXPECT_TRUE(mf::EventBatch::in_progress());
+    Mock::VerifyAndClearExpectations(&mock_msg_sender);
+    EXPECT_CALL(mock_msg_sender, send(_, _, _)).Times(1);
+}
+
+TEST_F(EventSender, sends_pending_events_before_other_messages)
+{
+    using namespace testing;
+
+    mtd::StubDisplayConfig config;
+
+    mf::EventBatch batch;
+    event_sender.handle_event(mev::make_event(mf::SurfaceId{1}, {10, 10}));
+
+    InSequence seq;
+    EXPECT_CALL(mock_msg_sender, send(_, _, _))
+        .WillOnce(Invoke(make_validator(
+            [](auto const& seq)
+            {
+                EXPECT_THAT(seq.event_size(), Eq(1));
+                EXPECT_FALSE(seq.has_display_configuration());
+            })));
+    EXPECT_CALL(mock_msg_sender, send(_, _, _))
+        .WillOnce(Invoke(make_validator(
+            [](auto const& seq)
+            {
+                EXPECT_THAT(seq.event_size(), Eq(0));
+                EXPECT_TRUE(seq.has_display_configuration());
+            })));
+
+    event_sender.handle_display_config_change(config);
+}
+
+TEST_F(EventSender, merges_pointer_motion_raised_during_a_batch)
+{
+    using namespace testing;
+
+    auto const motion = [](float x, float dx)
+        {
+            return mev::make_event(MirInputDeviceId{1}, std::chrono::nanoseconds{0}, std::vector<uint8_t>{},
+                mir_input_event_modifier_none, mir_pointer_action_motion, 0, x, 0, 0, 0, dx, 0);
+        };
+
+    auto msg_validator = make_validator(
+        [](auto const& seq)
+        {
+            ASSERT_THAT(seq.event_size(), Eq(1));
+            auto const ev = MirEvent::deserialize(seq.event(0).raw());
+            auto const pointer = mir_input_event_get_pointer_event(mir_event_get_input_event(ev.get()));
+            EXPECT_THAT(mir_pointer_event_axis_value(pointer, mir_pointer_axis_x), FloatEq(30));
+            EXPECT_THAT(mir_pointer_event_axis_value(pointer, mir_pointer_axis_relative_x), FloatEq(6));
+        });
+
+    EXPECT_CALL(mock_msg_sender, send(_, _, _))
+        .Times(1)
+        .WillOnce(Invoke(msg_validator));
+
+    mf::EventBatch batch;
+    event_sender.handle_event(motion(10, 1));
+    event_sender.handle_event(motion(20, 2));
+    event_sender.handle_event(motion(30, 3));
+}
+
+TEST_F(EventSender, sends_pointer_motion_as_coalescible)
+{
+    using namespace testing;
+
+    struct MockCoalescingMsgSender : MockMsgSender
+    {
+        MOCK_METHOD2(send_coalescible, void(char const*, size_t));
+    } sender;
+    mfd::EventSender coalescing_event_sender{
+        mt::fake_shared(sender),
+        mt::fake_shared(mock_buffer_packer),
+        mir::input::MotionCoalescing::pointer};
+
+    auto const motion = mev::make_event(MirInputDeviceId{1}, std::chrono::nanoseconds{0}, std::vector<uint8_t>{},
+        mir_input_event_modifier_none, mir_pointer_action_motion, 0, 10, 0, 0, 0, 0, 0);
+    auto const relative_motion = mev::make_event(MirInputDeviceId{1}, std::chrono::nanoseconds{0}, std::vector<uint8_t>{},
+        mir_input_event_modifier_none, mir_pointer_action_motion, 0, 11, 0, 0, 0, 1, 0);
+    auto const button = mev::make_event(MirInputDeviceId{1}, std::chrono::nanoseconds{0}, std::vector<uint8_t>{},
+        mir_input_event_modifier_none, mir_pointer_action_button_down, mir_pointer_button_primary, 10, 0, 0, 0, 0, 0);
+
+    InSequence seq;
+    EXPECT_CALL(sender, send_coalescible(_, _));
+    EXPECT_CALL(sender, send(_, _, _)).Times(2);
+
+    coalescing_event_sender.handle_event(mev::clone_event(*motion));
+    // Dropping relative motion would lose it
+    coalescing_event_sender.handle_event(mev::clone_event(*relative_motion));
+    coalescing_event_sender.handle_event(mev::clone_event(*button));
+}
+
+TEST_F(EventSender, merges_pointer_motion_into_the_motion_the_client_is_yet_to_receive)
+{
+    using namespace testing;
+
+    struct MockStreamingMsgSender : MockMsgSender
+    {
+        MOCK_METHOD4(send_in_stream, void(mf::MessageStream const&, char const*, size_t, bool));
+        MOCK_METHOD4(replace_unsent, bool(mf::MessageStream const&, char const*, size_t, bool));
+    } sender;
+    mfd::EventSender streaming_event_sender{
+        mt::fake_shared(sender),
+        mt::fake_shared(mock_buffer_packer),
+        mir::input::MotionCoalescing::pointer};
+
+    auto const motion = [](float x, float dx)
+        {
+            return mev::make_event(MirInputDeviceId{1}, std::chrono::nanoseconds{0}, std::vector<uint8_t>{},
+                mir_input_event_modifier_none, mir_pointer_action_motion, 0, x, 0, 0, 0, dx, 0);
+        };
+
+    auto const motion_is = [](float x, float dx)
+        {
+            return make_validator(
+                [x, dx](auto const& seq)
+                {
+                    ASSERT_THAT(seq.event_size(), Eq(1));
+                    auto const ev = MirEvent::deserialize(seq.event(0).raw());
+                    auto const pointer = mir_input_event_get_pointer_event(mir_event_get_input_event(ev.get()));
+                    EXPECT_THAT(mir_pointer_event_axis_value(pointer, mir_pointer_axis_x), FloatEq(x));
+                    EXPECT_THAT(mir_pointer_event_axis_value(pointer, mir_pointer_axis_relative_x), FloatEq(dx));
+                });
+        };
+
+    InSequence seq;
+    EXPECT_CALL(sender, send_in_stream(_, _, _, false))
+        .WillOnce(WithArgs<1, 2>(Invoke([&](char const* data, size_t len) { motion_is(10, 1)(data, len, {}); })));
+    EXPECT_CALL(sender, replace_unsent(_, _, _, false))
+        .WillOnce(DoAll(
+            WithArgs<1, 2>(Invoke([&](char const* data, size_t len) { motion_is(20, 3)(data, len, {}); })),
+            Return(true)));
+    // Once the client has started to receive it, motion goes in a message of its own
+    EXPECT_CALL(sender, replace_unsent(_, _, _, false))
+        .WillOnce(DoAll(
+            WithArgs<1, 2>(Invoke([&](char const* data, size_t len) { motion_is(30, 6)(data, len, {}); })),
+            Return(false)));
+    EXPECT_CALL(sender, send_in_stream(_, _, _, false))
+        .WillOnce(WithArgs<1, 2>(Invoke([&](char const* data, size_t len) { motion_is(30, 3)(data, len, {}); })));
+
+    streaming_event_sender.handle_event(motion(10, 1));
+    streaming_event_sender.handle_event(motion(20, 2));
+    streaming_event_sender.handle_event(motion(30, 3));
+}
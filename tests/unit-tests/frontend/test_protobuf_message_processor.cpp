@@ -43,6 +43,16 @@ struct StubProtobufMessageSender : mfd::ProtobufMessageSender
     }
 };
 
+struct RecordingProtobufMessageSender : mfd::ProtobufMessageSender
+{
+    void send_response(gp::uint32, gp::MessageLite* response, mf::FdSets const&) override
+    {
+        last_response = response->SerializeAsString();
+    }
+
+    std::string last_response;
+};
+
 struct StubMessageProcessorReport : mf::MessageProcessorReport
 {
     void received_invocation(void const*, int, std::string const&) override
@@ -64,11 +74,20 @@ struct StubMessageProcessorReport : mf::MessageProcessorReport
 
 struct StubDisplayServer : mtd::StubDisplayServer
 {
+    void connect(
+        mp::ConnectParameters const*,
+        mp::Connection*,
+        google::protobuf::Closure* closure) override
+    {
+        closure->Run();
+    }
+
     void create_surface(
         mp::SurfaceParameters const*,
         mp::Surface* response,
         google::protobuf::Closure* closure) override
     {
+        ++create_surface_calls;
         response->mutable_buffer_stream();
         auto before = response->buffer_stream().has_buffer();
         closure->Run();
@@ -89,6 +108,56 @@ struct StubDisplayServer : mtd::StubDisplayServer
 
     bool changed_during_create_surface_closure;
     bool changed_during_create_bstream_closure;
+    int create_surface_calls{0};
+};
+
+struct MockMessageProcessorReport : StubMessageProcessorReport
+{
+    MOCK_METHOD3(unknown_method, void(void const*, int, std::string const&));
+};
+
+std::string serialized(gp::MessageLite const& message)
+{
+    std::string result;
+    message.SerializeToString(&result);
+    return result;
+}
+
+mp::SurfaceParameters surface_parameters()
+{
+    mp::SurfaceParameters request;
+    request.set_width(1);
+    request.set_height(1);
+    request.set_pixel_format(1);
+    request.set_buffer_usage(1);
+    return request;
+}
+
+struct ProtobufMessageProcessorOpcodes : testing::Test
+{
+    mp::Connection connect()
+    {
+        mpw::Invocation raw_invocation;
+        raw_invocation.set_id(1);
+        raw_invocation.set_method_name("connect");
+        mp::ConnectParameters request;
+        request.set_application_name(__PRETTY_FUNCTION__);
+        raw_invocation.set_parameters(serialized(request));
+        mp->dispatch(mfd::Invocation{raw_invocation}, {});
+
+        mp::Connection connection;
+        connection.ParseFromString(sender.last_response);
+        return connection;
+    }
+
+    RecordingProtobufMessageSender sender;
+    testing::NiceMock<MockMessageProcessorReport> report;
+    StubDisplayServer display_server;
+    mfd::ProtobufMessageProcessor pb_message_processor{
+        mt::fake_shared(sender),
+        mt::fake_shared(display_server),
+        mt::fake_shared(report)};
+    std::shared_ptr<mfd::MessageProcessor> const mp = mt::fake_shared(pb_message_processor);
 };
 }
 
@@ -151,3 +220,58 @@ TEST(ProtobufMessageProcessor, doesnt_inject_buffers_when_creating_bstream)
     mp->dispatch(invocation, fds);
     EXPECT_FALSE(stub_display_server.changed_during_create_bstream_closure);
 }
+
+TEST_F(ProtobufMessageProcessorOpcodes, connect_reply_lists_method_table)
+{
+    auto const connection = connect();
+
+    std::vector<std::string> methods{
+        connection.method_opcode().begin(),
+        connection.method_opcode().end()};
+
+    EXPECT_THAT(methods, testing::Contains("connect"));
+    EXPECT_THAT(methods, testing::Contains("submit_buffer"));
+    EXPECT_THAT(methods, testing::Contains("disconnect"));
+}
+
+TEST_F(ProtobufMessageProcessorOpcodes, dispatches_invocation_by_opcode)
+{
+    auto const connection = connect();
+    auto const& methods = connection.method_opcode();
+    auto const opcode = std::find(methods.begin(), methods.end(), "create_surface") - methods.begin();
+    ASSERT_LT(opcode, methods.size());
+
+    mpw::Invocation raw_invocation;
+    raw_invocation.set_id(2);
+    raw_invocation.set_method_opcode(opcode);
+    raw_invocation.set_parameters(serialized(surface_parameters()));
+
+    EXPECT_TRUE(mp->dispatch(mfd::Invocation{raw_invocation}, {}));
+    EXPECT_EQ(1, display_server.create_surface_calls);
+}
+
+TEST_F(ProtobufMessageProcessorOpcodes, still_dispatches_invocation_by_name)
+{
+    mpw::Invocation raw_invocation;
+    raw_invocation.set_id(1);
+    raw_invocation.set_method_name("create_surface");
+    raw_invocation.set_parameters(serialized(surface_parameters()));
+
+    EXPECT_TRUE(mp->dispatch(mfd::Invocation{raw_invocation}, {}));
+    EXPECT_EQ(1, display_server.create_surface_calls);
+}
+
+TEST_F(ProtobufMessageProcessorOpcodes, unknown_opcode_is_reported_and_ends_the_session)
+{
+    auto const connection = connect();
+
+    mpw::Invocation raw_invocation;
+    raw_invocation.set_id(2);
+    raw_invocation.set_method_opcode(connection.method_opcode_size());
+    raw_invocation.set_parameters(serialized(surface_parameters()));
+
+    EXPECT_CALL(report, unknown_method(testing::_, 2, testing::_));
+
+    EXPECT_FALSE(mp->dispatch(mfd::Invocation{raw_invocation}, {}));
+    EXPECT_EQ(0, display_server.create_surface_calls);
+}
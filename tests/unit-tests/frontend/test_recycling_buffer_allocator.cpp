@@ -0,0 +1,173 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend/recycling_buffer_allocator.h"
+
+#include "mir/graphics/buffer_properties.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/fake_alarm_factory.h"
+#include "mir/test/doubles/stub_buffer_allocator.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+namespace
+{
+struct CountingBufferAllocator : mtd::StubBufferAllocator
+{
+    std::shared_ptr<mg::Buffer> alloc_software_buffer(geom::Size size, MirPixelFormat format) override
+    {
+        auto const buffer = mtd::StubBufferAllocator::alloc_software_buffer(size, format);
+        allocated.push_back(buffer);
+        return buffer;
+    }
+
+    std::shared_ptr<mg::Buffer> alloc_buffer(geom::Size size, uint32_t native_format, uint32_t native_flags) override
+    {
+        auto const buffer = mtd::StubBufferAllocator::alloc_buffer(size, native_format, native_flags);
+        allocated.push_back(buffer);
+        return buffer;
+    }
+
+    std::vector<std::weak_ptr<mg::Buffer>> allocated;
+};
+
+struct RecyclingBufferAllocator : Test
+{
+    // Freed storage of one 10x10 32bpp buffer
+    static size_t const buffer_bytes{10 * 10 * 4};
+
+    std::unique_ptr<mf::RecyclingBufferAllocator> allocator_holding(size_t max_bytes)
+    {
+        return std::make_unique<mf::RecyclingBufferAllocator>(
+            underlying, max_bytes, max_idle, clock, alarm_factory);
+    }
+
+    void advance_by(mir::time::Duration step)
+    {
+        clock->advance_by(step);
+        alarm_factory->advance_by(step);
+    }
+
+    geom::Size const size{10, 10};
+    MirPixelFormat const format{mir_pixel_format_argb_8888};
+    std::chrono::seconds const max_idle{3};
+
+    std::shared_ptr<CountingBufferAllocator> const underlying{std::make_shared<CountingBufferAllocator>()};
+    std::shared_ptr<mtd::AdvanceableClock> const clock{std::make_shared<mtd::AdvanceableClock>()};
+    std::shared_ptr<mtd::FakeAlarmFactory> const alarm_factory{std::make_shared<mtd::FakeAlarmFactory>()};
+    std::unique_ptr<mf::RecyclingBufferAllocator> const allocator{allocator_holding(4 * buffer_bytes)};
+};
+}
+
+TEST_F(RecyclingBufferAllocator, reuses_freed_storage_for_the_same_request_with_a_new_id)
+{
+    auto buffer = allocator->alloc_software_buffer(size, format);
+    auto const native = buffer->native_buffer_handle();
+    auto const id = buffer->id();
+    buffer.reset();
+
+    EXPECT_THAT(allocator->bytes_held(), Eq(buffer_bytes));
+
+    buffer = allocator->alloc_software_buffer(size, format);
+
+    EXPECT_THAT(underlying->allocated.size(), Eq(1u));
+    EXPECT_THAT(buffer->native_buffer_handle(), Eq(native));
+    EXPECT_THAT(buffer->id(), Ne(id));
+    EXPECT_THAT(buffer->size(), Eq(size));
+    EXPECT_THAT(allocator->bytes_held(), Eq(0u));
+}
+
+TEST_F(RecyclingBufferAllocator, does_not_reuse_storage_that_is_still_in_use)
+{
+    auto const buffer = allocator->alloc_software_buffer(size, format);
+    auto const other_buffer = allocator->alloc_software_buffer(size, format);
+
+    EXPECT_THAT(underlying->allocated.size(), Eq(2u));
+    EXPECT_THAT(other_buffer->native_buffer_handle(), Ne(buffer->native_buffer_handle()));
+}
+
+TEST_F(RecyclingBufferAllocator, reuses_storage_only_for_exactly_the_same_request)
+{
+    allocator->alloc_software_buffer(size, format);
+
+    allocator->alloc_software_buffer({10, 20}, format);
+    allocator->alloc_software_buffer(size, mir_pixel_format_abgr_8888);
+    allocator->alloc_buffer(size, 0, 0);
+
+    EXPECT_THAT(underlying->allocated.size(), Eq(4u));
+}
+
+TEST_F(RecyclingBufferAllocator, drops_the_least_recently_freed_storage_beyond_its_limit)
+{
+    auto const small_allocator = allocator_holding(buffer_bytes);
+
+    auto first = small_allocator->alloc_software_buffer(size, format);
+    auto second = small_allocator->alloc_software_buffer(size, format);
+    first.reset();
+    second.reset();
+
+    EXPECT_THAT(small_allocator->bytes_held(), Eq(buffer_bytes));
+    EXPECT_TRUE(underlying->allocated[0].expired());
+    EXPECT_FALSE(underlying->allocated[1].expired());
+}
+
+TEST_F(RecyclingBufferAllocator, keeps_nothing_when_its_limit_is_zero)
+{
+    auto const disabled_allocator = allocator_holding(0);
+
+    disabled_allocator->alloc_software_buffer(size, format);
+
+    EXPECT_THAT(disabled_allocator->bytes_held(), Eq(0u));
+    EXPECT_TRUE(underlying->allocated[0].expired());
+}
+
+TEST_F(RecyclingBufferAllocator, drops_storage_left_idle_without_further_allocation)
+{
+    allocator->alloc_software_buffer(size, format);
+    advance_by(2s);
+    allocator->alloc_software_buffer({20, 10}, format);
+
+    advance_by(max_idle - 2s + 1ms);
+
+    EXPECT_TRUE(underlying->allocated[0].expired());
+    EXPECT_FALSE(underlying->allocated[1].expired());
+
+    advance_by(2s);
+
+    EXPECT_TRUE(underlying->allocated[1].expired());
+    EXPECT_THAT(allocator->bytes_held(), Eq(0u));
+}
+
+TEST_F(RecyclingBufferAllocator, storage_freed_after_the_allocator_is_gone_is_destroyed)
+{
+    auto short_lived = allocator_holding(4 * buffer_bytes);
+    auto buffer = short_lived->alloc_software_buffer(size, format);
+
+    short_lived.reset();
+    EXPECT_FALSE(underlying->allocated[0].expired());
+
+    buffer.reset();
+    EXPECT_TRUE(underlying->allocated[0].expired());
+}
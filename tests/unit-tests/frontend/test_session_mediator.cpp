@@ -1002,7 +1002,7 @@ TEST_F(SessionMediator, events_sent_before_surface_creation_reply_are_buffered)
         std::unique_ptr<mf::EventSink> create_sink(
             std::shared_ptr<mf::MessageSender> const& sender)
         {
-            return std::make_unique<mf::detail::EventSender>(sender, ops);
+            return std::make_unique<mf::detail::EventSender>(sender, ops, mir::input::MotionCoalescing::none);
         }
 
     private:
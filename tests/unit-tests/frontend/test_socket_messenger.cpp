@@ -0,0 +1,310 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/server/frontend/socket_messenger.h"
+#include "mir/fd_socket_transmission.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <boost/asio.hpp>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <thread>
+
+namespace mf = mir::frontend;
+namespace mfd = mir::frontend::detail;
+namespace ba = boost::asio;
+
+using namespace testing;
+
+namespace
+{
+size_t const message_size{60000};
+
+std::vector<char> message_filled_with(char value, size_t size = message_size)
+{
+    return std::vector<char>(size, value);
+}
+
+struct SocketMessenger : Test
+{
+    SocketMessenger()
+    {
+        ba::local::connect_pair(*server_socket, client_socket);
+    }
+
+    ~SocketMessenger()
+    {
+        stop_pumping();
+    }
+
+    std::shared_ptr<mfd::SocketMessenger> messenger_with(mf::SendQueueLimit const& limit)
+    {
+        return std::make_shared<mfd::SocketMessenger>(server_socket, limit);
+    }
+
+    // Runs the completion handlers that drain the send queue
+    void start_pumping()
+    {
+        work = std::make_unique<ba::io_service::work>(io_service);
+        pump = std::thread{[this] { io_service.run(); }};
+    }
+
+    void stop_pumping()
+    {
+        work.reset();
+        io_service.stop();
+        if (pump.joinable())
+            pump.join();
+    }
+
+    void read_exactly(void* buffer, size_t size)
+    {
+        auto const bytes = static_cast<char*>(buffer);
+        for (size_t total = 0; total != size;)
+        {
+            auto const result = ::read(client_socket.native_handle(), bytes + total, size - total);
+            ASSERT_THAT(result, Gt(0));
+            total += result;
+        }
+    }
+
+    std::vector<char> receive_message()
+    {
+        unsigned char header[2];
+        read_exactly(header, sizeof header);
+        std::vector<char> body((header[0] << 8) | header[1]);
+        read_exactly(body.data(), body.size());
+        return body;
+    }
+
+    bool client_sees_end_of_stream()
+    {
+        char buffer[4096];
+        ssize_t result;
+        while ((result = ::read(client_socket.native_handle(), buffer, sizeof buffer)) > 0)
+            ;
+        return result == 0;
+    }
+
+    ba::io_service io_service;
+    std::shared_ptr<ba::local::stream_protocol::socket> const server_socket{
+        std::make_shared<ba::local::stream_protocol::socket>(io_service)};
+    ba::local::stream_protocol::socket client_socket{io_service};
+
+    mf::SendQueueLimit const generous_limit{16*1024*1024, mf::SendQueueLimit::Overflow::disconnect};
+
+    std::unique_ptr<ba::io_service::work> work;
+    std::thread pump;
+};
+}
+
+TEST_F(SocketMessenger, sends_length_prefixed_messages)
+{
+    auto const messenger = messenger_with(generous_limit);
+    std::string const message{"hello"};
+
+    messenger->send(message.data(), message.size(), {});
+
+    auto const received = receive_message();
+    EXPECT_THAT(std::string(received.begin(), received.end()), Eq(message));
+}
+
+TEST_F(SocketMessenger, does_not_wait_for_a_client_that_is_not_reading)
+{
+    auto const messenger = messenger_with(generous_limit);
+    int const message_count{100};
+
+    // Far more than the socket can buffer; this would block (or fail) if we wrote synchronously
+    for (int i = 0; i != message_count; ++i)
+    {
+        auto const message = message_filled_with(i);
+        messenger->send(message.data(), message.size(), {});
+    }
+
+    start_pumping();
+
+    for (int i = 0; i != message_count; ++i)
+        EXPECT_THAT(receive_message(), Eq(message_filled_with(i))) << "message " << i;
+}
+
+TEST_F(SocketMessenger, passes_fds_after_their_message_when_queued)
+{
+    auto const messenger = messenger_with(generous_limit);
+
+    for (int i = 0; i != 10; ++i)
+    {
+        auto const message = message_filled_with(i);
+        messenger->send(message.data(), message.size(), {});
+    }
+
+    auto const with_fd = message_filled_with('f', 10);
+    auto const after_fd = message_filled_with('a', 10);
+    messenger->send(with_fd.data(), with_fd.size(), {{mir::Fd{::dup(STDOUT_FILENO)}}});
+    messenger->send(after_fd.data(), after_fd.size(), {});
+
+    start_pumping();
+
+    for (int i = 0; i != 10; ++i)
+        receive_message();
+
+    EXPECT_THAT(receive_message(), Eq(with_fd));
+
+    std::vector<mir::Fd> fds(1);
+    char dummy;
+    mir::receive_data(mir::Fd{mir::IntOwnedFd{client_socket.native_handle()}}, &dummy, 1, fds);
+    struct stat info;
+    EXPECT_THAT(fstat(fds[0], &info), Eq(0));
+
+    EXPECT_THAT(receive_message(), Eq(after_fd));
+}
+
+TEST_F(SocketMessenger, disconnects_client_that_overflows_its_queue)
+{
+    auto const messenger = messenger_with({256*1024, mf::SendQueueLimit::Overflow::disconnect});
+    auto const message = message_filled_with('x');
+
+    EXPECT_THROW(
+        for (int i = 0; i != 1000; ++i)
+            messenger->send(message.data(), message.size(), {}),
+        std::runtime_error);
+
+    // The socket is shut down on the io_service's thread
+    start_pumping();
+
+    EXPECT_TRUE(client_sees_end_of_stream());
+}
+
+TEST_F(SocketMessenger, drops_coalescible_messages_rather_than_overflow)
+{
+    auto const messenger = messenger_with({256*1024, mf::SendQueueLimit::Overflow::drop_coalescible});
+    int const message_count{100};
+
+    for (int i = 0; i != message_count; ++i)
+    {
+        auto const message = message_filled_with(i);
+        EXPECT_NO_THROW(messenger->send_coalescible(message.data(), message.size()));
+    }
+
+    auto const last = message_filled_with('!', 10);
+    messenger->send(last.data(), last.size(), {});
+
+    start_pumping();
+
+    int received = 0;
+    char previous = -1;
+    for (auto message = receive_message(); message != last; message = receive_message())
+    {
+        ASSERT_THAT(message.size(), Eq(message_size));
+        EXPECT_THAT(message.front(), Gt(previous)) << "messages should stay in order";
+        previous = message.front();
+        ++received;
+    }
+
+    EXPECT_THAT(received, Lt(message_count));
+}
+
+TEST_F(SocketMessenger, disconnects_client_when_dropping_coalescible_messages_is_not_enough)
+{
+    auto const messenger = messenger_with({256*1024, mf::SendQueueLimit::Overflow::drop_coalescible});
+    auto const message = message_filled_with('x');
+
+    EXPECT_THROW(
+        for (int i = 0; i != 1000; ++i)
+            messenger->send(message.data(), message.size(), {}),
+        std::runtime_error);
+
+    // The socket is shut down on the io_service's thread
+    start_pumping();
+
+    EXPECT_TRUE(client_sees_end_of_stream());
+}
+
+TEST_F(SocketMessenger, replaces_a_queued_message_in_its_stream)
+{
+    auto const messenger = messenger_with(generous_limit);
+    mf::MessageStream const stream{1, 1};
+    mf::MessageStream const other_stream{1, 2};
+
+    // Enough to leave what follows queued
+    for (int i = 0; i != 10; ++i)
+    {
+        auto const message = message_filled_with(i);
+        messenger->send(message.data(), message.size(), {});
+    }
+
+    std::string const stale{"stale"}, other{"other"}, latest{"latest"};
+    messenger->send_in_stream(stream, stale.data(), stale.size(), true);
+    messenger->send_in_stream(other_stream, other.data(), other.size(), true);
+
+    EXPECT_TRUE(messenger->replace_unsent(stream, latest.data(), latest.size(), false));
+
+    start_pumping();
+
+    for (int i = 0; i != 10; ++i)
+        receive_message();
+
+    auto const first = receive_message();
+    auto const second = receive_message();
+    EXPECT_THAT(std::string(first.begin(), first.end()), Eq(latest));
+    EXPECT_THAT(std::string(second.begin(), second.end()), Eq(other));
+}
+
+TEST_F(SocketMessenger, does_not_replace_a_message_the_client_may_have_received)
+{
+    auto const messenger = messenger_with(generous_limit);
+    mf::MessageStream const stream{1, 1};
+
+    std::string const sent{"sent"}, latest{"latest"};
+    messenger->send_in_stream(stream, sent.data(), sent.size(), true);
+
+    EXPECT_FALSE(messenger->replace_unsent(stream, latest.data(), latest.size(), true));
+
+    auto const received = receive_message();
+    EXPECT_THAT(std::string(received.begin(), received.end()), Eq(sent));
+}
+
+TEST_F(SocketMessenger, does_not_replace_a_message_followed_by_one_outside_any_stream)
+{
+    auto const messenger = messenger_with(generous_limit);
+    mf::MessageStream const stream{1, 1};
+
+    for (int i = 0; i != 10; ++i)
+    {
+        auto const message = message_filled_with(i);
+        messenger->send(message.data(), message.size(), {});
+    }
+
+    std::string const stale{"stale"}, unrelated{"unrelated"}, latest{"latest"};
+    messenger->send_in_stream(stream, stale.data(), stale.size(), true);
+    messenger->send(unrelated.data(), unrelated.size(), {});
+
+    EXPECT_FALSE(messenger->replace_unsent(stream, latest.data(), latest.size(), true));
+
+    start_pumping();
+
+    for (int i = 0; i != 10; ++i)
+        receive_message();
+
+    auto const first = receive_message();
+    auto const second = receive_message();
+    EXPECT_THAT(std::string(first.begin(), first.end()), Eq(stale));
+    EXPECT_THAT(std::string(second.begin(), second.end()), Eq(unrelated));
+}
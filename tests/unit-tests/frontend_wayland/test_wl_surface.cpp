@@ -0,0 +1,403 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/server/frontend_wayland/wl_surface.h"
+#include "src/server/frontend_wayland/generated/presentation-time.h"
+
+#include "mir/compositor/presentation_clock.h"
+#include "mir/executor.h"
+#include "mir/graphics/wayland_allocator.h"
+
+#include "mir/test/doubles/stub_session.h"
+#include "mir/test/doubles/stub_buffer_stream.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <system_error>
+#include <thread>
+#include <functional>
+#include <vector>
+
+namespace mf = mir::frontend;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+// Object ids, as a client would allocate them
+uint32_t const compositor_id{2};
+uint32_t const surface_id{3};
+uint32_t const buffer_id{4};
+uint32_t const other_buffer_id{5};
+uint32_t const feedback_id{6};
+uint32_t const other_feedback_id{7};
+
+// Opcodes, from the protocol XML
+uint16_t const wl_surface_attach{1};
+uint16_t const wl_surface_commit{6};
+uint16_t const wp_presentation_feedback_presented{1};
+uint16_t const wp_presentation_feedback_discarded{2};
+
+struct WireEvent
+{
+    uint32_t object;
+    uint16_t opcode;
+    std::vector<uint32_t> args;
+};
+
+struct QueueingExecutor : mir::Executor
+{
+    void spawn(std::function<void()>&& work) override
+    {
+        queue.push_back(std::move(work));
+    }
+
+    void run()
+    {
+        while (!queue.empty())
+        {
+            auto const work = std::move(queue);
+            queue.clear();
+            for (auto const& item : work)
+                item();
+        }
+    }
+
+    std::vector<std::function<void()>> queue;
+};
+
+struct StubWaylandAllocator : mg::WaylandAllocator
+{
+    void bind_display(wl_display*) override
+    {
+    }
+
+    std::shared_ptr<mg::Buffer> buffer_from_resource(
+        wl_resource* buffer,
+        std::function<void()>&& on_consumed,
+        std::function<void()>&&) override
+    {
+        buffers.push_back(buffer);
+        consume.push_back(std::move(on_consumed));
+        return std::make_shared<mtd::StubBuffer>();
+    }
+
+    std::vector<wl_resource*> buffers;
+    std::vector<std::function<void()>> consume;
+};
+
+struct StubStreamSession : mtd::StubSession
+{
+    std::shared_ptr<mf::BufferStream> get_buffer_stream(mf::BufferStreamId) const override
+    {
+        return stream;
+    }
+
+    std::shared_ptr<mtd::StubBufferStream> const stream{std::make_shared<mtd::StubBufferStream>()};
+};
+
+/*
+ * Drives a WlSurface through a real wl_display, playing the client's side of the
+ * connection by writing requests straight onto the socket.
+ */
+struct WlSurfaceTest : Test
+{
+    WlSurfaceTest()
+    {
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0)
+            throw std::system_error{errno, std::system_category(), "Failed to create socket pair"};
+
+        client = wl_client_create(display, fds[0]);
+        compositor = wl_resource_create(client, &wl_compositor_interface, 3, compositor_id);
+        buffer = wl_resource_create(client, &wl_buffer_interface, 1, buffer_id);
+        other_buffer = wl_resource_create(client, &wl_buffer_interface, 1, other_buffer_id);
+
+        surface = new mf::WlSurface{
+            client, compositor, surface_id, session, executor, allocator, clock, false};
+    }
+
+    ~WlSurfaceTest()
+    {
+        wl_client_destroy(client);
+        wl_display_destroy(display);
+        close(fds[1]);
+    }
+
+    void request_feedback(uint32_t id)
+    {
+        surface->presentation_feedback(
+            wl_resource_create(client, &wp_presentation_feedback_interface, 1, id));
+    }
+
+    void send_request(uint32_t object, uint16_t opcode, std::vector<uint32_t> const& args = {})
+    {
+        std::vector<uint32_t> message{object, uint32_t((8 + 4*args.size()) << 16 | opcode)};
+        message.insert(end(message), begin(args), end(args));
+
+        auto const size = message.size() * sizeof(message[0]);
+        ASSERT_THAT(write(fds[1], message.data(), size), Eq(ssize_t(size)));
+        dispatch();
+    }
+
+    void attach(uint32_t buffer)
+    {
+        send_request(surface_id, wl_surface_attach, {buffer, 0, 0});
+    }
+
+    void commit()
+    {
+        send_request(surface_id, wl_surface_commit);
+    }
+
+    void dispatch()
+    {
+        wl_event_loop_dispatch(wl_display_get_event_loop(display), 0);
+        wl_display_flush_clients(display);
+    }
+
+    // The compositor thread of output consumes the buffer at index
+    void consume(size_t index, void const* output)
+    {
+        ASSERT_THAT(allocator->consume.size(), Gt(index));
+        std::thread{[this, index, output]
+            {
+                clock->compositing(output);
+                allocator->consume[index]();
+            }}.join();
+    }
+
+    void frame_presented(void const* output)
+    {
+        clock->frame_presented(output, frame, refresh);
+        executor->run();
+        dispatch();
+    }
+
+    // The compositor consumes the buffer at index, then presents the frame it's in
+    void present(size_t index)
+    {
+        consume(index, output);
+        frame_presented(output);
+    }
+
+    std::vector<WireEvent> events_for(uint32_t object)
+    {
+        char data[4096];
+        ssize_t size;
+        while ((size = recv(fds[1], data, sizeof data, MSG_DONTWAIT)) > 0)
+            received.insert(end(received), data, data + size);
+
+        std::vector<WireEvent> events;
+        for (size_t offset = 0; offset + 8 <= received.size();)
+        {
+            uint32_t header[2];
+            memcpy(header, received.data() + offset, sizeof header);
+            uint32_t const message_size = header[1] >> 16;
+
+            WireEvent event{header[0], uint16_t(header[1] & 0xffff), std::vector<uint32_t>((message_size - 8) / 4)};
+            memcpy(event.args.data(), received.data() + offset + 8, message_size - 8);
+
+            if (event.object == object)
+                events.push_back(event);
+
+            offset += message_size;
+        }
+        return events;
+    }
+
+    std::vector<uint16_t> opcodes_for(uint32_t object)
+    {
+        std::vector<uint16_t> opcodes;
+        for (auto const& event : events_for(object))
+            opcodes.push_back(event.opcode);
+        return opcodes;
+    }
+
+    void const* const output = "output";
+    std::chrono::nanoseconds const refresh{16666666ns};
+    mg::Frame const frame{42, {CLOCK_MONOTONIC, 7s + 1234ns}};
+
+    std::shared_ptr<StubStreamSession> const session{std::make_shared<StubStreamSession>()};
+    std::shared_ptr<QueueingExecutor> const executor{std::make_shared<QueueingExecutor>()};
+    std::shared_ptr<StubWaylandAllocator> const allocator{std::make_shared<StubWaylandAllocator>()};
+    std::shared_ptr<mc::PresentationClock> const clock{std::make_shared<mc::PresentationClock>()};
+
+    wl_display* const display{wl_display_create()};
+    int fds[2];
+    wl_client* client;
+    wl_resource* compositor;
+    wl_resource* buffer;
+    wl_resource* other_buffer;
+    mf::WlSurface* surface;
+
+    std::vector<char> received;
+};
+}
+
+TEST_F(WlSurfaceTest, feedback_is_presented_once_the_committed_buffer_is_shown)
+{
+    request_feedback(feedback_id);
+    attach(buffer_id);
+    commit();
+
+    EXPECT_THAT(opcodes_for(feedback_id), IsEmpty());
+
+    present(0);
+
+    auto const events = events_for(feedback_id);
+    ASSERT_THAT(events.size(), Eq(1u));
+    EXPECT_THAT(events[0].opcode, Eq(wp_presentation_feedback_presented));
+    EXPECT_THAT(events[0].args, ElementsAre(
+        0u, 7u, 1234u,                              // tv_sec_hi, tv_sec_lo, tv_nsec
+        uint32_t(refresh.count()),
+        0u, 42u,                                    // seq_hi, seq_lo
+        uint32_t(WP_PRESENTATION_FEEDBACK_KIND_VSYNC)));
+}
+
+TEST_F(WlSurfaceTest, feedback_waits_for_a_frame_after_the_buffer_is_consumed)
+{
+    request_feedback(feedback_id);
+    attach(buffer_id);
+    commit();
+
+    consume(0, output);
+    executor->run();
+    dispatch();
+
+    EXPECT_THAT(opcodes_for(feedback_id), IsEmpty());
+
+    frame_presented(output);
+
+    EXPECT_THAT(opcodes_for(feedback_id), ElementsAre(wp_presentation_feedback_presented));
+}
+
+TEST_F(WlSurfaceTest, feedback_waits_for_the_output_that_consumed_the_buffer)
+{
+    void const* const other_output = "other output";
+
+    request_feedback(feedback_id);
+    attach(buffer_id);
+    commit();
+
+    consume(0, output);
+    frame_presented(other_output);
+
+    EXPECT_THAT(opcodes_for(feedback_id), IsEmpty());
+
+    frame_presented(output);
+
+    EXPECT_THAT(opcodes_for(feedback_id), ElementsAre(wp_presentation_feedback_presented));
+}
+
+TEST_F(WlSurfaceTest, feedback_is_discarded_when_its_buffer_is_replaced_before_being_consumed)
+{
+    request_feedback(feedback_id);
+    attach(buffer_id);
+    commit();
+
+    request_feedback(other_feedback_id);
+    attach(other_buffer_id);
+    commit();
+
+    EXPECT_THAT(opcodes_for(feedback_id), ElementsAre(wp_presentation_feedback_discarded));
+    EXPECT_THAT(opcodes_for(other_feedback_id), IsEmpty());
+
+    // The compositor only ever picks up the latest buffer
+    present(1);
+
+    EXPECT_THAT(opcodes_for(feedback_id), ElementsAre(wp_presentation_feedback_discarded));
+    EXPECT_THAT(opcodes_for(other_feedback_id), ElementsAre(wp_presentation_feedback_presented));
+}
+
+TEST_F(WlSurfaceTest, consuming_a_replaced_buffer_does_not_present_its_discarded_feedback)
+{
+    request_feedback(feedback_id);
+    attach(buffer_id);
+    commit();
+
+    attach(other_buffer_id);
+    commit();
+
+    present(0);
+
+    EXPECT_THAT(opcodes_for(feedback_id), ElementsAre(wp_presentation_feedback_discarded));
+}
+
+TEST_F(WlSurfaceTest, feedback_follows_the_buffer_attached_last_before_commit)
+{
+    attach(buffer_id);
+    request_feedback(feedback_id);
+    attach(other_buffer_id);
+    commit();
+
+    ASSERT_THAT(allocator->buffers, ElementsAre(other_buffer));
+
+    present(0);
+
+    EXPECT_THAT(opcodes_for(feedback_id), ElementsAre(wp_presentation_feedback_presented));
+}
+
+TEST_F(WlSurfaceTest, feedback_is_discarded_by_a_commit_without_a_new_buffer)
+{
+    attach(buffer_id);
+    commit();
+
+    request_feedback(feedback_id);
+    commit();
+
+    EXPECT_THAT(opcodes_for(feedback_id), ElementsAre(wp_presentation_feedback_discarded));
+}
+
+TEST_F(WlSurfaceTest, feedback_is_discarded_by_a_commit_of_a_null_buffer)
+{
+    request_feedback(feedback_id);
+    attach(0);
+    commit();
+
+    EXPECT_THAT(opcodes_for(feedback_id), ElementsAre(wp_presentation_feedback_discarded));
+}
+
+TEST_F(WlSurfaceTest, pending_feedback_is_discarded_when_the_surface_is_destroyed)
+{
+    request_feedback(feedback_id);
+
+    wl_resource_destroy(surface->raw_resource());
+    dispatch();
+
+    EXPECT_THAT(opcodes_for(feedback_id), ElementsAre(wp_presentation_feedback_discarded));
+}
+
+TEST_F(WlSurfaceTest, unconsumed_feedback_is_discarded_when_the_surface_is_destroyed)
+{
+    request_feedback(feedback_id);
+    attach(buffer_id);
+    commit();
+
+    wl_resource_destroy(surface->raw_resource());
+    dispatch();
+
+    EXPECT_THAT(opcodes_for(feedback_id), ElementsAre(wp_presentation_feedback_discarded));
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace mir::geometry;
+using namespace testing;
+
+namespace
+{
+auto contents_of(Region const& region) -> std::vector<Rectangle>
+{
+    return {std::begin(region), std::end(region)};
+}
+}
+
+TEST(Region, default_is_empty)
+{
+    Region const region;
+
+    EXPECT_TRUE(region.empty());
+    EXPECT_THAT(region.size(), Eq(0u));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{}));
+}
+
+TEST(Region, empty_rectangles_are_ignored)
+{
+    Region const region{{{1, 2}, {0, 10}}, {{3, 4}, {10, 0}}};
+
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(Region, union_of_disjoint_rectangles_is_banded)
+{
+    Region const region{{{20, 0}, {10, 10}}, {{0, 5}, {10, 10}}};
+
+    EXPECT_THAT(contents_of(region), ElementsAre(
+        Rectangle{{20, 0}, {10, 5}},
+        Rectangle{{0, 5}, {10, 5}},
+        Rectangle{{20, 5}, {10, 5}},
+        Rectangle{{0, 10}, {10, 5}}));
+}
+
+TEST(Region, adjacent_rectangles_are_merged)
+{
+    Region const side_by_side{{{0, 0}, {10, 10}}, {{10, 0}, {10, 10}}};
+    Region const stacked{{{0, 0}, {10, 10}}, {{0, 10}, {10, 10}}};
+
+    EXPECT_THAT(contents_of(side_by_side), ElementsAre(Rectangle{{0, 0}, {20, 10}}));
+    EXPECT_THAT(contents_of(stacked), ElementsAre(Rectangle{{0, 0}, {10, 20}}));
+}
+
+TEST(Region, equal_regions_compare_equal_however_built)
+{
+    Region const a{{{0, 0}, {10, 20}}, {{10, 0}, {10, 20}}};
+    Region const b{{{0, 0}, {20, 10}}, {{0, 10}, {20, 10}}, {{5, 5}, {5, 5}}};
+
+    EXPECT_THAT(a, Eq(b));
+    EXPECT_THAT(a, Ne(Region{{{0, 0}, {20, 19}}}));
+}
+
+TEST(Region, subtract_punches_a_hole)
+{
+    Region region{{{0, 0}, {30, 30}}};
+    region.subtract({{{10, 10}, {10, 10}}});
+
+    EXPECT_THAT(contents_of(region), ElementsAre(
+        Rectangle{{0, 0}, {30, 10}},
+        Rectangle{{0, 10}, {10, 10}},
+        Rectangle{{20, 10}, {10, 10}},
+        Rectangle{{0, 20}, {30, 10}}));
+    EXPECT_FALSE(region.contains(Point{15, 15}));
+    EXPECT_TRUE(region.contains(Point{5, 15}));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{{0, 0}, {30, 30}}));
+}
+
+TEST(Region, intersect_keeps_only_common_points)
+{
+    Region region{{{0, 0}, {20, 20}}, {{40, 0}, {20, 20}}};
+    region.intersect({{{10, 10}, {40, 20}}});
+
+    EXPECT_THAT(region, Eq(Region{{{10, 10}, {10, 10}}, {{40, 10}, {10, 10}}}));
+}
+
+TEST(Region, contains_rectangle_covered_by_several_parts)
+{
+    Region const region{{{0, 0}, {10, 20}}, {{10, 0}, {10, 10}}, {{10, 10}, {10, 10}}};
+
+    EXPECT_TRUE(region.contains(Rectangle{{5, 5}, {10, 10}}));
+    EXPECT_FALSE(region.contains(Rectangle{{5, 5}, {10, 20}}));
+    EXPECT_TRUE(region.contains(Rectangle{{50, 50}, {0, 0}}));
+}
+
+TEST(Region, translate_moves_every_part)
+{
+    Region region{{{0, 0}, {10, 10}}, {{20, 20}, {10, 10}}};
+    region.translate({5, -5});
+
+    EXPECT_THAT(region, Eq(Region{{{5, -5}, {10, 10}}, {{25, 15}, {10, 10}}}));
+}
@@ -21,14 +21,25 @@
 #include "mir/test/doubles/mock_gl_buffer.h"
 #include "mir/test/doubles/mock_renderable.h"
 #include "mir/test/doubles/mock_gl.h"
+#include "mir/geometry/rectangles.h"
 #include <gtest/gtest.h>
 
 namespace mtd=mir::test::doubles;
 namespace mgl=mir::gl;
 namespace mg=mir::graphics;
+namespace geom=mir::geometry;
 
 namespace
 {
+struct MockDamagedGLBuffer : mtd::MockGLBuffer, mir::renderer::gl::DamagedTextureSource
+{
+    MockDamagedGLBuffer()
+        : MockGLBuffer{{100, 100}, geom::Stride{400}, mir_pixel_format_argb_8888}
+    {
+    }
+
+    MOCK_METHOD1(bind_damaged, std::size_t(geom::Rectangles const&));
+};
 
 class RecentlyUsedCache : public testing::Test
 {
@@ -140,3 +151,121 @@ TEST_F(RecentlyUsedCache, invalidated_buffers_are_reloaded)
     cache.invalidate();
     cache.load(*renderable);
 }
+
+TEST_F(RecentlyUsedCache, uploads_only_damage_when_possible)
+{
+    using namespace testing;
+    auto const damaged_buffer = std::make_shared<NiceMock<MockDamagedGLBuffer>>();
+    geom::Rectangles const damage{{{10, 10}, {5, 5}}};
+    ON_CALL(*renderable, buffer())
+        .WillByDefault(Return(damaged_buffer));
+    ON_CALL(*renderable, buffer_damage())
+        .WillByDefault(Return(damage));
+
+    mgl::RecentlyUsedCache cache;
+
+    InSequence seq;
+    EXPECT_CALL(*damaged_buffer, id())
+        .WillOnce(Return(mg::BufferID(1)));
+    EXPECT_CALL(*damaged_buffer, bind());
+    EXPECT_CALL(*damaged_buffer, id())
+        .WillOnce(Return(mg::BufferID(2)));
+    EXPECT_CALL(*damaged_buffer, bind_damaged(damage));
+
+    cache.load(*renderable);
+    cache.drop_unused();
+    cache.load(*renderable);
+}
+
+TEST_F(RecentlyUsedCache, reuses_texture_storage_when_damage_cannot_be_used)
+{
+    using namespace testing;
+    auto const damaged_buffer = std::make_shared<NiceMock<MockDamagedGLBuffer>>();
+    ON_CALL(*renderable, buffer())
+        .WillByDefault(Return(damaged_buffer));
+    ON_CALL(*renderable, buffer_damage())
+        .WillByDefault(Return(geom::Rectangles{{{10, 10}, {5, 5}}}));
+    unsigned int id{0};
+    ON_CALL(*damaged_buffer, id())
+        .WillByDefault(Invoke([&id] { return mg::BufferID(++id); }));
+
+    mgl::RecentlyUsedCache cache;
+
+    InSequence seq;
+    // No storage yet
+    EXPECT_CALL(*damaged_buffer, bind());
+    // Invalidated (e.g. following bypass)
+    EXPECT_CALL(*damaged_buffer, bind_damaged(geom::Rectangles{{{0, 0}, {100, 100}}}));
+    // Resized
+    EXPECT_CALL(*damaged_buffer, bind());
+    // Damage not tracked
+    EXPECT_CALL(*damaged_buffer, bind_damaged(geom::Rectangles{{{0, 0}, {200, 100}}}));
+
+    cache.load(*renderable);
+
+    cache.invalidate();
+    cache.load(*renderable);
+
+    ON_CALL(*damaged_buffer, size())
+        .WillByDefault(Return(geom::Size{200, 100}));
+    cache.load(*renderable);
+
+    ON_CALL(*renderable, buffer_damage())
+        .WillByDefault(Return(std::experimental::nullopt));
+    cache.load(*renderable);
+}
+
+TEST_F(RecentlyUsedCache, counts_bytes_uploaded_until_dropped)
+{
+    using namespace testing;
+    auto const damaged_buffer = std::make_shared<NiceMock<MockDamagedGLBuffer>>();
+    ON_CALL(*renderable, buffer())
+        .WillByDefault(Return(damaged_buffer));
+    ON_CALL(*renderable, buffer_damage())
+        .WillByDefault(Return(geom::Rectangles{{{10, 10}, {5, 5}}}));
+    ON_CALL(*damaged_buffer, bind_damaged(_))
+        .WillByDefault(Return(100));
+    unsigned int id{0};
+    ON_CALL(*damaged_buffer, id())
+        .WillByDefault(Invoke([&id] { return mg::BufferID(++id); }));
+
+    mgl::RecentlyUsedCache cache;
+    EXPECT_THAT(cache.bytes_uploaded(), Eq(0u));
+
+    cache.load(*renderable);
+    EXPECT_THAT(cache.bytes_uploaded(), Eq(100u * 100u * 4u));
+    cache.drop_unused();
+    EXPECT_THAT(cache.bytes_uploaded(), Eq(0u));
+
+    cache.load(*renderable);
+    EXPECT_THAT(cache.bytes_uploaded(), Eq(100u));
+}
+
+TEST_F(RecentlyUsedCache, does_not_upload_into_storage_bound_from_elsewhere)
+{
+    using namespace testing;
+    auto const image_buffer = std::make_shared<NiceMock<mtd::MockGLBuffer>>(
+        geom::Size{100, 100}, geom::Stride{400}, mir_pixel_format_argb_8888);
+    auto const damaged_buffer = std::make_shared<NiceMock<MockDamagedGLBuffer>>();
+    ON_CALL(*image_buffer, id())
+        .WillByDefault(Return(mg::BufferID(1)));
+    ON_CALL(*damaged_buffer, id())
+        .WillByDefault(Return(mg::BufferID(2)));
+
+    mgl::RecentlyUsedCache cache;
+
+    // Same size and format, but the texture's storage belongs to the image
+    InSequence seq;
+    EXPECT_CALL(*image_buffer, bind());
+    EXPECT_CALL(*damaged_buffer, bind());
+    EXPECT_CALL(*damaged_buffer, bind_damaged(_))
+        .Times(0);
+
+    ON_CALL(*renderable, buffer())
+        .WillByDefault(Return(image_buffer));
+    cache.load(*renderable);
+
+    ON_CALL(*renderable, buffer())
+        .WillByDefault(Return(damaged_buffer));
+    cache.load(*renderable);
+}
@@ -18,6 +18,7 @@
 
 #include "src/platforms/common/server/shm_buffer.h"
 #include "mir/shm_file.h"
+#include "mir/geometry/rectangles.h"
 
 #include "mir/test/doubles/mock_gl.h"
 
@@ -199,3 +200,28 @@ TEST_F(ShmBufferTest, uploads_abgr_8888_correctly)
     PlatformlessShmBuffer buf(std::make_unique<StubShmFile>(), size, mir_pixel_format_abgr_8888);
     buf.gl_bind_to_texture();
 }
+
+TEST_F(ShmBufferTest, uploads_only_damaged_rows)
+{
+    auto const base = static_cast<char*>(stub_shm_file->fake_mapping);
+    auto const stride = size.width.as_int() * 4;
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_,_,_,_,_,_,_,_,_))
+        .Times(0);
+    // Overlapping damage is merged into one run of rows
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 10,
+                                         size.width.as_int(), 15,
+                                         GL_RGBA, GL_UNSIGNED_BYTE,
+                                         base + 10 * stride));
+    // Damage outside the buffer is clipped
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 330,
+                                         size.width.as_int(), 10,
+                                         GL_RGBA, GL_UNSIGNED_BYTE,
+                                         base + 330 * stride));
+
+    PlatformlessShmBuffer buf(std::make_unique<StubShmFile>(), size, mir_pixel_format_abgr_8888);
+    auto const uploaded = buf.bind_damaged(geom::Rectangles{
+        {{5, 10}, {10, 10}}, {{50, 15}, {10, 10}}, {{0, 330}, {20, 20}}, {{0, 400}, {10, 10}}});
+
+    EXPECT_THAT(uploaded, Eq(25u * stride));
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "mir/events/event_pool.h"
+#include "mir/events/event_private.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace mev = mir::events;
+using namespace testing;
+
+TEST(EventPool, reuses_a_released_block)
+{
+    auto const size = 200;
+
+    auto const block = mev::event_pool::allocate(size);
+    mev::event_pool::release(block, size);
+
+    EXPECT_THAT(mev::event_pool::allocate(size), Eq(block));
+    mev::event_pool::release(block, size);
+}
+
+TEST(EventPool, serves_blocks_larger_than_it_recycles)
+{
+    auto const size = mev::event_pool::max_block_size * 4;
+
+    auto const block = mev::event_pool::allocate(size);
+    ASSERT_THAT(block, NotNull());
+    std::memset(block, 0xff, size);
+
+    mev::event_pool::release(block, size);
+}
+
+TEST(EventPool, reuses_blocks_released_on_another_thread)
+{
+    auto const size = 100;
+    auto const count = 64;
+
+    std::vector<void*> released;
+    for (auto i = 0; i != count; ++i)
+        released.push_back(mev::event_pool::allocate(size));
+
+    std::thread{[&]
+        {
+            for (auto block : released)
+                mev::event_pool::release(block, size);
+        }}.join();
+
+    std::vector<void*> allocated;
+    for (auto i = 0; i != count; ++i)
+        allocated.push_back(mev::event_pool::allocate(size));
+
+    auto const reused = std::count_if(begin(allocated), end(allocated), [&](void* block)
+        {
+            return std::find(begin(released), end(released), block) != end(released);
+        });
+
+    EXPECT_THAT(reused, Gt(0));
+
+    for (auto block : allocated)
+        mev::event_pool::release(block, size);
+}
+
+TEST(EventPool, shared_event_keeps_its_contents)
+{
+    auto const device_id = MirInputDeviceId{7};
+    auto const max_contacts = 16;
+
+    auto touch = mev::make_event(device_id, std::chrono::nanoseconds{1}, std::vector<uint8_t>{}, mir_input_event_modifier_none);
+    for (auto i = 0; i != max_contacts; ++i)
+        mev::add_touch(*touch, i, mir_touch_action_change, mir_touch_tooltype_finger, i, i, 1, 1, 1, 0);
+
+    auto const shared = mev::share_event(std::move(touch));
+    auto const copy = mev::clone_event(*shared);
+
+    auto const touch_event = mir_input_event_get_touch_event(mir_event_get_input_event(copy.get()));
+    ASSERT_THAT(mir_touch_event_point_count(touch_event), Eq(static_cast<unsigned>(max_contacts)));
+    EXPECT_THAT(mir_touch_event_axis_value(touch_event, max_contacts - 1, mir_touch_axis_x), Eq(max_contacts - 1));
+    EXPECT_THAT(mir_input_event_get_device_id(mir_event_get_input_event(copy.get())), Eq(device_id));
+}
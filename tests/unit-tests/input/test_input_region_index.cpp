@@ -0,0 +1,199 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/server/input/input_region_index.h"
+
+#include "mir/input/surface.h"
+#include "mir/test/doubles/stub_input_scene.h"
+#include "mir/test/fake_shared.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <list>
+
+namespace mi = mir::input;
+namespace mt = mir::test;
+namespace mtd = mt::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+struct RectangularSurface : mi::Surface
+{
+    explicit RectangularSurface(geom::Rectangle const& bounds)
+        : bounds{bounds},
+          extents{bounds}
+    {
+    }
+
+    std::string name() const override { return {}; }
+    geom::Rectangle input_bounds() const override { return bounds; }
+    geom::Rectangle input_extents() const override { return extents; }
+    bool input_area_contains(geom::Point const& point) const override
+    {
+        return accepts_input && extents.contains(point);
+    }
+    std::shared_ptr<mir::graphics::CursorImage> cursor_image() const override { return nullptr; }
+    mi::InputReceptionMode reception_mode() const override { return mi::InputReceptionMode::normal; }
+    void consume(MirEvent const*) override {}
+
+    geom::Rectangle bounds;
+    geom::Rectangle extents;
+    bool accepts_input{true};
+};
+
+struct StackedScene : mtd::StubInputScene
+{
+    void for_each(std::function<void(std::shared_ptr<mi::Surface> const&)> const& exec) override
+    {
+        ++traversals;
+        for (auto const& surface : surfaces)
+            exec(surface);
+    }
+
+    std::shared_ptr<RectangularSurface> add_surface(geom::Rectangle const& bounds)
+    {
+        auto const surface = std::make_shared<RectangularSurface>(bounds);
+        surfaces.push_back(surface);
+        return surface;
+    }
+
+    std::list<std::shared_ptr<RectangularSurface>> surfaces;
+    int traversals{0};
+};
+
+struct InputRegionIndex : Test
+{
+    StackedScene scene;
+    mi::InputRegionIndex index{mt::fake_shared(scene), 100};
+};
+}
+
+TEST_F(InputRegionIndex, finds_nothing_in_an_empty_scene)
+{
+    EXPECT_THAT(index.surface_at({10, 10}), IsNull());
+}
+
+TEST_F(InputRegionIndex, finds_topmost_surface_under_point)
+{
+    auto const bottom = scene.add_surface({{0, 0}, {500, 500}});
+    auto const top = scene.add_surface({{200, 200}, {100, 100}});
+
+    EXPECT_THAT(index.surface_at({250, 250}), Eq(top));
+    EXPECT_THAT(index.surface_at({50, 50}), Eq(bottom));
+    EXPECT_THAT(index.surface_at({600, 50}), IsNull());
+}
+
+TEST_F(InputRegionIndex, handles_surfaces_at_negative_coordinates)
+{
+    auto const surface = scene.add_surface({{-150, -150}, {100, 100}});
+
+    EXPECT_THAT(index.surface_at({-100, -100}), Eq(surface));
+    EXPECT_THAT(index.surface_at({-50, -50}), IsNull());
+    EXPECT_THAT(index.surface_at({-151, -100}), IsNull());
+}
+
+TEST_F(InputRegionIndex, defers_to_surface_input_area)
+{
+    auto const bottom = scene.add_surface({{0, 0}, {500, 500}});
+    auto const top = scene.add_surface({{0, 0}, {500, 500}});
+    top->accepts_input = false;
+
+    EXPECT_THAT(index.surface_at({250, 250}), Eq(bottom));
+}
+
+TEST_F(InputRegionIndex, follows_moved_surface_without_rebuilding)
+{
+    auto const surface = scene.add_surface({{0, 0}, {50, 50}});
+    index.surface_at({0, 0});
+    auto const traversals = scene.traversals;
+
+    surface->bounds = surface->extents = {{1000, 1000}, {50, 50}};
+    index.update(surface.get());
+
+    EXPECT_THAT(index.surface_at({10, 10}), IsNull());
+    EXPECT_THAT(index.surface_at({1010, 1010}), Eq(surface));
+    EXPECT_THAT(scene.traversals, Eq(traversals));
+}
+
+TEST_F(InputRegionIndex, follows_resized_surface)
+{
+    auto const surface = scene.add_surface({{0, 0}, {50, 50}});
+    index.surface_at({0, 0});
+
+    surface->bounds = surface->extents = {{0, 0}, {350, 350}};
+    index.update(surface.get());
+
+    EXPECT_THAT(index.surface_at({340, 340}), Eq(surface));
+}
+
+TEST_F(InputRegionIndex, finds_input_extending_beyond_surface_bounds)
+{
+    auto const surface = scene.add_surface({{0, 0}, {50, 50}});
+    surface->extents = {{-20, 0}, {400, 50}};
+
+    EXPECT_THAT(index.surface_at({-10, 10}), Eq(surface));
+    EXPECT_THAT(index.surface_at({390, 10}), Eq(surface));
+}
+
+TEST_F(InputRegionIndex, follows_changed_input_region)
+{
+    auto const surface = scene.add_surface({{0, 0}, {50, 50}});
+    index.surface_at({0, 0});
+
+    surface->extents = {{0, 0}, {400, 50}};
+    index.update(surface.get());
+
+    EXPECT_THAT(index.surface_at({390, 10}), Eq(surface));
+}
+
+TEST_F(InputRegionIndex, rebuilds_after_restacking)
+{
+    auto const first = scene.add_surface({{0, 0}, {100, 100}});
+    auto const second = scene.add_surface({{0, 0}, {100, 100}});
+    EXPECT_THAT(index.surface_at({10, 10}), Eq(second));
+
+    scene.surfaces.reverse();
+    index.invalidate();
+
+    EXPECT_THAT(index.surface_at({10, 10}), Eq(first));
+}
+
+TEST_F(InputRegionIndex, does_not_traverse_scene_for_each_lookup)
+{
+    scene.add_surface({{0, 0}, {100, 100}});
+
+    for (int i = 0; i != 10; ++i)
+        index.surface_at({i, i});
+
+    EXPECT_THAT(scene.traversals, Eq(1));
+}
+
+TEST_F(InputRegionIndex, forgets_removed_surface)
+{
+    auto const bottom = scene.add_surface({{0, 0}, {100, 100}});
+    auto const top = scene.add_surface({{0, 0}, {100, 100}});
+    index.surface_at({0, 0});
+
+    scene.surfaces.remove(top);
+    index.remove(top.get());
+
+    EXPECT_THAT(index.surface_at({10, 10}), Eq(bottom));
+}
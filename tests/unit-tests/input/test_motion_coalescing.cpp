@@ -0,0 +1,156 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/input/motion_coalescing.h"
+
+#include "mir/events/event_private.h"
+#include "mir/events/event_builders.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+
+namespace mi = mir::input;
+namespace mev = mir::events;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+MirInputDeviceId const device{7};
+int const window{3};
+
+mir::EventUPtr pointer_event(
+    MirPointerAction action,
+    MirPointerButtons buttons,
+    float x, float y,
+    float dx, float dy,
+    std::chrono::nanoseconds time = 0ns)
+{
+    auto ev = mev::make_event(device, time, std::vector<uint8_t>{}, mir_input_event_modifier_none,
+        action, buttons, x, y, 0.0f, 0.0f, dx, dy);
+    mev::set_window_id(*ev, window);
+    return ev;
+}
+
+mir::EventUPtr touch_event(MirTouchAction action, float x, float y, std::chrono::nanoseconds time = 0ns)
+{
+    auto ev = mev::make_event(device, time, std::vector<uint8_t>{}, mir_input_event_modifier_none);
+    mev::add_touch(*ev, 0, action, mir_touch_tooltype_finger, x, y, 1.0f, 1.0f, 1.0f, 1.0f);
+    mev::set_window_id(*ev, window);
+    return ev;
+}
+
+MirPointerEvent const& as_pointer(mir::EventUPtr const& ev)
+{
+    return *ev->to_input()->to_pointer();
+}
+
+MirTouchEvent const& as_touch(mir::EventUPtr const& ev)
+{
+    return *ev->to_input()->to_touch();
+}
+}
+
+TEST(MotionCoalescing, merges_pointer_motion_into_latest_position_and_summed_relative_motion)
+{
+    auto const pending = pointer_event(mir_pointer_action_motion, 0, 10, 10, 1, 2, 1ms);
+    auto const next = pointer_event(mir_pointer_action_motion, 0, 13, 15, 3, 5, 2ms);
+
+    ASSERT_TRUE(mi::coalesce_motion(*pending, *next, mi::MotionCoalescing::pointer));
+
+    auto const& merged = as_pointer(pending);
+    EXPECT_THAT(merged.x(), FloatEq(13));
+    EXPECT_THAT(merged.y(), FloatEq(15));
+    EXPECT_THAT(merged.dx(), FloatEq(4));
+    EXPECT_THAT(merged.dy(), FloatEq(7));
+    EXPECT_THAT(merged.event_time(), Eq(2ms));
+}
+
+TEST(MotionCoalescing, does_not_merge_anything_with_no_coalescing)
+{
+    auto const pending = pointer_event(mir_pointer_action_motion, 0, 10, 10, 1, 2);
+    auto const next = pointer_event(mir_pointer_action_motion, 0, 13, 15, 3, 5);
+
+    EXPECT_FALSE(mi::coalesce_motion(*pending, *next, mi::MotionCoalescing::none));
+    EXPECT_THAT(as_pointer(pending).x(), FloatEq(10));
+}
+
+TEST(MotionCoalescing, preserves_button_boundaries)
+{
+    auto const motion = pointer_event(mir_pointer_action_motion, 0, 10, 10, 0, 0);
+    auto const press = pointer_event(mir_pointer_action_button_down, mir_pointer_button_primary, 10, 10, 0, 0);
+    auto const drag = pointer_event(mir_pointer_action_motion, mir_pointer_button_primary, 12, 10, 2, 0);
+
+    EXPECT_FALSE(mi::coalesce_motion(*motion, *press, mi::MotionCoalescing::pointer));
+    EXPECT_FALSE(mi::coalesce_motion(*press, *drag, mi::MotionCoalescing::pointer));
+    EXPECT_FALSE(mi::coalesce_motion(*motion, *drag, mi::MotionCoalescing::pointer));
+}
+
+TEST(MotionCoalescing, does_not_merge_motion_for_different_windows)
+{
+    auto const pending = pointer_event(mir_pointer_action_motion, 0, 10, 10, 1, 2);
+    auto const next = pointer_event(mir_pointer_action_motion, 0, 13, 15, 3, 5);
+    mev::set_window_id(*next, window + 1);
+
+    EXPECT_FALSE(mi::coalesce_motion(*pending, *next, mi::MotionCoalescing::pointer));
+}
+
+TEST(MotionCoalescing, merges_touch_changes_only_when_configured_to)
+{
+    auto const pending = touch_event(mir_touch_action_change, 10, 10, 1ms);
+    auto const next = touch_event(mir_touch_action_change, 20, 25, 2ms);
+
+    EXPECT_FALSE(mi::coalesce_motion(*pending, *next, mi::MotionCoalescing::pointer));
+    ASSERT_TRUE(mi::coalesce_motion(*pending, *next, mi::MotionCoalescing::pointer_and_touch));
+
+    auto const& merged = as_touch(pending);
+    EXPECT_THAT(merged.x(0), FloatEq(20));
+    EXPECT_THAT(merged.y(0), FloatEq(25));
+    EXPECT_THAT(merged.event_time(), Eq(2ms));
+}
+
+TEST(MotionCoalescing, preserves_touch_down_and_up_boundaries)
+{
+    auto const down = touch_event(mir_touch_action_down, 10, 10);
+    auto const change = touch_event(mir_touch_action_change, 20, 25);
+    auto const up = touch_event(mir_touch_action_up, 20, 25);
+
+    EXPECT_FALSE(mi::coalesce_motion(*down, *change, mi::MotionCoalescing::pointer_and_touch));
+    EXPECT_FALSE(mi::coalesce_motion(*change, *up, mi::MotionCoalescing::pointer_and_touch));
+}
+
+TEST(MotionCoalescing, motion_carrying_relative_motion_or_scrolling_is_not_superseded)
+{
+    auto const absolute = pointer_event(mir_pointer_action_motion, 0, 10, 10, 0, 0);
+    auto const relative = pointer_event(mir_pointer_action_motion, 0, 10, 10, 1, 0);
+    auto const scroll = mev::make_event(device, 0ns, std::vector<uint8_t>{}, mir_input_event_modifier_none,
+        mir_pointer_action_motion, 0, 10, 10, 0.0f, 1.0f, 0.0f, 0.0f);
+
+    EXPECT_TRUE(mi::is_coalescible_motion(*absolute, mi::MotionCoalescing::pointer));
+    EXPECT_FALSE(mi::is_coalescible_motion(*relative, mi::MotionCoalescing::pointer));
+    EXPECT_FALSE(mi::is_coalescible_motion(*scroll, mi::MotionCoalescing::pointer));
+}
+
+TEST(MotionCoalescing, parses_option_values)
+{
+    EXPECT_THAT(mi::motion_coalescing_from("off"), Eq(mi::MotionCoalescing::none));
+    EXPECT_THAT(mi::motion_coalescing_from("pointer"), Eq(mi::MotionCoalescing::pointer));
+    EXPECT_THAT(mi::motion_coalescing_from("all"), Eq(mi::MotionCoalescing::pointer_and_touch));
+    EXPECT_THROW(mi::motion_coalescing_from("sometimes"), std::invalid_argument);
+}
@@ -189,3 +189,44 @@ TEST_F(LoggingCompositorReport, bypass_has_no_render_time)
 
     report.stopped();
 }
+
+TEST_F(LoggingCompositorReport, reports_average_texture_uploads)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    for (int f = 0; f < 8; ++f)
+    {
+        report.began_frame(id);
+        report.rendered_frame(id);
+        report.uploaded_textures(id, 8 * 1024);
+        report.finished_frame(id);
+        clock->advance_by(chrono::microseconds(600000));
+    }
+    EXPECT_TRUE(recorder->last_message_contains("8 KiB/frame uploaded"))
+        << recorder->last_message();
+
+    report.stopped();
+}
+
+TEST_F(LoggingCompositorReport, reports_skipped_wakeups)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    for (int f = 0; f < 8; ++f)
+    {
+        report.skipped_wakeup(id);
+        report.skipped_wakeup(id);
+        report.began_frame(id);
+        report.rendered_frame(id);
+        report.finished_frame(id);
+        clock->advance_by(chrono::microseconds(600000));
+    }
+    EXPECT_TRUE(recorder->last_message_contains("4 wakeups skipped"))
+        << recorder->last_message();
+
+    report.stopped();
+}
@@ -197,3 +197,11 @@ TEST_F(DisplayReport, reports_vsync_steady_interval_despite_missed_frames)
     frame.ust.nanoseconds += d2 * nanos_per_frame;
     report.report_vsync(id, frame);
 }
+
+TEST_F(DisplayReport, reports_coalesced_cursor_moves)
+{
+    EXPECT_CALL(*logger, log(ml::Severity::debug, "3 cursor moves coalesced", component));
+
+    mrl::DisplayReport report(logger);
+    report.report_cursor_moves_coalesced(3);
+}
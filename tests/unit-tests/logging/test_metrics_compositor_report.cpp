@@ -0,0 +1,325 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/server/report/metrics/compositor_report.h"
+#include "mir/test/doubles/advanceable_clock.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace mtd = mir::test::doubles;
+namespace mrm = mir::report::metrics;
+
+namespace
+{
+struct MetricsCompositorReport : Test
+{
+    std::shared_ptr<mtd::AdvanceableClock> const clock = std::make_shared<mtd::AdvanceableClock>();
+    mrm::CompositorReport report{clock, ""};
+
+    void composite(void const* id, std::chrono::microseconds frame_time, bool bypass = false)
+    {
+        report.began_frame(id);
+        clock->advance_by(frame_time / 2);
+        if (!bypass)
+            report.rendered_frame(id);
+        clock->advance_by(frame_time - frame_time / 2);
+        report.finished_frame(id);
+    }
+
+    /// Reads back one of id's metrics (or a statistic of one of its histograms) from json()
+    std::uint64_t metric_of(void const* id, std::string const& name, std::string const& histogram = {})
+    {
+        auto const json = report.json();
+
+        char id_field[48];
+        snprintf(id_field, sizeof id_field, "\"id\":\"%p\"", id);
+        auto const begin = json.find(id_field);
+        if (begin == std::string::npos)
+        {
+            ADD_FAILURE() << "No metrics for output " << id;
+            return 0;
+        }
+        auto const output = json.substr(begin, json.find("\"id\":", begin + 1) - begin);
+
+        auto const within = histogram.empty() ? 0 : output.find("\"" + histogram + "\":{");
+        auto const field = output.find("\"" + name + "\":", within);
+        if (within == std::string::npos || field == std::string::npos)
+        {
+            ADD_FAILURE() << "No " << histogram << " " << name << " for output " << id;
+            return 0;
+        }
+        return std::stoull(output.substr(field + name.size() + 3));
+    }
+
+    std::size_t outputs_reported()
+    {
+        auto const json = report.json();
+        std::size_t count = 0;
+        for (auto i = json.find("\"id\":"); i != std::string::npos; i = json.find("\"id\":", i + 1))
+            ++count;
+        return count;
+    }
+};
+
+MATCHER_P(IsWithinAThirtySecondOf, expected, "")
+{
+    auto const tolerance = expected / 32;
+    return arg + tolerance >= expected && arg <= expected + tolerance;
+}
+}
+
+TEST(MetricsHistogram, values_read_back_within_a_thirty_second)
+{
+    for (std::uint64_t value = 1; value < mrm::Histogram::max_trackable_value; value = value * 3 / 2 + 1)
+    {
+        auto const bucket = mrm::Histogram::bucket_for(value);
+
+        EXPECT_THAT(mrm::Histogram::highest_value_in(bucket), IsWithinAThirtySecondOf(value));
+        EXPECT_THAT(mrm::Histogram::highest_value_in(bucket), Ge(value));
+        if (mrm::Histogram::highest_value_in(bucket) < mrm::Histogram::max_trackable_value)
+        {
+            EXPECT_THAT(mrm::Histogram::bucket_for(mrm::Histogram::highest_value_in(bucket) + 1), Eq(bucket + 1));
+        }
+    }
+}
+
+TEST(MetricsHistogram, reports_percentiles_of_recorded_values)
+{
+    mrm::Histogram histogram;
+
+    for (std::uint64_t value = 1; value <= 1000; ++value)
+        histogram.record(value);
+
+    auto const snapshot = histogram.snapshot();
+    EXPECT_THAT(snapshot.count(), Eq(1000u));
+    EXPECT_THAT(snapshot.max(), Eq(1000u));
+    EXPECT_THAT(snapshot.mean(), DoubleEq(500.5));
+    EXPECT_THAT(snapshot.percentile(50), IsWithinAThirtySecondOf(500u));
+    EXPECT_THAT(snapshot.percentile(99), IsWithinAThirtySecondOf(990u));
+    EXPECT_THAT(snapshot.percentile(100), Eq(1000u));
+}
+
+TEST(MetricsHistogram, counts_values_recorded_from_many_threads)
+{
+    mrm::Histogram histogram;
+    int const threads = 4;
+    int const values_per_thread = 10000;
+
+    std::vector<std::thread> recorders;
+    for (int i = 0; i != threads; ++i)
+    {
+        recorders.emplace_back(
+            [&histogram, i]
+            {
+                for (int j = 0; j != values_per_thread; ++j)
+                    histogram.record(i + 1);
+            });
+    }
+    for (auto& recorder : recorders)
+        recorder.join();
+
+    auto const snapshot = histogram.snapshot();
+    EXPECT_THAT(snapshot.count(), Eq(std::uint64_t{threads * values_per_thread}));
+    EXPECT_THAT(snapshot.max(), Eq(std::uint64_t{threads}));
+}
+
+TEST_F(MetricsCompositorReport, reports_tail_frame_times_per_output)
+{
+    void const* const smooth = "smooth";
+    void const* const janky = "janky";
+
+    report.started();
+    for (int frame = 0; frame != 101; ++frame)
+        composite(smooth, 16ms);
+    for (int frame = 0; frame != 101; ++frame)
+        composite(janky, frame % 50 ? 16ms : 40ms);
+
+    // The first frame has nothing to be timed from
+    EXPECT_THAT(metric_of(smooth, "count", "frame_time_us"), Eq(100u));
+    EXPECT_THAT(metric_of(smooth, "p99", "frame_time_us"), Eq(16000u));
+    EXPECT_THAT(metric_of(janky, "p50", "frame_time_us"), IsWithinAThirtySecondOf(16000u));
+    EXPECT_THAT(metric_of(janky, "p99", "frame_time_us"), Eq(40000u));
+    EXPECT_THAT(metric_of(janky, "max", "frame_time_us"), Eq(40000u));
+}
+
+TEST_F(MetricsCompositorReport, bypassed_frames_have_no_render_time)
+{
+    void const* const id = "My Screen";
+
+    report.started();
+    for (int frame = 0; frame != 4; ++frame)
+        composite(id, 10ms, frame % 2);
+
+    EXPECT_THAT(metric_of(id, "frames"), Eq(4u));
+    EXPECT_THAT(metric_of(id, "bypassed_frames"), Eq(2u));
+    EXPECT_THAT(metric_of(id, "count", "render_time_us"), Eq(2u));
+    EXPECT_THAT(metric_of(id, "max", "render_time_us"), Eq(5000u));
+}
+
+TEST_F(MetricsCompositorReport, measures_latency_from_scheduling)
+{
+    void const* const id = "My Screen";
+
+    report.started();
+    report.scheduled();
+    clock->advance_by(3ms);
+    composite(id, 10ms);
+
+    EXPECT_THAT(metric_of(id, "max", "latency_us"), Eq(3000u));
+}
+
+TEST_F(MetricsCompositorReport, counts_renderables_uploads_and_skipped_wakeups)
+{
+    void const* const id = "My Screen";
+    mir::graphics::RenderableList const renderables(3);
+
+    report.started();
+    report.renderables_in_frame(id, renderables);
+    report.uploaded_textures(id, 4096);
+    report.uploaded_textures(id, 1024);
+    report.skipped_wakeup(id);
+
+    EXPECT_THAT(metric_of(id, "max", "renderables"), Eq(3u));
+    EXPECT_THAT(metric_of(id, "uploaded_bytes"), Eq(5120u));
+    EXPECT_THAT(metric_of(id, "skipped_wakeups"), Eq(1u));
+}
+
+TEST_F(MetricsCompositorReport, survives_more_outputs_than_it_measures)
+{
+    std::vector<char> ids(mrm::CompositorReport::max_outputs + 1);
+
+    report.started();
+    for (auto& id : ids)
+        composite(&id, 10ms);
+
+    EXPECT_THAT(outputs_reported(), Eq(mrm::CompositorReport::max_outputs));
+}
+
+TEST_F(MetricsCompositorReport, stopping_starts_afresh)
+{
+    void const* const id = "My Screen";
+
+    report.started();
+    composite(id, 10ms);
+    report.stopped();
+
+    EXPECT_THAT(outputs_reported(), Eq(0u));
+
+    report.started();
+    clock->advance_by(1s);
+    composite(id, 10ms);
+
+    EXPECT_THAT(metric_of(id, "frames"), Eq(1u));
+    EXPECT_THAT(metric_of(id, "count", "frame_time_us"), Eq(0u));
+}
+
+TEST_F(MetricsCompositorReport, reads_output_geometry_whole_while_it_changes)
+{
+    void const* const id = "My Screen";
+
+    report.started();
+    report.added_display(0, 0, 0, 0, id);
+
+    std::atomic<bool> moving{true};
+    std::thread compositor{
+        [&]
+        {
+            for (int i = 1; moving; ++i)
+                report.added_display(i, i, i, i, id);
+        }};
+
+    for (int i = 0; i != 1000; ++i)
+    {
+        auto const json = report.json();
+        auto const field = [&json](std::string const& name)
+            { return std::stoi(json.substr(json.find("\"" + name + "\":") + name.size() + 3)); };
+
+        auto const width = field("width");
+        EXPECT_THAT(field("height"), Eq(width));
+        EXPECT_THAT(field("x"), Eq(width));
+        EXPECT_THAT(field("y"), Eq(width));
+    }
+
+    moving = false;
+    compositor.join();
+}
+
+TEST_F(MetricsCompositorReport, dumps_json_to_file)
+{
+    std::string filename{"/tmp/mir_compositor_metrics_XXXXXX"};
+    close(mkstemp(&filename[0]));
+    mrm::CompositorReport dumping_report{clock, filename};
+    void const* const id = "My Screen";
+
+    dumping_report.started();
+    dumping_report.added_display(1920, 1080, 0, 0, id);
+    dumping_report.began_frame(id);
+    clock->advance_by(10ms);
+    dumping_report.finished_frame(id);
+    dumping_report.stopped();
+
+    std::ifstream file{filename};
+    std::string const dumped{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    unlink(filename.c_str());
+
+    EXPECT_THAT(dumped, StartsWith("{\"outputs\":[{"));
+    EXPECT_THAT(dumped, HasSubstr("\"width\":1920"));
+    EXPECT_THAT(dumped, HasSubstr("\"frames\":1"));
+    EXPECT_THAT(dumped, HasSubstr("\"frame_time_us\":{"));
+    EXPECT_THAT(dumped, HasSubstr("\"p99\":"));
+}
+
+TEST_F(MetricsCompositorReport, dumps_periodically_while_compositing)
+{
+    std::string filename{"/tmp/mir_compositor_metrics_XXXXXX"};
+    close(mkstemp(&filename[0]));
+    mrm::CompositorReport dumping_report{clock, filename};
+    void const* const id = "My Screen";
+
+    dumping_report.started();
+    dumping_report.began_frame(id);
+    dumping_report.finished_frame(id);
+
+    // The compositing thread doesn't write the file itself, so wait for the dumper
+    std::string dumped;
+    for (auto const give_up = std::chrono::steady_clock::now() + 10s;
+         dumped.find("\"frames\":1") == std::string::npos && std::chrono::steady_clock::now() < give_up;
+         std::this_thread::sleep_for(10ms))
+    {
+        std::ifstream file{filename};
+        dumped.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+    }
+
+    dumping_report.stopped();
+    unlink(filename.c_str());
+
+    EXPECT_THAT(dumped, HasSubstr("\"frames\":1"));
+}
@@ -66,6 +66,29 @@ struct MockKMSOutput : public graphics::mesa::KMSOutput
     MOCK_METHOD0(clear_cursor, bool());
     MOCK_CONST_METHOD0(has_cursor, bool());
 
+    MOCK_METHOD0(overlay_planes, std::vector<graphics::mesa::OverlayPlane>());
+    bool set_overlay_plane(
+        uint32_t plane_id,
+        graphics::mesa::FBHandle const& fb,
+        geometry::Rectangle const& destination) override
+    {
+        return set_overlay_plane_thunk(plane_id, &fb, destination);
+    }
+    MOCK_METHOD3(set_overlay_plane_thunk,
+        bool(uint32_t, graphics::mesa::FBHandle const*, geometry::Rectangle const&));
+    MOCK_METHOD1(clear_overlay_plane, void(uint32_t));
+
+    bool add_to_commit(graphics::mesa::AtomicKMSCommit& commit, graphics::mesa::FBHandle const& fb) override
+    {
+        return add_to_commit_thunk(&commit, &fb);
+    }
+    MOCK_METHOD2(add_to_commit_thunk,
+        bool(graphics::mesa::AtomicKMSCommit*, graphics::mesa::FBHandle const*));
+    MOCK_METHOD4(add_overlay_to_commit,
+        bool(graphics::mesa::AtomicKMSCommit&, uint32_t, graphics::mesa::FBHandle const*,
+             geometry::Rectangle const&));
+    MOCK_METHOD1(schedule_commit, bool(graphics::mesa::AtomicKMSCommit&));
+
     MOCK_METHOD1(set_power_mode, void(MirPowerMode));
     MOCK_METHOD1(set_gamma, void(mir::graphics::GammaCurves const&));
 
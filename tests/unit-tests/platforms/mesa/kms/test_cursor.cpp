@@ -27,8 +27,10 @@
 
 #include "mir/test/doubles/mock_gbm.h"
 #include "mir/test/doubles/mock_drm.h"
+#include "mir/test/doubles/mock_display_report.h"
 #include "mir/test/doubles/stub_display_configuration.h"
 #include "mir/test/fake_shared.h"
+#include "mir/test/signal.h"
 #include "mir_test_framework/temporary_environment_value.h"
 #include "mock_kms_output.h"
 
@@ -302,7 +304,8 @@ struct MesaCursorTest : ::testing::Test
     size_t const cursor_side{64};
     MesaCursorTest()
         : cursor{output_container,
-            mt::fake_shared(current_configuration)}
+            mt::fake_shared(current_configuration),
+            mt::fake_shared(report)}
     {
         using namespace ::testing;
         ON_CALL(mock_drm, drmGetCap(_, DRM_CAP_CURSOR_WIDTH, _))
@@ -324,6 +327,7 @@ struct MesaCursorTest : ::testing::Test
     StubCursorImage stub_image;
     StubKMSOutputContainer output_container;
     StubCurrentConfiguration current_configuration{output_container};
+    testing::NiceMock<mtd::MockDisplayReport> report;
     mgm::Cursor cursor;
 };
 
@@ -353,7 +357,8 @@ TEST_F(MesaCursorTest, creates_cursor_bo_image)
                                         GBM_BO_USE_CURSOR | GBM_BO_USE_WRITE));
 
     mgm::Cursor cursor_tmp{output_container,
-        std::make_shared<StubCurrentConfiguration>(output_container)};
+        std::make_shared<StubCurrentConfiguration>(output_container),
+        mt::fake_shared(report)};
 }
 
 TEST_F(MesaCursorTest, queries_received_cursor_size)
@@ -365,7 +370,8 @@ TEST_F(MesaCursorTest, queries_received_cursor_size)
     EXPECT_CALL(mock_gbm, gbm_bo_get_height(_)).Times(2);
 
     mgm::Cursor cursor_tmp{output_container,
-        std::make_shared<StubCurrentConfiguration>(output_container)};
+        std::make_shared<StubCurrentConfiguration>(output_container),
+        mt::fake_shared(report)};
 }
 
 TEST_F(MesaCursorTest, respects_drm_cap_cursor)
@@ -380,7 +386,8 @@ TEST_F(MesaCursorTest, respects_drm_cap_cursor)
     EXPECT_CALL(mock_gbm, gbm_bo_create(_, drm_buffer_size, drm_buffer_size, _, _));
 
     mgm::Cursor cursor_tmp{output_container,
-                           std::make_shared<StubCurrentConfiguration>(output_container)};
+                           std::make_shared<StubCurrentConfiguration>(output_container),
+                           mt::fake_shared(report)};
 }
 
 TEST_F(MesaCursorTest, can_force_64x64_cursor)
@@ -397,7 +404,8 @@ TEST_F(MesaCursorTest, can_force_64x64_cursor)
     EXPECT_CALL(mock_gbm, gbm_bo_create(_, 64, 64, _, _));
 
     mgm::Cursor cursor_tmp{output_container,
-                           std::make_shared<StubCurrentConfiguration>(output_container)};
+                           std::make_shared<StubCurrentConfiguration>(output_container),
+                           mt::fake_shared(report)};
 }
 
 TEST_F(MesaCursorTest, show_cursor_writes_to_bo)
@@ -461,7 +469,8 @@ TEST_F(MesaCursorTest, pads_missing_data_when_buffer_size_differs)
     EXPECT_CALL(mock_gbm, gbm_bo_write(mock_gbm.fake_gbm.bo, ContainsASingleWhitePixel(width*height), buffer_size_bytes));
 
     mgm::Cursor cursor_tmp{output_container,
-        std::make_shared<StubCurrentConfiguration>(output_container)};
+        std::make_shared<StubCurrentConfiguration>(output_container),
+        mt::fake_shared(report)};
     cursor_tmp.show(SinglePixelCursorImage());
 }
 
@@ -496,7 +505,8 @@ TEST_F(MesaCursorTest, clears_cursor_state_on_construction)
     EXPECT_CALL(*output_container.outputs[2], has_cursor()).Times(0);
 
     mgm::Cursor cursor_tmp{output_container,
-       std::make_shared<StubCurrentConfiguration>(output_container)};
+       std::make_shared<StubCurrentConfiguration>(output_container),
+       mt::fake_shared(report)};
 
     output_container.verify_and_clear_expectations();
 }
@@ -514,7 +524,8 @@ TEST_F(MesaCursorTest, construction_fails_if_initial_set_fails)
 
     EXPECT_THROW(
         mgm::Cursor cursor_tmp(output_container,
-           std::make_shared<StubCurrentConfiguration>(output_container));
+           std::make_shared<StubCurrentConfiguration>(output_container),
+           mt::fake_shared(report));
     , std::runtime_error);
 }
 
@@ -806,3 +817,79 @@ TEST_F(MesaCursorTest, show_cursor_sets_cursor_with_hotspot)
     cursor.move_to(cursor_location_2);
 }
 
+
+TEST_F(MesaCursorTest, moves_within_a_frame_are_coalesced)
+{
+    using namespace testing;
+
+    ON_CALL(*output_container.outputs[0], max_refresh_rate())
+        .WillByDefault(Return(10));
+
+    cursor.show(stub_image);
+
+    mt::Signal last_move_applied;
+
+    EXPECT_CALL(*output_container.outputs[0], move_cursor(geom::Point{20,20}))
+        .Times(0);
+    {
+        InSequence seq;
+        EXPECT_CALL(*output_container.outputs[0], move_cursor(geom::Point{10,10}));
+        EXPECT_CALL(*output_container.outputs[0], move_cursor(geom::Point{30,30}))
+            .WillOnce(InvokeWithoutArgs([&] { last_move_applied.raise(); }));
+    }
+    EXPECT_CALL(report, report_cursor_moves_coalesced(1));
+
+    cursor.move_to({10, 10});
+    cursor.move_to({20, 20});
+    cursor.move_to({30, 30});
+
+    EXPECT_TRUE(last_move_applied.wait_for(std::chrono::seconds{5}));
+
+    output_container.verify_and_clear_expectations();
+}
+
+TEST_F(MesaCursorTest, showing_a_recently_shown_image_again_does_not_rewrite_it)
+{
+    using namespace testing;
+
+    SinglePixelCursorImage const other_image;
+
+    cursor.show(stub_image);
+    cursor.show(other_image);
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, _, _)).Times(0);
+    EXPECT_CALL(*output_container.outputs[0], set_cursor(_));
+
+    cursor.show(stub_image);
+}
+
+// The two pixel image {1, 2} turned right puts 1 above 2 in the first column
+MATCHER_P(ContainsTwoPixelsTurnedRight, stride_pixels, "")
+{
+    auto pixels = static_cast<uint32_t const*>(arg);
+    return pixels[0] == 1 && pixels[stride_pixels] == 2 && pixels[1] == 0;
+}
+
+TEST_F(MesaCursorTest, turns_image_for_rotated_output)
+{
+    using namespace testing;
+
+    struct TwoPixelCursorImage : public StubCursorImage
+    {
+        geom::Size size() const override
+        {
+            return {2, 1};
+        }
+        void const* as_argb_8888() const override
+        {
+            static uint32_t const pixels[] = {1, 2};
+            return pixels;
+        }
+    };
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, _, _)).Times(AnyNumber());
+    EXPECT_CALL(mock_gbm, gbm_bo_write(_, ContainsTwoPixelsTurnedRight(cursor_side), _));
+
+    cursor.show(TwoPixelCursorImage{});
+    cursor.move_to({766, 112});
+}
@@ -20,6 +20,7 @@
 #include "mir/test/doubles/null_console_services.h"
 #include "src/platforms/mesa/server/kms/platform.h"
 #include "src/platforms/mesa/server/kms/display_buffer.h"
+#include "src/platforms/mesa/server/kms/atomic_kms_commit.h"
 #include "src/platforms/mesa/include/native_buffer.h"
 #include "src/server/report/null_report_factory.h"
 #include "mir/test/doubles/mock_egl.h"
@@ -48,6 +49,16 @@ using namespace mir::graphics;
 using namespace mir::graphics::mesa;
 using mir::report::null_display_report;
 
+namespace
+{
+// What a powered on output adds to an atomic commit
+ACTION_P(AddFlipOf, crtc_id)
+{
+    arg0->flip(crtc_id, 0);
+    return true;
+}
+}
+
 class MesaDisplayBufferTest : public Test
 {
 public:
@@ -445,6 +456,89 @@ TEST_F(MesaDisplayBufferTest, clone_mode_waits_for_page_flip_on_second_flip)
     db.post();
 }
 
+TEST_F(MesaDisplayBufferTest, clone_mode_flips_atomically_with_wait)
+{
+    std::shared_ptr<MockKMSOutput> const clone_output = std::make_shared<NiceMock<MockKMSOutput>>();
+    ON_CALL(*clone_output, fb_for(_))
+        .WillByDefault(Return(reinterpret_cast<FBHandle*>(0x12ad)));
+
+    uint32_t crtc_id{1};
+    for (auto const& output : {mock_kms_output, clone_output})
+    {
+        EXPECT_CALL(*output, add_to_commit_thunk(_, _))
+            .WillOnce(AddFlipOf(crtc_id++));
+        EXPECT_CALL(*output, schedule_page_flip_thunk(_))
+            .Times(0);
+        EXPECT_CALL(*output, wait_for_page_flip())
+            .Times(1);
+    }
+    EXPECT_CALL(*mock_kms_output, schedule_commit(_))
+        .WillOnce(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, clone_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, failed_atomic_commit_falls_back_to_page_flip)
+{
+    ON_CALL(*mock_kms_output, add_to_commit_thunk(_, _))
+        .WillByDefault(AddFlipOf(1));
+    EXPECT_CALL(*mock_kms_output, schedule_commit(_))
+        .WillOnce(Return(false));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(1);
+    EXPECT_CALL(*mock_kms_output, set_crtc_thunk(_))
+        .Times(1);  // Only on construction
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferTest, powered_off_outputs_are_not_flipped_atomically)
+{
+    std::shared_ptr<MockKMSOutput> const clone_output = std::make_shared<NiceMock<MockKMSOutput>>();
+    ON_CALL(*clone_output, fb_for(_))
+        .WillByDefault(Return(reinterpret_cast<FBHandle*>(0x12ad)));
+
+    // Powered off outputs take part in the commit without adding to it
+    for (auto const& output : {mock_kms_output, clone_output})
+    {
+        ON_CALL(*output, add_to_commit_thunk(_, _))
+            .WillByDefault(Return(true));
+        EXPECT_CALL(*output, schedule_page_flip_thunk(_))
+            .Times(1);
+    }
+    EXPECT_CALL(*mock_kms_output, schedule_commit(_))
+        .Times(0);
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, clone_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.swap_buffers();
+    db.post();
+}
+
 TEST_F(MesaDisplayBufferTest, skips_bypass_because_of_incompatible_list)
 {
     graphics::RenderableList list{
@@ -503,3 +597,328 @@ TEST_F(MesaDisplayBufferTest, buffer_requiring_migration_is_ineligable_for_bypas
 
     EXPECT_FALSE(db.overlay(bypassable_list));
 }
+
+TEST_F(MesaDisplayBufferTest, cannot_predict_vblank_before_first_page_flip)
+{
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_FALSE(db.next_vblank());
+
+    db.post();
+
+    EXPECT_FALSE(db.next_vblank());
+}
+
+TEST_F(MesaDisplayBufferTest, predicts_vblank_following_last_page_flip)
+{
+    Frame last_flip;
+    last_flip.msc = 100;
+    last_flip.ust = Frame::Timestamp::now(CLOCK_MONOTONIC);
+    ON_CALL(*mock_kms_output, last_frame())
+        .WillByDefault(Return(last_flip));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.post();
+
+    auto const next = db.next_vblank();
+    ASSERT_TRUE(next);
+    auto const frames_later = next->msc - last_flip.msc;
+    EXPECT_THAT(frames_later, Ge(1));
+    EXPECT_THAT(next->ust - last_flip.ust, Eq(frames_later * (std::chrono::nanoseconds{1s} / mock_refresh_rate)));
+    EXPECT_THAT(next->ust, Gt(Frame::Timestamp::now(CLOCK_MONOTONIC) - (std::chrono::nanoseconds{1s} / mock_refresh_rate)));
+}
+
+TEST_F(MesaDisplayBufferTest, predicts_vblanks_using_measured_frame_period)
+{
+    std::chrono::nanoseconds const measured_period{16683333}; // 59.94Hz, nominally "60Hz"
+
+    Frame last_flip;
+    last_flip.msc = 160;
+    last_flip.ust = Frame::Timestamp::now(CLOCK_MONOTONIC);
+    Frame earlier_flip;
+    earlier_flip.msc = 100;
+    earlier_flip.ust = last_flip.ust - 60 * measured_period;
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    ON_CALL(*mock_kms_output, last_frame())
+        .WillByDefault(Return(earlier_flip));
+    db.post();
+    ON_CALL(*mock_kms_output, last_frame())
+        .WillByDefault(Return(last_flip));
+    db.post();
+
+    auto const next = db.next_vblank();
+    ASSERT_TRUE(next);
+    EXPECT_THAT(next->ust - last_flip.ust, Eq((next->msc - last_flip.msc) * measured_period));
+}
+
+TEST_F(MesaDisplayBufferTest, cannot_predict_vblank_in_clone_mode)
+{
+    auto const other_output = std::make_shared<NiceMock<MockKMSOutput>>();
+    ON_CALL(*other_output, schedule_page_flip_thunk(_))
+        .WillByDefault(Return(true));
+    ON_CALL(*other_output, max_refresh_rate())
+        .WillByDefault(Return(mock_refresh_rate));
+    ON_CALL(*other_output, fb_for(_))
+        .WillByDefault(Return(reinterpret_cast<FBHandle*>(0x12ad)));
+
+    Frame last_flip;
+    last_flip.msc = 100;
+    last_flip.ust = Frame::Timestamp::now(CLOCK_MONOTONIC);
+    ON_CALL(*mock_kms_output, last_frame())
+        .WillByDefault(Return(last_flip));
+    ON_CALL(*other_output, last_frame())
+        .WillByDefault(Return(last_flip));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, other_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    db.post();
+
+    EXPECT_FALSE(db.next_vblank());
+}
+
+namespace
+{
+struct MesaDisplayBufferOverlayTest : MesaDisplayBufferTest
+{
+    MesaDisplayBufferOverlayTest()
+    {
+        ON_CALL(*mock_kms_output, overlay_planes())
+            .WillByDefault(Return(std::vector<OverlayPlane>{overlay_plane}));
+        ON_CALL(*mock_kms_output, set_overlay_plane_thunk(_, _, _))
+            .WillByDefault(Return(true));
+        ON_CALL(mock_gbm, gbm_bo_get_format(_))
+            .WillByDefault(Return(GBM_FORMAT_XRGB8888));
+
+        ON_CALL(*window_buffer, size())
+            .WillByDefault(Return(window->screen_position().size));
+        ON_CALL(*window_buffer, native_buffer_handle())
+            .WillByDefault(Return(window_native_buffer));
+        window->set_buffer(window_buffer);
+    }
+
+    OverlayPlane const overlay_plane{7, {GBM_FORMAT_XRGB8888}};
+    std::shared_ptr<FakeRenderable> const window{
+        std::make_shared<FakeRenderable>(mir::geometry::Rectangle{{20, 40}, {10, 10}})};
+    std::shared_ptr<MockBuffer> const window_buffer{std::make_shared<NiceMock<MockBuffer>>()};
+    std::shared_ptr<StubGBMNativeBuffer> const window_native_buffer{
+        std::make_shared<StubGBMNativeBuffer>(window->screen_position().size)};
+    // Relative to display_area
+    mir::geometry::Rectangle const window_on_output{{8, 6}, {10, 10}};
+};
+}
+
+TEST_F(MesaDisplayBufferOverlayTest, composites_only_what_is_not_on_an_overlay_plane)
+{
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    graphics::RenderableList to_render;
+    EXPECT_FALSE(db.overlay_where_possible({fake_software_renderable, window}, to_render));
+    EXPECT_THAT(to_render, ElementsAre(fake_software_renderable));
+
+    EXPECT_CALL(*mock_kms_output, set_overlay_plane_thunk(overlay_plane.id, _, window_on_output))
+        .WillOnce(Return(true));
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferOverlayTest, plane_is_cleared_once_no_longer_needed)
+{
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    graphics::RenderableList to_render;
+    db.overlay_where_possible({fake_software_renderable, window}, to_render);
+    db.post();
+
+    EXPECT_CALL(*mock_kms_output, clear_overlay_plane(overlay_plane.id));
+    db.overlay_where_possible({fake_software_renderable}, to_render);
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferOverlayTest, overlay_buffer_is_held_until_replaced_on_screen)
+{
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    auto const original_count = window_buffer.use_count();
+
+    graphics::RenderableList to_render;
+    db.overlay_where_possible({fake_software_renderable, window}, to_render);
+    db.post();
+    EXPECT_EQ(original_count + 1, window_buffer.use_count());
+
+    db.overlay_where_possible({fake_software_renderable}, to_render);
+    db.post();
+    EXPECT_EQ(original_count, window_buffer.use_count());
+}
+
+TEST_F(MesaDisplayBufferOverlayTest, planes_are_not_used_in_clone_mode)
+{
+    auto const clone_output = std::make_shared<NiceMock<MockKMSOutput>>();
+    ON_CALL(*clone_output, schedule_page_flip_thunk(_))
+        .WillByDefault(Return(true));
+    ON_CALL(*clone_output, fb_for(_))
+        .WillByDefault(Return(reinterpret_cast<FBHandle*>(0x12ad)));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, clone_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    EXPECT_CALL(*mock_kms_output, set_overlay_plane_thunk(_, _, _))
+        .Times(0);
+
+    graphics::RenderableList const list{fake_software_renderable, window};
+    graphics::RenderableList to_render;
+    EXPECT_FALSE(db.overlay_where_possible(list, to_render));
+    EXPECT_THAT(to_render, ContainerEq(list));
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferOverlayTest, planes_are_not_used_when_rotated)
+{
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        transformation(mir_orientation_right));
+
+    graphics::RenderableList const list{fake_software_renderable, window};
+    graphics::RenderableList to_render;
+    EXPECT_FALSE(db.overlay_where_possible(list, to_render));
+    EXPECT_THAT(to_render, ContainerEq(list));
+}
+
+TEST_F(MesaDisplayBufferOverlayTest, composites_everything_after_failing_to_set_a_plane)
+{
+    ON_CALL(*mock_kms_output, set_overlay_plane_thunk(_, _, _))
+        .WillByDefault(Return(false));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    graphics::RenderableList const list{fake_software_renderable, window};
+    graphics::RenderableList to_render;
+    db.overlay_where_possible(list, to_render);
+    db.post();
+
+    EXPECT_FALSE(db.overlay_where_possible(list, to_render));
+    EXPECT_THAT(to_render, ContainerEq(list));
+}
+
+TEST_F(MesaDisplayBufferOverlayTest, overlay_plane_is_committed_with_the_frame)
+{
+    ON_CALL(*mock_kms_output, add_to_commit_thunk(_, _))
+        .WillByDefault(AddFlipOf(1));
+    ON_CALL(*mock_kms_output, add_overlay_to_commit(_, _, _, _))
+        .WillByDefault(Return(true));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    graphics::RenderableList to_render;
+    EXPECT_FALSE(db.overlay_where_possible({fake_software_renderable, window}, to_render));
+    EXPECT_THAT(to_render, ElementsAre(fake_software_renderable));
+
+    EXPECT_CALL(*mock_kms_output, add_overlay_to_commit(_, overlay_plane.id, NotNull(), window_on_output))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mock_kms_output, schedule_commit(_))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mock_kms_output, set_overlay_plane_thunk(_, _, _))
+        .Times(0);
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_))
+        .Times(0);
+    db.post();
+
+    EXPECT_CALL(*mock_kms_output, add_overlay_to_commit(_, overlay_plane.id, IsNull(), _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*mock_kms_output, schedule_commit(_))
+        .WillOnce(Return(true));
+    db.overlay_where_possible({fake_software_renderable}, to_render);
+    db.post();
+}
+
+TEST_F(MesaDisplayBufferOverlayTest, composites_everything_if_the_kernel_rejects_the_planes)
+{
+    ON_CALL(*mock_kms_output, add_to_commit_thunk(_, _))
+        .WillByDefault(AddFlipOf(1));
+    ON_CALL(*mock_kms_output, add_overlay_to_commit(_, _, _, _))
+        .WillByDefault(Return(true));
+
+    // The verdict holds until the layout changes
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(Return(-EINVAL));
+
+    graphics::mesa::DisplayBuffer db(
+        graphics::mesa::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        make_output_surface(),
+        display_area,
+        identity);
+
+    graphics::RenderableList const list{fake_software_renderable, window};
+    for (int frame = 0; frame != 2; ++frame)
+    {
+        graphics::RenderableList to_render;
+        EXPECT_FALSE(db.overlay_where_possible(list, to_render));
+        EXPECT_THAT(to_render, ContainerEq(list));
+    }
+}
@@ -17,6 +17,7 @@
  */
 
 #include "src/platforms/mesa/server/kms/kms_page_flipper.h"
+#include "src/platforms/mesa/server/kms/atomic_kms_commit.h"
 
 #include "mir/test/doubles/mock_drm.h"
 #include "mir/test/doubles/mock_display_report.h"
@@ -69,6 +70,42 @@ ACTION_P(InvokePageFlipHandler, param)
     ASSERT_EQ(1, read(arg0, &dummy, 1));
 }
 
+ACTION_P2(InvokePageFlipHandler2, param, crtc_id)
+{
+    int const dont_care{0};
+    char dummy;
+
+    ASSERT_LE(3, arg1->version);
+    arg1->page_flip_handler2(dont_care, dont_care, dont_care, dont_care, crtc_id, *param);
+    ASSERT_EQ(1, read(arg0, &dummy, 1));
+}
+
+class AtomicKMSPageFlipperTest : public ::testing::Test
+{
+public:
+    AtomicKMSPageFlipperTest()
+    : drm_fd{open(drm_device, 0, 0)}
+    {
+        using namespace testing;
+
+        ON_CALL(mock_drm, drmGetCap(drm_fd, crtc_in_vblank_event_cap, _))
+            .WillByDefault(DoAll(SetArgPointee<2>(1), Return(0)));
+
+        page_flipper = std::make_unique<mgm::KMSPageFlipper>(drm_fd, mt::fake_shared(report));
+    }
+
+    // DRM_CAP_CRTC_IN_VBLANK_EVENT, which older libdrm headers lack
+    uint64_t const crtc_in_vblank_event_cap{0x12};
+
+    testing::NiceMock<mtd::MockDisplayReport> report;
+    testing::NiceMock<mtd::MockDRM> mock_drm;
+
+    char const* const drm_device = "/dev/dri/card0";
+    int const drm_fd;
+
+    std::unique_ptr<mgm::KMSPageFlipper> page_flipper;
+};
+
 }
 
 TEST_F(KMSPageFlipperTest, schedule_flip_calls_drm_page_flip)
@@ -581,3 +618,113 @@ TEST_F(KMSPageFlipperTest, threads_concurrent_page_flips_dont_deadlock)
     EXPECT_EQ(counter.count_flips(), counter.count_handle_events());
     EXPECT_TRUE(counter.no_consecutive_flips_for_same_crtc_id());
 }
+
+TEST_F(KMSPageFlipperTest, atomic_commits_need_crtc_in_vblank_events)
+{
+    EXPECT_FALSE(page_flipper.atomic_commits_supported());
+}
+
+TEST_F(AtomicKMSPageFlipperTest, enables_atomic_commits_when_driver_supports_them)
+{
+    using namespace testing;
+
+    EXPECT_CALL(mock_drm, drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1))
+        .WillOnce(Return(0));
+
+    mgm::KMSPageFlipper flipper{drm_fd, mt::fake_shared(report)};
+
+    EXPECT_TRUE(flipper.atomic_commits_supported());
+}
+
+TEST_F(AtomicKMSPageFlipperTest, atomic_commits_unsupported_if_driver_refuses_them)
+{
+    using namespace testing;
+
+    ON_CALL(mock_drm, drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, _))
+        .WillByDefault(Return(-EOPNOTSUPP));
+
+    mgm::KMSPageFlipper flipper{drm_fd, mt::fake_shared(report)};
+
+    EXPECT_FALSE(flipper.atomic_commits_supported());
+}
+
+TEST_F(AtomicKMSPageFlipperTest, schedule_commit_makes_nonblocking_commit_with_flip_events)
+{
+    using namespace testing;
+
+    mgm::AtomicKMSCommit commit{drm_fd};
+    commit.flip(10, 345);
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _,
+                                              DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT, NotNull()))
+        .WillOnce(Return(0));
+
+    EXPECT_TRUE(page_flipper->schedule_commit(commit));
+}
+
+TEST_F(AtomicKMSPageFlipperTest, schedule_commit_throws_if_a_flip_is_already_scheduled)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const connector_id{345};
+
+    page_flipper->schedule_flip(crtc_id, 101, connector_id);
+
+    mgm::AtomicKMSCommit commit{drm_fd};
+    commit.flip(crtc_id, connector_id);
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, _, _)).Times(0);
+
+    EXPECT_THROW({
+        page_flipper->schedule_commit(commit);
+    }, std::logic_error);
+}
+
+TEST_F(AtomicKMSPageFlipperTest, failed_commit_leaves_no_flips_pending)
+{
+    using namespace testing;
+
+    uint32_t const crtc_id{10};
+    uint32_t const connector_id{345};
+
+    mgm::AtomicKMSCommit commit{drm_fd};
+    commit.flip(crtc_id, connector_id);
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, _, _))
+        .WillOnce(Return(-EINVAL));
+
+    EXPECT_FALSE(page_flipper->schedule_commit(commit));
+    EXPECT_NO_THROW(page_flipper->schedule_flip(crtc_id, 101, connector_id));
+}
+
+TEST_F(AtomicKMSPageFlipperTest, wait_for_flip_handles_each_crtc_of_a_commit)
+{
+    using namespace testing;
+
+    uint32_t const crtc_ids[]{10, 11};
+    uint32_t const connector_ids[]{345, 346};
+    void* user_data{nullptr};
+
+    mgm::AtomicKMSCommit commit{drm_fd};
+    commit.flip(crtc_ids[0], connector_ids[0]);
+    commit.flip(crtc_ids[1], connector_ids[1]);
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, _, _))
+        .WillOnce(DoAll(SaveArg<3>(&user_data), Return(0)));
+
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(InvokePageFlipHandler2(&user_data, crtc_ids[1]), Return(0)))
+        .WillOnce(DoAll(InvokePageFlipHandler2(&user_data, crtc_ids[0]), Return(0)));
+
+    EXPECT_CALL(report, report_vsync(connector_ids[1], _));
+    EXPECT_CALL(report, report_vsync(connector_ids[0], _));
+
+    ASSERT_TRUE(page_flipper->schedule_commit(commit));
+
+    mock_drm.generate_event_on(drm_device);
+    page_flipper->wait_for_flip(crtc_ids[1]);
+
+    mock_drm.generate_event_on(drm_device);
+    page_flipper->wait_for_flip(crtc_ids[0]);
+}
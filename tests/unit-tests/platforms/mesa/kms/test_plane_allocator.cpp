@@ -0,0 +1,187 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/platforms/mesa/server/kms/plane_allocator.h"
+#include "mir/test/doubles/fake_renderable.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <drm_fourcc.h>
+
+namespace mg = mir::graphics;
+namespace mgm = mir::graphics::mesa;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+using namespace testing;
+
+namespace
+{
+struct PlaneAllocator : Test
+{
+    std::shared_ptr<mtd::FakeRenderable> renderable_at(geom::Rectangle const& rect)
+    {
+        return std::make_shared<mtd::FakeRenderable>(rect);
+    }
+
+    std::vector<uint32_t> planes_of(std::vector<mgm::PlaneAllocator::Allocation> const& allocations)
+    {
+        std::vector<uint32_t> planes;
+        for (auto const& allocation : allocations)
+            planes.push_back(allocation.plane_id);
+        return planes;
+    }
+
+    geom::Rectangle const area{{1920, 0}, {1920, 1080}};
+    mgm::OverlayPlane const xrgb_plane{31, {DRM_FORMAT_XRGB8888}};
+    mgm::OverlayPlane const nv12_plane{32, {DRM_FORMAT_NV12}};
+    mgm::OverlayPlane const any_rgb_plane{33, {DRM_FORMAT_ARGB8888, DRM_FORMAT_XRGB8888}};
+    mgm::PlaneAllocator::ScanoutFormat const xrgb = [](mg::Renderable const&) { return DRM_FORMAT_XRGB8888; };
+    mg::RenderableList to_composite;
+};
+}
+
+TEST_F(PlaneAllocator, without_planes_everything_is_composited)
+{
+    mgm::PlaneAllocator const allocator{{}};
+    mg::RenderableList const renderables{renderable_at({{2000, 10}, {100, 100}})};
+
+    EXPECT_TRUE(allocator.empty());
+    EXPECT_THAT(allocator.allocate(renderables, area, xrgb, to_composite), IsEmpty());
+    EXPECT_THAT(to_composite, ContainerEq(renderables));
+}
+
+TEST_F(PlaneAllocator, opaque_renderable_is_overlaid_relative_to_the_area)
+{
+    mgm::PlaneAllocator const allocator{{xrgb_plane}};
+    auto const window = renderable_at({{2000, 10}, {100, 200}});
+
+    auto const allocations = allocator.allocate({window}, area, xrgb, to_composite);
+
+    ASSERT_THAT(allocations.size(), Eq(1u));
+    EXPECT_THAT(allocations[0].renderable, Eq(window));
+    EXPECT_THAT(allocations[0].plane_id, Eq(xrgb_plane.id));
+    EXPECT_THAT(allocations[0].destination, Eq(geom::Rectangle{{80, 10}, {100, 200}}));
+    EXPECT_THAT(to_composite, IsEmpty());
+}
+
+TEST_F(PlaneAllocator, translucent_and_shaped_renderables_are_composited)
+{
+    mgm::PlaneAllocator const allocator{{xrgb_plane, any_rgb_plane}};
+    mg::RenderableList const renderables{
+        std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{2000, 10}, {100, 100}}, 0.5f),
+        std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{2500, 10}, {100, 100}}, 1.0f, false)};
+
+    EXPECT_THAT(allocator.allocate(renderables, area, xrgb, to_composite), IsEmpty());
+    EXPECT_THAT(to_composite, ContainerEq(renderables));
+}
+
+TEST_F(PlaneAllocator, renderable_partly_off_the_area_is_composited)
+{
+    mgm::PlaneAllocator const allocator{{xrgb_plane}};
+    mg::RenderableList const renderables{renderable_at({{1900, 10}, {100, 100}})};
+
+    EXPECT_THAT(allocator.allocate(renderables, area, xrgb, to_composite), IsEmpty());
+    EXPECT_THAT(to_composite, ContainerEq(renderables));
+}
+
+TEST_F(PlaneAllocator, renderable_overlapped_from_above_is_composited)
+{
+    mgm::PlaneAllocator const allocator{{xrgb_plane}};
+    auto const below = renderable_at({{2000, 10}, {100, 100}});
+    auto const above = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{2050, 50}, {100, 100}}, 0.5f);
+
+    EXPECT_THAT(allocator.allocate({below, above}, area, xrgb, to_composite), IsEmpty());
+    EXPECT_THAT(to_composite, ElementsAre(below, above));
+}
+
+TEST_F(PlaneAllocator, renderable_may_overlap_what_is_composited_below_it)
+{
+    mgm::PlaneAllocator const allocator{{xrgb_plane}};
+    auto const background = std::make_shared<mtd::FakeRenderable>(area, 1.0f, false);
+    auto const window = renderable_at({{2000, 10}, {100, 100}});
+
+    auto const allocations = allocator.allocate({background, window}, area, xrgb, to_composite);
+
+    EXPECT_THAT(planes_of(allocations), ElementsAre(xrgb_plane.id));
+    EXPECT_THAT(to_composite, ElementsAre(background));
+}
+
+TEST_F(PlaneAllocator, overlapping_renderables_do_not_share_the_overlay_planes)
+{
+    mgm::PlaneAllocator const allocator{{xrgb_plane, any_rgb_plane}};
+    auto const below = renderable_at({{2000, 10}, {100, 100}});
+    auto const above = renderable_at({{2050, 50}, {100, 100}});
+
+    auto const allocations = allocator.allocate({below, above}, area, xrgb, to_composite);
+
+    ASSERT_THAT(allocations.size(), Eq(1u));
+    EXPECT_THAT(allocations[0].renderable, Eq(above));
+    EXPECT_THAT(to_composite, ElementsAre(below));
+}
+
+TEST_F(PlaneAllocator, planes_are_only_given_renderables_in_formats_they_support)
+{
+    mgm::PlaneAllocator const allocator{{nv12_plane, any_rgb_plane}};
+    auto const window = renderable_at({{2000, 10}, {100, 100}});
+
+    EXPECT_THAT(planes_of(allocator.allocate({window}, area, xrgb, to_composite)),
+        ElementsAre(any_rgb_plane.id));
+
+    auto const argb = [](mg::Renderable const&) { return DRM_FORMAT_ABGR8888; };
+    EXPECT_THAT(allocator.allocate({window}, area, argb, to_composite), IsEmpty());
+    EXPECT_THAT(to_composite, ElementsAre(window));
+}
+
+TEST_F(PlaneAllocator, renderable_that_cannot_be_scanned_out_is_composited)
+{
+    mgm::PlaneAllocator const allocator{{xrgb_plane}};
+    auto const window = renderable_at({{2000, 10}, {100, 100}});
+    auto const not_scanout = [](mg::Renderable const&) { return 0u; };
+
+    EXPECT_THAT(allocator.allocate({window}, area, not_scanout, to_composite), IsEmpty());
+    EXPECT_THAT(to_composite, ElementsAre(window));
+}
+
+TEST_F(PlaneAllocator, topmost_renderables_get_the_planes_and_order_is_kept)
+{
+    mgm::PlaneAllocator const allocator{{xrgb_plane, any_rgb_plane}};
+    auto const bottom = renderable_at({{2000, 10}, {100, 100}});
+    auto const translucent = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{2000, 500}, {10, 10}}, 0.5f);
+    auto const middle = renderable_at({{2200, 10}, {100, 100}});
+    auto const top = renderable_at({{2400, 10}, {100, 100}});
+
+    auto const allocations = allocator.allocate({bottom, translucent, middle, top}, area, xrgb, to_composite);
+
+    EXPECT_THAT(planes_of(allocations), ElementsAre(xrgb_plane.id, any_rgb_plane.id));
+    EXPECT_THAT(allocations[0].renderable, Eq(top));
+    EXPECT_THAT(allocations[1].renderable, Eq(middle));
+    EXPECT_THAT(to_composite, ElementsAre(bottom, translucent));
+}
+
+TEST_F(PlaneAllocator, format_is_only_queried_for_eligible_renderables)
+{
+    mgm::PlaneAllocator const allocator{{xrgb_plane}};
+    auto const offscreen = renderable_at({{0, 0}, {100, 100}});
+    auto const translucent = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{2000, 10}, {10, 10}}, 0.5f);
+    int queries = 0;
+    auto const counting = [&](mg::Renderable const&) { ++queries; return DRM_FORMAT_XRGB8888; };
+
+    allocator.allocate({offscreen, translucent}, area, counting, to_composite);
+
+    EXPECT_THAT(queries, Eq(0));
+    EXPECT_THAT(to_composite, ElementsAre(offscreen, translucent));
+}
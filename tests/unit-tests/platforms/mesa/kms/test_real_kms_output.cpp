@@ -18,6 +18,7 @@
 
 #include "src/platforms/mesa/server/kms/real_kms_output.h"
 #include "src/platforms/mesa/server/kms/page_flipper.h"
+#include "src/platforms/mesa/server/kms/atomic_kms_commit.h"
 #include "mir/fatal.h"
 
 #include "mir/test/fake_shared.h"
@@ -47,6 +48,8 @@ class NullPageFlipper : public mgm::PageFlipper
 public:
     bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
+    bool atomic_commits_supported() const override { return false; }
+    bool schedule_commit(mgm::AtomicKMSCommit&) override { return false; }
 };
 
 class MockPageFlipper : public mgm::PageFlipper
@@ -54,6 +57,8 @@ class MockPageFlipper : public mgm::PageFlipper
 public:
     MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
     MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
+    MOCK_CONST_METHOD0(atomic_commits_supported, bool());
+    MOCK_METHOD1(schedule_commit, bool(mgm::AtomicKMSCommit&));
 };
 
 class RealKMSOutputTest : public ::testing::Test
@@ -218,6 +223,77 @@ TEST_F(RealKMSOutputTest, operations_use_existing_crtc)
     output.wait_for_page_flip();
 }
 
+TEST_F(RealKMSOutputTest, add_to_commit_fails_without_atomic_support)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+    append_fb_id(42);
+
+    ON_CALL(mock_page_flipper, atomic_commits_supported())
+        .WillByDefault(Return(false));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, _, _, _)).Times(0);
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    auto fb = output.fb_for(fake_bo);
+    ASSERT_TRUE(output.set_crtc(*fb));
+
+    mgm::AtomicKMSCommit commit{drm_fd};
+    EXPECT_FALSE(output.add_to_commit(commit, *fb));
+    EXPECT_FALSE(output.add_overlay_to_commit(commit, 7, fb, {{0, 0}, {64, 64}}));
+    EXPECT_THAT(commit.flips(), IsEmpty());
+}
+
+TEST_F(RealKMSOutputTest, atomic_commits_leave_powered_off_output_alone)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+    append_fb_id(42);
+
+    ON_CALL(mock_page_flipper, atomic_commits_supported())
+        .WillByDefault(Return(true));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, _, _, _)).Times(0);
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    auto fb = output.fb_for(fake_bo);
+    ASSERT_TRUE(output.set_crtc(*fb));
+    output.set_power_mode(mir_power_mode_off);
+
+    mgm::AtomicKMSCommit commit{drm_fd};
+    EXPECT_TRUE(output.add_to_commit(commit, *fb));
+    EXPECT_FALSE(output.add_overlay_to_commit(commit, 7, fb, {{0, 0}, {64, 64}}));
+    EXPECT_FALSE(output.add_overlay_to_commit(commit, 7, nullptr, {}));
+    EXPECT_THAT(commit.flips(), IsEmpty());
+}
+
+TEST_F(RealKMSOutputTest, schedule_commit_goes_to_the_page_flipper)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+
+    mgm::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    mgm::AtomicKMSCommit commit{drm_fd};
+
+    EXPECT_CALL(mock_page_flipper, schedule_commit(Ref(commit)))
+        .WillOnce(Return(true));
+
+    EXPECT_TRUE(output.schedule_commit(commit));
+}
+
 TEST_F(RealKMSOutputTest, operations_use_possible_crtc)
 {
     using namespace testing;
@@ -466,3 +466,38 @@ TEST_F(GLRenderer, sets_viewport_downscaled_wide)
 
     mrg::Renderer renderer(mock_display_buffer);
 }
+
+TEST_F(GLRenderer, limits_drawing_to_damage)
+{
+    ON_CALL(mock_egl, eglQuerySurface(_, _, EGL_WIDTH, _))
+        .WillByDefault(DoAll(SetArgPointee<3>(3), Return(EGL_TRUE)));
+    ON_CALL(mock_egl, eglQuerySurface(_, _, EGL_HEIGHT, _))
+        .WillByDefault(DoAll(SetArgPointee<3>(4), Return(EGL_TRUE)));
+
+    mrg::Renderer renderer(display_buffer);
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST));
+    EXPECT_CALL(mock_gl, glScissor(1, 2, 1, 1));
+    EXPECT_CALL(mock_gl, glClear(_));
+    EXPECT_CALL(mock_gl, glDisable(GL_SCISSOR_TEST));
+
+    renderer.set_damage({{{2, 3}, {1, 1}}});
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, damage_only_limits_the_next_frame)
+{
+    ON_CALL(mock_egl, eglQuerySurface(_, _, EGL_WIDTH, _))
+        .WillByDefault(DoAll(SetArgPointee<3>(3), Return(EGL_TRUE)));
+    ON_CALL(mock_egl, eglQuerySurface(_, _, EGL_HEIGHT, _))
+        .WillByDefault(DoAll(SetArgPointee<3>(4), Return(EGL_TRUE)));
+
+    mrg::Renderer renderer(display_buffer);
+
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(1);
+
+    renderer.set_damage({{{2, 3}, {1, 1}}});
+    renderer.render(renderable_list);
+    renderer.render(renderable_list);
+}
@@ -446,6 +446,17 @@ TEST_F(BasicSurfaceTest, disables_input_when_setting_input_region_with_empty_rec
     EXPECT_FALSE(surface.input_area_contains(rect.top_left));
 }
 
+TEST_F(BasicSurfaceTest, input_extents_cover_custom_input_region)
+{
+    EXPECT_EQ(rect, surface.input_extents());
+
+    surface.set_input_region({{{-2, 0}, {1, 1}}, {{0, 0}, {10, 12}}});
+
+    geom::Rectangle const expected{rect.top_left + geom::Displacement{-2, 0}, {12, 12}};
+    EXPECT_EQ(expected, surface.input_extents());
+    EXPECT_TRUE(surface.input_area_contains(rect.top_left + geom::Displacement{-2, 0}));
+}
+
 TEST_F(BasicSurfaceTest, reception_mode_is_normal_by_default)
 {
     EXPECT_EQ(mi::InputReceptionMode::normal, surface.reception_mode());
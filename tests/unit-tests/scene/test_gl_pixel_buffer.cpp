@@ -21,12 +21,17 @@
 
 #include "mir/test/doubles/mock_gl_buffer.h"
 #include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_egl.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include <GLES2/gl2ext.h>
 
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+
 namespace mg = mir::graphics;
 namespace geom = mir::geometry;
 namespace ms = mir::scene;
@@ -74,6 +79,18 @@ public:
     std::unique_ptr<WrappingGLContext> context;
 };
 
+std::vector<uint32_t> pack_buffer_contents;
+
+void* fake_glMapBufferRange(GLenum, GLintptr, GLsizeiptr, GLbitfield)
+{
+    return pack_buffer_contents.data();
+}
+
+GLboolean fake_glUnmapBuffer(GLenum)
+{
+    return GL_TRUE;
+}
+
 ACTION(FillPixels)
 {
     auto const pixels = static_cast<uint32_t*>(arg6);
@@ -225,3 +242,68 @@ TEST_F(GLPixelBufferTest, returns_data_from_rgba_buffer_texture)
     EXPECT_EQ(width - 1,
               static_cast<uint32_t const*>(data)[width * height - 1]);
 }
+
+TEST_F(GLPixelBufferTest, stops_trying_bgra_once_it_fails)
+{
+    using namespace testing;
+    uint32_t const width{mock_buffer.size().width.as_uint32_t()};
+    uint32_t const height{mock_buffer.size().height.as_uint32_t()};
+
+    ON_CALL(mock_gl, glGetError())
+        .WillByDefault(Return(GL_INVALID_ENUM));
+
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height, GL_BGRA_EXT, GL_UNSIGNED_BYTE, _))
+        .Times(1);
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, _))
+        .Times(2);
+
+    ms::GLPixelBuffer pixels{std::move(context)};
+
+    pixels.fill_from(mock_buffer);
+    pixels.fill_from(mock_buffer);
+}
+
+TEST_F(GLPixelBufferTest, reads_through_pixel_pack_buffer_where_available)
+{
+    using namespace testing;
+    GLuint const pbo{30};
+    uint32_t const width{mock_buffer.size().width.as_uint32_t()};
+    uint32_t const height{mock_buffer.size().height.as_uint32_t()};
+
+    NiceMock<mtd::MockEGL> mock_egl;
+
+    pack_buffer_contents.resize(width * height);
+    for (uint32_t i = 0; i < width * height; ++i)
+        pack_buffer_contents[i] = i;
+
+    ON_CALL(mock_gl, glGetString(GL_VERSION))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("OpenGL ES 3.2 Mesa 18.0.0")));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glMapBufferRange")))
+        .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_glMapBufferRange)));
+    ON_CALL(mock_egl, eglGetProcAddress(StrEq("glUnmapBuffer")))
+        .WillByDefault(Return(reinterpret_cast<mtd::MockEGL::generic_function_pointer_t>(&fake_glUnmapBuffer)));
+    ON_CALL(mock_gl, glGenBuffers(1, _))
+        .WillByDefault(SetArgPointee<1>(pbo));
+
+    EXPECT_CALL(mock_gl, glBindBuffer(_, _))
+        .Times(AnyNumber());
+    EXPECT_CALL(mock_gl, glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo))
+        .Times(AtLeast(1));
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, width, height, GL_BGRA_EXT, GL_UNSIGNED_BYTE, IsNull()));
+    EXPECT_CALL(mock_gl, glDeleteBuffers(1, Pointee(pbo)));
+
+    ms::GLPixelBuffer pixels{std::move(context)};
+
+    pixels.fill_from(mock_buffer);
+    auto data = pixels.as_argb_8888();
+
+    /* Check that data has been properly y-flipped */
+    EXPECT_EQ(1,
+              static_cast<uint32_t const*>(data)[width * (height - 1) + 1]);
+    EXPECT_EQ(width * (height / 2),
+              static_cast<uint32_t const*>(data)[width * (height / 2)]);
+    EXPECT_EQ(width * (height - 1),
+              static_cast<uint32_t const*>(data)[0]);
+    EXPECT_EQ(width - 1,
+              static_cast<uint32_t const*>(data)[width * height - 1]);
+}
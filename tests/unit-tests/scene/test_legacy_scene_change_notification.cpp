@@ -143,3 +143,93 @@ TEST_F(LegacySceneChangeNotificationTest, ending_observation_unregisters_observe
     // Verify that its not simply the destruction removing the observer...
     ::testing::Mock::VerifyAndClearExpectations(&observer);
 }
+
+namespace
+{
+struct MockDamageCallback
+{
+    MOCK_METHOD2(invoke, void(int, mir::geometry::Rectangle const&));
+};
+
+struct SceneChangeDamageNotificationTest : LegacySceneChangeNotificationTest
+{
+    void SetUp() override
+    {
+        using namespace testing;
+        LegacySceneChangeNotificationTest::SetUp();
+
+        ON_CALL(surface, size()).WillByDefault(Return(surface_size));
+        ON_CALL(surface, add_observer(_)).WillByDefault(SaveArg<0>(&surface_observer));
+    }
+
+    mir::geometry::Size const surface_size{100, 50};
+    std::shared_ptr<ms::SurfaceObserver> surface_observer;
+    testing::NiceMock<MockDamageCallback> damage_callback;
+    std::function<void(int, mir::geometry::Rectangle const&)> damage_change_callback{
+        [this](int frames, mir::geometry::Rectangle const& damage) { damage_callback.invoke(frames, damage); }};
+};
+}
+
+TEST_F(SceneChangeDamageNotificationTest, adding_and_removing_surface_damages_only_its_extents)
+{
+    using namespace ::testing;
+
+    EXPECT_CALL(scene_callback, invoke()).Times(0);
+    EXPECT_CALL(damage_callback, invoke(1, mir::geometry::Rectangle{{0, 0}, surface_size})).Times(2);
+
+    ms::LegacySceneChangeNotification observer(scene_change_callback, damage_change_callback);
+    observer.surface_added(&surface);
+    observer.surface_removed(&surface);
+}
+
+TEST_F(SceneChangeDamageNotificationTest, moving_surface_damages_old_and_new_positions)
+{
+    using namespace ::testing;
+
+    ms::LegacySceneChangeNotification observer(scene_change_callback, damage_change_callback);
+    observer.surface_exists(&surface);
+
+    EXPECT_CALL(scene_callback, invoke()).Times(0);
+    EXPECT_CALL(damage_callback, invoke(1, mir::geometry::Rectangle{{0, 0}, {300, 250}}));
+
+    surface_observer->moved_to(&surface, {200, 200});
+}
+
+TEST_F(SceneChangeDamageNotificationTest, resizing_surface_damages_old_and_new_extents)
+{
+    using namespace ::testing;
+
+    ms::LegacySceneChangeNotification observer(scene_change_callback, damage_change_callback);
+    observer.surface_exists(&surface);
+
+    EXPECT_CALL(damage_callback, invoke(1, mir::geometry::Rectangle{{0, 0}, {100, 80}}));
+
+    surface_observer->resized_to(&surface, {60, 80});
+}
+
+TEST_F(SceneChangeDamageNotificationTest, hiding_surface_damages_its_extents_once)
+{
+    using namespace ::testing;
+
+    ms::LegacySceneChangeNotification observer(scene_change_callback, damage_change_callback);
+    observer.surface_exists(&surface);
+
+    EXPECT_CALL(damage_callback, invoke(1, mir::geometry::Rectangle{{0, 0}, surface_size})).Times(1);
+
+    ON_CALL(surface, visible()).WillByDefault(Return(false));
+    surface_observer->hidden_set_to(&surface, true);
+    surface_observer->alpha_set_to(&surface, 0.5f);
+}
+
+TEST_F(SceneChangeDamageNotificationTest, transforming_surface_changes_whole_scene)
+{
+    using namespace ::testing;
+
+    ms::LegacySceneChangeNotification observer(scene_change_callback, damage_change_callback);
+    observer.surface_exists(&surface);
+
+    EXPECT_CALL(damage_callback, invoke(_, _)).Times(0);
+    EXPECT_CALL(scene_callback, invoke()).Times(1);
+
+    surface_observer->transformation_set_to(&surface, glm::mat4{2.0f});
+}
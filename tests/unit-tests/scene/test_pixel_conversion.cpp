@@ -0,0 +1,66 @@
+/*
+ * Copyright © 2018 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "src/server/scene/pixel_conversion.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <vector>
+
+namespace ms = mir::scene;
+
+using namespace testing;
+
+TEST(PixelConversion, swaps_red_and_blue)
+{
+    uint32_t const abgr[]{0x80112233, 0xff0000ff, 0x00ff0000, 0x12345678};
+    uint32_t argb[4];
+
+    ms::abgr_to_argb(abgr, argb, 4);
+
+    EXPECT_THAT(argb, ElementsAre(0x80332211, 0xffff0000, 0x000000ff, 0x12785634));
+}
+
+TEST(PixelConversion, matches_scalar_conversion_for_any_row_length)
+{
+    // Lengths either side of every vector width we use
+    for (size_t count = 0; count != 70; ++count)
+    {
+        std::vector<uint32_t> src(count);
+        std::iota(src.begin(), src.end(), 0x01020304);
+        std::vector<uint32_t> expected(count), converted(count);
+
+        ms::detail::abgr_to_argb_scalar(src.data(), expected.data(), count);
+        ms::abgr_to_argb(src.data(), converted.data(), count);
+
+        EXPECT_THAT(converted, ContainerEq(expected)) << "count = " << count;
+    }
+}
+
+TEST(PixelConversion, converts_in_place)
+{
+    std::vector<uint32_t> pixels(37);
+    std::iota(pixels.begin(), pixels.end(), 0xa0b0c0d0);
+    std::vector<uint32_t> expected(pixels.size());
+
+    ms::detail::abgr_to_argb_scalar(pixels.data(), expected.data(), pixels.size());
+    ms::abgr_to_argb(pixels.data(), pixels.data(), pixels.size());
+
+    EXPECT_THAT(pixels, ContainerEq(expected));
+}
@@ -330,6 +330,30 @@ TEST_F(SurfaceStack, scene_doesnt_count_pending_frames_from_partially_exposed_su
     EXPECT_EQ(0, stack.frames_pending(comp2));
 }
 
+TEST_F(SurfaceStack, scene_change_is_pending_for_each_compositor_until_it_composites)
+{
+    ms::SurfaceStack stack{report};
+    auto const comp1 = reinterpret_cast<mc::CompositorID>(0);
+    auto const comp2 = reinterpret_cast<mc::CompositorID>(1);
+
+    stack.register_compositor(comp1);
+    stack.register_compositor(comp2);
+
+    stack.emit_scene_changed();
+
+    EXPECT_EQ(1, stack.frames_pending(comp1));
+    EXPECT_EQ(1, stack.frames_pending(comp2));
+
+    stack.scene_elements_for(comp1);
+
+    EXPECT_EQ(0, stack.frames_pending(comp1));
+    EXPECT_EQ(1, stack.frames_pending(comp2));
+
+    stack.scene_elements_for(comp2);
+
+    EXPECT_EQ(0, stack.frames_pending(comp2));
+}
+
 TEST_F(SurfaceStack, surfaces_are_emitted_by_layer)
 {
     using namespace testing;
@@ -1027,3 +1051,58 @@ TEST_F(SurfaceStack, raise_surfaces_to_top)
             SceneElementForStream(stub_buffer_stream2),
             SceneElementForStream(stub_buffer_stream3)));
 }
+
+TEST_F(SurfaceStack, reuses_scene_elements_a_registered_compositor_has_released)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+    stack.add_surface(stub_surface1, default_params.input_mode);
+
+    auto const first = stack.scene_elements_for(compositor_id).front().get();
+    auto const second = stack.scene_elements_for(compositor_id);
+
+    ASSERT_THAT(second, ElementsAre(SceneElementForStream(stub_buffer_stream1)));
+    EXPECT_THAT(second.front().get(), Eq(first));
+}
+
+TEST_F(SurfaceStack, does_not_reuse_scene_elements_a_compositor_still_holds)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+    stack.add_surface(stub_surface1, default_params.input_mode);
+
+    auto const first = stack.scene_elements_for(compositor_id);
+    auto const second = stack.scene_elements_for(compositor_id);
+
+    ASSERT_THAT(second, ElementsAre(SceneElementForStream(stub_buffer_stream1)));
+    EXPECT_THAT(second.front(), Ne(first.front()));
+    EXPECT_THAT(first, ElementsAre(SceneElementForStream(stub_buffer_stream1)));
+}
+
+TEST_F(SurfaceStack, scene_elements_already_taken_are_unaffected_by_later_changes)
+{
+    using namespace testing;
+
+    stack.register_compositor(compositor_id);
+    stack.add_surface(stub_surface1, default_params.input_mode);
+    stack.add_surface(stub_surface2, default_params.input_mode);
+
+    auto const elements = stack.scene_elements_for(compositor_id);
+
+    stack.remove_surface(stub_surface1);
+    stack.raise(stub_surface2);
+    stack.add_surface(stub_surface3, default_params.input_mode);
+
+    EXPECT_THAT(
+        elements,
+        ElementsAre(
+            SceneElementForStream(stub_buffer_stream1),
+            SceneElementForStream(stub_buffer_stream2)));
+    EXPECT_THAT(
+        stack.scene_elements_for(compositor_id),
+        ElementsAre(
+            SceneElementForStream(stub_buffer_stream2),
+            SceneElementForStream(stub_buffer_stream3)));
+}
@@ -23,6 +23,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <chrono>
+#include <vector>
+
 namespace mt = mir::test;
 
 using namespace testing;
@@ -174,3 +177,115 @@ TEST_F(RecursiveReadWriteMutex, read_lock_waits_for_write_locks_on_other_threads
 
     threads.push_back(std::thread{writer_function});
 }
+
+TEST_F(RecursiveReadWriteMutex, new_read_lock_waits_for_waiting_writer)
+{
+    mt::Barrier writer_started{2};
+
+    mutex.read_lock();
+
+    threads.push_back(std::thread{
+        [&]{
+            writer_started.ready();
+            mutex.write_lock();
+            notify_write_locked();
+
+            notify_write_unlocking();
+            mutex.write_unlock();
+        }});
+
+    writer_started.ready();
+    // Give the writer time to start waiting for our read lock
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+
+    InSequence seq;
+
+    EXPECT_CALL(*this, notify_read_unlocking()).Times(1);
+    EXPECT_CALL(*this, notify_write_locked()).Times(1);
+    EXPECT_CALL(*this, notify_write_unlocking()).Times(1);
+    EXPECT_CALL(*this, notify_read_locked()).Times(1);
+
+    threads.push_back(std::thread{
+        [&]{
+            mutex.read_lock();
+            notify_read_locked();
+            mutex.read_unlock();
+        }});
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+
+    notify_read_unlocking();
+    mutex.read_unlock();
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+TEST_F(RecursiveReadWriteMutex, can_be_write_locked_on_thread_with_read_lock_while_another_writer_waits)
+{
+    mt::Barrier writer_started{2};
+
+    mutex.read_lock();
+
+    threads.push_back(std::thread{
+        [&]{
+            writer_started.ready();
+            mutex.write_lock();
+            notify_write_locked();
+            mutex.write_unlock();
+        }});
+
+    writer_started.ready();
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+
+    InSequence seq;
+
+    EXPECT_CALL(*this, notify_read_unlocking()).Times(1);
+    EXPECT_CALL(*this, notify_write_locked()).Times(1);
+
+    mutex.write_lock();
+    mutex.write_unlock();
+
+    notify_read_unlocking();
+    mutex.read_unlock();
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+TEST_F(RecursiveReadWriteMutex, read_lock_taken_while_write_locked_outlasts_write_lock)
+{
+    mt::Barrier downgraded{2};
+
+    auto const downgrading_function =
+        [&]{
+            mutex.write_lock();
+            mutex.read_lock();
+            mutex.write_unlock();
+
+            downgraded.ready();
+
+            notify_read_unlocking();
+            mutex.read_unlock();
+        };
+
+    auto const writer_function =
+        [&]{
+            downgraded.ready();
+
+            mutex.write_lock();
+            notify_write_locked();
+            mutex.write_unlock();
+        };
+
+    InSequence seq;
+
+    EXPECT_CALL(*this, notify_read_unlocking()).Times(1);
+    EXPECT_CALL(*this, notify_write_locked()).Times(1);
+
+    threads.push_back(std::thread{downgrading_function});
+    threads.push_back(std::thread{writer_function});
+
+    for (auto& thread : threads)
+        thread.join();
+}
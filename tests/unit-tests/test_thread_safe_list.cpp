@@ -22,6 +22,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <atomic>
+#include <thread>
+
 namespace
 {
 
@@ -157,3 +160,55 @@ TEST_F(ThreadSafeListTest, clears_all_elements)
 
     EXPECT_THAT(elements_seen, Eq(0));
 }
+
+TEST_F(ThreadSafeListTest, remove_waits_for_call_in_progress_on_different_thread)
+{
+    using namespace testing;
+
+    list.add(element1);
+
+    mir::test::Signal element_in_use;
+    std::atomic<bool> call_finished{false};
+
+    std::thread t{
+        [&]
+        {
+            list.for_each(
+                [&] (Element const&)
+                {
+                    element_in_use.raise();
+                    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+                    call_finished = true;
+                });
+        }};
+
+    element_in_use.wait_for(std::chrono::seconds{3});
+    list.remove(element1);
+
+    EXPECT_TRUE(call_finished);
+
+    t.join();
+}
+
+TEST_F(ThreadSafeListTest, can_add_element_while_iterating)
+{
+    using namespace testing;
+
+    list.add(element1);
+
+    list.for_each(
+        [&] (Element const&)
+        {
+            list.add(element2);
+        });
+
+    std::vector<Element> elements_seen;
+
+    list.for_each(
+        [&] (Element const& element)
+        {
+            elements_seen.push_back(element);
+        });
+
+    EXPECT_THAT(elements_seen, ElementsAre(element1, element2));
+}